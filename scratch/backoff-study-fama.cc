@@ -422,6 +422,12 @@ BackoffStudy::PrepareSimulation ()
   Ptr<UanChannel> channel = CreateObjectWithAttributes<UanChannel> ("PropagationModel", PointerValue (prop),
                                                                     "NoiseModel", PointerValue(noise));
 
+  // Three devices per node run out of 8 bit addresses above 85 nodes
+  if (3 * m_numNodes > 255)
+    {
+      UanAddress::SetWidth (2);
+    }
+
   //Create net device and nodes with UanHelper
   devices = uan.Install (nc, channel);
 
@@ -162,6 +162,12 @@ SimpleTest::SetupWakeup( NodeContainer& nc, NodeContainer& sink){
 #endif //UAN_PROP_BH_INSTALLED
   Ptr<UanChannel> channel = CreateObjectWithAttributes<UanChannel> ("PropagationModel", PointerValue (prop));
   
+  // Three devices per node run out of 8 bit addresses above 84 nodes
+  if (3 * (m_numNodes + 1) > 255)
+    {
+      UanAddress::SetWidth (2);
+    }
+
   //Create net device and nodes with UanHelper
   devices = m_uan.Install (nc, channel);
   sinkDevice = m_uan.Install(sink, channel);
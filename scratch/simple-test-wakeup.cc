@@ -46,6 +46,7 @@ public:
   uint32_t m_offeredLoad;
   Time m_simTime;
   bool m_ack;
+  bool m_slotted;
   double m_backoff;
   uint32_t m_sentPackets;
   uint32_t m_receivedPackets;
@@ -63,12 +64,7 @@ public:
   UanHelper m_uan;
 
   NetDeviceContainer devices;
-  NetDeviceContainer devicesWakeup;
-  NetDeviceContainer devicesWakeupHE;
-
   NetDeviceContainer sinkDevice;
-  NetDeviceContainer sinkDeviceWakeup;
-  NetDeviceContainer sinkDeviceWakeupHE;
   
   Gnuplot3dDataset m_plotData;
 private:
@@ -88,6 +84,7 @@ SimpleTest::SimpleTest()
    m_offeredLoad(1),
    m_simTime (Seconds(100)),
    m_ack (true),
+   m_slotted (false),
    m_backoff(0.5),
    m_sentPackets(0),
    m_receivedPackets(0),
@@ -114,13 +111,10 @@ SimpleTest::SetPhyMac()
   m_randExp->SetAttribute ("Bound", DoubleValue (m_offeredLoad*0.3));
   
   std::string perModel = "ns3::UanPhyPerGenDefault";
-  std::string sinrModel = "ns3::UanPhyCalcSinrDefault";
 
   ObjectFactory obf;
   obf.SetTypeId (perModel);
   Ptr<UanPhyPer> per = obf.Create<UanPhyPer> ();
-  obf.SetTypeId (sinrModel);
-  Ptr<UanPhyCalcSinr> sinr = obf.Create<UanPhyCalcSinr> ();
 
   UanTxMode mode;
   mode = UanTxModeFactory::CreateMode (UanTxMode::FSK, m_dataRate,
@@ -130,10 +124,9 @@ SimpleTest::SetPhyMac()
   UanModesList myModes;
   myModes.AppendMode (mode);
 
-  m_uan.SetPhy ("ns3::UanPhyGen",
+  m_uan.SetPhy ("ns3::UanPhyWakeupDual",
               "PerModel", PointerValue (per),
-              "SinrModel", PointerValue (sinr),
-              "SupportedModes", UanModesListValue (myModes));
+              "DataModes", UanModesListValue (myModes));
   m_uan.SetMac ("ns3::UanMacWakeup");
 }
 
@@ -165,12 +158,6 @@ SimpleTest::SetupWakeup( NodeContainer& nc, NodeContainer& sink){
   //Create net device and nodes with UanHelper
   devices = m_uan.Install (nc, channel);
   sinkDevice = m_uan.Install(sink, channel);
-  //Create wakeup net device
-  devicesWakeup = m_uan.Install (nc, channel);
-  sinkDeviceWakeup = m_uan.Install(sink, channel);
-  //Create wakeupHE net device
-  devicesWakeupHE = m_uan.Install (nc, channel);
-  sinkDeviceWakeupHE = m_uan.Install(sink, channel);
   // Set location
   MobilityHelper mobility;
   Ptr<ListPositionAllocator> pos = CreateObject<ListPositionAllocator> ();
@@ -194,59 +181,21 @@ SimpleTest::SetupWakeup( NodeContainer& nc, NodeContainer& sink){
 
   for (uint32_t i = 0; i < devices.GetN()+1; i++)
   {
-      Ptr<UanPhyGen> phy = 0 ;
-	  Ptr<UanMac> mac = 0 ;
-	  Ptr<UanMacWakeup> macWakeup = 0 ;
-	  Ptr<UanPhy> phyWakeup = 0;
-	  Ptr<UanNetDevice> uanNetdevice = 0;
-	  Ptr<Node> nodePtr = 0 ;
-	  Ptr<NetDevice> wakeUpDevicePtr = 0 ;  
-	  UanAddress uanAddress (i);
-	  if (i == devices.GetN()){
-	    
-	    phy = DynamicCast<UanPhyGen> (DynamicCast<UanNetDevice> (sinkDevice.Get(0))->GetPhy ());
-		mac = DynamicCast<UanNetDevice> (sinkDevice.Get(0))->GetMac ();
-        macWakeup = DynamicCast<UanMacWakeup> (mac);
-        phy->RegisterListener( &(*macWakeup));
-		macWakeup->AttachPhy(phy);
-		
-
-
-        phyWakeup = DynamicCast<UanNetDevice> (sinkDeviceWakeup.Get(0))->GetPhy ();
-        macWakeup->AttachWakeupPhy (phyWakeup);
-        phyWakeup->SetMac (macWakeup);
-        phyWakeup->RegisterListener( &(*macWakeup));
-
-
-        //Afegir mac rts
-		uanNetdevice = DynamicCast<UanNetDevice> (sinkDevice.Get(0));
-        
-		
-		nodePtr = sink.Get(0);
-		wakeUpDevicePtr = sinkDeviceWakeupHE.Get(0);
-	  }
-	  else{
-	  
-	    phy = DynamicCast<UanPhyGen> (DynamicCast<UanNetDevice> (devices.Get(i))->GetPhy ());
-        mac = DynamicCast<UanNetDevice> (devices.Get(i))->GetMac ();
-        macWakeup = DynamicCast<UanMacWakeup> (mac);
-        phy->RegisterListener( &(*macWakeup));
-		macWakeup->AttachPhy(phy);
-		
-
-        phyWakeup = DynamicCast<UanNetDevice> (devicesWakeup.Get(i))->GetPhy ();
-        macWakeup->AttachWakeupPhy (phyWakeup);
-        phyWakeup->SetMac (macWakeup);
-        phyWakeup->RegisterListener( &(*macWakeup));
-
-
-        //Afegir mac rts
-        uanNetdevice = DynamicCast<UanNetDevice> (devices.Get(i));
-
-        nodePtr=nc.Get(i);
-		wakeUpDevicePtr = devicesWakeupHE.Get(i);
-		}
-      Ptr<UanMacFama> macAlohaRts = Create<UanMacFama> ();
+      // One device per node: data PHY and wakeup PHY share its transducer
+      Ptr<UanNetDevice> uanNetdevice = DynamicCast<UanNetDevice> (i == devices.GetN () ? sinkDevice.Get (0) : devices.Get (i));
+      Ptr<Node> nodePtr = i == devices.GetN () ? sink.Get (0) : nc.Get (i);
+      UanAddress uanAddress (i);
+
+      Ptr<UanPhyWakeupDual> dual = DynamicCast<UanPhyWakeupDual> (uanNetdevice->GetPhy ());
+      Ptr<UanPhyGen> phy = dual->GetDataPhy ();
+      Ptr<UanPhy> phyWakeup = dual->GetWakeupPhy ();
+      Ptr<UanMacWakeup> macWakeup = DynamicCast<UanMacWakeup> (uanNetdevice->GetMac ());
+
+      Ptr<UanMacFama> macAlohaRts;
+      if (m_slotted)
+        macAlohaRts = Create<UanMacSlottedFama> ();
+      else
+        macAlohaRts = Create<UanMacFama> ();
       macAlohaRts->AttachMacWakeup (macWakeup);
       macAlohaRts->AttachPhy (phy);
       macAlohaRts->SetBackoffTime (m_backoff);
@@ -481,24 +430,6 @@ SimpleTest::StartRun(){
         sinkDevice.Get (i) = 0;
       }
 
-	for (uint32_t i=0; i < devicesWakeup.GetN (); i++)
-      {
-        devicesWakeup.Get (i) = 0;
-      }
-	for (uint32_t i=0; i < sinkDeviceWakeup.GetN (); i++)
-      {
-        sinkDeviceWakeup.Get (i) = 0;
-      }
-	  
-	 for (uint32_t i=0; i < devicesWakeupHE.GetN (); i++)
-      {
-        devicesWakeupHE.Get (i) = 0;
-      }
-	 for (uint32_t i=0; i < sinkDeviceWakeupHE.GetN (); i++)
-      {
-        sinkDeviceWakeupHE.Get (i) = 0;
-      }
-	  
     Simulator::Destroy ();
     //return m_plotData;
 
@@ -633,6 +564,7 @@ main (int argc, char **argv)
   cmd.AddValue ("DataRate", "DataRate in bps", exp.m_dataRate);
   cmd.AddValue ("Averages", "Experiement Repeat Time", exp.m_avgs);
   cmd.AddValue ("GnuFile", "Name for GNU Plot output", exp.m_gnudatfile);
+  cmd.AddValue ("Slotted", "Use slotted FAMA", exp.m_slotted);
   //cmd.AddValue ("PerModel", "PER model name", perModel);
   //cmd.AddValue ("SinrModel", "SINR model name", sinrModel);
   cmd.Parse (argc, argv);
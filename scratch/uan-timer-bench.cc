@@ -0,0 +1,191 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Timer churn benchmark.
+ *
+ * Every node runs the MAC timeout pattern of a contention handshake: on
+ * each attempt it arms a short TxFail, a WfCTS and a WfACK timeout and
+ * cancels most of them before they expire, as a successful exchange does.
+ * The same load is run once with one ns3::Timer per timeout and once with
+ * a UanTimerQueue per node, and the number of simulator events and the
+ * wall clock rate are printed.
+ *
+ *   ./waf --run "uan-timer-bench --nodes=100 --attempts=1000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/uan-module.h"
+
+#include <ctime>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("UanTimerBench");
+
+namespace {
+
+uint32_t g_expired = 0;
+
+void
+Expired (void)
+{
+  g_expired++;
+}
+
+/** One node using a plain Timer per timeout. */
+class TimerNode
+{
+public:
+  TimerNode (Ptr<UniformRandomVariable> rv)
+    : m_rv (rv),
+      m_left (0)
+  {
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        m_timers[i].SetFunction (&Expired);
+      }
+  }
+  void Start (uint32_t attempts)
+  {
+    m_left = attempts;
+    Simulator::Schedule (Seconds (m_rv->GetValue (0, 1)), &TimerNode::Attempt, this);
+  }
+  void Attempt (void)
+  {
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        m_timers[i].Cancel ();
+        m_timers[i].Schedule (Seconds (1 + i));
+      }
+    // Most exchanges succeed and cancel their timeouts
+    if (m_rv->GetValue (0, 1) < 0.9)
+      {
+        for (uint32_t i = 0; i < 3; i++)
+          {
+            m_timers[i].Cancel ();
+          }
+      }
+    if (--m_left > 0)
+      {
+        Simulator::Schedule (Seconds (m_rv->GetValue (0.1, 0.5)), &TimerNode::Attempt, this);
+      }
+  }
+private:
+  Ptr<UniformRandomVariable> m_rv;
+  Timer m_timers[3];
+  uint32_t m_left;
+};
+
+/** One node using a shared UanTimerQueue. */
+class QueueNode
+{
+public:
+  QueueNode (Ptr<UniformRandomVariable> rv)
+    : m_rv (rv),
+      m_left (0)
+  {
+    m_queue = CreateObject<UanTimerQueue> ();
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        m_timers[i] = m_queue->Add ("T", MakeCallback (&Expired));
+      }
+  }
+  void Start (uint32_t attempts)
+  {
+    m_left = attempts;
+    Simulator::Schedule (Seconds (m_rv->GetValue (0, 1)), &QueueNode::Attempt, this);
+  }
+  void Attempt (void)
+  {
+    for (uint32_t i = 0; i < 3; i++)
+      {
+        m_queue->Cancel (m_timers[i]);
+        m_queue->Schedule (m_timers[i], Seconds (1 + i));
+      }
+    if (m_rv->GetValue (0, 1) < 0.9)
+      {
+        for (uint32_t i = 0; i < 3; i++)
+          {
+            m_queue->Cancel (m_timers[i]);
+          }
+      }
+    if (--m_left > 0)
+      {
+        Simulator::Schedule (Seconds (m_rv->GetValue (0.1, 0.5)), &QueueNode::Attempt, this);
+      }
+  }
+private:
+  Ptr<UniformRandomVariable> m_rv;
+  Ptr<UanTimerQueue> m_queue;
+  uint32_t m_timers[3];
+  uint32_t m_left;
+};
+
+template <class NodeType>
+void
+Run (std::string label, uint32_t nodes, uint32_t attempts)
+{
+  RngSeedManager::SetRun (1);
+  g_expired = 0;
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  std::vector<NodeType *> all;
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      all.push_back (new NodeType (rv));
+      all.back ()->Start (attempts);
+    }
+
+  std::clock_t start = std::clock ();
+  Simulator::Run ();
+  double wall = double (std::clock () - start) / CLOCKS_PER_SEC;
+  uint64_t events = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < all.size (); i++)
+    {
+      delete all[i];
+    }
+
+  std::cout << label
+            << " events=" << events
+            << " expired=" << g_expired
+            << " wall=" << wall << "s"
+            << " events/s=" << (wall > 0 ? events / wall : 0)
+            << std::endl;
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodes = 100;
+  uint32_t attempts = 1000;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Number of nodes", nodes);
+  cmd.AddValue ("attempts", "Handshake attempts per node", attempts);
+  cmd.Parse (argc, argv);
+
+  Run<TimerNode> ("Timer     ", nodes, attempts);
+  Run<QueueNode> ("TimerQueue", nodes, attempts);
+
+  return 0;
+}
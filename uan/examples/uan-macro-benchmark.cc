@@ -0,0 +1,593 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file uan-macro-benchmark.cc
+ * \ingroup uan
+ *
+ * End-to-end benchmark scenarios.  Every node sends to one sink at
+ * exponential intervals, over:
+ *
+ *   aloha-cs     UanHelper, UanMacAlohaCs on UanPhyGen
+ *   cw           UanHelper, UanMacCw on UanPhyGen
+ *   fama-wakeup  UanWakeupHelper, FAMA over UanMacWakeup, with batteries
+ *   tlohi        UanWakeupHelper, T-Lohi over UanMacWakeupTlohi, with batteries
+ *   rc-gw        UanHelper, UanMacRc nodes and a UanMacRcGw gateway on UanPhyDual
+ *
+ * The wakeup scenarios use the topology and modes of
+ * scratch/simple-test-wakeup.cc, rc-gw those of uan-rc-example.cc.  Runs
+ * use 16 bit addresses, numbered from 0 (the sink) in every run.  For
+ * each scenario and node count the wall time, simulator events
+ * run, events per second, peak RSS and heap allocations per
+ * generated packet are reported, as Google Benchmark style JSON or as
+ * CSV:
+ *
+ *   ./waf --run "uan-macro-benchmark --Scenario=fama-wakeup --Nodes=50,200"
+ *
+ * The peak RSS is that of the process so far, so run one scenario per
+ * process when comparing memory.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/uan-module.h"
+#include "ns3/default-simulator-impl.h"
+
+#include <sys/resource.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("UanMacroBenchmark");
+
+/** Heap allocations made by the whole process. */
+static uint64_t g_allocations = 0;
+
+#if __cplusplus >= 201103L
+void *
+operator new (std::size_t size)
+#else
+void *
+operator new (std::size_t size) throw (std::bad_alloc)
+#endif
+{
+  g_allocations++;
+  void *p = std::malloc (size ? size : 1);
+  if (p == 0)
+    {
+      throw std::bad_alloc ();
+    }
+  return p;
+}
+
+void
+operator delete (void *p) throw ()
+{
+  std::free (p);
+}
+
+/**
+ * Event wrapper counting the invocations of the event it holds.
+ * Cancelled events are not invoked, so they are not counted.
+ */
+class UanCountingEvent : public EventImpl
+{
+public:
+  /**
+   * \param event Event to run; its reference is taken over.
+   * \param count Counter bumped when the event runs.
+   */
+  UanCountingEvent (EventImpl *event, uint64_t *count);
+  virtual ~UanCountingEvent ();
+
+protected:
+  virtual void Notify (void);
+
+private:
+  EventImpl *m_event;
+  uint64_t *m_count;
+};
+
+UanCountingEvent::UanCountingEvent (EventImpl *event, uint64_t *count)
+  : m_event (event),
+    m_count (count)
+{
+}
+
+UanCountingEvent::~UanCountingEvent ()
+{
+  m_event->Unref ();
+}
+
+void
+UanCountingEvent::Notify (void)
+{
+  (*m_count)++;
+  m_event->Invoke ();
+}
+
+/**
+ * Default scheduler that counts the events it runs, so the count does
+ * not depend on a Simulator::GetEventCount.  Each event is wrapped in a
+ * UanCountingEvent when scheduled.
+ */
+class UanCountingSimulatorImpl : public DefaultSimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+  UanCountingSimulatorImpl ();
+
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+
+  /** \return Events run since the simulator was created. */
+  uint64_t GetEvents (void) const;
+  /**
+   * \return Wrappers allocated since the simulator was created, one per
+   *   scheduled event, to keep them out of the allocation count.
+   */
+  uint64_t GetWrappers (void) const;
+
+private:
+  uint64_t m_events;
+  uint64_t m_wrappers;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (UanCountingSimulatorImpl);
+
+TypeId
+UanCountingSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanCountingSimulatorImpl")
+    .SetParent<DefaultSimulatorImpl> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanCountingSimulatorImpl> ()
+  ;
+  return tid;
+}
+
+UanCountingSimulatorImpl::UanCountingSimulatorImpl ()
+  : m_events (0),
+    m_wrappers (0)
+{
+}
+
+EventId
+UanCountingSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  m_wrappers++;
+  return DefaultSimulatorImpl::Schedule (delay, new UanCountingEvent (event, &m_events));
+}
+
+void
+UanCountingSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  m_wrappers++;
+  DefaultSimulatorImpl::ScheduleWithContext (context, delay, new UanCountingEvent (event, &m_events));
+}
+
+EventId
+UanCountingSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  m_wrappers++;
+  return DefaultSimulatorImpl::ScheduleNow (new UanCountingEvent (event, &m_events));
+}
+
+uint64_t
+UanCountingSimulatorImpl::GetEvents (void) const
+{
+  return m_events;
+}
+
+uint64_t
+UanCountingSimulatorImpl::GetWrappers (void) const
+{
+  return m_wrappers;
+}
+
+namespace {
+
+struct Result
+{
+  std::string name;
+  double simTime;
+  double wallTime;
+  uint64_t events;
+  long peakRssKb;
+  uint64_t generated;
+  uint64_t received;
+  double allocationsPerPacket;
+};
+
+uint64_t g_generated = 0;
+uint64_t g_received = 0;
+
+void
+Send (Ptr<NetDevice> dev, Address dst, Ptr<ExponentialRandomVariable> interval, uint32_t size)
+{
+  dev->Send (Create<Packet> (size), dst, 0);
+  g_generated++;
+  Simulator::Schedule (Seconds (interval->GetValue ()), &Send, dev, dst, interval, size);
+}
+
+void
+SinkRx (Ptr<const Packet> pkt, UanAddress src)
+{
+  g_received++;
+}
+
+/** Sink in the middle of the surface, nodes spread below it, as in simple-test-wakeup. */
+void
+PlaceSquare (NodeContainer sink, NodeContainer nodes, double boundary)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  Ptr<ListPositionAllocator> pos = CreateObject<ListPositionAllocator> ();
+  pos->Add (Vector (boundary / 2.0, boundary / 2.0, 1));
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      pos->Add (Vector (rand->GetValue (0, boundary), rand->GetValue (0, boundary), 70));
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (pos);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (sink);
+  mobility.Install (nodes);
+}
+
+/** Gateway in the middle of a disc of nodes, as in uan-rc-example. */
+void
+PlaceDisc (NodeContainer sink, NodeContainer nodes, double maxRange)
+{
+  Ptr<UniformRandomVariable> urv = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> utheta = CreateObject<UniformRandomVariable> ();
+  Ptr<ListPositionAllocator> pos = CreateObject<ListPositionAllocator> ();
+  pos->Add (Vector (maxRange, maxRange, 70));
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      double theta = utheta->GetValue (0, 2.0 * M_PI);
+      double r = urv->GetValue (0, maxRange);
+      pos->Add (Vector (maxRange + r * std::cos (theta), maxRange + r * std::sin (theta), 70));
+    }
+  MobilityHelper mobility;
+  mobility.SetPositionAllocator (pos);
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.Install (sink);
+  mobility.Install (nodes);
+}
+
+/** Install a scenario, sink device first, and return its packet size. */
+typedef uint32_t (*Setup)(NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel,
+                          NetDeviceContainer &devices);
+
+uint32_t
+SetupUanHelper (std::string mac, NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel,
+                NetDeviceContainer &devices)
+{
+  UanHelper uan;
+  uan.SetMac (mac);
+  devices.Add (uan.Install (sink, channel));
+  devices.Add (uan.Install (nodes, channel));
+  PlaceSquare (sink, nodes, 500);
+  return 23;
+}
+
+uint32_t
+SetupAlohaCs (NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel, NetDeviceContainer &devices)
+{
+  return SetupUanHelper ("ns3::UanMacAlohaCs", sink, nodes, channel, devices);
+}
+
+uint32_t
+SetupCw (NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel, NetDeviceContainer &devices)
+{
+  return SetupUanHelper ("ns3::UanMacCw", sink, nodes, channel, devices);
+}
+
+uint32_t
+SetupWakeup (std::string mac, NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel,
+             NetDeviceContainer &devices)
+{
+  UanModesList modes;
+  modes.AppendMode (UanTxModeFactory::CreateMode (UanTxMode::FSK, 1000, 1000, 12000, 1000, 2,
+                                                  "Default mode"));
+  UanWakeupHelper uan;
+  uan.SetMac (mac);
+  uan.SetPhy ("PerModel", PointerValue (CreateObject<UanPhyPerGenDefault> ()),
+              "DataModes", UanModesListValue (modes));
+
+  // The energy models are installed on the node batteries
+  NodeContainer all (sink, nodes);
+  for (uint32_t i = 0; i < all.GetN (); i++)
+    {
+      Ptr<UanBatteryEnergySource> battery = CreateObject<UanBatteryEnergySource> ();
+      battery->SetInitialEnergy (1e9);
+      battery->SetNode (all.Get (i));
+      all.Get (i)->AggregateObject (battery);
+    }
+  devices.Add (uan.Install (all, channel));
+  PlaceSquare (sink, nodes, 500);
+  return 23;
+}
+
+uint32_t
+SetupFamaWakeup (NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel, NetDeviceContainer &devices)
+{
+  return SetupWakeup ("ns3::UanMacFama", sink, nodes, channel, devices);
+}
+
+uint32_t
+SetupTlohi (NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel, NetDeviceContainer &devices)
+{
+  return SetupWakeup ("ns3::UanMacTlohi", sink, nodes, channel, devices);
+}
+
+/** Modes of uan-rc-example: numRates slices of totalRate Hz around fc. */
+UanTxMode
+CreateRcMode (uint32_t kass, uint32_t fc, bool upperblock, std::string name,
+              uint32_t numRates, uint32_t totalRate)
+{
+  std::ostringstream buf;
+  buf << name << " " << kass;
+
+  uint32_t rate = totalRate / (numRates + 1) * kass;
+  uint32_t bw = kass * totalRate / (numRates + 1);
+  uint32_t fcmode;
+  if (upperblock)
+    {
+      fcmode = (totalRate - bw) / 2 + fc;
+    }
+  else
+    {
+      fcmode = (uint32_t)((-((double) totalRate) + (double) bw) / 2.0 + (double) fc);
+    }
+  return UanTxModeFactory::CreateMode (UanTxMode::OTHER, rate, totalRate, fcmode, bw, 2, buf.str ());
+}
+
+uint32_t
+SetupRcGw (NodeContainer sink, NodeContainer nodes, Ptr<UanChannel> channel, NetDeviceContainer &devices)
+{
+  uint32_t numRates = 1023;
+  uint32_t totalRate = 4096;
+  double maxRange = 3000;
+  uint32_t pktSize = 1000;
+
+  UanModesList controlModes;
+  UanModesList dataModes;
+  for (uint32_t i = 1; i < numRates + 1; i++)
+    {
+      controlModes.AppendMode (CreateRcMode (i, 12000, false, "control ", numRates, totalRate));
+    }
+  for (uint32_t i = numRates; i > 0; i--)
+    {
+      dataModes.AppendMode (CreateRcMode (i, 12000, true, "data ", numRates, totalRate));
+    }
+  Time pDelay = Seconds (maxRange / 1500.0);
+
+  UanHelper uan;
+  uan.SetPhy ("ns3::UanPhyDual",
+              "SupportedModesPhy1", UanModesListValue (dataModes),
+              "SupportedModesPhy2", UanModesListValue (controlModes));
+  uan.SetMac ("ns3::UanMacRcGw",
+              "NumberOfRates", UintegerValue (numRates),
+              "NumberOfNodes", UintegerValue (nodes.GetN ()),
+              "MaxReservations", UintegerValue (0),
+              "SIFS", TimeValue (Seconds (0.05)),
+              "MaxPropDelay", TimeValue (pDelay),
+              "FrameSize", UintegerValue (pktSize));
+  devices.Add (uan.Install (sink, channel));
+  uan.SetMac ("ns3::UanMacRc",
+              "NumberOfRates", UintegerValue (numRates),
+              "MaxPropDelay", TimeValue (pDelay));
+  devices.Add (uan.Install (nodes, channel));
+  PlaceDisc (sink, nodes, maxRange);
+  return pktSize;
+}
+
+long
+GetPeakRssKb (void)
+{
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+Result
+RunScenario (std::string name, Setup setup, uint32_t numNodes, Time simTime, double interval)
+{
+  RngSeedManager::SetRun (1);
+  g_generated = 0;
+  g_received = 0;
+  // Up to 1001 devices.  Width and numbering are reset by the
+  // Simulator::Destroy of the previous run.
+  UanAddress::SetWidth (2);
+
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  channel->SetPropagationModel (CreateObject<UanPropModelIdeal> ());
+  channel->SetNoiseModel (CreateObject<UanNoiseModelDefault> ());
+
+  NodeContainer sink;
+  sink.Create (1);
+  NodeContainer nodes;
+  nodes.Create (numNodes);
+  NetDeviceContainer devices;
+  uint32_t size = setup (sink, nodes, channel, devices);
+  NS_ABORT_MSG_UNLESS (UanAddress::ConvertFrom (devices.Get (0)->GetAddress ()).GetAsInt () == 0,
+                       "Sink not numbered first, addresses carried over from a previous run");
+
+  devices.Get (0)->TraceConnectWithoutContext ("Rx", MakeCallback (&SinkRx));
+  Address dst = devices.Get (0)->GetAddress ();
+  Ptr<UniformRandomVariable> start = CreateObject<UniformRandomVariable> ();
+  for (uint32_t i = 1; i < devices.GetN (); i++)
+    {
+      Ptr<ExponentialRandomVariable> next = CreateObject<ExponentialRandomVariable> ();
+      next->SetAttribute ("Mean", DoubleValue (interval));
+      Simulator::Schedule (Seconds (start->GetValue (0, interval)), &Send, devices.Get (i), dst, next, size);
+    }
+
+  Simulator::Stop (simTime);
+  Ptr<UanCountingSimulatorImpl> impl = DynamicCast<UanCountingSimulatorImpl> (Simulator::GetImplementation ());
+  uint64_t allocations = g_allocations + impl->GetWrappers ();
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t ms = clock.End ();
+  allocations = g_allocations - impl->GetWrappers () - allocations;
+
+  std::ostringstream label;
+  label << name << "/" << numNodes;
+  Result result;
+  result.name = label.str ();
+  result.simTime = simTime.GetSeconds ();
+  result.wallTime = ms / 1000.0;
+  result.events = impl->GetEvents ();
+  result.generated = g_generated;
+  result.received = g_received;
+  result.allocationsPerPacket = g_generated > 0 ? double (allocations) / g_generated : 0;
+  Simulator::Destroy ();
+  result.peakRssKb = GetPeakRssKb ();
+  return result;
+}
+
+void
+PrintJson (std::ostream &os, const std::vector<Result> &results)
+{
+  os << "{\n"
+     << "  \"context\": {\n"
+     << "    \"executable\": \"uan-macro-benchmark\"\n"
+     << "  },\n"
+     << "  \"benchmarks\": [\n";
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      const Result &r = results[i];
+      os << "    {\n"
+         << "      \"name\": \"" << r.name << "\",\n"
+         << "      \"iterations\": 1,\n"
+         << "      \"real_time\": " << r.wallTime << ",\n"
+         << "      \"time_unit\": \"s\",\n"
+         << "      \"sim_time\": " << r.simTime << ",\n"
+         << "      \"events\": " << r.events << ",\n"
+         << "      \"events_per_second\": " << (r.wallTime > 0 ? r.events / r.wallTime : 0) << ",\n"
+         << "      \"peak_rss_kb\": " << r.peakRssKb << ",\n"
+         << "      \"packets_generated\": " << r.generated << ",\n"
+         << "      \"packets_received\": " << r.received << ",\n"
+         << "      \"allocations_per_packet\": " << r.allocationsPerPacket << "\n"
+         << "    }" << (i + 1 < results.size () ? "," : "") << "\n";
+    }
+  os << "  ]\n"
+     << "}\n";
+}
+
+void
+PrintCsv (std::ostream &os, const std::vector<Result> &results)
+{
+  os << "name,sim_time_s,wall_time_s,events,events_per_s,peak_rss_kb,"
+     << "packets_generated,packets_received,allocations_per_packet" << std::endl;
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      const Result &r = results[i];
+      os << r.name << "," << r.simTime << "," << r.wallTime << "," << r.events << ","
+         << (r.wallTime > 0 ? r.events / r.wallTime : 0) << "," << r.peakRssKb << ","
+         << r.generated << "," << r.received << "," << r.allocationsPerPacket << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string scenario = "all";
+  std::string nodeList = "50,200,1000";
+  Time simTime = Seconds (600);
+  double interval = 60;
+  std::string output;
+  std::string format = "json";
+
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::UanCountingSimulatorImpl"));
+
+  CommandLine cmd;
+  cmd.AddValue ("Scenario", "aloha-cs, cw, fama-wakeup, tlohi, rc-gw or all", scenario);
+  cmd.AddValue ("Nodes", "Comma separated node counts", nodeList);
+  cmd.AddValue ("SimTime", "Simulated time of each run", simTime);
+  cmd.AddValue ("Interval", "Mean time between packets of a node, in s", interval);
+  cmd.AddValue ("Output", "Output file, stdout if empty", output);
+  cmd.AddValue ("Format", "json or csv", format);
+  cmd.Parse (argc, argv);
+
+  if (format != "json" && format != "csv")
+    {
+      std::cerr << "Unknown format " << format << std::endl;
+      return 1;
+    }
+
+  std::vector<uint32_t> counts;
+  std::istringstream list (nodeList);
+  std::string item;
+  while (std::getline (list, item, ','))
+    {
+      counts.push_back (std::atoi (item.c_str ()));
+    }
+
+  const char *names[] = { "aloha-cs", "cw", "fama-wakeup", "tlohi", "rc-gw" };
+  Setup setups[] = { &SetupAlohaCs, &SetupCw, &SetupFamaWakeup, &SetupTlohi, &SetupRcGw };
+
+  std::vector<Result> results;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      if (scenario != "all" && scenario != names[i])
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < counts.size (); j++)
+        {
+          results.push_back (RunScenario (names[i], setups[i], counts[j], simTime, interval));
+          NS_LOG_INFO (results.back ().name << " " << results.back ().wallTime << " s, "
+                                            << results.back ().events << " events");
+        }
+    }
+  if (results.empty ())
+    {
+      std::cerr << "Unknown scenario " << scenario << std::endl;
+      return 1;
+    }
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+  if (format == "json")
+    {
+      PrintJson (os, results);
+    }
+  else
+    {
+      PrintCsv (os, results);
+    }
+  return 0;
+}
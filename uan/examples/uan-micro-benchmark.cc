@@ -0,0 +1,479 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file uan-micro-benchmark.cc
+ * \ingroup uan
+ *
+ * Micro-benchmarks of the UAN hot paths: channel fan-out, PHY reception
+ * under concurrent arrivals, the SINR and PER models, PDP sums, header
+ * (de)serialization, UanTxMode getters and UanWakeupHelper installs.
+ *
+ * Each benchmark doubles its iteration count until a run takes MinTime,
+ * then reports the wall clock time per iteration.  Results go out as
+ * JSON in the layout of Google Benchmark, or as CSV, so they can be
+ * compared across commits:
+ *
+ *   ./waf --run "uan-micro-benchmark --Format=json --Output=uan-bench.json"
+ *   ./waf --run "uan-micro-benchmark --Filter=Sinr"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/uan-module.h"
+#include "ns3/energy-module.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+/** Runs the given number of iterations, returns the wall clock ms they took. */
+typedef Callback<int64_t, uint64_t> Benchmark;
+
+struct Result
+{
+  std::string name;
+  uint64_t iterations;
+  double nsPerIteration;
+};
+
+/** Keeps the compiler from dropping the benchmarked calls. */
+volatile double g_sink;
+
+Result
+Measure (std::string name, Benchmark benchmark, int64_t minTimeMs)
+{
+  uint64_t n = 1;
+  int64_t ms = 0;
+  while (true)
+    {
+      ms = benchmark (n);
+      if (ms >= minTimeMs || n >= (1ULL << 32))
+        {
+          break;
+        }
+      // Aim past minTimeMs, but at most grow tenfold per round
+      uint64_t next = ms > 0 ? (uint64_t) (n * 1.4 * minTimeMs / ms) : n * 10;
+      n = std::min (std::max (next, n * 2), n * 10);
+    }
+  Result result;
+  result.name = name;
+  result.iterations = n;
+  result.nsPerIteration = ms * 1e6 / n;
+  return result;
+}
+
+Ptr<UanChannel>
+CreateChannel (void)
+{
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  channel->SetPropagationModel (CreateObject<UanPropModelIdeal> ());
+  channel->SetNoiseModel (CreateObject<UanNoiseModelDefault> ());
+  return channel;
+}
+
+/** Install UanHelper devices on nodes, node 0 in the middle of a ring of the others. */
+NetDeviceContainer
+CreateNodes (uint32_t nodes, Ptr<UanChannel> channel)
+{
+  NodeContainer c;
+  c.Create (nodes);
+  for (uint32_t i = 0; i < nodes; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      double angle = 2 * M_PI * i / nodes;
+      double radius = i == 0 ? 0 : 500;
+      mobility->SetPosition (Vector (radius * std::cos (angle), radius * std::sin (angle), 50));
+      c.Get (i)->AggregateObject (mobility);
+    }
+  UanHelper uan;
+  return uan.Install (c, channel);
+}
+
+/** Node 0 transmits n packets, each reaching every other node. */
+int64_t
+BenchChannelTx (uint32_t nodes, uint64_t n)
+{
+  Ptr<UanChannel> channel = CreateChannel ();
+  NetDeviceContainer devices = CreateNodes (nodes, channel);
+  Ptr<UanNetDevice> src = DynamicCast<UanNetDevice> (devices.Get (0));
+  UanTxMode mode = src->GetPhy ()->GetMode (0);
+  Ptr<Packet> pkt = Create<Packet> (32);
+  for (uint64_t i = 0; i < n; i++)
+    {
+      Simulator::Schedule (Seconds (10 * i), &UanChannel::TxPacket, channel,
+                           src->GetTransducer (), pkt, 190.0, mode);
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t ms = clock.End ();
+  Simulator::Destroy ();
+  return ms;
+}
+
+/** All but node 0 transmit at once, so each PHY sees that many arrivals overlap. */
+int64_t
+BenchPhyRx (uint32_t arrivals, uint64_t n)
+{
+  Ptr<UanChannel> channel = CreateChannel ();
+  NetDeviceContainer devices = CreateNodes (arrivals + 1, channel);
+  UanTxMode mode = DynamicCast<UanNetDevice> (devices.Get (0))->GetPhy ()->GetMode (0);
+  Ptr<Packet> pkt = Create<Packet> (32);
+  for (uint64_t i = 0; i < n; i++)
+    {
+      for (uint32_t j = 1; j <= arrivals; j++)
+        {
+          Ptr<UanNetDevice> src = DynamicCast<UanNetDevice> (devices.Get (j));
+          Simulator::Schedule (Seconds (10 * i), &UanChannel::TxPacket, channel,
+                               src->GetTransducer (), pkt, 190.0, mode);
+        }
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t ms = clock.End ();
+  Simulator::Destroy ();
+  return ms;
+}
+
+/** Install the wakeup stack with energy models on a topology of that many nodes. */
+int64_t
+BenchWakeupInstall (uint32_t nodes, uint64_t n)
+{
+  UanWakeupHelper helper;
+  BasicEnergySourceHelper energy;
+  int64_t ms = 0;
+  // Each batch stays within the 16 bit address space of one run
+  uint64_t batch = std::max<uint64_t> (1, 60000 / nodes);
+  for (uint64_t done = 0; done < n; done += batch)
+    {
+      UanAddress::SetWidth (2);
+      Ptr<UanChannel> channel = CreateChannel ();
+      uint64_t runs = std::min (batch, n - done);
+      std::vector<NodeContainer> topologies (runs);
+      for (uint64_t i = 0; i < runs; i++)
+        {
+          topologies[i].Create (nodes);
+          for (uint32_t j = 0; j < nodes; j++)
+            {
+              topologies[i].Get (j)->AggregateObject (CreateObject<ConstantPositionMobilityModel> ());
+            }
+          energy.Install (topologies[i]);
+        }
+
+      SystemWallClockMs clock;
+      clock.Start ();
+      for (uint64_t i = 0; i < runs; i++)
+        {
+          helper.Install (topologies[i], channel);
+        }
+      ms += clock.End ();
+      Simulator::Destroy ();
+    }
+  return ms;
+}
+
+UanTxMode
+GetFskMode (void)
+{
+  return UanTxModeFactory::CreateMode (UanTxMode::FSK, 80, 80, 22000, 4000, 13, "FSK");
+}
+
+UanPdp
+CreatePdp (uint32_t taps)
+{
+  std::vector<double> amps;
+  for (uint32_t i = 0; i < taps; i++)
+    {
+      amps.push_back (1.0 / (1 + i));
+    }
+  return UanPdp (amps, MilliSeconds (1));
+}
+
+/** One SINR computation against interferers overlapping arrivals. */
+int64_t
+BenchSinr (Ptr<UanPhyCalcSinr> sinr, uint32_t interferers, uint64_t n)
+{
+  UanTxMode mode = GetFskMode ();
+  UanPdp pdp = CreatePdp (10);
+  Ptr<Packet> pkt = Create<Packet> (32);
+  UanTransducer::ArrivalList arrivals;
+  arrivals.push_back (UanPacketArrival (pkt, 100, mode, pdp, Seconds (0)));
+  for (uint32_t i = 0; i < interferers; i++)
+    {
+      arrivals.push_back (UanPacketArrival (Create<Packet> (32), 80, mode, pdp, MilliSeconds (i)));
+    }
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  double sum = 0;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      sum += sinr->CalcSinrDb (pkt, Seconds (0), 100, 60, mode, pdp, arrivals);
+    }
+  int64_t ms = clock.End ();
+  g_sink = sum;
+  return ms;
+}
+
+int64_t
+BenchPer (Ptr<UanPhyPer> per, uint64_t n)
+{
+  UanTxMode mode = GetFskMode ();
+  Ptr<Packet> pkt = Create<Packet> (32);
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  double sum = 0;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      // Sweep the waterfall region
+      sum += per->CalcPer (pkt, (i % 20) * 0.5, mode);
+    }
+  int64_t ms = clock.End ();
+  g_sink = sum;
+  return ms;
+}
+
+enum PdpSum { SUM_NC, SUM_C, SUM_FROM_MAX_NC };
+
+int64_t
+BenchPdp (uint32_t kind, uint32_t taps, uint64_t n)
+{
+  UanPdp pdp = CreatePdp (taps);
+  Time end = MilliSeconds (taps);
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  double sum = 0;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      switch (kind)
+        {
+        case SUM_NC:
+          sum += pdp.SumTapsNc (Seconds (0), end);
+          break;
+        case SUM_C:
+          sum += std::abs (pdp.SumTapsC (Seconds (0), end));
+          break;
+        default:
+          sum += pdp.SumTapsFromMaxNc (Seconds (0), end);
+          break;
+        }
+    }
+  int64_t ms = clock.End ();
+  g_sink = sum;
+  return ms;
+}
+
+/** Add and remove header from a packet. */
+template <class H>
+int64_t
+BenchHeader (H header, uint64_t n)
+{
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint32_t size = 0;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> pkt = Create<Packet> (32);
+      pkt->AddHeader (header);
+      H copy;
+      pkt->RemoveHeader (copy);
+      size += pkt->GetSize ();
+    }
+  int64_t ms = clock.End ();
+  g_sink = size;
+  return ms;
+}
+
+int64_t
+BenchTxMode (uint64_t n)
+{
+  UanTxMode mode = GetFskMode ();
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  uint64_t sum = 0;
+  for (uint64_t i = 0; i < n; i++)
+    {
+      sum += mode.GetDataRateBps () + mode.GetPhyRateSps () + mode.GetCenterFreqHz ()
+        + mode.GetBandwidthHz () + mode.GetConstellationSize () + mode.GetUid ()
+        + mode.GetModType ();
+    }
+  int64_t ms = clock.End ();
+  g_sink = sum;
+  return ms;
+}
+
+void
+PrintJson (std::ostream &os, const std::vector<Result> &results, int64_t minTimeMs)
+{
+  os << "{\n"
+     << "  \"context\": {\n"
+     << "    \"executable\": \"uan-micro-benchmark\",\n"
+     << "    \"min_time_ms\": " << minTimeMs << "\n"
+     << "  },\n"
+     << "  \"benchmarks\": [\n";
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      os << "    {\n"
+         << "      \"name\": \"" << results[i].name << "\",\n"
+         << "      \"iterations\": " << results[i].iterations << ",\n"
+         << "      \"real_time\": " << results[i].nsPerIteration << ",\n"
+         << "      \"time_unit\": \"ns\"\n"
+         << "    }" << (i + 1 < results.size () ? "," : "") << "\n";
+    }
+  os << "  ]\n"
+     << "}\n";
+}
+
+void
+PrintCsv (std::ostream &os, const std::vector<Result> &results)
+{
+  os << "name,iterations,real_time,time_unit" << std::endl;
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      os << results[i].name << "," << results[i].iterations << ","
+         << results[i].nsPerIteration << ",ns" << std::endl;
+    }
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string output;
+  std::string format = "json";
+  std::string filter;
+  int64_t minTimeMs = 200;
+
+  CommandLine cmd;
+  cmd.AddValue ("Output", "Output file, stdout if empty", output);
+  cmd.AddValue ("Format", "json or csv", format);
+  cmd.AddValue ("Filter", "Only run benchmarks whose name contains this", filter);
+  cmd.AddValue ("MinTime", "Minimum run time of each benchmark, in ms", minTimeMs);
+  cmd.Parse (argc, argv);
+
+  if (format != "json" && format != "csv")
+    {
+      std::cerr << "Unknown format " << format << std::endl;
+      return 1;
+    }
+
+  std::vector<std::pair<std::string, Benchmark> > benchmarks;
+  uint32_t nodes[] = { 2, 8, 32, 128 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      std::ostringstream name;
+      name << "BM_ChannelTxPacket/" << nodes[i];
+      benchmarks.push_back (std::make_pair (name.str (), MakeBoundCallback (&BenchChannelTx, nodes[i])));
+    }
+  uint32_t installs[] = { 50, 200, 1000 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      std::ostringstream name;
+      name << "BM_UanWakeupHelperInstall/" << installs[i];
+      benchmarks.push_back (std::make_pair (name.str (), MakeBoundCallback (&BenchWakeupInstall, installs[i])));
+    }
+  uint32_t arrivals[] = { 1, 4, 16, 64 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      std::ostringstream name;
+      name << "BM_PhyGenStartRxPacket/" << arrivals[i];
+      benchmarks.push_back (std::make_pair (name.str (), MakeBoundCallback (&BenchPhyRx, arrivals[i])));
+    }
+  const char *sinrNames[] = { "Default", "FhFsk", "Dual", "DualPw" };
+  Ptr<UanPhyCalcSinr> sinrs[] = { CreateObject<UanPhyCalcSinrDefault> (),
+                                  CreateObject<UanPhyCalcSinrFhFsk> (),
+                                  CreateObject<UanPhyCalcSinrDual> (),
+                                  CreateObject<UanPhyCalcSinrDualPw> () };
+  uint32_t interferers[] = { 0, 8, 64 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          std::ostringstream name;
+          name << "BM_UanPhyCalcSinr" << sinrNames[i] << "/" << interferers[j];
+          benchmarks.push_back (std::make_pair (name.str (), MakeBoundCallback (&BenchSinr, sinrs[i], interferers[j])));
+        }
+    }
+  benchmarks.push_back (std::make_pair (std::string ("BM_UanPhyPerGenDefault"),
+                                        MakeBoundCallback (&BenchPer, Ptr<UanPhyPer> (CreateObject<UanPhyPerGenDefault> ()))));
+  benchmarks.push_back (std::make_pair (std::string ("BM_UanPhyPerUmodem"),
+                                        MakeBoundCallback (&BenchPer, Ptr<UanPhyPer> (CreateObject<UanPhyPerUmodem> ()))));
+  const char *pdpNames[] = { "SumTapsNc", "SumTapsC", "SumTapsFromMaxNc" };
+  uint32_t taps[] = { 8, 64, 512 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      for (uint32_t j = 0; j < 3; j++)
+        {
+          std::ostringstream name;
+          name << "BM_UanPdp" << pdpNames[i] << "/" << taps[j];
+          benchmarks.push_back (std::make_pair (name.str (), MakeBoundCallback (&BenchPdp, i, taps[j])));
+        }
+    }
+  benchmarks.push_back (std::make_pair (std::string ("BM_UanHeaderCommon"),
+                                        MakeBoundCallback (&BenchHeader<UanHeaderCommon>,
+                                                           UanHeaderCommon (UanAddress (1), UanAddress (2), 0))));
+  benchmarks.push_back (std::make_pair (std::string ("BM_UanHeaderWakeup"),
+                                        MakeBoundCallback (&BenchHeader<UanHeaderWakeup>, UanHeaderWakeup (2))));
+  benchmarks.push_back (std::make_pair (std::string ("BM_UanHeaderRcData"),
+                                        MakeBoundCallback (&BenchHeader<UanHeaderRcData>,
+                                                           UanHeaderRcData (1, MilliSeconds (300)))));
+  benchmarks.push_back (std::make_pair (std::string ("BM_UanTxModeGetters"), MakeCallback (&BenchTxMode)));
+
+  std::vector<Result> results;
+  for (uint32_t i = 0; i < benchmarks.size (); i++)
+    {
+      if (benchmarks[i].first.find (filter) == std::string::npos)
+        {
+          continue;
+        }
+      results.push_back (Measure (benchmarks[i].first, benchmarks[i].second, minTimeMs));
+      std::cerr << results.back ().name << " " << results.back ().nsPerIteration << " ns" << std::endl;
+    }
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+  if (format == "json")
+    {
+      PrintJson (os, results, minTimeMs);
+    }
+  else
+    {
+      PrintCsv (os, results);
+    }
+  return 0;
+}
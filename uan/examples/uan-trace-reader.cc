@@ -0,0 +1,95 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/**
+ * \file uan-trace-reader.cc
+ * \ingroup uan
+ *
+ * Converts a binary trace written by UanHelper::EnableBinary to CSV or
+ * to the text format of UanHelper::EnableAscii.
+ *
+ *   ./waf --run "uan-trace-reader --Input=uan.bin --Format=csv --Output=uan.csv"
+ *
+ * Without Output the result goes to stdout.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/uan-binary-trace.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  std::string input;
+  std::string output;
+  std::string format = "csv";
+
+  CommandLine cmd;
+  cmd.AddValue ("Input", "Binary trace file", input);
+  cmd.AddValue ("Output", "Output file, stdout if empty", output);
+  cmd.AddValue ("Format", "csv or text", format);
+  cmd.Parse (argc, argv);
+
+  if (format != "csv" && format != "text")
+    {
+      std::cerr << "Unknown format " << format << std::endl;
+      return 1;
+    }
+
+  UanBinaryTraceReader reader;
+  if (!reader.Open (input))
+    {
+      std::cerr << "Cannot read " << input << std::endl;
+      return 1;
+    }
+
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      if (!file.is_open ())
+        {
+          std::cerr << "Cannot write " << output << std::endl;
+          return 1;
+        }
+    }
+  std::ostream &os = output.empty () ? std::cout : file;
+
+  if (format == "csv")
+    {
+      UanBinaryTraceReader::PrintCsvHeader (os);
+    }
+  UanTraceRecord record;
+  while (reader.Read (record))
+    {
+      if (format == "csv")
+        {
+          UanBinaryTraceReader::PrintCsv (record, os);
+        }
+      else
+        {
+          UanBinaryTraceReader::PrintText (record, os);
+        }
+    }
+
+  return 0;
+}
@@ -50,6 +50,22 @@ AcousticModemEnergyModelHelper::SetDepletionCallback (
   m_depletionCallback = callback;
 }
 
+std::vector<AcousticModemEnergyModel::Snapshot>
+AcousticModemEnergyModelHelper::GetSnapshots (DeviceEnergyModelContainer models)
+{
+  std::vector<AcousticModemEnergyModel::Snapshot> snapshots;
+  snapshots.reserve (models.GetN ());
+  for (DeviceEnergyModelContainer::Iterator i = models.Begin (); i != models.End (); ++i)
+    {
+      Ptr<AcousticModemEnergyModel> model = DynamicCast<AcousticModemEnergyModel> (*i);
+      if (model != 0)
+        {
+          snapshots.push_back (model->GetSnapshot ());
+        }
+    }
+  return snapshots;
+}
+
 /*
  * Private function starts here.
  */
@@ -78,6 +94,7 @@ AcousticModemEnergyModelHelper::DoInstall (Ptr<NetDevice> device,
   Ptr<UanPhy> uanPhy = uanDevice->GetPhy ();
   // set energy depletion callback
   model->SetEnergyDepletionCallback (m_depletionCallback);
+  model->SetPhy (uanPhy);
   // add model to device model list in energy source
   source->AppendDeviceEnergyModel (model);
   // set node pointer
@@ -22,8 +22,11 @@
 #define ACOUSTIC_MODEM_ENERGY_MODEL_HELPER_H
 
 #include "ns3/energy-model-helper.h"
+#include "ns3/device-energy-model-container.h"
 #include "ns3/acoustic-modem-energy-model.h"
 
+#include <vector>
+
 namespace ns3 {
 
 /**
@@ -63,6 +66,15 @@ public:
   void SetDepletionCallback (
     AcousticModemEnergyModel::AcousticModemEnergyDepletionCallback callback);
 
+  /**
+   * Read the per-state counters of every AcousticModemEnergyModel in
+   * models, up to now.  Other model types are skipped.
+   *
+   * \param models Energy models, e.g. as returned by Install.
+   * \return One snapshot per acoustic modem model, in container order.
+   */
+  static std::vector<AcousticModemEnergyModel::Snapshot> GetSnapshots (DeviceEnergyModelContainer models);
+
 
 private:
   /**
@@ -0,0 +1,320 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-binary-trace.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanBinaryTrace");
+
+NS_OBJECT_ENSURE_REGISTERED (UanBinaryTraceWriter);
+
+namespace {
+
+const char g_magic[4] = { 'U', 'A', 'N', 'B' };
+
+void
+PutU32 (uint8_t *p, uint32_t v)
+{
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+void
+PutU64 (uint8_t *p, uint64_t v)
+{
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      p[i] = (v >> (8 * i)) & 0xff;
+    }
+}
+
+uint32_t
+GetU32 (const uint8_t *p)
+{
+  uint32_t v = 0;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      v |= (uint32_t) p[i] << (8 * i);
+    }
+  return v;
+}
+
+uint64_t
+GetU64 (const uint8_t *p)
+{
+  uint64_t v = 0;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      v |= (uint64_t) p[i] << (8 * i);
+    }
+  return v;
+}
+
+const char *
+EventName (uint8_t event)
+{
+  switch (event)
+    {
+    case UanTraceRecord::TX:
+      return "tx";
+    case UanTraceRecord::RX_OK:
+      return "rx";
+    case UanTraceRecord::RX_ERROR:
+      return "rxerr";
+    default:
+      return "unknown";
+    }
+}
+
+} // anonymous namespace
+
+UanBinaryTraceWriter::UanBinaryTraceWriter ()
+  : m_bufferSize (1 << 20),
+    m_records (0)
+{
+}
+
+UanBinaryTraceWriter::~UanBinaryTraceWriter ()
+{
+  // Writers are usually held by the trace callbacks only
+  Close ();
+}
+
+TypeId
+UanBinaryTraceWriter::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanBinaryTraceWriter")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanBinaryTraceWriter> ()
+    .AddAttribute ("BufferSize",
+                   "Bytes of records held in memory between writes to the file.",
+                   UintegerValue (1 << 20),
+                   MakeUintegerAccessor (&UanBinaryTraceWriter::m_bufferSize),
+                   MakeUintegerChecker<uint32_t> (RECORD_SIZE))
+  ;
+  return tid;
+}
+
+void
+UanBinaryTraceWriter::DoDispose (void)
+{
+  Close ();
+  Object::DoDispose ();
+}
+
+bool
+UanBinaryTraceWriter::Open (std::string filename)
+{
+  Close ();
+  m_file.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open ())
+    {
+      NS_LOG_WARN ("Cannot open " << filename);
+      return false;
+    }
+  m_buffer.reserve (m_bufferSize + RECORD_SIZE);
+
+  uint8_t header[12];
+  std::memcpy (header, g_magic, 4);
+  PutU32 (header + 4, VERSION);
+  PutU32 (header + 8, RECORD_SIZE);
+  m_file.write ((const char *) header, sizeof (header));
+  m_records = 0;
+  return true;
+}
+
+void
+UanBinaryTraceWriter::Write (const UanTraceRecord &record)
+{
+  if (!m_file.is_open ())
+    {
+      return;
+    }
+
+  uint32_t pos = m_buffer.size ();
+  m_buffer.resize (pos + RECORD_SIZE);
+  uint8_t *p = &m_buffer[pos];
+  uint64_t sinr;
+  std::memcpy (&sinr, &record.sinr, sizeof (sinr));
+
+  PutU64 (p, record.time);
+  PutU32 (p + 8, record.node);
+  PutU32 (p + 12, record.device);
+  p[16] = record.event;
+  PutU32 (p + 17, record.size);
+  PutU64 (p + 21, sinr);
+  PutU32 (p + 29, record.mode);
+  m_records++;
+
+  if (m_buffer.size () >= m_bufferSize)
+    {
+      Flush ();
+    }
+}
+
+void
+UanBinaryTraceWriter::Flush (void)
+{
+  if (m_file.is_open () && !m_buffer.empty ())
+    {
+      m_file.write ((const char *) &m_buffer[0], m_buffer.size ());
+    }
+  m_buffer.clear ();
+}
+
+void
+UanBinaryTraceWriter::Close (void)
+{
+  if (m_file.is_open ())
+    {
+      Flush ();
+      m_file.close ();
+    }
+}
+
+uint64_t
+UanBinaryTraceWriter::GetRecords (void) const
+{
+  return m_records;
+}
+
+void
+UanBinaryTraceWriter::Record (uint8_t event, uint32_t node, uint32_t device,
+                              Ptr<const Packet> packet, double db, UanTxMode mode)
+{
+  UanTraceRecord record;
+  record.time = Simulator::Now ().GetNanoSeconds ();
+  record.node = node;
+  record.device = device;
+  record.event = event;
+  record.size = packet->GetSize ();
+  record.sinr = db;
+  record.mode = mode.GetUid ();
+  Write (record);
+}
+
+void
+UanBinaryTraceWriter::TxSink (Ptr<UanBinaryTraceWriter> writer, uint32_t node, uint32_t device,
+                              Ptr<const Packet> packet, double db, UanTxMode mode)
+{
+  writer->Record (UanTraceRecord::TX, node, device, packet, db, mode);
+}
+
+void
+UanBinaryTraceWriter::RxOkSink (Ptr<UanBinaryTraceWriter> writer, uint32_t node, uint32_t device,
+                                Ptr<const Packet> packet, double db, UanTxMode mode)
+{
+  writer->Record (UanTraceRecord::RX_OK, node, device, packet, db, mode);
+}
+
+void
+UanBinaryTraceWriter::RxErrorSink (Ptr<UanBinaryTraceWriter> writer, uint32_t node, uint32_t device,
+                                   Ptr<const Packet> packet, double db, UanTxMode mode)
+{
+  writer->Record (UanTraceRecord::RX_ERROR, node, device, packet, db, mode);
+}
+
+/*************** UanBinaryTraceReader definition *****************/
+UanBinaryTraceReader::UanBinaryTraceReader ()
+  : m_recordSize (0)
+{
+}
+
+bool
+UanBinaryTraceReader::Open (std::string filename)
+{
+  m_file.open (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+
+  uint8_t header[12];
+  if (!m_file.read ((char *) header, sizeof (header))
+      || std::memcmp (header, g_magic, 4) != 0)
+    {
+      NS_LOG_WARN (filename << " is not a UAN binary trace");
+      m_file.close ();
+      return false;
+    }
+  m_recordSize = GetU32 (header + 8);
+  if (GetU32 (header + 4) > UanBinaryTraceWriter::VERSION
+      || m_recordSize < UanBinaryTraceWriter::RECORD_SIZE)
+    {
+      NS_LOG_WARN (filename << " has an unsupported format version");
+      m_file.close ();
+      return false;
+    }
+  return true;
+}
+
+bool
+UanBinaryTraceReader::Read (UanTraceRecord &record)
+{
+  // Newer versions may only append fields
+  std::vector<uint8_t> buf (m_recordSize);
+  if (!m_file.is_open () || !m_file.read ((char *) &buf[0], m_recordSize))
+    {
+      return false;
+    }
+  const uint8_t *p = &buf[0];
+  uint64_t sinr = GetU64 (p + 21);
+
+  record.time = GetU64 (p);
+  record.node = GetU32 (p + 8);
+  record.device = GetU32 (p + 12);
+  record.event = p[16];
+  record.size = GetU32 (p + 17);
+  std::memcpy (&record.sinr, &sinr, sizeof (sinr));
+  record.mode = GetU32 (p + 29);
+  return true;
+}
+
+void
+UanBinaryTraceReader::PrintCsvHeader (std::ostream &os)
+{
+  os << "time_ns,node,device,event,size,db,mode\n";
+}
+
+void
+UanBinaryTraceReader::PrintCsv (const UanTraceRecord &record, std::ostream &os)
+{
+  os << record.time << "," << record.node << "," << record.device << ","
+     << EventName (record.event) << "," << record.size << "," << record.sinr << ","
+     << record.mode << "\n";
+}
+
+void
+UanBinaryTraceReader::PrintText (const UanTraceRecord &record, std::ostream &os)
+{
+  char c = record.event == UanTraceRecord::TX ? '+' : record.event == UanTraceRecord::RX_OK ? 'r' : 'd';
+  os << c << " " << NanoSeconds (record.time).GetSeconds ()
+     << " /NodeList/" << record.node << "/DeviceList/" << record.device
+     << " size=" << record.size << " db=" << record.sinr << " mode=" << record.mode << "\n";
+}
+
+} // namespace ns3
@@ -0,0 +1,161 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_BINARY_TRACE_H
+#define UAN_BINARY_TRACE_H
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/uan-tx-mode.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * One PHY event of a binary UAN trace.
+ */
+struct UanTraceRecord
+{
+  /** Event kinds. */
+  enum EventType
+  {
+    TX = 0,
+    RX_OK = 1,
+    RX_ERROR = 2
+  };
+
+  int64_t time;       //!< Simulation time, ns.
+  uint32_t node;      //!< Node id.
+  uint32_t device;    //!< Device index on the node.
+  uint8_t event;      //!< EventType.
+  uint32_t size;      //!< Packet size, bytes.
+  double sinr;        //!< SINR (dB) for receptions, tx power (dB) for transmissions.
+  uint32_t mode;      //!< UanTxMode uid.
+};
+
+/**
+ * \ingroup uan
+ *
+ * Writes PHY Tx/RxOk/RxError events as fixed-size little-endian records.
+ *
+ * The file starts with the magic "UANB", a format version and the record
+ * size, all 32 bit.  Records are staged in a memory buffer and written
+ * in one call when it fills, so tracing costs one copy per event and one
+ * write per BufferSize bytes.  No packet printing is involved.  Call
+ * Close after Simulator::Run; the destructor flushes as a fallback.
+ */
+class UanBinaryTraceWriter : public Object
+{
+public:
+  /** Size of a record in the file. */
+  static const uint32_t RECORD_SIZE = 33;
+  /** Current file format version. */
+  static const uint32_t VERSION = 1;
+
+  UanBinaryTraceWriter ();
+  virtual ~UanBinaryTraceWriter ();
+  static TypeId GetTypeId (void);
+
+  /**
+   * Create or truncate filename and write the file header.
+   * \param filename Output file.
+   * \return False if the file could not be opened.
+   */
+  bool Open (std::string filename);
+  /** Append one record. */
+  void Write (const UanTraceRecord &record);
+  /** Write the buffered records to the file. */
+  void Flush (void);
+  /** Flush and close the file. */
+  void Close (void);
+  /** \return Number of records written so far. */
+  uint64_t GetRecords (void) const;
+
+  /**
+   * Trace sinks for the UanPhy Tx, RxOk and RxError sources.
+   *
+   * \param writer The writer.
+   * \param node Node id.
+   * \param device Device index.
+   * \param packet The packet.
+   * \param db SINR or tx power.
+   * \param mode The mode.
+   */
+  static void TxSink (Ptr<UanBinaryTraceWriter> writer, uint32_t node, uint32_t device,
+                      Ptr<const Packet> packet, double db, UanTxMode mode);
+  /** \copydoc TxSink */
+  static void RxOkSink (Ptr<UanBinaryTraceWriter> writer, uint32_t node, uint32_t device,
+                        Ptr<const Packet> packet, double db, UanTxMode mode);
+  /** \copydoc TxSink */
+  static void RxErrorSink (Ptr<UanBinaryTraceWriter> writer, uint32_t node, uint32_t device,
+                           Ptr<const Packet> packet, double db, UanTxMode mode);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void Record (uint8_t event, uint32_t node, uint32_t device,
+               Ptr<const Packet> packet, double db, UanTxMode mode);
+
+  std::ofstream m_file;
+  std::vector<uint8_t> m_buffer;  //!< Records not yet written.
+  uint32_t m_bufferSize;          //!< Flush threshold, bytes.
+  uint64_t m_records;
+};
+
+/**
+ * \ingroup uan
+ *
+ * Reads back a file written by UanBinaryTraceWriter.
+ */
+class UanBinaryTraceReader
+{
+public:
+  UanBinaryTraceReader ();
+
+  /**
+   * \param filename Trace file.
+   * \return False if the file cannot be opened or has a bad header.
+   */
+  bool Open (std::string filename);
+  /**
+   * \param record Filled with the next record.
+   * \return False at the end of the file.
+   */
+  bool Read (UanTraceRecord &record);
+
+  /** Write the CSV column names. */
+  static void PrintCsvHeader (std::ostream &os);
+  /** Write record as one CSV line. */
+  static void PrintCsv (const UanTraceRecord &record, std::ostream &os);
+  /** Write record in the format of UanHelper::EnableAscii, without packet contents. */
+  static void PrintText (const UanTraceRecord &record, std::ostream &os);
+
+private:
+  std::ifstream m_file;
+  uint32_t m_recordSize;
+};
+
+} // namespace ns3
+
+#endif /* UAN_BINARY_TRACE_H */
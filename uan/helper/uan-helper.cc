@@ -27,16 +27,21 @@
 #include "ns3/uan-net-device.h"
 #include "ns3/uan-mac.h"
 #include "ns3/uan-phy.h"
+#include "ns3/uan-phy-gen.h"
+#include "ns3/uan-phy-wakeup-dual.h"
+#include "ns3/uan-header-pcap.h"
 #include "ns3/uan-channel.h"
 #include "ns3/uan-prop-model.h"
 #include "ns3/uan-prop-model-ideal.h"
 #include "ns3/uan-transducer.h"
 #include "ns3/mobility-model.h"
 #include "ns3/log.h"
+#include "ns3/abort.h"
 #include "ns3/uan-tx-mode.h"
-#include "ns3/config.h"
 #include "ns3/simulator.h"
 #include "ns3/uan-noise-model-default.h"
+#include "ns3/node-list.h"
+#include "ns3/trace-helper.h"
 
 #include <sstream>
 #include <string>
@@ -57,7 +62,7 @@ NS_LOG_COMPONENT_DEFINE ("UanHelper");
 static void AsciiPhyTxEvent (std::ostream *os, std::string context,
                              Ptr<const Packet> packet, double txPowerDb, UanTxMode mode)
 {
-  *os << "+ " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << std::endl;
+  *os << "+ " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << "\n";
 }
 
 /**
@@ -72,7 +77,184 @@ static void AsciiPhyTxEvent (std::ostream *os, std::string context,
 static void AsciiPhyRxOkEvent (std::ostream *os, std::string context,
                                Ptr<const Packet> packet, double snr, UanTxMode mode)
 {
-  *os << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << std::endl;
+  *os << "r " << Simulator::Now ().GetSeconds () << " " << context << " " << *packet << "\n";
+}
+
+/**
+ * Pcap trace callback on Phy transmit events.
+ *
+ * \param file The pcap file.
+ * \param channel The receiver the PHY is.
+ * \param packet The transmitted packet.
+ * \param txPowerDb The transmission power.
+ * \param mode The transmission mode.
+ */
+static void PcapPhyTxEvent (Ptr<PcapFileWrapper> file, UanHeaderPcap::Channel channel,
+                            Ptr<const Packet> packet, double txPowerDb, UanTxMode mode)
+{
+  UanHeaderPcap header;
+  header.SetEvent (UanHeaderPcap::TX);
+  header.SetChannel (channel);
+  header.SetMode (mode);
+  header.SetPowerDb (txPowerDb);
+  file->Write (Simulator::Now (), header, packet);
+}
+
+/**
+ * Write a received frame to a pcap file.
+ *
+ * \param file The pcap file.
+ * \param phy The receiving PHY, if it reports received power.
+ * \param channel The receiver the PHY is.
+ * \param event RX_OK or RX_ERROR.
+ * \param packet The received packet.
+ * \param sinr The received signal to noise ratio.
+ * \param mode The channel transmission mode.
+ */
+static void PcapPhyRx (Ptr<PcapFileWrapper> file, Ptr<UanPhyGen> phy, UanHeaderPcap::Channel channel,
+                       UanHeaderPcap::Event event, Ptr<const Packet> packet, double sinr, UanTxMode mode)
+{
+  UanHeaderPcap header;
+  header.SetEvent (event);
+  header.SetChannel (channel);
+  header.SetMode (mode);
+  header.SetSinrDb (sinr);
+  if (phy)
+    {
+      header.SetPowerDb (phy->GetRxPowerDb ());
+    }
+  file->Write (Simulator::Now (), header, packet);
+}
+
+/**
+ * Pcap trace callback on successful packet reception.
+ *
+ * \param file The pcap file.
+ * \param phy The receiving PHY, if it reports received power.
+ * \param channel The receiver the PHY is.
+ * \param packet The received packet.
+ * \param sinr The received signal to noise ratio.
+ * \param mode The channel transmission mode.
+ */
+static void PcapPhyRxOkEvent (Ptr<PcapFileWrapper> file, Ptr<UanPhyGen> phy, UanHeaderPcap::Channel channel,
+                              Ptr<const Packet> packet, double sinr, UanTxMode mode)
+{
+  PcapPhyRx (file, phy, channel, UanHeaderPcap::RX_OK, packet, sinr, mode);
+}
+
+/**
+ * Pcap trace callback on failed packet reception.
+ *
+ * \param file The pcap file.
+ * \param phy The receiving PHY, if it reports received power.
+ * \param channel The receiver the PHY is.
+ * \param packet The received packet.
+ * \param sinr The received signal to noise ratio.
+ * \param mode The channel transmission mode.
+ */
+static void PcapPhyRxErrorEvent (Ptr<PcapFileWrapper> file, Ptr<UanPhyGen> phy, UanHeaderPcap::Channel channel,
+                                 Ptr<const Packet> packet, double sinr, UanTxMode mode)
+{
+  PcapPhyRx (file, phy, channel, UanHeaderPcap::RX_ERROR, packet, sinr, mode);
+}
+
+/**
+ * Connect the pcap callbacks to the trace sources of phy.
+ *
+ * \param file The pcap file.
+ * \param phy The PHY to trace.
+ * \param channel The receiver the PHY is.
+ */
+static void ConnectPcap (Ptr<PcapFileWrapper> file, Ptr<UanPhy> phy, UanHeaderPcap::Channel channel)
+{
+  Ptr<UanPhyGen> gen = DynamicCast<UanPhyGen> (phy);
+  bool connected = phy->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&PcapPhyTxEvent, file, channel))
+    && phy->TraceConnectWithoutContext ("RxOk", MakeBoundCallback (&PcapPhyRxOkEvent, file, gen, channel))
+    && phy->TraceConnectWithoutContext ("RxError", MakeBoundCallback (&PcapPhyRxErrorEvent, file, gen, channel));
+  NS_ABORT_MSG_UNLESS (connected, phy->GetInstanceTypeId ().GetName () << " has no Tx, RxOk and RxError traces");
+}
+
+/**
+ * \param dual The dual PHY.
+ * \param mode A mode of either of its PHYs.
+ * \return WAKEUP for a wakeup tone mode, DATA otherwise.  Data frames the
+ *   wakeup PHY sends are on the data channel.
+ */
+static UanHeaderPcap::Channel GetPcapChannel (Ptr<UanPhyWakeupDual> dual, UanTxMode mode)
+{
+  UanModesList wakeupModes = dual->GetWakeupModes ();
+  for (uint32_t i = 0; i < wakeupModes.GetNModes (); i++)
+    {
+      if (wakeupModes[i].GetUid () == mode.GetUid ())
+        {
+          return UanHeaderPcap::WAKEUP;
+        }
+    }
+  return UanHeaderPcap::DATA;
+}
+
+/**
+ * Pcap trace callback on transmit events of either PHY of a dual PHY.
+ *
+ * \param file The pcap file.
+ * \param dual The dual PHY.
+ * \param packet The transmitted packet.
+ * \param txPowerDb The transmission power.
+ * \param mode The transmission mode.
+ */
+static void PcapDualTxEvent (Ptr<PcapFileWrapper> file, Ptr<UanPhyWakeupDual> dual,
+                             Ptr<const Packet> packet, double txPowerDb, UanTxMode mode)
+{
+  PcapPhyTxEvent (file, GetPcapChannel (dual, mode), packet, txPowerDb, mode);
+}
+
+/**
+ * Write a frame received by either PHY of a dual PHY to a pcap file.
+ *
+ * \param file The pcap file.
+ * \param dual The dual PHY.
+ * \param event RX_OK or RX_ERROR.
+ * \param packet The received packet.
+ * \param sinr The received signal to noise ratio.
+ * \param mode The channel transmission mode.
+ */
+static void PcapDualRx (Ptr<PcapFileWrapper> file, Ptr<UanPhyWakeupDual> dual,
+                        UanHeaderPcap::Event event, Ptr<const Packet> packet, double sinr, UanTxMode mode)
+{
+  // The wakeup PHY only receives tones, so the channel names the receiver
+  UanHeaderPcap::Channel channel = GetPcapChannel (dual, mode);
+  Ptr<UanPhyGen> phy = channel == UanHeaderPcap::WAKEUP ? dual->GetWakeupPhy () : dual->GetDataPhy ();
+  PcapPhyRx (file, phy, channel, event, packet, sinr, mode);
+}
+
+/**
+ * Pcap trace callback on successful reception by a dual PHY.
+ *
+ * \param file The pcap file.
+ * \param dual The dual PHY.
+ * \param packet The received packet.
+ * \param sinr The received signal to noise ratio.
+ * \param mode The channel transmission mode.
+ */
+static void PcapDualRxOkEvent (Ptr<PcapFileWrapper> file, Ptr<UanPhyWakeupDual> dual,
+                               Ptr<const Packet> packet, double sinr, UanTxMode mode)
+{
+  PcapDualRx (file, dual, UanHeaderPcap::RX_OK, packet, sinr, mode);
+}
+
+/**
+ * Pcap trace callback on failed reception by a dual PHY.
+ *
+ * \param file The pcap file.
+ * \param dual The dual PHY.
+ * \param packet The received packet.
+ * \param sinr The received signal to noise ratio.
+ * \param mode The channel transmission mode.
+ */
+static void PcapDualRxErrorEvent (Ptr<PcapFileWrapper> file, Ptr<UanPhyWakeupDual> dual,
+                                  Ptr<const Packet> packet, double sinr, UanTxMode mode)
+{
+  PcapDualRx (file, dual, UanHeaderPcap::RX_ERROR, packet, sinr, mode);
 }
 
 UanHelper::UanHelper ()
@@ -163,16 +345,29 @@ UanHelper::SetTransducer (std::string type,
 void
 UanHelper::EnableAscii (std::ostream &os, uint32_t nodeid, uint32_t deviceid)
 {
-  Packet::EnablePrinting ();
-  std::ostringstream oss;
-
-  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::UanNetDevice/Phy/RxOk";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiPhyRxOkEvent, &os));
+  EnableAscii (os, NodeList::GetNode (nodeid)->GetDevice (deviceid));
+}
 
-  oss.str ("");
+void
+UanHelper::EnableAscii (std::ostream &os, Ptr<NetDevice> nd)
+{
+  Ptr<UanNetDevice> device = DynamicCast<UanNetDevice> (nd);
+  if (device == 0)
+    {
+      return;
+    }
+  Packet::EnablePrinting ();
 
-  oss << "/NodeList/" << nodeid << "/DeviceList/" << deviceid << "/$ns3::UanNetDevice/Phy/Tx";
-  Config::Connect (oss.str (), MakeBoundCallback (&AsciiPhyTxEvent, &os));
+  // Same context as the former Config path
+  std::ostringstream oss;
+  oss << "/NodeList/" << device->GetNode ()->GetId () << "/DeviceList/" << device->GetIfIndex () << "/$ns3::UanNetDevice/Phy/";
+  std::string context = oss.str ();
+
+  // A UanPhyWakeupDual forwards the traces of both its PHYs
+  Ptr<UanPhy> phy = device->GetPhy ();
+  bool connected = phy->TraceConnect ("RxOk", context + "RxOk", MakeBoundCallback (&AsciiPhyRxOkEvent, &os))
+    && phy->TraceConnect ("Tx", context + "Tx", MakeBoundCallback (&AsciiPhyTxEvent, &os));
+  NS_ABORT_MSG_UNLESS (connected, phy->GetInstanceTypeId ().GetName () << " has no Tx and RxOk traces");
 }
 
 void
@@ -180,8 +375,7 @@ UanHelper::EnableAscii (std::ostream &os, NetDeviceContainer d)
 {
   for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
     {
-      Ptr<NetDevice> dev = *i;
-      EnableAscii (os, dev->GetNode ()->GetId (), dev->GetIfIndex ());
+      EnableAscii (os, *i);
     }
 }
 
@@ -206,6 +400,126 @@ UanHelper::EnableAsciiAll (std::ostream &os)
   EnableAscii (os, NodeContainer::GetGlobal ());
 }
 
+void
+UanHelper::EnableBinary (Ptr<UanBinaryTraceWriter> writer, uint32_t nodeid, uint32_t deviceid)
+{
+  EnableBinary (writer, NodeList::GetNode (nodeid)->GetDevice (deviceid));
+}
+
+void
+UanHelper::EnableBinary (Ptr<UanBinaryTraceWriter> writer, Ptr<NetDevice> nd)
+{
+  Ptr<UanNetDevice> device = DynamicCast<UanNetDevice> (nd);
+  if (device == 0)
+    {
+      return;
+    }
+  uint32_t nodeid = device->GetNode ()->GetId ();
+  uint32_t deviceid = device->GetIfIndex ();
+
+  // A UanPhyWakeupDual forwards the traces of both its PHYs
+  Ptr<UanPhy> phy = device->GetPhy ();
+  bool connected = phy->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&UanBinaryTraceWriter::TxSink, writer, nodeid, deviceid))
+    && phy->TraceConnectWithoutContext ("RxOk", MakeBoundCallback (&UanBinaryTraceWriter::RxOkSink, writer, nodeid, deviceid))
+    && phy->TraceConnectWithoutContext ("RxError", MakeBoundCallback (&UanBinaryTraceWriter::RxErrorSink, writer, nodeid, deviceid));
+  NS_ABORT_MSG_UNLESS (connected, phy->GetInstanceTypeId ().GetName () << " has no Tx, RxOk and RxError traces");
+}
+
+void
+UanHelper::EnableBinary (Ptr<UanBinaryTraceWriter> writer, NetDeviceContainer d)
+{
+  for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
+    {
+      EnableBinary (writer, *i);
+    }
+}
+
+void
+UanHelper::EnableBinary (Ptr<UanBinaryTraceWriter> writer, NodeContainer n)
+{
+  NetDeviceContainer devs;
+  for (NodeContainer::Iterator i = n.Begin (); i != n.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          devs.Add (node->GetDevice (j));
+        }
+    }
+  EnableBinary (writer, devs);
+}
+
+void
+UanHelper::EnableBinaryAll (Ptr<UanBinaryTraceWriter> writer)
+{
+  EnableBinary (writer, NodeContainer::GetGlobal ());
+}
+
+void
+UanHelper::EnablePcap (std::string prefix, uint32_t nodeid, uint32_t deviceid)
+{
+  EnablePcap (prefix, NodeList::GetNode (nodeid)->GetDevice (deviceid));
+}
+
+void
+UanHelper::EnablePcap (std::string prefix, Ptr<NetDevice> nd)
+{
+  Ptr<UanNetDevice> device = DynamicCast<UanNetDevice> (nd);
+  if (device == 0)
+    {
+      return;
+    }
+
+  PcapHelper pcapHelper;
+  std::string filename = pcapHelper.GetFilenameFromDevice (prefix, device);
+  Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (filename, std::ios::out, UanHeaderPcap::DLT_UAN);
+
+  Ptr<UanPhyWakeupDual> dual = DynamicCast<UanPhyWakeupDual> (device->GetPhy ());
+  if (dual)
+    {
+      // One connection to the traces the dual PHY forwards, so a data
+      // frame sent through the wakeup PHY is written once, as DATA
+      bool connected = dual->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&PcapDualTxEvent, file, dual))
+        && dual->TraceConnectWithoutContext ("RxOk", MakeBoundCallback (&PcapDualRxOkEvent, file, dual))
+        && dual->TraceConnectWithoutContext ("RxError", MakeBoundCallback (&PcapDualRxErrorEvent, file, dual));
+      NS_ABORT_MSG_UNLESS (connected, "UanPhyWakeupDual traces missing");
+    }
+  else
+    {
+      ConnectPcap (file, device->GetPhy (), UanHeaderPcap::DATA);
+    }
+}
+
+void
+UanHelper::EnablePcap (std::string prefix, NetDeviceContainer d)
+{
+  for (NetDeviceContainer::Iterator i = d.Begin (); i != d.End (); ++i)
+    {
+      EnablePcap (prefix, *i);
+    }
+}
+
+void
+UanHelper::EnablePcap (std::string prefix, NodeContainer n)
+{
+  NetDeviceContainer devs;
+  for (NodeContainer::Iterator i = n.Begin (); i != n.End (); ++i)
+    {
+      Ptr<Node> node = *i;
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          devs.Add (node->GetDevice (j));
+        }
+    }
+  EnablePcap (prefix, devs);
+}
+
+void
+UanHelper::EnablePcapAll (std::string prefix)
+{
+  EnablePcap (prefix, NodeContainer::GetGlobal ());
+}
+
 NetDeviceContainer
 UanHelper::Install (NodeContainer c) const
 {
@@ -27,6 +27,7 @@
 #include "ns3/node-container.h"
 #include "ns3/net-device-container.h"
 #include "ns3/uan-net-device.h"
+#include "ns3/uan-binary-trace.h"
 
 namespace ns3 {
 
@@ -156,6 +157,16 @@ public:
    * \param deviceid The id of the device to generate ascii output for.
    */
   static void EnableAscii (std::ostream &os, uint32_t nodeid, uint32_t deviceid);
+  /**
+   * Enable ascii output on nd if it is of type ns3::UanNetDevice.
+   *
+   * The sinks are connected on the device PHY directly, with the
+   * context string built once, so no Config path is resolved.
+   *
+   * \param os Output stream.
+   * \param nd The device.
+   */
+  static void EnableAscii (std::ostream &os, Ptr<NetDevice> nd);
   /**
    * Enable ascii output on each device which is of the
    * ns3::UanNetDevice type and which is located in the input
@@ -185,6 +196,86 @@ public:
    */
   static void EnableAsciiAll (std::ostream &os);
 
+  /**
+   * Enable binary PHY tracing on the specified deviceid within the
+   * specified nodeid if it is of type ns3::UanNetDevice.  Tx, RxOk
+   * and RxError events are written as UanTraceRecord entries; use
+   * UanBinaryTraceReader to convert them to text or CSV.
+   *
+   * \param writer An open trace writer.
+   * \param nodeid The id of the node to trace.
+   * \param deviceid The id of the device to trace.
+   */
+  static void EnableBinary (Ptr<UanBinaryTraceWriter> writer, uint32_t nodeid, uint32_t deviceid);
+  /**
+   * Enable binary PHY tracing on nd if it is of type ns3::UanNetDevice.
+   *
+   * \param writer An open trace writer.
+   * \param nd The device.
+   */
+  static void EnableBinary (Ptr<UanBinaryTraceWriter> writer, Ptr<NetDevice> nd);
+  /**
+   * Enable binary PHY tracing on each ns3::UanNetDevice in d.
+   *
+   * \param writer An open trace writer.
+   * \param d Device container.
+   */
+  static void EnableBinary (Ptr<UanBinaryTraceWriter> writer, NetDeviceContainer d);
+  /**
+   * Enable binary PHY tracing on each ns3::UanNetDevice of the nodes in n.
+   *
+   * \param writer An open trace writer.
+   * \param n Node container.
+   */
+  static void EnableBinary (Ptr<UanBinaryTraceWriter> writer, NodeContainer n);
+  /**
+   * Enable binary PHY tracing on every ns3::UanNetDevice.
+   *
+   * \param writer An open trace writer.
+   */
+  static void EnableBinaryAll (Ptr<UanBinaryTraceWriter> writer);
+
+  /**
+   * Enable pcap output on the specified deviceid within the specified
+   * nodeid if it is of type ns3::UanNetDevice.  The file is named
+   * prefix-nodeid-deviceid.pcap and uses link type LINKTYPE_USER0; each
+   * transmitted or received frame is preceded by a UanHeaderPcap.  With
+   * a UanPhyWakeupDual both receivers are traced into the same file, the
+   * channel field telling wakeup tones from data frames by their mode.
+   *
+   * \param prefix Filename prefix.
+   * \param nodeid The id of the node to trace.
+   * \param deviceid The id of the device to trace.
+   */
+  static void EnablePcap (std::string prefix, uint32_t nodeid, uint32_t deviceid);
+  /**
+   * Enable pcap output on nd if it is of type ns3::UanNetDevice.
+   *
+   * \param prefix Filename prefix.
+   * \param nd The device.
+   */
+  static void EnablePcap (std::string prefix, Ptr<NetDevice> nd);
+  /**
+   * Enable pcap output on each ns3::UanNetDevice in d.
+   *
+   * \param prefix Filename prefix.
+   * \param d Device container.
+   */
+  static void EnablePcap (std::string prefix, NetDeviceContainer d);
+  /**
+   * Enable pcap output on each ns3::UanNetDevice of the nodes in n.
+   *
+   * \param prefix Filename prefix.
+   * \param n Node container.
+   */
+  static void EnablePcap (std::string prefix, NodeContainer n);
+  /**
+   * Enable pcap output on every ns3::UanNetDevice.
+   *
+   * \param prefix Filename prefix.
+   */
+  static void EnablePcapAll (std::string prefix);
+
   /**
    * This method creates a simple ns3::UanChannel (with a default
    * ns3::UanNoiseModelDefault and ns3::UanPropModelIdeal) and
@@ -0,0 +1,272 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-wakeup-helper.h"
+#include "ns3/uan-channel.h"
+#include "ns3/uan-transducer.h"
+#include "ns3/uan-phy-wakeup-dual.h"
+#include "ns3/uan-mac-wakeup.h"
+#include "ns3/uan-mac-wakeup-maca.h"
+#include "ns3/uan-mac-wakeup-tlohi.h"
+#include "ns3/uan-mac-fama.h"
+#include "ns3/uan-mac-maca.h"
+#include "ns3/uan-mac-tlohi.h"
+#include "ns3/uan-mac-cw-w.h"
+#include "ns3/uan-duty-cycle-controller.h"
+#include "ns3/acoustic-modem-energy-model.h"
+#include "ns3/energy-source.h"
+#include "ns3/energy-source-container.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanWakeupHelper");
+
+UanWakeupHelper::UanWakeupHelper ()
+  : m_dataSleep (true),
+    m_useDutyCycle (false)
+{
+  m_mac.SetTypeId ("ns3::UanMacFama");
+  m_phy.SetTypeId ("ns3::UanPhyWakeupDual");
+  m_transducer.SetTypeId ("ns3::UanTransducerHd");
+  SetDataEnergy (0.120, 0.024, 0.024, 0.000003);
+  SetWakeupEnergy (0.120, 0.0000081, 0.0000081, 0);
+}
+
+UanWakeupHelper::~UanWakeupHelper ()
+{
+}
+
+void
+UanWakeupHelper::SetMac (std::string type,
+                         std::string n0, const AttributeValue &v0,
+                         std::string n1, const AttributeValue &v1,
+                         std::string n2, const AttributeValue &v2,
+                         std::string n3, const AttributeValue &v3)
+{
+  m_mac = ObjectFactory ();
+  m_mac.SetTypeId (type);
+  m_mac.Set (n0, v0);
+  m_mac.Set (n1, v1);
+  m_mac.Set (n2, v2);
+  m_mac.Set (n3, v3);
+}
+
+void
+UanWakeupHelper::SetPhy (std::string n0, const AttributeValue &v0,
+                         std::string n1, const AttributeValue &v1,
+                         std::string n2, const AttributeValue &v2,
+                         std::string n3, const AttributeValue &v3)
+{
+  m_phy = ObjectFactory ();
+  m_phy.SetTypeId ("ns3::UanPhyWakeupDual");
+  m_phy.Set (n0, v0);
+  m_phy.Set (n1, v1);
+  m_phy.Set (n2, v2);
+  m_phy.Set (n3, v3);
+}
+
+void
+UanWakeupHelper::SetTransducer (std::string type)
+{
+  m_transducer = ObjectFactory ();
+  m_transducer.SetTypeId (type);
+}
+
+void
+UanWakeupHelper::SetDataEnergy (double txW, double rxW, double idleW, double sleepW)
+{
+  m_dataEnergy[0] = txW;
+  m_dataEnergy[1] = rxW;
+  m_dataEnergy[2] = idleW;
+  m_dataEnergy[3] = sleepW;
+}
+
+void
+UanWakeupHelper::SetWakeupEnergy (double txW, double rxW, double idleW, double sleepW)
+{
+  m_wakeupEnergy[0] = txW;
+  m_wakeupEnergy[1] = rxW;
+  m_wakeupEnergy[2] = idleW;
+  m_wakeupEnergy[3] = sleepW;
+}
+
+void
+UanWakeupHelper::SetDataSleep (bool sleep)
+{
+  m_dataSleep = sleep;
+}
+
+void
+UanWakeupHelper::SetDutyCycle (std::string n0, const AttributeValue &v0,
+                               std::string n1, const AttributeValue &v1,
+                               std::string n2, const AttributeValue &v2,
+                               std::string n3, const AttributeValue &v3)
+{
+  m_dutyCycle = ObjectFactory ();
+  m_dutyCycle.SetTypeId ("ns3::UanDutyCycleController");
+  m_dutyCycle.Set (n0, v0);
+  m_dutyCycle.Set (n1, v1);
+  m_dutyCycle.Set (n2, v2);
+  m_dutyCycle.Set (n3, v3);
+  m_useDutyCycle = true;
+}
+
+NetDeviceContainer
+UanWakeupHelper::Install (NodeContainer c, Ptr<UanChannel> channel) const
+{
+  NetDeviceContainer devices;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); i++)
+    {
+      devices.Add (Install (*i, channel));
+    }
+  return devices;
+}
+
+Ptr<UanNetDevice>
+UanWakeupHelper::Install (Ptr<Node> node, Ptr<UanChannel> channel) const
+{
+  Ptr<UanNetDevice> device = CreateObject<UanNetDevice> ();
+  Ptr<UanPhyWakeupDual> phy = m_phy.Create<UanPhyWakeupDual> ();
+  Ptr<UanTransducer> trans = m_transducer.Create<UanTransducer> ();
+  Ptr<UanMac> upper = m_mac.Create<UanMac> ();
+  UanAddress address = UanAddress::Allocate ();
+
+  // Pick the wakeup MAC the upper MAC talks to
+  Ptr<UanMac> wakeup;
+  if (DynamicCast<UanMacMaca> (upper) != 0)
+    {
+      wakeup = CreateObject<UanMacWakeupMaca> ();
+    }
+  else if (DynamicCast<UanMacTlohi> (upper) != 0)
+    {
+      wakeup = CreateObject<UanMacWakeupTlohi> ();
+    }
+  else if (DynamicCast<UanMacFama> (upper) != 0 || DynamicCast<UanMacCwW> (upper) != 0)
+    {
+      wakeup = CreateObject<UanMacWakeup> ();
+    }
+  else
+    {
+      NS_FATAL_ERROR ("No wakeup MAC for " << upper->GetInstanceTypeId ().GetName ());
+    }
+
+  // The wakeup MAC wires both receivers of the dual PHY in AttachPhy
+  device->SetPhy (phy);
+  device->SetMac (wakeup);
+  device->SetTransducer (trans);
+  device->SetChannel (channel);
+  wakeup->SetAddress (address);
+
+  Ptr<UanMacFama> fama = DynamicCast<UanMacFama> (upper);
+  Ptr<UanMacCwW> cw = DynamicCast<UanMacCwW> (upper);
+  Ptr<UanMacMaca> maca = DynamicCast<UanMacMaca> (upper);
+  Ptr<UanMacTlohi> tlohi = DynamicCast<UanMacTlohi> (upper);
+  if (fama != 0)
+    {
+      Ptr<UanMacWakeup> wu = DynamicCast<UanMacWakeup> (wakeup);
+      fama->AttachMacWakeup (wu);
+      wu->SetSendPhyStateChangeCb (MakeCallback (&UanMacFama::PhyStateCb, fama));
+      wu->SetTxEndCallback (MakeCallback (&UanMacFama::TxEnd, fama));
+    }
+  else if (cw != 0)
+    {
+      Ptr<UanMacWakeup> wu = DynamicCast<UanMacWakeup> (wakeup);
+      cw->AttachMacWakeup (wu);
+      wu->SetSendPhyStateChangeCb (MakeCallback (&UanMacCwW::PhyStateCb, cw));
+      wu->SetTxEndCallback (MakeCallback (&UanMacCwW::EndTx, cw));
+    }
+  else if (maca != 0)
+    {
+      maca->AttachMacWakeup (DynamicCast<UanMacWakeupMaca> (wakeup));
+    }
+  else
+    {
+      Ptr<UanMacWakeupTlohi> wu = DynamicCast<UanMacWakeupTlohi> (wakeup);
+      tlohi->AttachMacWakeup (wu);
+      wu->SetTxEndCallback (MakeCallback (&UanMacTlohi::TxEnd, tlohi));
+      wu->SetToneRxCallback (MakeCallback (&UanMacTlohi::RxCTD, tlohi));
+    }
+
+  // The upper MAC is the one the device sends through
+  device->SetMac (upper);
+  upper->SetAddress (address);
+  node->AddDevice (device);
+
+  InstallEnergy (node, phy->GetDataPhy (), phy->GetWakeupPhy ());
+  if (m_dataSleep)
+    {
+      phy->GetDataPhy ()->SetSleepMode (true);
+    }
+
+  Ptr<UanMacWakeup> wu = DynamicCast<UanMacWakeup> (wakeup);
+  if (m_useDutyCycle && wu != 0)
+    {
+      m_dutyCycle.Create<UanDutyCycleController> ()->Install (wu, GetEnergySource (node));
+    }
+  else if (m_useDutyCycle)
+    {
+      NS_LOG_DEBUG ("Node " << node->GetId () << ": no duty cycle with " << upper->GetInstanceTypeId ().GetName ());
+    }
+
+  return device;
+}
+
+Ptr<EnergySource>
+UanWakeupHelper::GetEnergySource (Ptr<Node> node)
+{
+  Ptr<EnergySource> source = node->GetObject<EnergySource> ();
+  Ptr<EnergySourceContainer> sources = node->GetObject<EnergySourceContainer> ();
+  if (source == 0 && sources != 0 && sources->GetN () > 0)
+    {
+      // Installed by an EnergySourceHelper
+      source = sources->Get (0);
+    }
+  return source;
+}
+
+void
+UanWakeupHelper::InstallEnergy (Ptr<Node> node, Ptr<UanPhy> dataPhy, Ptr<UanPhy> wakeupPhy) const
+{
+  Ptr<EnergySource> source = GetEnergySource (node);
+  if (source == 0)
+    {
+      NS_LOG_DEBUG ("Node " << node->GetId () << " has no energy source, no energy models installed");
+      return;
+    }
+
+  Ptr<UanPhy> phys[2] = { dataPhy, wakeupPhy };
+  const double *power[2] = { m_dataEnergy, m_wakeupEnergy };
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<AcousticModemEnergyModel> model = CreateObject<AcousticModemEnergyModel> ();
+      model->SetTxPowerW (power[i][0]);
+      model->SetRxPowerW (power[i][1]);
+      model->SetIdlePowerW (power[i][2]);
+      model->SetSleepPowerW (power[i][3]);
+      model->SetNode (node);
+      model->SetEnergySource (source);
+      model->SetPhy (phys[i]);
+      model->SetEnergyDepletionCallback (MakeCallback (&UanPhy::EnergyDepletionHandler, phys[i]));
+      source->AppendDeviceEnergyModel (model);
+      phys[i]->SetEnergyModelCallback (MakeCallback (&DeviceEnergyModel::ChangeState, model));
+    }
+}
+
+} // end namespace ns3
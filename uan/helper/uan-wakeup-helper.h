@@ -0,0 +1,172 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_WAKEUP_HELPER_H
+#define UAN_WAKEUP_HELPER_H
+
+#include <string>
+#include "ns3/attribute.h"
+#include "ns3/object-factory.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/uan-net-device.h"
+
+namespace ns3 {
+
+class UanChannel;
+class EnergySource;
+
+/**
+ * \ingroup uan
+ *
+ * Installs the wakeup stack: one UanNetDevice per node with a
+ * UanPhyWakeupDual, the wakeup MAC matching the upper MAC (UanMacWakeup,
+ * UanMacWakeupMaca or UanMacWakeupTlohi), the upper MAC itself (FAMA,
+ * slotted FAMA, MACA, T-Lohi or CW) and, on nodes that already have an
+ * EnergySource aggregated, one AcousticModemEnergyModel per receiver.
+ *
+ * Attributes are resolved once in the factories; per node only objects
+ * are created and wired, with no Config path lookups.
+ */
+class UanWakeupHelper
+{
+public:
+  UanWakeupHelper ();
+  virtual ~UanWakeupHelper ();
+
+  /**
+   * Set the upper MAC type and attributes, default ns3::UanMacFama.
+   *
+   * \param type ns3::UanMacFama, ns3::UanMacSlottedFama, ns3::UanMacMaca,
+   *   ns3::UanMacTlohi or ns3::UanMacCwW.
+   * \param n0 The name of the attribute to set.
+   * \param v0 The value of the attribute to set.
+   * \param n1 The name of the attribute to set.
+   * \param v1 The value of the attribute to set.
+   * \param n2 The name of the attribute to set.
+   * \param v2 The value of the attribute to set.
+   * \param n3 The name of the attribute to set.
+   * \param v3 The value of the attribute to set.
+   */
+  void SetMac (std::string type,
+               std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),
+               std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+               std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+               std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue ());
+
+  /**
+   * Set ns3::UanPhyWakeupDual attributes.
+   *
+   * \param n0 The name of the attribute to set.
+   * \param v0 The value of the attribute to set.
+   * \param n1 The name of the attribute to set.
+   * \param v1 The value of the attribute to set.
+   * \param n2 The name of the attribute to set.
+   * \param v2 The value of the attribute to set.
+   * \param n3 The name of the attribute to set.
+   * \param v3 The value of the attribute to set.
+   */
+  void SetPhy (std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),
+               std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+               std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+               std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue ());
+
+  /**
+   * Set the transducer type, default ns3::UanTransducerHd.
+   *
+   * \param type The type of ns3::UanTransducer to create.
+   */
+  void SetTransducer (std::string type);
+
+  /**
+   * Power draw of the data modem, in W.
+   *
+   * \param txW Transmitting.
+   * \param rxW Receiving.
+   * \param idleW Idle.
+   * \param sleepW Sleeping.
+   */
+  void SetDataEnergy (double txW, double rxW, double idleW, double sleepW);
+  /**
+   * Power draw of the wakeup receiver, in W.
+   *
+   * \param txW Transmitting.
+   * \param rxW Receiving.
+   * \param idleW Idle.
+   * \param sleepW Sleeping.
+   */
+  void SetWakeupEnergy (double txW, double rxW, double idleW, double sleepW);
+
+  /**
+   * \param sleep Put the data modem to sleep after install, as the wakeup
+   *   MACs expect.  Default true.
+   */
+  void SetDataSleep (bool sleep);
+
+  /**
+   * Duty-cycle the wakeup receiver of every node with a
+   * UanDutyCycleController.  Only with the UanMacWakeup based upper MACs
+   * (FAMA, slotted FAMA and CW).
+   *
+   * \param n0 The name of the attribute to set.
+   * \param v0 The value of the attribute to set.
+   * \param n1 The name of the attribute to set.
+   * \param v1 The value of the attribute to set.
+   * \param n2 The name of the attribute to set.
+   * \param v2 The value of the attribute to set.
+   * \param n3 The name of the attribute to set.
+   * \param v3 The value of the attribute to set.
+   */
+  void SetDutyCycle (std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue (),
+                     std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue (),
+                     std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue (),
+                     std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue ());
+
+  /**
+   * \param c Nodes to install on.
+   * \param channel Channel shared by all devices.
+   * \return The devices, in node order.
+   */
+  NetDeviceContainer Install (NodeContainer c, Ptr<UanChannel> channel) const;
+
+  /**
+   * \param node Node to install on.
+   * \param channel Channel to attach to.
+   * \return The device.  GetMac returns the upper MAC.
+   */
+  Ptr<UanNetDevice> Install (Ptr<Node> node, Ptr<UanChannel> channel) const;
+
+private:
+  /** \return The EnergySource of the node, 0 if none. */
+  static Ptr<EnergySource> GetEnergySource (Ptr<Node> node);
+  /** Install the energy models on the node EnergySource, if any. */
+  void InstallEnergy (Ptr<Node> node, Ptr<UanPhy> dataPhy, Ptr<UanPhy> wakeupPhy) const;
+
+  ObjectFactory m_mac;         //!< The upper MAC.
+  ObjectFactory m_phy;         //!< The dual PHY.
+  ObjectFactory m_transducer;  //!< The transducer.
+  double m_dataEnergy[4];      //!< Data modem tx, rx, idle, sleep W.
+  double m_wakeupEnergy[4];    //!< Wakeup receiver tx, rx, idle, sleep W.
+  bool m_dataSleep;            //!< Start with the data modem asleep.
+  ObjectFactory m_dutyCycle;   //!< The duty cycle controller.
+  bool m_useDutyCycle;         //!< Install m_dutyCycle.
+};
+
+} // end namespace ns3
+
+#endif /* UAN_WAKEUP_HELPER_H */
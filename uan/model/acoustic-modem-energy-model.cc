@@ -24,6 +24,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/energy-source.h"
 #include "ns3/uan-phy.h"
+#include "ns3/uan-phy-gen.h"
 #include "ns3/uan-net-device.h"
 #include "acoustic-modem-energy-model.h"
 
@@ -63,10 +64,29 @@ AcousticModemEnergyModel::GetTypeId (void)
                    MakeDoubleAccessor (&AcousticModemEnergyModel::SetSleepPowerW,
                                        &AcousticModemEnergyModel::GetSleepPowerW),
                    MakeDoubleChecker<double> ())
+    .AddAttribute ("WakeupEnergy",
+                   "Energy in Joules drawn when leaving sleep, spread over the PHY WakeupLatency.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&AcousticModemEnergyModel::m_wakeupEnergyJ),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("SleepEnergy",
+                   "Energy in Joules drawn when entering sleep, spread over SleepTime.",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&AcousticModemEnergyModel::m_sleepEnergyJ),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("SleepTime",
+                   "Duration of the sleep transition.  No sleep energy is drawn when zero.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&AcousticModemEnergyModel::m_sleepTime),
+                   MakeTimeChecker ())
     .AddTraceSource ("TotalEnergyConsumption",
                      "Total energy consumption of the modem device.",
                      MakeTraceSourceAccessor (&AcousticModemEnergyModel::m_totalEnergyConsumption),
                      "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("StateEnergy",
+                     "The modem left a state; time spent and energy used in it.",
+                     MakeTraceSourceAccessor (&AcousticModemEnergyModel::m_stateTrace),
+                     "ns3::AcousticModemEnergyModel::StateEnergyTracedCallback")
   ;
   return tid;
 }
@@ -79,6 +99,18 @@ AcousticModemEnergyModel::AcousticModemEnergyModel ()
   m_energyDepletionCallback.Nullify ();
   m_node = 0;
   m_source = 0;
+  m_phy = 0;
+  m_stateStart = Seconds (0.0);
+  m_transitionPowerW = 0;
+  m_transitionEnergy = 0;
+  m_off = false;
+  for (uint32_t i = 0; i < STATES; i++)
+    {
+      m_stateTime[i] = Seconds (0);
+      m_stateEnergy[i] = 0;
+      m_stateEntries[i] = 0;
+    }
+  m_stateEntries[m_currentState] = 1;
 }
 
 AcousticModemEnergyModel::~AcousticModemEnergyModel ()
@@ -111,7 +143,9 @@ double
 AcousticModemEnergyModel::GetTotalEnergyConsumption (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_totalEnergyConsumption;
+  // Energy since the last update is only added when the draw changes
+  Time duration = Simulator::Now () - m_lastUpdateTime;
+  return m_totalEnergyConsumption + duration.GetSeconds () * (GetStateDrawW () + m_transitionPowerW);
 }
 
 double
@@ -177,6 +211,59 @@ AcousticModemEnergyModel::GetCurrentState (void) const
   return m_currentState;
 }
 
+Time
+AcousticModemEnergyModel::GetStateTime (int state) const
+{
+  NS_ASSERT (state >= 0 && state < (int) STATES);
+  Time time = m_stateTime[state];
+  if (state == m_currentState)
+    {
+      time += Simulator::Now () - m_lastUpdateTime;
+    }
+  return time;
+}
+
+double
+AcousticModemEnergyModel::GetStateEnergy (int state) const
+{
+  NS_ASSERT (state >= 0 && state < (int) STATES);
+  double energy = m_stateEnergy[state];
+  if (state == m_currentState)
+    {
+      energy += (Simulator::Now () - m_lastUpdateTime).GetSeconds () * GetStateDrawW ();
+    }
+  return energy;
+}
+
+double
+AcousticModemEnergyModel::GetTransitionEnergy (void) const
+{
+  return m_transitionEnergy + (Simulator::Now () - m_lastUpdateTime).GetSeconds () * m_transitionPowerW;
+}
+
+uint32_t
+AcousticModemEnergyModel::GetStateEntries (int state) const
+{
+  NS_ASSERT (state >= 0 && state < (int) STATES);
+  return m_stateEntries[state];
+}
+
+AcousticModemEnergyModel::Snapshot
+AcousticModemEnergyModel::GetSnapshot (void) const
+{
+  Snapshot snapshot;
+  snapshot.node = m_node ? m_node->GetId () : 0;
+  snapshot.total = GetTotalEnergyConsumption ();
+  snapshot.transition = GetTransitionEnergy ();
+  for (uint32_t i = 0; i < STATES; i++)
+    {
+      snapshot.time[i] = GetStateTime (i);
+      snapshot.energy[i] = GetStateEnergy (i);
+      snapshot.entries[i] = m_stateEntries[i];
+    }
+  return snapshot;
+}
+
 void
 AcousticModemEnergyModel::SetEnergyDepletionCallback (
   AcousticModemEnergyDepletionCallback callback)
@@ -189,51 +276,123 @@ AcousticModemEnergyModel::SetEnergyDepletionCallback (
   m_energyDepletionCallback = callback;
 }
 
+void
+AcousticModemEnergyModel::SetPhy (Ptr<UanPhy> phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  m_phy = phy;
+}
+
 void
 AcousticModemEnergyModel::ChangeState (int newState)
 {
   NS_LOG_FUNCTION (this << newState);
   // NS_ASSERT (IsStateTransitionValid ((MicroModemState) newState));
 
+  if (newState == m_currentState)
+    {
+      return;
+    }
+
+  double power = GetStateDrawW () + m_transitionPowerW;
+  UpdateEnergyConsumption ();
+
+  Time visit = Simulator::Now () - m_stateStart;
+  m_stateTrace (m_currentState, newState, visit, visit.GetSeconds () * GetStateDrawW ());
+  m_stateStart = Simulator::Now ();
+
+  // Waking up or falling asleep draws its energy over the transition
+  // time, unless the modem is switched off
+  double transitionPowerW = m_transitionPowerW;
+  Time transitionTime = Seconds (0);
+  Ptr<UanPhyGen> phy = DynamicCast<UanPhyGen> (m_phy);
+  Time wakeupTime = phy ? phy->GetWakeupLatency () : Seconds (0);
+  if (!m_off && m_currentState == UanPhy::SLEEP && wakeupTime.IsStrictlyPositive ())
+    {
+      transitionPowerW = m_wakeupEnergyJ / wakeupTime.GetSeconds ();
+      transitionTime = wakeupTime;
+    }
+  else if (!m_off && newState == UanPhy::SLEEP && m_sleepTime.IsStrictlyPositive ())
+    {
+      transitionPowerW = m_sleepEnergyJ / m_sleepTime.GetSeconds ();
+      transitionTime = m_sleepTime;
+    }
+
+  // The source integrates our current draw on its own, so it only needs
+  // to hear about changes of it.  Rx and idle usually draw the same.
+  double newPower = m_off ? 0 : GetStatePowerW (newState);
+  if (newPower + transitionPowerW != power)
+    {
+      m_source->UpdateEnergySource ();
+    }
+
+  if (transitionTime.IsStrictlyPositive ())
+    {
+      m_transitionEvent.Cancel ();
+      m_transitionPowerW = transitionPowerW;
+      m_transitionEvent = Simulator::Schedule (transitionTime, &AcousticModemEnergyModel::EndTransition, this);
+    }
+
+  // update current state & last update time stamp
+  SetMicroModemState (newState);
+  m_stateEntries[newState]++;
+
+  // some debug message
+  NS_LOG_DEBUG ("AcousticModemEnergyModel:Total energy consumption at node #" <<
+                m_node->GetId () << " is " << m_totalEnergyConsumption << "J");
+}
+
+void
+AcousticModemEnergyModel::UpdateEnergyConsumption (void)
+{
   Time duration = Simulator::Now () - m_lastUpdateTime;
   NS_ASSERT (duration.GetNanoSeconds () >= 0); // check if duration is valid
 
   // energy to decrease = current * voltage * time
-  double energyToDecrease = 0.0;
+  double stateEnergy = duration.GetSeconds () * GetStateDrawW ();
+  double transitionEnergy = duration.GetSeconds () * m_transitionPowerW;
+
+  m_stateTime[m_currentState] += duration;
+  m_stateEnergy[m_currentState] += stateEnergy;
+  m_transitionEnergy += transitionEnergy;
+  m_totalEnergyConsumption += stateEnergy + transitionEnergy;
+
+  m_lastUpdateTime = Simulator::Now ();
+}
+
+void
+AcousticModemEnergyModel::EndTransition (void)
+{
+  NS_LOG_FUNCTION (this);
+  UpdateEnergyConsumption ();
+  m_source->UpdateEnergySource ();
+  m_transitionPowerW = 0;
+}
 
-  switch (m_currentState)
+double
+AcousticModemEnergyModel::GetStatePowerW (int state) const
+{
+  switch (state)
     {
     case UanPhy::TX:
-      energyToDecrease = duration.GetSeconds () * m_txPowerW;
-      break;
+      return m_txPowerW;
     case UanPhy::RX:
-      energyToDecrease = duration.GetSeconds () * m_rxPowerW;
-      break;
+      return m_rxPowerW;
     case UanPhy::IDLE:
-      energyToDecrease = duration.GetSeconds () * m_idlePowerW;
-      break;
+    case UanPhy::CCABUSY:
+      return m_idlePowerW;
     case UanPhy::SLEEP:
-      energyToDecrease = duration.GetSeconds () * m_sleepPowerW;
-      break;
+      return m_sleepPowerW;
     default:
       NS_FATAL_ERROR ("AcousticModemEnergyModel:Undefined radio state!");
     }
+  return 0;
+}
 
-  // update total energy consumption
-  m_totalEnergyConsumption += energyToDecrease;
-
-  // update last update time stamp
-  m_lastUpdateTime = Simulator::Now ();
-
-  // notify energy source
-  m_source->UpdateEnergySource ();
-
-  // update current state & last update time stamp
-  SetMicroModemState (newState);
-
-  // some debug message
-  NS_LOG_DEBUG ("AcousticModemEnergyModel:Total energy consumption at node #" <<
-                m_node->GetId () << " is " << m_totalEnergyConsumption << "J");
+double
+AcousticModemEnergyModel::GetStateDrawW (void) const
+{
+  return m_off ? 0 : GetStatePowerW (m_currentState);
 }
 
 void
@@ -242,14 +401,43 @@ AcousticModemEnergyModel::HandleEnergyDepletion (void)
   NS_LOG_FUNCTION (this);
   NS_LOG_DEBUG ("AcousticModemEnergyModel:Energy is depleted at node #" <<
                 m_node->GetId ());
+  // The source notices the lower draw on its own update, which is running
+  UpdateEnergyConsumption ();
+  m_transitionEvent.Cancel ();
+  m_transitionPowerW = 0;
+  m_off = true;
   // invoke energy depletion callback, if set.
   if (!m_energyDepletionCallback.IsNull ())
     {
       m_energyDepletionCallback ();
     }
-  // invoke the phy energy depletion handler
-  Ptr<UanNetDevice> dev = m_node->GetDevice (0)->GetObject<UanNetDevice> ();
-  dev->GetPhy ()->EnergyDepletionHandler ();
+  // invoke the phy energy depletion handler of every UAN device
+  for (uint32_t i = 0; i < m_node->GetNDevices (); i++)
+    {
+      Ptr<UanNetDevice> dev = DynamicCast<UanNetDevice> (m_node->GetDevice (i));
+      if (dev && dev->GetPhy ())
+        {
+          dev->GetPhy ()->EnergyDepletionHandler ();
+        }
+    }
+}
+
+void
+AcousticModemEnergyModel::HandleEnergyRecharged (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_DEBUG ("AcousticModemEnergyModel:Energy is recharged at node #" <<
+                m_node->GetId ());
+  UpdateEnergyConsumption ();
+  m_off = false;
+  for (uint32_t i = 0; i < m_node->GetNDevices (); i++)
+    {
+      Ptr<UanNetDevice> dev = DynamicCast<UanNetDevice> (m_node->GetDevice (i));
+      if (dev && dev->GetPhy ())
+        {
+          dev->GetPhy ()->EnergyRechargeHandler ();
+        }
+    }
 }
 
 /*
@@ -260,8 +448,10 @@ void
 AcousticModemEnergyModel::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  m_transitionEvent.Cancel ();
   m_node = 0;
   m_source = 0;
+  m_phy = 0;
   m_energyDepletionCallback.Nullify ();
 }
 
@@ -272,26 +462,7 @@ AcousticModemEnergyModel::DoGetCurrentA (void) const
 
   double supplyVoltage = m_source->GetSupplyVoltage ();
   NS_ASSERT (supplyVoltage != 0.0);
-  double stateCurrent = 0.0;
-  switch (m_currentState)
-    {
-    case UanPhy::TX:
-      stateCurrent = m_txPowerW / supplyVoltage;
-      break;
-    case UanPhy::RX:
-      stateCurrent = m_rxPowerW / supplyVoltage;
-      break;
-    case UanPhy::IDLE:
-      stateCurrent = m_idlePowerW / supplyVoltage;
-      break;
-    case UanPhy::SLEEP:
-      stateCurrent = m_sleepPowerW / supplyVoltage;
-      break;
-    default:
-      NS_FATAL_ERROR ("AcousticModemEnergyModel:Undefined radio state!");
-    }
-
-  return stateCurrent;
+  return (GetStateDrawW () + m_transitionPowerW) / supplyVoltage;
 }
 
 bool
@@ -25,9 +25,12 @@
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
 #include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
 
 namespace ns3 {
 
+class UanPhy;
+
 /**
  * \ingroup uan
  *
@@ -51,6 +54,12 @@ namespace ns3 {
  *     and navigation system for multiple platforms,
  *     in In Proc. IEEE OCEANS05 Conf, 2005.
  *     URL: http://ieeexplore.ieee.org/iel5/10918/34367/01639901.pdf
+ *
+ * Repeated states cost nothing, and the energy source only hears about
+ * changes of the drawn power.  The model predicts no depletion itself: a
+ * UanBatteryEnergySource schedules one event at the predicted crossing
+ * and moves it when the draw changes, other sources keep their periodic
+ * update.
  */
 class AcousticModemEnergyModel : public DeviceEnergyModel
 {
@@ -58,6 +67,34 @@ public:
   /** Callback type for energy depletion handling. */
   typedef Callback<void> AcousticModemEnergyDepletionCallback;
 
+  /**
+   * TracedCallback signature for leaving a modem state.
+   *
+   * \param [in] state The state left.
+   * \param [in] next The state entered.
+   * \param [in] duration Time spent in state.
+   * \param [in] energy Energy used in state, in J.
+   */
+  typedef void (* StateEnergyTracedCallback)
+    (int state, int next, Time duration, double energy);
+
+  /** Number of modem states, indexed by UanPhy::State. */
+  static const uint32_t STATES = 5;
+
+  /**
+   * Per-state counters of one model, indexed by UanPhy::State.
+   * CCABUSY draws idle power.
+   */
+  struct Snapshot
+  {
+    uint32_t node;              //!< Node id.
+    Time time[STATES];          //!< Time spent in each state.
+    double energy[STATES];      //!< Energy used in each state, J.
+    uint32_t entries[STATES];   //!< Times each state was entered.
+    double transition;          //!< Sleep/wake transition energy, J.
+    double total;               //!< Total energy, J.
+  };
+
 public:  
   /**
    * Register this type.
@@ -85,6 +122,12 @@ public:
 
   // Inherited methods.
   virtual void SetEnergySource (Ptr<EnergySource> source);
+  /**
+   * \return Energy consumed up to now, in J.  The current state is added
+   *   on the fly, so at every state change this equals what an update on
+   *   every PHY callback would report, and in between it is up to date
+   *   rather than as of the last change.
+   */
   virtual double GetTotalEnergyConsumption (void) const;
 
   /**
@@ -150,6 +193,26 @@ public:
    */
   int GetCurrentState (void) const;
 
+  /**
+   * \param state UanPhy::State value.
+   * \return Time spent in state so far, including the current visit.
+   */
+  Time GetStateTime (int state) const;
+  /**
+   * \param state UanPhy::State value.
+   * \return Energy used in state so far, in J.
+   */
+  double GetStateEnergy (int state) const;
+  /**
+   * \param state UanPhy::State value.
+   * \return Number of times state was entered.
+   */
+  uint32_t GetStateEntries (int state) const;
+  /** \return Energy drawn by sleep and wake-up transitions so far, in J. */
+  double GetTransitionEnergy (void) const;
+  /** \return All per-state counters, up to now. */
+  Snapshot GetSnapshot (void) const;
+
   /**
    * \param callback Callback function.
    *
@@ -157,6 +220,14 @@ public:
    */
   void SetEnergyDepletionCallback (AcousticModemEnergyDepletionCallback callback);
 
+  /**
+   * Set the PHY this model accounts for.  The WakeupEnergy is drawn over
+   * its WakeupLatency; without a UanPhyGen leaving sleep costs nothing.
+   *
+   * \param phy The modem PHY.
+   */
+  void SetPhy (Ptr<UanPhy> phy);
+
   /**
    * Changes state of the AcousticModemEnergyModel.
    *
@@ -165,18 +236,16 @@ public:
   virtual void ChangeState (int newState);
 
   /**
-   * Handles energy depletion.
+   * Handles energy depletion.  The modem is switched off and draws no
+   * current until recharged, and every UAN PHY of the node is disabled.
    */
   virtual void HandleEnergyDepletion (void);
 
   /**
-   * \brief Handles energy recharged.
-   *
-   * Not implemented
+   * Handles energy recharged.  The modem draws the power of its state
+   * again and every UAN PHY of the node is enabled.
    */
-  virtual void HandleEnergyRecharged (void)
-  {
-  }
+  virtual void HandleEnergyRecharged (void);
 
 
 private:
@@ -187,6 +256,19 @@ private:
    */
   virtual double DoGetCurrentA (void) const;
 
+  /**
+   * \param state Modem state.
+   * \return Power drawn in state, in watts.
+   */
+  double GetStatePowerW (int state) const;
+  /** \return Power drawn in the current state, 0 while switched off. */
+  double GetStateDrawW (void) const;
+
+  /** Add the energy drawn since m_lastUpdateTime to the counters. */
+  void UpdateEnergyConsumption (void);
+  /** End of a sleep or wake-up transition. */
+  void EndTransition (void);
+
   /**
    * \param destState Modem state to switch to.
    * \return True if the transition is allowed.
@@ -206,6 +288,7 @@ private:
 private:
   Ptr<Node> m_node;            //!< The node hosting this transducer.
   Ptr<EnergySource> m_source;  //!< The energy source.
+  Ptr<UanPhy> m_phy;           //!< The PHY, for its warm-up time.
 
   // Member variables for power consumption in different modem states.
   double m_txPowerW;           //!< The transmitter power, in watts.
@@ -213,13 +296,36 @@ private:
   double m_idlePowerW;         //!< The idle power, in watts.
   double m_sleepPowerW;        //!< The sleep power, in watts.
 
-  /** The total energy consumed by this model. */
+  /**
+   * Energy consumed up to m_lastUpdateTime, integrated when the state
+   * changes; repeated states are skipped.  GetTotalEnergyConsumption adds
+   * the current state.
+   */
   TracedValue<double> m_totalEnergyConsumption;
 
   // State variables.
   int m_currentState;          //!< Current modem state.
   Time m_lastUpdateTime;       //!< Time stamp of previous energy update.
 
+  // Per-state counters, up to m_lastUpdateTime.
+  Time m_stateTime[STATES];          //!< Time spent in each state.
+  double m_stateEnergy[STATES];      //!< Energy used in each state.
+  uint32_t m_stateEntries[STATES];   //!< Times each state was entered.
+
+  Time m_stateStart;                 //!< Entry time of the current state.
+
+  /** Fired when a state is left. */
+  TracedCallback<int, int, Time, double> m_stateTrace;
+
+  // Sleep/wake transitions, drawn on top of the state power.
+  double m_wakeupEnergyJ;      //!< Energy to leave sleep.
+  double m_sleepEnergyJ;       //!< Energy to enter sleep.
+  Time m_sleepTime;            //!< Time to enter sleep.
+  double m_transitionPowerW;   //!< Extra power of the running transition.
+  double m_transitionEnergy;   //!< Transition energy up to m_lastUpdateTime.
+  EventId m_transitionEvent;   //!< End of the running transition.
+  bool m_off;                  //!< Switched off by energy depletion.
+
   /** Energy depletion callback. */
   AcousticModemEnergyDepletionCallback m_energyDepletionCallback;
 
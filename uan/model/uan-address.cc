@@ -20,15 +20,69 @@
 
 #include "uan-address.h"
 #include "ns3/address.h"
+#include "ns3/simulator.h"
+#include "ns3/fatal-error.h"
+#include "ns3/abort.h"
 
 namespace ns3 {
 
+/** Bytes per address on the air, see UanAddress::SetWidth. */
+static uint8_t g_uanAddressWidth = 1;
+/** Addresses were allocated or serialized at g_uanAddressWidth in this run. */
+static bool g_uanAddressWidthUsed = false;
+/** Next address handed out by UanAddress::Allocate in this run. */
+static uint32_t g_uanAddressNext = 0;
+/** Bits per bit-packed address in this run, 0 for byte aligned headers. */
+static uint8_t g_uanAddressPackedBits = 0;
+/** UanAddressEndRun is scheduled for the end of this run. */
+static bool g_uanAddressEndRunScheduled = false;
+
+/** Broadcast in memory at every width, so it does not depend on when it was read. */
+static const uint16_t UAN_ADDRESS_BROADCAST = 0xffff;
+
+/** Back to the defaults when the simulator is destroyed. */
+static void
+UanAddressEndRun (void)
+{
+  g_uanAddressWidth = 1;
+  g_uanAddressWidthUsed = false;
+  g_uanAddressNext = 0;
+  g_uanAddressPackedBits = 0;
+  g_uanAddressEndRunScheduled = false;
+}
+
+/** Reset the run settings when the simulator is destroyed. */
+static void
+UanAddressScheduleEndRun (void)
+{
+  if (!g_uanAddressEndRunScheduled)
+    {
+      g_uanAddressEndRunScheduled = true;
+      Simulator::ScheduleDestroy (&UanAddressEndRun);
+    }
+}
+
+/** All ones at the current width: the broadcast on the air, the first address that does not fit. */
+static uint16_t
+UanAddressWireBroadcast (void)
+{
+  return g_uanAddressWidth == 1 ? 0xff : 0xffff;
+}
+
+/** Fix the width for the rest of the run. */
+static void
+UanAddressUseWidth (void)
+{
+  g_uanAddressWidthUsed = true;
+  UanAddressScheduleEndRun ();
+}
+
 UanAddress::UanAddress ()
+  : m_address (UAN_ADDRESS_BROADCAST)
 {
-  m_address = 255;
 }
 
-UanAddress::UanAddress (uint8_t addr)
+UanAddress::UanAddress (uint16_t addr)
   : m_address (addr)
 {
 }
@@ -47,27 +101,93 @@ UanAddress::GetType (void)
 Address
 UanAddress::ConvertTo (void) const
 {
-  return Address (GetType (), &m_address, 1);
+  // Always two bytes in memory, whatever the width on the air
+  uint8_t buf[2];
+  buf[0] = m_address >> 8;
+  buf[1] = m_address & 0xff;
+  return Address (GetType (), buf, 2);
 }
 
 UanAddress
 UanAddress::ConvertFrom (const Address &address)
 {
   NS_ASSERT (IsMatchingType (address));
-  UanAddress uAddr;
-  address.CopyTo (&uAddr.m_address);
-  return uAddr;
+  uint8_t buf[2];
+  address.CopyTo (buf);
+  return UanAddress ((buf[0] << 8) | buf[1]);
 }
 
-uint8_t
+uint16_t
 UanAddress::GetAsInt (void) const
 {
   return m_address;
 }
+
+void
+UanAddress::SetWidth (uint8_t bytes)
+{
+  NS_ASSERT_MSG (bytes == 1 || bytes == 2, "UanAddress width must be 1 or 2 bytes");
+  if (g_uanAddressWidthUsed && bytes != g_uanAddressWidth)
+    {
+      NS_FATAL_ERROR ("UanAddress width changed to " << (int) bytes << " after addresses of width "
+                      << (int) g_uanAddressWidth << " were used in this run");
+    }
+  g_uanAddressWidth = bytes;
+}
+
+uint8_t
+UanAddress::GetWidth (void)
+{
+  return g_uanAddressWidth;
+}
+
+void
+UanAddress::SetPackedBits (uint8_t bits)
+{
+  NS_ABORT_MSG_IF (bits > 16, "Packed addresses take 1 to 16 bits, not " << (int) bits);
+  g_uanAddressPackedBits = bits;
+  UanAddressScheduleEndRun ();
+}
+
+uint8_t
+UanAddress::GetPackedBits (void)
+{
+  return g_uanAddressPackedBits;
+}
+
+void
+UanAddress::Serialize (Buffer::Iterator &i) const
+{
+  UanAddressUseWidth ();
+  uint16_t address = m_address == UAN_ADDRESS_BROADCAST ? UanAddressWireBroadcast () : m_address;
+  NS_ASSERT_MSG (m_address == UAN_ADDRESS_BROADCAST || m_address < UanAddressWireBroadcast (), "Address " << m_address << " does not fit in "
+                 << (int) g_uanAddressWidth << " byte(s)");
+  if (g_uanAddressWidth == 1)
+    {
+      i.WriteU8 (address);
+    }
+  else
+    {
+      i.WriteHtonU16 (m_address);
+    }
+}
+
+UanAddress
+UanAddress::Deserialize (Buffer::Iterator &i)
+{
+  UanAddressUseWidth ();
+  if (g_uanAddressWidth == 1)
+    {
+      uint8_t address = i.ReadU8 ();
+      return address == UanAddressWireBroadcast () ? GetBroadcast () : UanAddress (address);
+    }
+  return UanAddress (i.ReadNtohU16 ());
+}
+
 bool
 UanAddress::IsMatchingType (const Address &address)
 {
-  return address.CheckCompatible (GetType (), 1);
+  return address.CheckCompatible (GetType (), 2);
 }
 
 UanAddress::operator Address () const
@@ -78,33 +198,31 @@ UanAddress::operator Address () const
 void
 UanAddress::CopyFrom (const uint8_t *pBuffer)
 {
-  m_address = *pBuffer;
+  m_address = (pBuffer[0] << 8) | pBuffer[1];
 }
 
 void
 UanAddress::CopyTo (uint8_t *pBuffer)
 {
-  *pBuffer = m_address;
-
+  pBuffer[0] = m_address >> 8;
+  pBuffer[1] = m_address & 0xff;
 }
 
 UanAddress
 UanAddress::GetBroadcast ()
 {
-  return UanAddress (255);
+  return UanAddress (UAN_ADDRESS_BROADCAST);
 }
 UanAddress
 UanAddress::Allocate ()
 {
-  static uint8_t nextAllocated = 0;
-
-  uint32_t address = nextAllocated++;
-  if (nextAllocated == 255)
+  UanAddressUseWidth ();
+  if (g_uanAddressNext >= UanAddressWireBroadcast ())
     {
-      nextAllocated = 0;
+      NS_FATAL_ERROR ("All " << UanAddressWireBroadcast () << " UAN addresses of "
+                      << (int) g_uanAddressWidth << " byte(s) allocated, see UanAddress::SetWidth");
     }
-
-  return UanAddress (address);
+  return UanAddress (g_uanAddressNext++);
 }
 
 bool
@@ -137,8 +255,8 @@ operator>> (std::istream& is, UanAddress & address)
   int x;
   is >> x;
   NS_ASSERT (0 <= x);
-  NS_ASSERT (x <= 255);
-  address.m_address = x;
+  NS_ASSERT (x <= UanAddressWireBroadcast ());
+  address.m_address = x == UanAddressWireBroadcast () ? UAN_ADDRESS_BROADCAST : x;
   return is;
 }
 
@@ -22,6 +22,7 @@
 #define UAN_ADDRESS_H
 
 #include "ns3/address.h"
+#include "ns3/buffer.h"
 #include <iostream>
 
 namespace ns3 {
@@ -36,18 +37,24 @@ namespace ns3 {
  * exceed 200 nodes (or the overlapping of two underwater networks
  * - the ocean is big), so this should provide adequate addressing
  * for most applications.
+ *
+ * Larger deployments can switch to 16 bit addresses with SetWidth.
+ * The width decides how many bytes the UAN headers use per address.  It
+ * holds for one simulation run: it must be set before the first address
+ * is allocated or serialized, and Simulator::Destroy resets it to 1 along
+ * with the Allocate counter.  The generic Address form is always 2 bytes.
  */
 class UanAddress
 {
 public:
-  /** Constructor */
+  /** Constructor, the broadcast address */
   UanAddress ();
   /**
    * Create UanAddress object with address addr.
    *
-   * \param addr Byte address to assign to this address.
+   * \param addr Address to assign, below the broadcast address.
    */
-  UanAddress (uint8_t addr);
+  UanAddress (uint16_t addr);
   /** Destructor */
   virtual ~UanAddress ();
 
@@ -77,36 +84,78 @@ public:
   /**
    * Sets address to address stored in parameter.
    *
-   * \param pBuffer Buffer to extract address from.
+   * \param pBuffer Buffer to extract address from, 2 bytes.
    */
   void CopyFrom (const uint8_t *pBuffer);
 
   /**
    * Writes address to buffer parameter.
    *
-   * \param pBuffer
+   * \param pBuffer Buffer of at least 2 bytes.
    */
   void CopyTo (uint8_t *pBuffer);
 
   /**
    * Convert to integer.
    *
-   * \return 8 bit integer version of address.
+   * \return Integer version of address.
+   */
+  uint16_t GetAsInt (void) const;
+
+  /**
+   * Select the address width for this run.  Changing it once addresses
+   * have been allocated or serialized is a fatal error.
+   *
+   * \param bytes 1 (default, legacy header sizes) or 2.
+   */
+  static void SetWidth (uint8_t bytes);
+  /**
+   * Get the address width.
+   *
+   * \return Bytes per address in serialized headers.
+   */
+  static uint8_t GetWidth (void);
+  /**
+   * Select bit-packed headers for this run, see UanHeaderPacking.  Like
+   * the width, Simulator::Destroy resets it (to 0).
+   *
+   * \param bits Bits per packed address, 0 for byte aligned headers.
+   */
+  static void SetPackedBits (uint8_t bits);
+  /**
+   * \return Bits per packed address, 0 when headers are byte aligned.
+   */
+  static uint8_t GetPackedBits (void);
+
+  /**
+   * Write the address to a header at the selected width.
+   *
+   * \param i Buffer position, advanced past the address.
+   */
+  void Serialize (Buffer::Iterator &i) const;
+  /**
+   * Read an address written by Serialize.
+   *
+   * \param i Buffer position, advanced past the address.
+   * \return The address.
    */
-  uint8_t GetAsInt (void) const;
+  static UanAddress Deserialize (Buffer::Iterator &i);
 
   /**
-   * Get the broadcast address (255).
+   * Get the broadcast address.  It is 65535 at every width, and goes on
+   * the air as all ones (255 with 8 bit addresses), so a default
+   * constructed address stays broadcast whatever width is set later.
    *
    * \return Broadcast address.
    */
   static UanAddress GetBroadcast (void);
 
   /**
-   * Allocates UanAddress from 0-254
+   * Allocates UanAddress from 0 up to just below the all ones address
+   * of the current width (254, or 65534 with 16 bit addresses).
    *
-   * Will wrap back to 0 if more than 254 are allocated.
-   * Excludes the broadcast address.
+   * Allocating past that is a fatal error.  Excludes the broadcast
+   * address.  Numbering restarts at 0 after Simulator::Destroy.
    *
    * \return The next sequential UanAddress.
    */
@@ -114,7 +163,7 @@ public:
 
 
 private:
-  uint8_t m_address;  //!< The address.
+  uint16_t m_address;  //!< The address.
 
   /**
    * Get the UanAddress type.
@@ -0,0 +1,261 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-backoff.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanBackoff");
+
+NS_OBJECT_ENSURE_REGISTERED (UanBackoff);
+NS_OBJECT_ENSURE_REGISTERED (UanBackoffUniform);
+NS_OBJECT_ENSURE_REGISTERED (UanBackoffBeb);
+NS_OBJECT_ENSURE_REGISTERED (UanBackoffBayesian);
+
+/*************** UanBackoff definition *****************/
+UanBackoff::UanBackoff ()
+  : m_collisions (0),
+    m_successes (0),
+    m_retries (0),
+    m_deferrals (0)
+{
+  m_rand = CreateObject<UniformRandomVariable> ();
+}
+
+UanBackoff::~UanBackoff ()
+{
+}
+
+TypeId
+UanBackoff::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanBackoff")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+  ;
+  return tid;
+}
+
+void
+UanBackoff::NotifyCollision (void)
+{
+  m_collisions++;
+  m_retries++;
+}
+
+void
+UanBackoff::NotifySuccess (void)
+{
+  m_successes++;
+  m_retries = 0;
+}
+
+void
+UanBackoff::NotifyBusy (void)
+{
+  m_deferrals++;
+}
+
+uint32_t
+UanBackoff::GetCollisions (void) const
+{
+  return m_collisions;
+}
+
+uint32_t
+UanBackoff::GetSuccesses (void) const
+{
+  return m_successes;
+}
+
+uint32_t
+UanBackoff::GetRetries (void) const
+{
+  return m_retries;
+}
+
+uint32_t
+UanBackoff::GetDeferrals (void) const
+{
+  return m_deferrals;
+}
+
+void
+UanBackoff::Reset (void)
+{
+  m_collisions = 0;
+  m_successes = 0;
+  m_retries = 0;
+  m_deferrals = 0;
+}
+
+int64_t
+UanBackoff::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rand->SetStream (stream);
+  return 1;
+}
+
+void
+UanBackoff::DoDispose (void)
+{
+  m_rand = 0;
+  Object::DoDispose ();
+}
+
+/*************** UanBackoffUniform definition *****************/
+UanBackoffUniform::UanBackoffUniform ()
+  : UanBackoff ()
+{
+}
+
+UanBackoffUniform::~UanBackoffUniform ()
+{
+}
+
+TypeId
+UanBackoffUniform::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanBackoffUniform")
+    .SetParent<UanBackoff> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanBackoffUniform> ()
+  ;
+  return tid;
+}
+
+double
+UanBackoffUniform::GetBackoff (double min, double max)
+{
+  return m_rand->GetValue (min, max);
+}
+
+/*************** UanBackoffBeb definition *****************/
+UanBackoffBeb::UanBackoffBeb ()
+  : UanBackoff (),
+    m_maxMultiplier (10)
+{
+}
+
+UanBackoffBeb::~UanBackoffBeb ()
+{
+}
+
+TypeId
+UanBackoffBeb::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanBackoffBeb")
+    .SetParent<UanBackoff> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanBackoffBeb> ()
+    .AddAttribute ("MaxMultiplier",
+                   "Largest factor applied to the upper edge of the backoff window.",
+                   DoubleValue (10),
+                   MakeDoubleAccessor (&UanBackoffBeb::m_maxMultiplier),
+                   MakeDoubleChecker<double> (1))
+  ;
+  return tid;
+}
+
+double
+UanBackoffBeb::GetMultiplier (void) const
+{
+  return std::min (std::pow (2.0, (double) m_retries), m_maxMultiplier);
+}
+
+double
+UanBackoffBeb::GetBackoff (double min, double max)
+{
+  return m_rand->GetValue (min, max * GetMultiplier ());
+}
+
+/*************** UanBackoffBayesian definition *****************/
+UanBackoffBayesian::UanBackoffBayesian ()
+  : UanBackoff (),
+    m_contenders (1),
+    m_maxContenders (64)
+{
+}
+
+UanBackoffBayesian::~UanBackoffBayesian ()
+{
+}
+
+TypeId
+UanBackoffBayesian::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanBackoffBayesian")
+    .SetParent<UanBackoff> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanBackoffBayesian> ()
+    .AddAttribute ("MaxContenders",
+                   "Upper bound on the estimated number of contenders.",
+                   DoubleValue (64),
+                   MakeDoubleAccessor (&UanBackoffBayesian::m_maxContenders),
+                   MakeDoubleChecker<double> (1))
+  ;
+  return tid;
+}
+
+double
+UanBackoffBayesian::GetContenders (void) const
+{
+  return m_contenders;
+}
+
+double
+UanBackoffBayesian::GetBackoff (double min, double max)
+{
+  return m_rand->GetValue (min, max * m_contenders);
+}
+
+void
+UanBackoffBayesian::NotifyCollision (void)
+{
+  UanBackoff::NotifyCollision ();
+  m_contenders = std::min (m_contenders + 1.0 / (std::exp (1.0) - 2.0), m_maxContenders);
+}
+
+void
+UanBackoffBayesian::NotifySuccess (void)
+{
+  UanBackoff::NotifySuccess ();
+  m_contenders = std::max (m_contenders - 1.0, 1.0);
+}
+
+void
+UanBackoffBayesian::NotifyBusy (void)
+{
+  UanBackoff::NotifyBusy ();
+  m_contenders = std::min (std::max (m_contenders - 1.0, 2.0), m_maxContenders);
+}
+
+void
+UanBackoffBayesian::Reset (void)
+{
+  UanBackoff::Reset ();
+  m_contenders = 1;
+}
+
+} // namespace ns3
@@ -0,0 +1,195 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_BACKOFF_H
+#define UAN_BACKOFF_H
+
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Backoff policy base class for the contention MACs.
+ *
+ * The MAC keeps its own base window [min, max] (in seconds, slots or
+ * any other unit) and asks the policy for a draw inside a window
+ * widened according to the contention history.  The MAC reports the
+ * outcome of each attempt so the policy can adapt, and the policy
+ * keeps the per-node collision counters.
+ */
+class UanBackoff : public Object
+{
+public:
+  UanBackoff ();           //!< Default constructor
+  virtual ~UanBackoff ();  //!< Dummy destructor, see DoDispose.
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Draw a backoff value.
+   *
+   * \param min Lower edge of the MAC base window.
+   * \param max Upper edge of the MAC base window.
+   * \return Backoff in the same unit as min and max.
+   */
+  virtual double GetBackoff (double min, double max) = 0;
+
+  /** The last attempt failed (no CTS/ACK before timeout). */
+  virtual void NotifyCollision (void);
+  /** The last attempt succeeded. */
+  virtual void NotifySuccess (void);
+  /** Traffic from other nodes forced this node to defer. */
+  virtual void NotifyBusy (void);
+
+  /** \return Total number of failed attempts. */
+  uint32_t GetCollisions (void) const;
+  /** \return Total number of successful attempts. */
+  uint32_t GetSuccesses (void) const;
+  /** \return Failed attempts since the last success. */
+  uint32_t GetRetries (void) const;
+  /** \return Number of times the node deferred to other traffic. */
+  uint32_t GetDeferrals (void) const;
+
+  /** Reset the contention history and counters. */
+  virtual void Reset (void);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream First stream index to use.
+   * \return The number of stream indices assigned by this model.
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+  Ptr<UniformRandomVariable> m_rand;  //!< Backoff draws.
+  uint32_t m_collisions;              //!< Failed attempts.
+  uint32_t m_successes;               //!< Successful attempts.
+  uint32_t m_retries;                 //!< Failed attempts since the last success.
+  uint32_t m_deferrals;               //!< Deferrals to other traffic.
+
+};  // class UanBackoff
+
+/**
+ * \ingroup uan
+ *
+ * Memoryless backoff, uniform in the MAC base window.
+ *
+ * This is the behaviour the MACs had before backoff became pluggable.
+ */
+class UanBackoffUniform : public UanBackoff
+{
+public:
+  UanBackoffUniform ();
+  virtual ~UanBackoffUniform ();
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  // Inherited methods
+  virtual double GetBackoff (double min, double max);
+
+};  // class UanBackoffUniform
+
+/**
+ * \ingroup uan
+ *
+ * Binary exponential backoff.
+ *
+ * The upper edge of the window is multiplied by 2^k after k
+ * consecutive collisions, up to MaxMultiplier, and restored
+ * after a success.
+ */
+class UanBackoffBeb : public UanBackoff
+{
+public:
+  UanBackoffBeb ();
+  virtual ~UanBackoffBeb ();
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** \return Current window multiplier. */
+  double GetMultiplier (void) const;
+
+  // Inherited methods
+  virtual double GetBackoff (double min, double max);
+
+private:
+  double m_maxMultiplier;  //!< Largest window multiplier.
+
+};  // class UanBackoffBeb
+
+/**
+ * \ingroup uan
+ *
+ * Load-estimating (pseudo-Bayesian) backoff.
+ *
+ * Keeps an estimate of the number of backlogged contenders, following
+ * Rivest's pseudo-Bayesian broadcast: a collision adds 1/(e-2), a success
+ * removes one contender and overheard traffic from other nodes implies
+ * at least two.  The upper edge of the window is scaled by the estimate.
+ */
+class UanBackoffBayesian : public UanBackoff
+{
+public:
+  UanBackoffBayesian ();
+  virtual ~UanBackoffBayesian ();
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** \return Current estimate of backlogged contenders. */
+  double GetContenders (void) const;
+
+  // Inherited methods
+  virtual double GetBackoff (double min, double max);
+  virtual void NotifyCollision (void);
+  virtual void NotifySuccess (void);
+  virtual void NotifyBusy (void);
+  virtual void Reset (void);
+
+private:
+  double m_contenders;     //!< Estimated backlogged contenders.
+  double m_maxContenders;  //!< Cap on the estimate.
+
+};  // class UanBackoffBayesian
+
+} // namespace ns3
+
+#endif /* UAN_BACKOFF_H */
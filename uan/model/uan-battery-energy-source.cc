@@ -0,0 +1,366 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-battery-energy-source.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanBatteryEnergySource");
+
+NS_OBJECT_ENSURE_REGISTERED (UanBatteryEnergySource);
+
+TypeId
+UanBatteryEnergySource::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanBatteryEnergySource")
+    .SetParent<EnergySource> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanBatteryEnergySource> ()
+    .AddAttribute ("InitialEnergyJ",
+                   "Energy of a full battery, in J.",
+                   DoubleValue (10000.0),
+                   MakeDoubleAccessor (&UanBatteryEnergySource::SetInitialEnergy,
+                                       &UanBatteryEnergySource::GetInitialEnergy),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("SupplyVoltageV",
+                   "Supply voltage, in V.",
+                   DoubleValue (12.0),
+                   MakeDoubleAccessor (&UanBatteryEnergySource::SetSupplyVoltage,
+                                       &UanBatteryEnergySource::GetSupplyVoltage),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PeukertExponent",
+                   "Peukert exponent of the battery, 1 for an ideal one.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&UanBatteryEnergySource::m_peukertExponent),
+                   MakeDoubleChecker<double> (1.0))
+    .AddAttribute ("NominalCurrentA",
+                   "Discharge current at which the battery delivers InitialEnergyJ, in A.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&UanBatteryEnergySource::m_nominalCurrentA),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("RechargeThreshold",
+                   "Energy fraction a depleted battery must harvest back before "
+                   "the devices are notified of the recharge.",
+                   DoubleValue (0.05),
+                   MakeDoubleAccessor (&UanBatteryEnergySource::m_rechargeThreshold),
+                   MakeDoubleChecker<double> (0, 1))
+    .AddAttribute ("HarvestingPeriod",
+                   "Period of the harvesting profile, 0 to run it only once.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UanBatteryEnergySource::m_harvestingPeriod),
+                   MakeTimeChecker ())
+    .AddTraceSource ("RemainingEnergy",
+                     "Remaining energy at the battery.",
+                     MakeTraceSourceAccessor (&UanBatteryEnergySource::m_remainingEnergyJ),
+                     "ns3::TracedValueCallback::Double")
+  ;
+  return tid;
+}
+
+UanBatteryEnergySource::UanBatteryEnergySource ()
+  : m_initialEnergyJ (0),
+    m_supplyVoltageV (0),
+    m_peukertExponent (1.0),
+    m_nominalCurrentA (1.0),
+    m_rechargeThreshold (0),
+    m_remainingEnergyJ (0),
+    m_harvestedEnergyJ (0),
+    m_depleted (false),
+    m_harvestingPeriod (Seconds (0)),
+    m_lastUpdateTime (Seconds (0)),
+    m_rearmPending (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+UanBatteryEnergySource::~UanBatteryEnergySource ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+UanBatteryEnergySource::DoInitialize (void)
+{
+  NS_LOG_FUNCTION (this);
+  UpdateEnergySource ();
+}
+
+void
+UanBatteryEnergySource::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  BreakDeviceEnergyModelRefCycle ();
+}
+
+void
+UanBatteryEnergySource::SetInitialEnergy (double initialEnergyJ)
+{
+  NS_LOG_FUNCTION (this << initialEnergyJ);
+  NS_ASSERT (initialEnergyJ >= 0);
+  m_initialEnergyJ = initialEnergyJ;
+  m_remainingEnergyJ = initialEnergyJ;
+}
+
+void
+UanBatteryEnergySource::SetSupplyVoltage (double supplyVoltageV)
+{
+  NS_LOG_FUNCTION (this << supplyVoltageV);
+  m_supplyVoltageV = supplyVoltageV;
+}
+
+double
+UanBatteryEnergySource::GetInitialEnergy (void) const
+{
+  return m_initialEnergyJ;
+}
+
+double
+UanBatteryEnergySource::GetSupplyVoltage (void) const
+{
+  return m_supplyVoltageV;
+}
+
+double
+UanBatteryEnergySource::GetRemainingEnergy (void)
+{
+  NS_LOG_FUNCTION (this);
+  Integrate ();
+  return m_remainingEnergyJ;
+}
+
+double
+UanBatteryEnergySource::GetEnergyFraction (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_initialEnergyJ == 0)
+    {
+      return 0;
+    }
+  Integrate ();
+  return m_remainingEnergyJ / m_initialEnergyJ;
+}
+
+double
+UanBatteryEnergySource::GetHarvestedEnergy (void)
+{
+  Integrate ();
+  return m_harvestedEnergyJ;
+}
+
+bool
+UanBatteryEnergySource::IsDepleted (void) const
+{
+  return m_depleted;
+}
+
+void
+UanBatteryEnergySource::UpdateEnergySource (void)
+{
+  NS_LOG_FUNCTION (this);
+  Integrate ();
+  CheckThresholds ();
+
+  // Device models call this before they change their draw, so the new
+  // current is only known once the caller returns
+  if (!m_rearmPending)
+    {
+      m_rearmPending = true;
+      Simulator::ScheduleNow (&UanBatteryEnergySource::Rearm, this);
+    }
+}
+
+void
+UanBatteryEnergySource::AddHarvestingStep (Time start, double powerW)
+{
+  NS_LOG_FUNCTION (this << start << powerW);
+  NS_ASSERT (start >= Seconds (0));
+  Integrate ();
+  std::pair<Time, double> step (start, powerW);
+  m_harvesting.insert (std::upper_bound (m_harvesting.begin (), m_harvesting.end (), step), step);
+  if (!m_rearmPending)
+    {
+      Rearm ();
+    }
+}
+
+double
+UanBatteryEnergySource::GetHarvestingPower (Time t) const
+{
+  if (m_harvesting.empty ())
+    {
+      return 0;
+    }
+  Time offset = t;
+  if (m_harvestingPeriod > Seconds (0))
+    {
+      offset = TimeStep (t.GetTimeStep () % m_harvestingPeriod.GetTimeStep ());
+    }
+  // Last step at or before offset; a periodic profile wraps around
+  double powerW = m_harvestingPeriod > Seconds (0) ? m_harvesting.back ().second : 0;
+  for (std::vector<std::pair<Time, double> >::const_iterator it = m_harvesting.begin ();
+       it != m_harvesting.end () && it->first <= offset; ++it)
+    {
+      powerW = it->second;
+    }
+  return powerW;
+}
+
+Time
+UanBatteryEnergySource::GetNextHarvestingStep (Time t) const
+{
+  if (m_harvesting.empty ())
+    {
+      return Time::Max ();
+    }
+  Time base = Seconds (0);
+  Time offset = t;
+  if (m_harvestingPeriod > Seconds (0))
+    {
+      offset = TimeStep (t.GetTimeStep () % m_harvestingPeriod.GetTimeStep ());
+      base = t - offset;
+    }
+  for (std::vector<std::pair<Time, double> >::const_iterator it = m_harvesting.begin ();
+       it != m_harvesting.end (); ++it)
+    {
+      if (it->first > offset)
+        {
+          return base + it->first;
+        }
+    }
+  if (m_harvestingPeriod > Seconds (0))
+    {
+      return base + m_harvestingPeriod + m_harvesting.front ().first;
+    }
+  return Time::Max ();
+}
+
+double
+UanBatteryEnergySource::HarvestEnergy (Time from, Time to) const
+{
+  double energyJ = 0;
+  Time t = from;
+  while (t < to)
+    {
+      Time next = std::min (to, GetNextHarvestingStep (t));
+      energyJ += GetHarvestingPower (t) * (next - t).GetSeconds ();
+      t = next;
+    }
+  return energyJ;
+}
+
+double
+UanBatteryEnergySource::GetEffectiveCurrent (double currentA) const
+{
+  if (currentA <= 0 || m_peukertExponent == 1.0 || m_nominalCurrentA == 0)
+    {
+      return currentA;
+    }
+  return currentA * std::pow (currentA / m_nominalCurrentA, m_peukertExponent - 1.0);
+}
+
+void
+UanBatteryEnergySource::Integrate (void)
+{
+  Time now = Simulator::Now ();
+  if (now == m_lastUpdateTime)
+    {
+      return;
+    }
+  // The models still draw what they drew since the last update
+  double duration = (now - m_lastUpdateTime).GetSeconds ();
+  double drainedJ = GetEffectiveCurrent (CalculateTotalCurrent ()) * m_supplyVoltageV * duration;
+  double harvestedJ = HarvestEnergy (m_lastUpdateTime, now);
+  m_lastUpdateTime = now;
+
+  m_harvestedEnergyJ += harvestedJ;
+  double remainingJ = m_remainingEnergyJ - drainedJ + harvestedJ;
+  m_remainingEnergyJ = std::max (0.0, std::min (m_initialEnergyJ, remainingJ));
+  NS_LOG_DEBUG ("UanBatteryEnergySource:Remaining energy = " << m_remainingEnergyJ);
+}
+
+void
+UanBatteryEnergySource::CheckThresholds (void)
+{
+  if (!m_depleted && m_remainingEnergyJ <= 0)
+    {
+      NS_LOG_DEBUG ("UanBatteryEnergySource:Energy depleted!");
+      m_depleted = true;
+      NotifyEnergyDrained ();
+    }
+  else if (m_depleted && m_remainingEnergyJ > 0
+           && m_remainingEnergyJ >= m_rechargeThreshold * m_initialEnergyJ)
+    {
+      NS_LOG_DEBUG ("UanBatteryEnergySource:Energy recharged!");
+      m_depleted = false;
+      NotifyEnergyRecharged ();
+    }
+}
+
+void
+UanBatteryEnergySource::Rearm (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rearmPending = false;
+  m_event.Cancel ();
+
+  Time now = Simulator::Now ();
+  Time next = GetNextHarvestingStep (now);
+  double netPowerW = GetHarvestingPower (now)
+    - GetEffectiveCurrent (CalculateTotalCurrent ()) * m_supplyVoltageV;
+
+  double targetJ = -1;
+  if (!m_depleted && netPowerW < 0)
+    {
+      targetJ = 0;
+    }
+  else if (m_depleted && netPowerW > 0)
+    {
+      targetJ = std::max (m_rechargeThreshold * m_initialEnergyJ, 0.0);
+    }
+  if (targetJ >= 0)
+    {
+      // Round up, so the battery has crossed the target when the event fires
+      double seconds = std::fabs (m_remainingEnergyJ - targetJ) / std::fabs (netPowerW);
+      Time cross = now + NanoSeconds (std::max (1.0, std::ceil (seconds * 1e9)));
+      next = std::min (next, cross);
+    }
+
+  if (next != Time::Max ())
+    {
+      m_event = Simulator::Schedule (next - now, &UanBatteryEnergySource::Check, this);
+    }
+}
+
+void
+UanBatteryEnergySource::Check (void)
+{
+  NS_LOG_FUNCTION (this);
+  Integrate ();
+  CheckThresholds ();
+  Rearm ();
+}
+
+} // namespace ns3
@@ -0,0 +1,127 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_BATTERY_ENERGY_SOURCE_H
+#define UAN_BATTERY_ENERGY_SOURCE_H
+
+#include "ns3/energy-source.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-value.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Battery for long-lived acoustic nodes, with rate-dependent capacity
+ * and an optional harvesting profile.
+ *
+ * Capacity follows Peukert's law: a load current I above NominalCurrent
+ * drains the battery as I (I / NominalCurrent)^(PeukertExponent - 1).
+ * Harvested power is a piecewise-constant profile (AddHarvestingStep),
+ * repeated every HarvestingPeriod when that is not zero.
+ *
+ * There is no periodic update.  The battery is integrated when a device
+ * model reports a change, and a single event is kept armed for the
+ * earliest of the predicted depletion (or recharge) time and the next
+ * harvesting step, so depletion is detected exactly.  On depletion every
+ * model is notified; AcousticModemEnergyModel then switches off, drawing
+ * nothing until the recharge, and disables every UAN PHY of the node.
+ * The remaining energy is clamped at 0 only for rounding, so with a
+ * PeukertExponent of 1 the models' totals add up to the energy supplied.
+ */
+class UanBatteryEnergySource : public EnergySource
+{
+public:
+  static TypeId GetTypeId (void);
+  UanBatteryEnergySource ();
+  virtual ~UanBatteryEnergySource ();
+
+  // Inherited methods
+  virtual double GetInitialEnergy (void) const;
+  virtual double GetSupplyVoltage (void) const;
+  virtual double GetRemainingEnergy (void);
+  virtual double GetEnergyFraction (void);
+  virtual void UpdateEnergySource (void);
+
+  /** \param initialEnergyJ Full charge, in J.  Also sets the remaining energy. */
+  void SetInitialEnergy (double initialEnergyJ);
+  /** \param supplyVoltageV Supply voltage, in V. */
+  void SetSupplyVoltage (double supplyVoltageV);
+
+  /**
+   * Harvest powerW from start on, until the next step.  Steps may be
+   * added in any order.
+   *
+   * \param start Offset from the start of the simulation, or of each
+   *   HarvestingPeriod.
+   * \param powerW Harvested power, in W.
+   */
+  void AddHarvestingStep (Time start, double powerW);
+  /** \return Harvested power at time t, in W. */
+  double GetHarvestingPower (Time t) const;
+  /** \return Energy harvested so far, in J. */
+  double GetHarvestedEnergy (void);
+
+  /** \return True from depletion until recharged above RechargeThreshold. */
+  bool IsDepleted (void) const;
+
+private:
+  virtual void DoInitialize (void);
+  virtual void DoDispose (void);
+
+  /** Integrate load and harvest since m_lastUpdateTime. */
+  void Integrate (void);
+  /** Check depletion and recharge at the current remaining energy. */
+  void CheckThresholds (void);
+  /** Arm m_event for the next depletion, recharge or harvesting step. */
+  void Rearm (void);
+  /** m_event handler. */
+  void Check (void);
+
+  /** \return Load current corrected for the discharge rate. */
+  double GetEffectiveCurrent (double currentA) const;
+  /** \return Time of the first harvesting step after t. */
+  Time GetNextHarvestingStep (Time t) const;
+  /** \return Energy harvested between from and to. */
+  double HarvestEnergy (Time from, Time to) const;
+
+  double m_initialEnergyJ;
+  double m_supplyVoltageV;
+  double m_peukertExponent;
+  double m_nominalCurrentA;
+  double m_rechargeThreshold;   //!< Fraction that ends depletion.
+  TracedValue<double> m_remainingEnergyJ;
+  double m_harvestedEnergyJ;
+  bool m_depleted;
+
+  /** Harvesting steps (start, power), by start. */
+  std::vector<std::pair<Time, double> > m_harvesting;
+  Time m_harvestingPeriod;
+
+  Time m_lastUpdateTime;
+  EventId m_event;              //!< Next depletion, recharge or step.
+  bool m_rearmPending;          //!< Rearm scheduled for the current time.
+};
+
+} // namespace ns3
+
+#endif /* UAN_BATTERY_ENERGY_SOURCE_H */
@@ -126,6 +126,12 @@ UanChannel::SetPropagationModel (Ptr<UanPropModel> prop)
   m_prop = prop;
 }
 
+Ptr<UanPropModel>
+UanChannel::GetPropagationModel (void) const
+{
+  return m_prop;
+}
+
 uint32_t
 UanChannel::GetNDevices () const
 {
@@ -90,6 +90,8 @@ public:
    * \param prop The propagation model.
    */
   void SetPropagationModel (Ptr<UanPropModel> prop);
+  /** \return The propagation model of this channel. */
+  Ptr<UanPropModel> GetPropagationModel (void) const;
 
   /**
    * Set the noise model this channel will use
@@ -0,0 +1,260 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-duty-cycle-controller.h"
+#include "uan-mac-wakeup.h"
+#include "uan-phy-gen.h"
+#include "ns3/energy-source.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanDutyCycleController");
+
+NS_OBJECT_ENSURE_REGISTERED (UanDutyCycleController);
+
+UanDutyCycleController::UanDutyCycleController ()
+  : m_level (0),
+    m_listening (false),
+    m_holding (false),
+    m_lastEnergyJ (0),
+    m_lastWakeups (0),
+    m_lastControl (Seconds (0))
+{
+}
+
+UanDutyCycleController::~UanDutyCycleController ()
+{
+}
+
+TypeId
+UanDutyCycleController::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanDutyCycleController")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanDutyCycleController> ()
+    .AddAttribute ("BasePeriod",
+                   "Listen period at level 0.",
+                   TimeValue (Seconds (10)),
+                   MakeTimeAccessor (&UanDutyCycleController::m_basePeriod),
+                   MakeTimeChecker ())
+    .AddAttribute ("ListenWindow",
+                   "Time the wakeup receiver listens at the start of each period. "
+                   "Must cover the tone air time plus the largest propagation delay.",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&UanDutyCycleController::m_listenWindow),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxLevel",
+                   "Largest level, the longest period is BasePeriod * 2^MaxLevel.",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&UanDutyCycleController::m_maxLevel),
+                   MakeUintegerChecker<uint32_t> (0, 16))
+    .AddAttribute ("ControlInterval",
+                   "Time between level adjustments.",
+                   TimeValue (Seconds (3600)),
+                   MakeTimeAccessor (&UanDutyCycleController::m_controlInterval),
+                   MakeTimeChecker ())
+    .AddAttribute ("TargetLifetime",
+                   "Time, from the start of the simulation, the node should last.",
+                   TimeValue (Seconds (180 * 86400)),
+                   MakeTimeAccessor (&UanDutyCycleController::m_targetLifetime),
+                   MakeTimeChecker ())
+    .AddAttribute ("Hysteresis",
+                   "Fraction by which the predicted lifetime must exceed the target "
+                   "before the level is lowered.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&UanDutyCycleController::m_hysteresis),
+                   MakeDoubleChecker<double> (0))
+    .AddTraceSource ("Level",
+                     "The duty cycle level changed.",
+                     MakeTraceSourceAccessor (&UanDutyCycleController::m_level),
+                     "ns3::TracedValueCallback::Uint32")
+  ;
+  return tid;
+}
+
+void
+UanDutyCycleController::DoDispose (void)
+{
+  m_timerListen.Cancel ();
+  m_timerEnd.Cancel ();
+  m_timerControl.Cancel ();
+  m_mac = 0;
+  m_phy = 0;
+  m_source = 0;
+  Object::DoDispose ();
+}
+
+void
+UanDutyCycleController::Install (Ptr<UanMacWakeup> mac, Ptr<EnergySource> source)
+{
+  NS_ASSERT_MSG (m_listenWindow < m_basePeriod, "ListenWindow must be shorter than BasePeriod");
+  m_mac = mac;
+  m_phy = mac->GetWakeupPhy ();
+  m_source = source;
+
+  // The timers share the timer queue of the MAC
+  m_timerListen.Attach (mac->GetFsm (), "DutyListen", MakeCallback (&UanDutyCycleController::StartListen, this));
+  m_timerEnd.Attach (mac->GetFsm (), "DutyEnd", MakeCallback (&UanDutyCycleController::EndListen, this));
+  m_timerControl.Attach (mac->GetFsm (), "DutyControl", MakeCallback (&UanDutyCycleController::Control, this));
+  mac->SetDutyCycleController (this);
+
+  m_lastEnergyJ = source != 0 ? source->GetRemainingEnergy () : 0;
+  m_lastWakeups = mac->GetWakeupsReceived ();
+  m_lastControl = Simulator::Now ();
+  m_timerControl.Schedule (m_controlInterval);
+
+  m_phy->SetSleepMode (true);
+  ScheduleListen ();
+}
+
+uint32_t
+UanDutyCycleController::GetLevel (void) const
+{
+  return m_level;
+}
+
+Time
+UanDutyCycleController::GetPeriod (void) const
+{
+  return TimeStep (m_basePeriod.GetTimeStep () << m_level);
+}
+
+Time
+UanDutyCycleController::GetNextWindow (void) const
+{
+  int64_t base = m_basePeriod.GetTimeStep ();
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  return TimeStep ((now + base - 1) / base * base);
+}
+
+bool
+UanDutyCycleController::IsListening (void) const
+{
+  return m_listening;
+}
+
+Time
+UanDutyCycleController::Hold (void)
+{
+  m_holding = true;
+  m_phy->SetSleepMode (false);
+  Ptr<UanPhyGen> phy = DynamicCast<UanPhyGen> (m_phy);
+  return phy != 0 ? phy->GetWakeupDelayLeft () : Seconds (0);
+}
+
+void
+UanDutyCycleController::Release (void)
+{
+  m_holding = false;
+  if (!m_listening && !m_phy->IsStateRx () && !m_phy->IsStateTx ())
+    {
+      m_phy->SetSleepMode (true);
+    }
+}
+
+void
+UanDutyCycleController::StartListen (void)
+{
+  NS_LOG_DEBUG (Simulator::Now ().GetSeconds () << " wakeup receiver listens, level " << m_level);
+  m_listening = true;
+  m_phy->SetSleepMode (false);
+  m_timerEnd.Schedule (m_listenWindow);
+}
+
+void
+UanDutyCycleController::EndListen (void)
+{
+  // Do not cut a reception or an exchange short
+  if (m_holding || m_mac->IsBusy () || m_phy->IsStateRx () || m_phy->IsStateTx ())
+    {
+      m_timerEnd.Schedule (m_listenWindow);
+      return;
+    }
+  NS_LOG_DEBUG (Simulator::Now ().GetSeconds () << " wakeup receiver sleeps");
+  m_listening = false;
+  m_phy->SetSleepMode (true);
+  ScheduleListen ();
+}
+
+void
+UanDutyCycleController::ScheduleListen (void)
+{
+  int64_t period = GetPeriod ().GetTimeStep ();
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  m_timerListen.Cancel ();
+  m_timerListen.Schedule (TimeStep ((now + period - 1) / period * period - now));
+}
+
+void
+UanDutyCycleController::Control (void)
+{
+  Time now = Simulator::Now ();
+  double interval = (now - m_lastControl).GetSeconds ();
+  m_lastControl = now;
+
+  uint32_t wakeups = m_mac->GetWakeupsReceived ();
+  double rate = (wakeups - m_lastWakeups) / interval;
+  m_lastWakeups = wakeups;
+
+  double lifetime = std::numeric_limits<double>::infinity ();
+  if (m_source != 0)
+    {
+      double energyJ = m_source->GetRemainingEnergy ();
+      double powerW = (m_lastEnergyJ - energyJ) / interval;
+      if (powerW > 0)
+        {
+          lifetime = energyJ / powerW;
+        }
+      m_lastEnergyJ = energyJ;
+    }
+  double needed = (m_targetLifetime - now).GetSeconds ();
+
+  uint32_t level = m_level;
+  if (lifetime < needed)
+    {
+      level = std::min (level + 1, m_maxLevel);
+    }
+  else if (level > 0
+           && (lifetime > needed * (1 + m_hysteresis) || rate * GetPeriod ().GetSeconds () > 1))
+    {
+      level--;
+    }
+
+  if (level != m_level)
+    {
+      NS_LOG_DEBUG (now.GetSeconds () << " lifetime " << lifetime << " s, needed " << needed
+                                      << " s, tone rate " << rate << "/s, level " << m_level << " -> " << level);
+      m_level = level;
+      if (!m_listening)
+        {
+          ScheduleListen ();
+        }
+    }
+  m_timerControl.Schedule (m_controlInterval);
+}
+
+} // namespace ns3
@@ -0,0 +1,124 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_DUTY_CYCLE_CONTROLLER_H_
+#define UAN_DUTY_CYCLE_CONTROLLER_H_
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include "uan-mac-fsm.h"
+
+namespace ns3 {
+
+class UanMacWakeup;
+class UanPhy;
+class EnergySource;
+
+/**
+ * \ingroup uan
+ *
+ * Duty cycle of the wakeup receiver of a UanMacWakeup.
+ *
+ * The wakeup receiver listens for ListenWindow at the start of every
+ * period and sleeps otherwise.  The period is BasePeriod * 2^level, and
+ * windows are aligned to multiples of it, so every window of a node is
+ * also a base window of its neighbors.  Tones are held until the next
+ * base window; a tone sent to a node that skips that window is lost and
+ * left to the retries of the upper MAC.  This is the latency traded for
+ * lifetime.  ListenWindow must cover the tone air time plus the largest
+ * propagation delay.
+ *
+ * Every ControlInterval the level is adjusted.  The lifetime predicted
+ * from the remaining energy of the node EnergySource and the power drawn
+ * over the last interval is compared with what is left of
+ * TargetLifetime: a short lifetime raises the level; a lifetime longer
+ * than the target by Hysteresis, or more wakeup tones than windows
+ * received in the interval, lowers it.
+ */
+class UanDutyCycleController : public Object
+{
+public:
+  UanDutyCycleController ();
+  virtual ~UanDutyCycleController ();
+  static TypeId GetTypeId (void);
+
+  /**
+   * Start duty-cycling the wakeup receiver of mac.
+   *
+   * \param mac Wakeup MAC, with its PHYs attached.
+   * \param source Energy source of the node, 0 to follow traffic only.
+   */
+  void Install (Ptr<UanMacWakeup> mac, Ptr<EnergySource> source);
+
+  /** \return Current level, the period is BasePeriod * 2^level. */
+  uint32_t GetLevel (void) const;
+  /** \return Current listen period. */
+  Time GetPeriod (void) const;
+  /** \return Start of the next base window, now if one starts now. */
+  Time GetNextWindow (void) const;
+  /** \return True while the wakeup receiver is in a listen window. */
+  bool IsListening (void) const;
+
+  /**
+   * Keep the wakeup receiver awake to transmit.
+   *
+   * \return Time left before the receiver can transmit, non-zero while
+   *   it warms up from sleep.
+   */
+  Time Hold (void);
+  /** Transmission over, sleep again if outside a listen window. */
+  void Release (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void StartListen (void);
+  void EndListen (void);
+  /** Schedule the next listen window for the current level. */
+  void ScheduleListen (void);
+  /** Adjust the level from energy and traffic. */
+  void Control (void);
+
+  Time m_basePeriod;
+  Time m_listenWindow;
+  uint32_t m_maxLevel;
+  Time m_controlInterval;
+  Time m_targetLifetime;
+  double m_hysteresis;
+
+  Ptr<UanMacWakeup> m_mac;
+  Ptr<UanPhy> m_phy;
+  Ptr<EnergySource> m_source;
+
+  UanMacFsmTimer m_timerListen;
+  UanMacFsmTimer m_timerEnd;
+  UanMacFsmTimer m_timerControl;
+
+  TracedValue<uint32_t> m_level;
+  bool m_listening;
+  bool m_holding;
+  double m_lastEnergyJ;      //!< Remaining energy at the last control.
+  uint32_t m_lastWakeups;    //!< Tones received at the last control.
+  Time m_lastControl;
+};
+
+} // namespace ns3
+
+#endif /* UAN_DUTY_CYCLE_CONTROLLER_H_ */
@@ -20,10 +20,12 @@
 
 #include "uan-header-common.h"
 #include "uan-address.h"
+#include "uan-header-packing.h"
 
 namespace ns3 {
 
 NS_OBJECT_ENSURE_REGISTERED (UanHeaderCommon);
+NS_OBJECT_ENSURE_REGISTERED (UanHeaderRoute);
 
 UanHeaderCommon::UanHeaderCommon ()
 {
@@ -97,14 +99,27 @@ UanHeaderCommon::GetType (void) const
 uint32_t
 UanHeaderCommon::GetSerializedSize (void) const
 {
-  return 1 + 1 + 1;
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      return UanHeaderPacking::GetBytes (2 * UanHeaderPacking::GetAddressBits () + 3);
+    }
+  return 2 * UanAddress::GetWidth () + 1;
 }
 
 void
 UanHeaderCommon::Serialize (Buffer::Iterator start) const
 {
-  start.WriteU8 (m_src.GetAsInt ());
-  start.WriteU8 (m_dest.GetAsInt ());
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitWriter bits (start);
+      bits.WriteAddress (m_src);
+      bits.WriteAddress (m_dest);
+      bits.Write (m_type, 3);
+      bits.Flush ();
+      return;
+    }
+  m_src.Serialize (start);
+  m_dest.Serialize (start);
   start.WriteU8 (m_type);
 }
 
@@ -113,8 +128,16 @@ UanHeaderCommon::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator rbuf = start;
 
-  m_src = UanAddress (rbuf.ReadU8 ());
-  m_dest = UanAddress (rbuf.ReadU8 ());
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitReader bits (rbuf);
+      m_src = bits.ReadAddress ();
+      m_dest = bits.ReadAddress ();
+      m_type = bits.Read (3);
+      return rbuf.GetDistanceFrom (start);
+    }
+  m_src = UanAddress::Deserialize (rbuf);
+  m_dest = UanAddress::Deserialize (rbuf);
   m_type = rbuf.ReadU8 ();
 
   return rbuf.GetDistanceFrom (start);
@@ -127,6 +150,109 @@ UanHeaderCommon::Print (std::ostream &os) const
 }
 
 
+UanHeaderRoute::UanHeaderRoute ()
+{
+}
+
+UanHeaderRoute::UanHeaderRoute (const UanAddress origin, const UanAddress target)
+  : Header (),
+    m_origin (origin),
+    m_final (target)
+{
+}
+
+UanHeaderRoute::~UanHeaderRoute ()
+{
+}
+
+TypeId
+UanHeaderRoute::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanHeaderRoute")
+    .SetParent<Header> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanHeaderRoute> ()
+  ;
+  return tid;
+}
+
+TypeId
+UanHeaderRoute::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+UanHeaderRoute::SetOrigin (UanAddress origin)
+{
+  m_origin = origin;
+}
+void
+UanHeaderRoute::SetFinal (UanAddress target)
+{
+  m_final = target;
+}
+UanAddress
+UanHeaderRoute::GetOrigin (void) const
+{
+  return m_origin;
+}
+UanAddress
+UanHeaderRoute::GetFinal (void) const
+{
+  return m_final;
+}
+
+uint32_t
+UanHeaderRoute::GetSerializedSize (void) const
+{
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      return UanHeaderPacking::GetBytes (2 * UanHeaderPacking::GetAddressBits ());
+    }
+  return 2 * UanAddress::GetWidth ();
+}
+
+void
+UanHeaderRoute::Serialize (Buffer::Iterator start) const
+{
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitWriter bits (start);
+      bits.WriteAddress (m_origin);
+      bits.WriteAddress (m_final);
+      bits.Flush ();
+      return;
+    }
+  m_origin.Serialize (start);
+  m_final.Serialize (start);
+}
+
+uint32_t
+UanHeaderRoute::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator rbuf = start;
+
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitReader bits (rbuf);
+      m_origin = bits.ReadAddress ();
+      m_final = bits.ReadAddress ();
+      return rbuf.GetDistanceFrom (start);
+    }
+  m_origin = UanAddress::Deserialize (rbuf);
+  m_final = UanAddress::Deserialize (rbuf);
+
+  return rbuf.GetDistanceFrom (start);
+}
+
+void
+UanHeaderRoute::Print (std::ostream &os) const
+{
+  os << "UAN origin=" << m_origin << " final=" << m_final;
+}
+
+
 
 
 } // namespace ns3
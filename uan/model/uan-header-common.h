@@ -33,8 +33,8 @@ namespace ns3 {
  *
  * Common packet header fields.
  *
- * Includes 1 byte src address, 1 byte dest address,
- * and a 1 byte type field.
+ * Includes src and dest addresses, 1 byte each or 2 with
+ * 16 bit addresses (see UanAddress::SetWidth), and a 1 byte type field.
  *
  * The type field is protocol specific; see the relevant MAC protocol.
  */
@@ -114,6 +114,48 @@ private:
 
 };  // class UanHeaderCommon
 
+/**
+ * \ingroup uan
+ *
+ * End to end addresses of a routed packet.
+ *
+ * Added by UanNetDevice when a UanRoutingTable is attached: origin
+ * and final destination addresses, carried unchanged across relays.
+ */
+class UanHeaderRoute : public Header
+{
+public:
+  UanHeaderRoute ();
+  /**
+   * \param origin Node that generated the packet.
+   * \param target Node the packet is for.
+   */
+  UanHeaderRoute (const UanAddress origin, const UanAddress target);
+  virtual ~UanHeaderRoute ();
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  void SetOrigin (UanAddress origin);
+  void SetFinal (UanAddress target);
+  UanAddress GetOrigin (void) const;
+  UanAddress GetFinal (void) const;
+
+  // Inherited methods
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  virtual TypeId GetInstanceTypeId (void) const;
+private:
+  UanAddress m_origin;  //!< The originating node.
+  UanAddress m_final;   //!< The final destination.
+
+};  // class UanHeaderRoute
+
 } // namespace ns3
 
 #endif /* UAN_HEADER_COMMON_H */
@@ -0,0 +1,143 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-header-packing.h"
+#include "ns3/abort.h"
+
+namespace ns3 {
+
+void
+UanHeaderPacking::Enable (uint8_t addressBits)
+{
+  NS_ABORT_MSG_IF (addressBits == 0, "Packed addresses take 1 to 16 bits");
+  UanAddress::SetPackedBits (addressBits);
+}
+
+void
+UanHeaderPacking::Disable (void)
+{
+  UanAddress::SetPackedBits (0);
+}
+
+bool
+UanHeaderPacking::IsEnabled (void)
+{
+  return UanAddress::GetPackedBits () > 0;
+}
+
+uint8_t
+UanHeaderPacking::GetAddressBits (void)
+{
+  return UanAddress::GetPackedBits ();
+}
+
+uint32_t
+UanHeaderPacking::GetBytes (uint32_t bits)
+{
+  return (bits + 7) / 8;
+}
+
+
+UanBitWriter::UanBitWriter (Buffer::Iterator &i)
+  : m_i (i),
+    m_byte (0),
+    m_used (0)
+{
+}
+
+void
+UanBitWriter::Write (uint32_t value, uint8_t bits)
+{
+  NS_ABORT_MSG_IF (bits < 32 && value >= (1u << bits), "Value " << value << " does not fit in " << (uint32_t) bits << " bits");
+  while (bits > 0)
+    {
+      bits--;
+      m_byte = (m_byte << 1) | ((value >> bits) & 1);
+      if (++m_used == 8)
+        {
+          m_i.WriteU8 (m_byte);
+          m_byte = 0;
+          m_used = 0;
+        }
+    }
+}
+
+void
+UanBitWriter::WriteAddress (UanAddress addr)
+{
+  uint8_t bits = UanHeaderPacking::GetAddressBits ();
+  uint32_t all = (1u << bits) - 1;
+  if (addr == UanAddress::GetBroadcast ())
+    {
+      Write (all, bits);
+      return;
+    }
+  NS_ABORT_MSG_IF (addr.GetAsInt () >= all, "Address " << addr << " does not fit in " << (uint32_t) bits << " packed bits");
+  Write (addr.GetAsInt (), bits);
+}
+
+void
+UanBitWriter::Flush (void)
+{
+  if (m_used > 0)
+    {
+      m_i.WriteU8 (m_byte << (8 - m_used));
+      m_byte = 0;
+      m_used = 0;
+    }
+}
+
+
+UanBitReader::UanBitReader (Buffer::Iterator &i)
+  : m_i (i),
+    m_byte (0),
+    m_left (0)
+{
+}
+
+uint32_t
+UanBitReader::Read (uint8_t bits)
+{
+  uint32_t value = 0;
+  while (bits > 0)
+    {
+      if (m_left == 0)
+        {
+          m_byte = m_i.ReadU8 ();
+          m_left = 8;
+        }
+      m_left--;
+      value = (value << 1) | ((m_byte >> m_left) & 1);
+      bits--;
+    }
+  return value;
+}
+
+UanAddress
+UanBitReader::ReadAddress (void)
+{
+  uint8_t bits = UanHeaderPacking::GetAddressBits ();
+  uint32_t value = Read (bits);
+  if (value == (1u << bits) - 1)
+    {
+      return UanAddress::GetBroadcast ();
+    }
+  return UanAddress (value);
+}
+
+} // namespace ns3
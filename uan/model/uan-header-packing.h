@@ -0,0 +1,104 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_HEADER_PACKING_H_
+#define UAN_HEADER_PACKING_H_
+
+#include "ns3/buffer.h"
+#include "uan-address.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Global switch for the bit-packed UAN header format.
+ *
+ * When enabled, UanHeaderCommon, UanHeaderRoute, UanHeaderWakeup,
+ * UanHeaderDuration, UanHeaderTimestamp, UanPhyHeader, UanPhyTrailer and
+ * the RC CTS headers drop byte alignment: addresses take
+ * GetAddressBits () bits, the common type 3 bits, durations are quantized
+ * to 16 bit milliseconds, FAMA timestamps keep their low 16 bits of
+ * milliseconds and CTS timestamps are coded relative to the CTS global
+ * timestamp.
+ * GetSerializedSize follows the format, so air times shrink with it.
+ * Like the address width, it must be chosen before the simulation runs
+ * and only lasts for that run.
+ */
+class UanHeaderPacking
+{
+public:
+  /**
+   * \param addressBits Bits per address, enough for the highest address
+   * used plus one value kept for broadcast.  Kept by UanAddress with the
+   * address width, so Simulator::Destroy turns packing off again.
+   */
+  static void Enable (uint8_t addressBits);
+  static void Disable (void);
+  static bool IsEnabled (void);
+  static uint8_t GetAddressBits (void);
+  /**
+   * \param bits Number of bits
+   * \return Bytes needed to hold them.
+   */
+  static uint32_t GetBytes (uint32_t bits);
+};
+
+/**
+ * \ingroup uan
+ *
+ * Writes bit fields MSB first, zero padding the last byte on Flush.
+ */
+class UanBitWriter
+{
+public:
+  UanBitWriter (Buffer::Iterator &i);
+
+  void Write (uint32_t value, uint8_t bits);
+  /** Write an address in UanHeaderPacking::GetAddressBits bits. */
+  void WriteAddress (UanAddress addr);
+  void Flush (void);
+
+private:
+  Buffer::Iterator &m_i;
+  uint8_t m_byte;
+  uint8_t m_used;
+};
+
+/**
+ * \ingroup uan
+ *
+ * Reads bit fields written by UanBitWriter.
+ */
+class UanBitReader
+{
+public:
+  UanBitReader (Buffer::Iterator &i);
+
+  uint32_t Read (uint8_t bits);
+  UanAddress ReadAddress (void);
+
+private:
+  Buffer::Iterator &m_i;
+  uint8_t m_byte;
+  uint8_t m_left;
+};
+
+} // namespace ns3
+
+#endif /* UAN_HEADER_PACKING_H_ */
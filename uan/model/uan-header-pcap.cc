@@ -0,0 +1,184 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-header-pcap.h"
+
+#include <cmath>
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (UanHeaderPcap);
+
+UanHeaderPcap::UanHeaderPcap ()
+  : m_event (TX),
+    m_channel (DATA),
+    m_modeUid (0),
+    m_dataRate (0),
+    m_centerFreq (0),
+    m_sinr (0),
+    m_power (0)
+{
+}
+
+UanHeaderPcap::~UanHeaderPcap ()
+{
+}
+
+TypeId
+UanHeaderPcap::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanHeaderPcap")
+    .SetParent<Header> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanHeaderPcap> ()
+  ;
+  return tid;
+}
+
+TypeId
+UanHeaderPcap::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+UanHeaderPcap::SetEvent (Event event)
+{
+  m_event = event;
+}
+
+void
+UanHeaderPcap::SetChannel (Channel channel)
+{
+  m_channel = channel;
+}
+
+void
+UanHeaderPcap::SetMode (UanTxMode mode)
+{
+  m_modeUid = mode.GetUid ();
+  m_dataRate = mode.GetDataRateBps ();
+  m_centerFreq = mode.GetCenterFreqHz ();
+}
+
+void
+UanHeaderPcap::SetSinrDb (double sinr)
+{
+  m_sinr = (int32_t) std::floor (sinr * 100 + 0.5);
+}
+
+void
+UanHeaderPcap::SetPowerDb (double power)
+{
+  m_power = (int32_t) std::floor (power * 100 + 0.5);
+}
+
+UanHeaderPcap::Event
+UanHeaderPcap::GetEvent (void) const
+{
+  return (Event) m_event;
+}
+
+UanHeaderPcap::Channel
+UanHeaderPcap::GetChannel (void) const
+{
+  return (Channel) m_channel;
+}
+
+uint32_t
+UanHeaderPcap::GetModeUid (void) const
+{
+  return m_modeUid;
+}
+
+uint32_t
+UanHeaderPcap::GetDataRateBps (void) const
+{
+  return m_dataRate;
+}
+
+uint32_t
+UanHeaderPcap::GetCenterFreqHz (void) const
+{
+  return m_centerFreq;
+}
+
+double
+UanHeaderPcap::GetSinrDb (void) const
+{
+  return m_sinr / 100.0;
+}
+
+double
+UanHeaderPcap::GetPowerDb (void) const
+{
+  return m_power / 100.0;
+}
+
+uint32_t
+UanHeaderPcap::GetSerializedSize (void) const
+{
+  return 24;
+}
+
+void
+UanHeaderPcap::Serialize (Buffer::Iterator start) const
+{
+  start.WriteU8 (0);
+  start.WriteU8 (m_event);
+  start.WriteU8 (m_channel);
+  start.WriteU8 (0);
+  start.WriteHtolsbU32 (m_modeUid);
+  start.WriteHtolsbU32 (m_dataRate);
+  start.WriteHtolsbU32 (m_centerFreq);
+  start.WriteHtolsbU32 ((uint32_t) m_sinr);
+  start.WriteHtolsbU32 ((uint32_t) m_power);
+}
+
+uint32_t
+UanHeaderPcap::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator rbuf = start;
+
+  rbuf.ReadU8 ();
+  m_event = rbuf.ReadU8 ();
+  m_channel = rbuf.ReadU8 ();
+  rbuf.ReadU8 ();
+  m_modeUid = rbuf.ReadLsbtohU32 ();
+  m_dataRate = rbuf.ReadLsbtohU32 ();
+  m_centerFreq = rbuf.ReadLsbtohU32 ();
+  m_sinr = (int32_t) rbuf.ReadLsbtohU32 ();
+  m_power = (int32_t) rbuf.ReadLsbtohU32 ();
+
+  return rbuf.GetDistanceFrom (start);
+}
+
+void
+UanHeaderPcap::Print (std::ostream &os) const
+{
+  static const char *events[] = { "tx", "rx", "rxerr" };
+  os << "Event=" << (m_event < 3 ? events[m_event] : "?")
+     << " Channel=" << (m_channel == WAKEUP ? "wakeup" : "data")
+     << " Mode=" << m_modeUid
+     << " Rate=" << m_dataRate
+     << " Freq=" << m_centerFreq
+     << " SINR=" << GetSinrDb ()
+     << " Power=" << GetPowerDb ();
+}
+
+} // namespace ns3
@@ -0,0 +1,105 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_HEADER_PCAP_H
+#define UAN_HEADER_PCAP_H
+
+#include "ns3/header.h"
+#include "uan-tx-mode.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Link-layer pseudo-header of UAN pcap traces.
+ *
+ * Written in front of each frame in files with link type
+ * LINKTYPE_USER0 (147).  24 bytes, little-endian:
+ *
+ *   version (1) | event (1) | channel (1) | pad (1) |
+ *   mode uid (4) | data rate bps (4) | center frequency Hz (4) |
+ *   SINR (4) | power (4)
+ *
+ * SINR and power are signed, in 1/100 dB.  Power is the received power
+ * (dB re 1 uPa) for receptions and the tx power for transmissions.
+ */
+class UanHeaderPcap : public Header
+{
+public:
+  /** Frame event. */
+  enum Event
+  {
+    TX = 0,
+    RX_OK = 1,
+    RX_ERROR = 2
+  };
+  /** Receiver the event belongs to. */
+  enum Channel
+  {
+    DATA = 0,
+    WAKEUP = 1
+  };
+
+  /** pcap link type of UAN traces, LINKTYPE_USER0. */
+  static const uint32_t DLT_UAN = 147;
+
+  UanHeaderPcap ();
+  virtual ~UanHeaderPcap ();
+
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  void SetEvent (Event event);
+  void SetChannel (Channel channel);
+  /** Copy uid, data rate and center frequency of mode. */
+  void SetMode (UanTxMode mode);
+  void SetSinrDb (double sinr);
+  void SetPowerDb (double power);
+
+  Event GetEvent (void) const;
+  Channel GetChannel (void) const;
+  uint32_t GetModeUid (void) const;
+  uint32_t GetDataRateBps (void) const;
+  uint32_t GetCenterFreqHz (void) const;
+  double GetSinrDb (void) const;
+  double GetPowerDb (void) const;
+
+  // Inherited methods
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual void Print (std::ostream &os) const;
+  virtual TypeId GetInstanceTypeId (void) const;
+private:
+  uint8_t m_event;        //!< Event.
+  uint8_t m_channel;      //!< Channel.
+  uint32_t m_modeUid;     //!< Mode uid.
+  uint32_t m_dataRate;    //!< Mode data rate, bps.
+  uint32_t m_centerFreq;  //!< Mode center frequency, Hz.
+  int32_t m_sinr;         //!< SINR, 1/100 dB.
+  int32_t m_power;        //!< Power, 1/100 dB.
+
+};  // class UanHeaderPcap
+
+} // namespace ns3
+
+#endif /* UAN_HEADER_PCAP_H */
@@ -20,8 +20,10 @@
 
 
 #include "uan-header-rc.h"
+#include "uan-header-packing.h"
 
 #include <set>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -349,12 +351,26 @@ UanHeaderRcCtsGlobal::GetRateNum (void) const
 uint32_t
 UanHeaderRcCtsGlobal::GetSerializedSize (void) const
 {
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      return 1 + 1 + 4 + 2;
+    }
   return 4 + 4 + 2 + 2;
 }
 
 void
 UanHeaderRcCtsGlobal::Serialize (Buffer::Iterator start) const
 {
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      // Rate and retry rate are small indexes; window time in ms
+      NS_ASSERT (m_rateNum < 256 && m_retryRate < 256);
+      start.WriteU8 (m_rateNum);
+      start.WriteU8 (m_retryRate);
+      start.WriteU32 ( (uint32_t)(m_timeStampTx.GetSeconds () * 1000.0 + 0.5));
+      start.WriteU16 ( (uint16_t) std::min (m_winTime.GetSeconds () * 1000.0 + 0.5, 65535.0));
+      return;
+    }
   start.WriteU16 (m_rateNum);
   start.WriteU16 (m_retryRate);
   start.WriteU32 ( (uint32_t)(m_timeStampTx.GetSeconds () * 1000.0 + 0.5));
@@ -365,6 +381,14 @@ uint32_t
 UanHeaderRcCtsGlobal::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator rbuf = start;
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      m_rateNum = rbuf.ReadU8 ();
+      m_retryRate = rbuf.ReadU8 ();
+      m_timeStampTx = Seconds ( ( (double) rbuf.ReadU32 ()) / 1000.0 );
+      m_winTime = Seconds ( ( (double) rbuf.ReadU16 ()) / 1000.0 );
+      return rbuf.GetDistanceFrom (start);
+    }
   m_rateNum = rbuf.ReadU16 ();
   m_retryRate = rbuf.ReadU16 ();
   m_timeStampTx = Seconds ( ( (double) rbuf.ReadU32 ()) / 1000.0 );
@@ -391,7 +415,8 @@ UanHeaderRcCts::UanHeaderRcCts ()
     m_timeStampRts (Seconds (0)),
     m_retryNo (0),
     m_delay (Seconds (0)),
-    m_address (UanAddress::GetBroadcast ())
+    m_address (UanAddress::GetBroadcast ()),
+    m_reference (Seconds (0))
 {
 
 }
@@ -402,7 +427,8 @@ UanHeaderRcCts::UanHeaderRcCts (uint8_t frameNo, uint8_t retryNo, Time ts, Time
     m_timeStampRts (ts),
     m_retryNo (retryNo),
     m_delay (delay),
-    m_address (addr)
+    m_address (addr),
+    m_reference (Seconds (0))
 {
 
 }
@@ -454,6 +480,12 @@ UanHeaderRcCts::SetAddress (UanAddress addr)
 {
   m_address = addr;
 }
+
+void
+UanHeaderRcCts::SetTimeStampReference (Time reference)
+{
+  m_reference = reference;
+}
 uint8_t
 UanHeaderRcCts::GetFrameNo () const
 {
@@ -487,14 +519,32 @@ UanHeaderRcCts::GetAddress () const
 uint32_t
 UanHeaderRcCts::GetSerializedSize (void) const
 {
-  return 1 + 1 + 1 + 4 + 4;
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      return UanHeaderPacking::GetBytes (UanHeaderPacking::GetAddressBits () + 8 + 8 + 16 + 16);
+    }
+  return UanAddress::GetWidth () + 1 + 1 + 4 + 4;
 }
 
 
 void
 UanHeaderRcCts::Serialize (Buffer::Iterator start) const
 {
-  start.WriteU8 (m_address.GetAsInt ());
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      // RTS timestamp as ms before the reference, delay in ms
+      double age = (m_reference - m_timeStampRts).GetSeconds () * 1000.0 + 0.5;
+      double delay = m_delay.GetSeconds () * 1000.0 + 0.5;
+      UanBitWriter bits (start);
+      bits.WriteAddress (m_address);
+      bits.Write (m_frameNo, 8);
+      bits.Write (m_retryNo, 8);
+      bits.Write ((uint32_t) std::max (0.0, std::min (age, 65535.0)), 16);
+      bits.Write ((uint32_t) std::max (0.0, std::min (delay, 65535.0)), 16);
+      bits.Flush ();
+      return;
+    }
+  m_address.Serialize (start);
   start.WriteU8 (m_frameNo);
   start.WriteU8 (m_retryNo);
   start.WriteU32 ((uint32_t)(m_timeStampRts.GetSeconds () * 1000.0 + 0.5));
@@ -505,7 +555,17 @@ uint32_t
 UanHeaderRcCts::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator rbuf = start;
-  m_address = UanAddress (rbuf.ReadU8 ());
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitReader bits (rbuf);
+      m_address = bits.ReadAddress ();
+      m_frameNo = bits.Read (8);
+      m_retryNo = bits.Read (8);
+      m_timeStampRts = m_reference - Seconds (bits.Read (16) / 1000.0);
+      m_delay = Seconds (bits.Read (16) / 1000.0);
+      return rbuf.GetDistanceFrom (start);
+    }
+  m_address = UanAddress::Deserialize (rbuf);
   m_frameNo = rbuf.ReadU8 ();
   m_retryNo = rbuf.ReadU8 ();
   m_timeStampRts = Seconds ( ( (double) rbuf.ReadU32 ()) / 1000.0 );
@@ -373,6 +373,14 @@ public:
    * \param addr The destination address.
    */
   void SetAddress (UanAddress addr);
+  /**
+   * Set the time the RTS timestamp is coded against with packed
+   * headers, the UanHeaderRcCtsGlobal TX timestamp of the same packet.
+   * Needed before both AddHeader and RemoveHeader; not serialized.
+   *
+   * \param reference The reference time.
+   */
+  void SetTimeStampReference (Time reference);
 
   /**
    * Get the frame number of the RTS being cleared.
@@ -419,6 +427,7 @@ private:
   uint8_t m_retryNo;     //!< Retry number of received RTS packet.
   Time m_delay;          //!< Delay until transmission.
   UanAddress m_address;  //!< Destination of CTS packet.
+  Time m_reference;      //!< Base of the packed RTS timestamp.
 
 };  // class UanHeaderRcCts
 
@@ -20,18 +20,26 @@
 
 #include "uan-header-wakeup.h"
 #include "uan-address.h"
+#include "uan-header-packing.h"
+#include "ns3/assert.h"
+#include "ns3/fatal-error.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
 
 namespace ns3 {
 
   NS_OBJECT_ENSURE_REGISTERED (UanHeaderWakeup);
 
 UanHeaderWakeup::UanHeaderWakeup ()
+  : m_mode (UNICAST)
 {
 }
 
-UanHeaderWakeup::UanHeaderWakeup (const uint8_t addr)
+UanHeaderWakeup::UanHeaderWakeup (const uint16_t addr)
   : Header (),
-    m_dest (addr)
+    m_dest (addr),
+    m_mode (UNICAST)
 {
 
 }
@@ -61,6 +69,8 @@ void
 UanHeaderWakeup::SetDest (UanAddress dest)
 {
   m_dest = dest;
+  m_mode = UNICAST;
+  m_bitmap.clear ();
 }
 
 UanAddress
@@ -69,19 +79,154 @@ UanHeaderWakeup::GetDest (void) const
   return m_dest;
 }
 
+void
+UanHeaderWakeup::SetGroup (uint8_t group)
+{
+  m_dest = UanAddress (group);
+  m_mode = GROUP;
+  m_bitmap.clear ();
+}
+
+uint8_t
+UanHeaderWakeup::GetGroup (void) const
+{
+  return m_dest.GetAsInt ();
+}
+
+void
+UanHeaderWakeup::SetMembers (const std::vector<UanAddress> &members)
+{
+  if (members.empty ())
+    {
+      NS_FATAL_ERROR ("Wakeup bitmap needs at least one member");
+    }
+
+  uint16_t first = UanAddress::GetBroadcast ().GetAsInt ();
+  uint16_t last = 0;
+  for (std::vector<UanAddress>::const_iterator it = members.begin (); it != members.end (); it++)
+    {
+      first = std::min (first, it->GetAsInt ());
+      last = std::max (last, it->GetAsInt ());
+    }
+
+  if (last - first >= 255 * 8)
+    {
+      NS_FATAL_ERROR ("Wakeup members span " << last - first + 1 << " addresses, one bitmap holds " << 255 * 8);
+    }
+  m_dest = UanAddress (first);
+  m_mode = BITMAP;
+  m_bitmap.assign ((last - first) / 8 + 1, 0);
+  for (std::vector<UanAddress>::const_iterator it = members.begin (); it != members.end (); it++)
+    {
+      uint16_t bit = it->GetAsInt () - first;
+      m_bitmap[bit / 8] |= (1 << (bit % 8));
+    }
+}
+
+std::vector<UanAddress>
+UanHeaderWakeup::GetMembers (void) const
+{
+  std::vector<UanAddress> members;
+  if (m_mode != BITMAP)
+    {
+      return members;
+    }
+  for (uint32_t bit = 0; bit < m_bitmap.size () * 8; bit++)
+    {
+      if (m_bitmap[bit / 8] & (1 << (bit % 8)))
+        {
+          members.push_back (UanAddress (m_dest.GetAsInt () + bit));
+        }
+    }
+  return members;
+}
+
+UanHeaderWakeup::Mode
+UanHeaderWakeup::GetMode (void) const
+{
+  return m_mode;
+}
+
+bool
+UanHeaderWakeup::IsValid (void) const
+{
+  return m_mode != INVALID;
+}
+
+bool
+UanHeaderWakeup::IsDestination (UanAddress addr) const
+{
+  switch (m_mode)
+    {
+    case UNICAST:
+      return m_dest == addr || m_dest == UanAddress::GetBroadcast ();
+    case BITMAP:
+      {
+        if (addr.GetAsInt () < m_dest.GetAsInt ())
+          {
+            return false;
+          }
+        uint32_t bit = addr.GetAsInt () - m_dest.GetAsInt ();
+        return bit < m_bitmap.size () * 8 && (m_bitmap[bit / 8] & (1 << (bit % 8)));
+      }
+    case GROUP:
+    case INVALID:
+      break;
+    }
+  return false;
+}
+
 // Inherrited methods
 
 uint32_t
 UanHeaderWakeup::GetSerializedSize (void) const
 {
-  return sizeof(uint16_t);
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      // Address, 2 bit mode and, for bitmaps, length and bitmap
+      uint32_t bits = UanHeaderPacking::GetAddressBits () + 2;
+      if (m_mode == BITMAP)
+        {
+          bits += 8 + 8 * m_bitmap.size ();
+        }
+      return UanHeaderPacking::GetBytes (bits);
+    }
+  if (m_mode == BITMAP)
+    {
+      return UanAddress::GetWidth () + 1 + 1 + m_bitmap.size ();
+    }
+  return UanAddress::GetWidth () + 1;
 }
 
 void
 UanHeaderWakeup::Serialize (Buffer::Iterator start) const
 {
-  start.WriteU8 (m_dest.GetAsInt());
-  start.WriteU8 (0);
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitWriter bits (start);
+      bits.WriteAddress (m_dest);
+      bits.Write (m_mode, 2);
+      if (m_mode == BITMAP)
+        {
+          bits.Write (m_bitmap.size (), 8);
+          for (uint32_t i = 0; i < m_bitmap.size (); i++)
+            {
+              bits.Write (m_bitmap[i], 8);
+            }
+        }
+      bits.Flush ();
+      return;
+    }
+  m_dest.Serialize (start);
+  start.WriteU8 (m_mode);
+  if (m_mode == BITMAP)
+    {
+      start.WriteU8 (m_bitmap.size ());
+      for (uint32_t i = 0; i < m_bitmap.size (); i++)
+        {
+          start.WriteU8 (m_bitmap[i]);
+        }
+    }
 }
 
 uint32_t
@@ -89,17 +234,68 @@ UanHeaderWakeup::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator rbuf = start;
 
-  UanAddress addr (rbuf.ReadU8());
-  m_dest = addr;
-
-  rbuf.ReadU8 ();
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      UanBitReader bits (rbuf);
+      m_dest = bits.ReadAddress ();
+      m_mode = ToMode (bits.Read (2));
+      m_bitmap.clear ();
+      if (m_mode == BITMAP)
+        {
+          uint8_t length = bits.Read (8);
+          for (uint8_t i = 0; i < length; i++)
+            {
+              m_bitmap.push_back (bits.Read (8));
+            }
+        }
+      return rbuf.GetDistanceFrom (start);
+    }
+  m_dest = UanAddress::Deserialize (rbuf);
+
+  m_mode = ToMode (rbuf.ReadU8 ());
+  m_bitmap.clear ();
+  if (m_mode == BITMAP)
+    {
+      uint8_t length = rbuf.ReadU8 ();
+      for (uint8_t i = 0; i < length; i++)
+        {
+          m_bitmap.push_back (rbuf.ReadU8 ());
+        }
+    }
   return rbuf.GetDistanceFrom (start);
 }
 
 void
 UanHeaderWakeup::Print (std::ostream &os) const
 {
-  os << "UAN wakeup addr=" << (uint32_t) m_dest.GetAsInt ();
+  switch (m_mode)
+    {
+    case UNICAST:
+      os << "UAN wakeup addr=" << (uint32_t) m_dest.GetAsInt ();
+      break;
+    case GROUP:
+      os << "UAN wakeup group=" << (uint32_t) m_dest.GetAsInt ();
+      break;
+    case BITMAP:
+      {
+        os << "UAN wakeup members=";
+        std::vector<UanAddress> members = GetMembers ();
+        for (uint32_t i = 0; i < members.size (); i++)
+          {
+            os << (i ? "," : "") << (uint32_t) members[i].GetAsInt ();
+          }
+      }
+      break;
+    case INVALID:
+      os << "UAN wakeup invalid mode";
+      break;
+    }
+}
+
+UanHeaderWakeup::Mode
+UanHeaderWakeup::ToMode (uint32_t value)
+{
+  return value < INVALID ? (Mode) value : INVALID;
 }
 
 
@@ -158,12 +354,23 @@ UanHeaderDuration::GetTxDuration (void) const
 uint32_t
 UanHeaderDuration::GetSerializedSize (void) const
 {
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      return 2;
+    }
   return sizeof(float);
 }
 
 void
 UanHeaderDuration::Serialize (Buffer::Iterator start) const
 {
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      // Milliseconds, saturating at 65.535 s
+      double ms = std::min (m_time * 1000.0 + 0.5, 65535.0);
+      start.WriteU16 ((uint16_t) std::max (ms, 0.0));
+      return;
+    }
   uint8_t* buffer = (uint8_t*) &m_time;
   start.Write(buffer, sizeof(float));
 }
@@ -172,6 +379,11 @@ uint32_t
 UanHeaderDuration::Deserialize (Buffer::Iterator start)
 {
   Buffer::Iterator rbuf = start;
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      m_time = rbuf.ReadU16 () / 1000.0;
+      return rbuf.GetDistanceFrom (start);
+    }
   uint8_t* buffer = (uint8_t*) &m_time;
 
   rbuf.Read (buffer, sizeof(float));
@@ -186,6 +398,106 @@ UanHeaderDuration::Print (std::ostream &os) const
 }
 
 
+/*
+ * UanHeaderTimestamp
+ */
+NS_OBJECT_ENSURE_REGISTERED (UanHeaderTimestamp);
+
+
+UanHeaderTimestamp::UanHeaderTimestamp ()
+{
+}
+
+UanHeaderTimestamp::UanHeaderTimestamp (Time timeStamp)
+  : Header (),
+    m_timeStamp (timeStamp)
+{
+
+}
+
+TypeId
+UanHeaderTimestamp::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanHeaderTimestamp")
+    .SetParent<Header> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanHeaderTimestamp> ()
+  ;
+  return tid;
+}
+
+TypeId
+UanHeaderTimestamp::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+UanHeaderTimestamp::~UanHeaderTimestamp ()
+{
+}
+
+
+void
+UanHeaderTimestamp::SetTimeStamp (Time timeStamp)
+{
+  m_timeStamp = timeStamp;
+}
+
+Time
+UanHeaderTimestamp::GetTimeStamp (void) const
+{
+  return m_timeStamp;
+}
+
+// Inherrited methods
+
+uint32_t
+UanHeaderTimestamp::GetSerializedSize (void) const
+{
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      return 2;
+    }
+  return 4;
+}
+
+void
+UanHeaderTimestamp::Serialize (Buffer::Iterator start) const
+{
+  uint64_t ms = (uint64_t)(m_timeStamp.GetSeconds () * 1000.0 + 0.5);
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      start.WriteU16 (ms & 0xffff);
+      return;
+    }
+  start.WriteU32 ((uint32_t) ms);
+}
+
+uint32_t
+UanHeaderTimestamp::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator rbuf = start;
+
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      // Milliseconds modulo 65.536 s; the frame is read well within that
+      // of being stamped, so the latest matching time before now is it
+      uint64_t now = (uint64_t)(Simulator::Now ().GetSeconds () * 1000.0 + 0.5);
+      uint16_t age = (uint16_t)(now - rbuf.ReadU16 ());
+      m_timeStamp = MilliSeconds (now - age);
+      return rbuf.GetDistanceFrom (start);
+    }
+  m_timeStamp = Seconds (((double) rbuf.ReadU32 ()) / 1000.0);
+
+  return rbuf.GetDistanceFrom (start);
+}
+
+void
+UanHeaderTimestamp::Print (std::ostream &os) const
+{
+  os << "UAN tx timestamp=" << m_timeStamp.GetSeconds ();
+}
+
+
 /*
  * UanHeaderData
  */
@@ -328,85 +640,6 @@ UanIdPacket::Print (std::ostream &os) const
 
 }
 
-
-
-/*
- * UanWakeupTag
- */
-
-NS_OBJECT_ENSURE_REGISTERED (UanWakeupTag);
-
-
-UanWakeupTag::UanWakeupTag ()
-{
-}
-
-TypeId
-UanWakeupTag::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::UanWakeupTag")
-    .SetParent<Tag> ()
-	.SetGroupName ("Uan")
-    .AddConstructor<UanWakeupTag> ()
-  ;
-  return tid;
-}
-
-TypeId
-UanWakeupTag::GetInstanceTypeId (void) const
-{
-  return GetTypeId ();
-}
-
-
-
-// Inherrited methods
-
-uint32_t
-UanWakeupTag::GetSerializedSize (void) const
-{
-  return 1;
-}
-
-void
-UanWakeupTag::Serialize (TagBuffer start) const
-{
-  start.WriteU8(m_type);
-}
-
-void
-UanWakeupTag::Deserialize (TagBuffer start)
-{
-  m_type = (UanWakeupTag::Type) start.ReadU8();
-}
-
-void
-UanWakeupTag::Print (std::ostream &os) const
-{
-  std::string print;
-
-  switch (m_type)
-  {
-  case WU:
-    print = "WU";
-    break;
-  case WUHE:
-    print = "WUHE";
-    break;
-  case DATA:
-    print = "DATA";
-    break;
-  case CTD:
-    print = "CTD";
-	break;
-  case CTS:
-    print = "CTS";
-	break;
-  }
-
-  os << "type = " << print;
-}
-
 }
 
 
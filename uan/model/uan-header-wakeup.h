@@ -24,17 +24,29 @@
 #include "ns3/header.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
-#include "ns3/tag.h"
 #include "uan-address.h"
 
+#include <vector>
+
 namespace ns3 {
 
+/**
+ * Wakeup tone header.
+ *
+ * Addresses a single node (or broadcast), a group id that nodes join at
+ * the wakeup MAC, or an explicit set of nodes encoded as a bitmap.  The
+ * unicast format keeps the original two bytes; the bitmap adds one length
+ * byte plus one byte per eight addresses spanned.
+ */
 class UanHeaderWakeup : public Header
 {
 public:
+  /** Addressing mode.  INVALID marks a received mode field out of range. */
+  enum Mode { UNICAST = 0, GROUP = 1, BITMAP = 2, INVALID = 3 };
+
   UanHeaderWakeup ();
 
-  UanHeaderWakeup (const uint8_t addr);
+  UanHeaderWakeup (const uint16_t addr);
   virtual ~UanHeaderWakeup ();
 
   static TypeId GetTypeId (void);
@@ -46,8 +58,29 @@ public:
 
   UanAddress GetDest (void) const;
 
+  /**
+   * \param group Wakeup group id, joined with UanMacWakeup::JoinWakeupGroup
+   */
+  void SetGroup (uint8_t group);
+  uint8_t GetGroup (void) const;
+
+  /**
+   * \param members Nodes to wake, encoded as a bitmap
+   */
+  void SetMembers (const std::vector<UanAddress> &members);
+  std::vector<UanAddress> GetMembers (void) const;
 
+  Mode GetMode (void) const;
+  /** \return False if the mode field of a received header was corrupted. */
+  bool IsValid (void) const;
 
+  /**
+   * \param addr Address of the receiving node
+   * \return True if addr is the unicast destination, broadcast is set
+   * or addr is in the bitmap.  Group membership is checked by the MAC,
+   * and an invalid header addresses nobody.
+   */
+  bool IsDestination (UanAddress addr) const;
 
   // Inherrited methods
   virtual uint32_t GetSerializedSize (void) const;
@@ -56,7 +89,12 @@ public:
   virtual void Print (std::ostream &os) const;
   virtual TypeId GetInstanceTypeId (void) const;
 private:
-  UanAddress m_dest;
+  /** \return value as a Mode, INVALID if out of range. */
+  static Mode ToMode (uint32_t value);
+
+  UanAddress m_dest;     //!< Destination, group id or first bitmap address
+  Mode m_mode;
+  std::vector<uint8_t> m_bitmap;
 };
 
 class UanHeaderDuration : public Header
@@ -89,16 +127,33 @@ private:
   float m_time;
 };
 
-class UanData : public Header
+/**
+ * Transmission timestamp carried by FAMA RTS/CTS frames.
+ *
+ * Lets the receiver learn the one-way delay to the sender.
+ * \note Timestamp is serialized into 32 bits with ms accuracy, or 16 bits
+ * modulo 65.536 s with UanHeaderPacking, which must then be read within
+ * that time of being written.
+ */
+class UanHeaderTimestamp : public Header
 {
 public:
-  UanData ();
+  UanHeaderTimestamp ();
 
-  UanData (uint32_t dataSize);
-  virtual ~UanData ();
+  UanHeaderTimestamp (Time timeStamp);
+  virtual ~UanHeaderTimestamp ();
 
   static TypeId GetTypeId (void);
 
+  /**
+   * \param timeStamp Time the PHY started sending the frame
+   */
+  void SetTimeStamp (Time timeStamp);
+
+  Time GetTimeStamp (void) const;
+
+
+
 
   // Inherrited methods
   virtual uint32_t GetSerializedSize (void) const;
@@ -107,20 +162,19 @@ public:
   virtual void Print (std::ostream &os) const;
   virtual TypeId GetInstanceTypeId (void) const;
 private:
-  uint32_t m_dataSize;
+  Time m_timeStamp;
 };
 
-class UanIdPacket : public Header
+class UanData : public Header
 {
 public:
-  UanIdPacket ();
+  UanData ();
 
-  UanIdPacket (uint8_t idPacket);
-  virtual ~UanIdPacket ();
+  UanData (uint32_t dataSize);
+  virtual ~UanData ();
 
   static TypeId GetTypeId (void);
 
-  uint8_t GetIdPacket ();
 
   // Inherrited methods
   virtual uint32_t GetSerializedSize (void) const;
@@ -128,27 +182,31 @@ public:
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual void Print (std::ostream &os) const;
   virtual TypeId GetInstanceTypeId (void) const;
-
 private:
-  uint8_t m_idPacket;
+  uint32_t m_dataSize;
 };
 
-class UanWakeupTag : public Tag
+class UanIdPacket : public Header
 {
 public:
-  enum Type {WU,WUHE, DATA, CTD, CTS};
-  Type m_type;
+  UanIdPacket ();
+
+  UanIdPacket (uint8_t idPacket);
+  virtual ~UanIdPacket ();
 
   static TypeId GetTypeId (void);
 
-  UanWakeupTag ();
+  uint8_t GetIdPacket ();
 
   // Inherrited methods
   virtual uint32_t GetSerializedSize (void) const;
-  virtual void Serialize (TagBuffer start) const;
-  virtual void Deserialize (TagBuffer start);
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual void Print (std::ostream &os) const;
   virtual TypeId GetInstanceTypeId (void) const;
+
+private:
+  uint8_t m_idPacket;
 };
 
 }
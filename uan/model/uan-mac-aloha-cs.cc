@@ -22,6 +22,8 @@
 #include "ns3/attribute.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/nstime.h"
 #include "ns3/uan-header-common.h"
 #include "ns3/trace-source-accessor.h"
@@ -41,7 +43,7 @@ UanMacAlohaCs::UanMacAlohaCs ()
     m_cleared (false)
 
 {
-  m_rv = CreateObject<UniformRandomVariable> ();
+  m_backoff = CreateObject<UanBackoffUniform> ();
 }
 
 UanMacAlohaCs::~UanMacAlohaCs ()
@@ -90,6 +92,11 @@ UanMacAlohaCs::GetTypeId (void)
                    TimeValue (MilliSeconds (50)),
                    MakeTimeAccessor (&UanMacAlohaCs::m_slotTime),
                    MakeTimeChecker ())
+    .AddAttribute ("Backoff",
+                   "Backoff policy drawing the contention window, in slots.",
+                   StringValue ("ns3::UanBackoffUniform"),
+                   MakePointerAccessor (&UanMacAlohaCs::m_backoff),
+                   MakePointerChecker<UanBackoff> ())
     .AddTraceSource ("Enqueue",
                      "A packet arrived at the MAC for transmission.",
                      MakeTraceSourceAccessor (&UanMacAlohaCs::m_enqueueLogger),
@@ -160,7 +167,10 @@ UanMacAlohaCs::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protoc
             m_pktTx = packet;
             m_pktTxProt = protocolNumber;
             m_state = CCABUSY;
-            uint32_t cw = m_cw;
+            m_backoff->NotifyBusy ();
+            // Base window [CW, CW]: a constant CW slots with the uniform
+            // policy, widened upwards by BEB and Bayesian
+            uint32_t cw = (uint32_t) m_backoff->GetBackoff (m_cw, m_cw);
             m_savedDelayS = Seconds ((double)(cw) * m_slotTime.GetSeconds ());
             m_sendTime = Simulator::Now () + m_savedDelayS;
             NS_LOG_DEBUG ("Time " << Simulator::Now ().GetSeconds () << ": Addr " << GetAddress () << ": Enqueuing new packet while busy:  (Chose CW " << cw << ", Sending at " << m_sendTime.GetSeconds () << " Packet size: " << packet->GetSize ());
@@ -294,14 +304,23 @@ int64_t
 UanMacAlohaCs::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
-  m_rv->SetStream (stream);
-  return 1;
+  return m_backoff->AssignStreams (stream);
 }
 
 void
 UanMacAlohaCs::EndTx (void)
 {
   NS_ASSERT (m_state == TX || m_state == CCABUSY);
+  // There are no ACKs at this layer; a signal still arriving when our
+  // frame ends is the local hint that it collided
+  if (m_phy->GetTransducer ()->GetArrivalList ().empty ())
+    {
+      m_backoff->NotifySuccess ();
+    }
+  else
+    {
+      m_backoff->NotifyCollision ();
+    }
   if (m_state == TX)
     {
       m_state = IDLE;
@@ -335,6 +354,12 @@ UanMacAlohaCs::GetCw (void)
 {
   return m_cw;
 }
+
+Ptr<UanBackoff>
+UanMacAlohaCs::GetBackoff (void) const
+{
+  return m_backoff;
+}
 Time
 UanMacAlohaCs::GetSlotTime (void)
 {
@@ -28,6 +28,7 @@
 #include "ns3/uan-tx-mode.h"
 #include "ns3/uan-address.h"
 #include "ns3/random-variable-stream.h"
+#include "uan-backoff.h"
 
 namespace ns3 {
 
@@ -75,6 +76,8 @@ public:
    * \return Contention window size.
    */
   virtual uint32_t GetCw (void);
+  /** \return The backoff policy. */
+  Ptr<UanBackoff> GetBackoff (void) const;
   /**
    * Get the slot time duration.
    *
@@ -154,8 +157,8 @@ private:
   /** Flag when we've been cleared */
   bool m_cleared;
 
-  /** Provides uniform random variable for contention window. */
-  Ptr<UniformRandomVariable> m_rv;
+  /** Backoff policy drawing the contention window. */
+  Ptr<UanBackoff> m_backoff;
 
   /**
    * Receive packet from lower layer (passed to PHY as callback).
@@ -178,7 +181,7 @@ private:
   void StartTimer (void);
   /** Send packet on PHY. */
   void SendPacket (void);
-  /** End TX state. */
+  /** End TX state and report the attempt to the backoff policy. */
   void EndTx (void);
 
 protected:
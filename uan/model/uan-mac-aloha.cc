@@ -147,8 +147,7 @@ UanMacAloha::RxPacketError (Ptr<Packet> pkt, double sinr)
 Address
 UanMacAloha::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 int64_t
@@ -22,6 +22,8 @@
 #include "ns3/attribute.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/nstime.h"
 #include "ns3/uan-header-common.h"
 #include "ns3/trace-source-accessor.h"
@@ -43,7 +45,7 @@ UanMacCwW::UanMacCwW ()
     m_cleared (false)
 
 {
-  m_rv = CreateObject<UniformRandomVariable> ();
+  m_backoff = CreateObject<UanBackoffUniform> ();
   m_wakeupState = UanMacWakeup::IDLE;
   m_cw = 125;
   m_slotTime = MilliSeconds (50);  
@@ -96,6 +98,11 @@ UanMacCwW::GetTypeId (void)
                    TimeValue (MilliSeconds (50)),
                    MakeTimeAccessor (&UanMacCwW::m_slotTime),
                    MakeTimeChecker ())
+    .AddAttribute ("Backoff",
+                   "Backoff policy drawing the contention window, in slots.",
+                   StringValue ("ns3::UanBackoffUniform"),
+                   MakePointerAccessor (&UanMacCwW::m_backoff),
+                   MakePointerChecker<UanBackoff> ())
     .AddTraceSource ("Enqueue",
                      "A packet arrived at the MAC for transmission.",
                      MakeTraceSourceAccessor (&UanMacCwW::m_enqueueLogger),
@@ -171,7 +178,8 @@ UanMacCwW::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolNu
             m_dest = dest;
 			m_pktTxProt = protocolNumber;
             m_state = CCABUSY;
-            uint32_t cw = (uint32_t) m_rv->GetValue (0,m_cw);
+            m_backoff->NotifyBusy ();
+            uint32_t cw = (uint32_t) m_backoff->GetBackoff (0, m_cw);
             m_savedDelayS = Seconds ((double)(cw) * m_slotTime.GetSeconds ());
             m_sendTime = Simulator::Now () + m_savedDelayS;
             NS_LOG_DEBUG ("Time " << Simulator::Now ().GetSeconds () << ": Addr " <<  UanAddress::ConvertFrom (GetAddress ()) << ": Enqueuing new packet while busy:  (Chose CW " << cw << ", Sending at " << m_sendTime.GetSeconds () << " Packet size: " << packet->GetSize ());
@@ -294,14 +302,23 @@ int64_t
 UanMacCwW::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
-  m_rv->SetStream (stream);
-  return 1;
+  return m_backoff->AssignStreams (stream);
 }
 
 void
 UanMacCwW::EndTx (void)
 {
   NS_ASSERT (m_state == TX || m_state == CCABUSY);
+  // There are no ACKs at this layer; a signal still arriving when our
+  // frame ends is the local hint that it collided
+  if (m_phy->GetTransducer ()->GetArrivalList ().empty ())
+    {
+      m_backoff->NotifySuccess ();
+    }
+  else
+    {
+      m_backoff->NotifyCollision ();
+    }
   if (m_state == TX)
     {
       m_state = IDLE;
@@ -338,6 +355,12 @@ UanMacCwW::GetCw (void)
 {
   return m_cw;
 }
+
+Ptr<UanBackoff>
+UanMacCwW::GetBackoff (void) const
+{
+  return m_backoff;
+}
 Time
 UanMacCwW::GetSlotTime (void)
 {
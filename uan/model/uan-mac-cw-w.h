@@ -28,6 +28,7 @@
 #include "ns3/uan-tx-mode.h"
 #include "ns3/uan-address.h"
 #include "ns3/random-variable-stream.h"
+#include "uan-backoff.h"
 #include "uan-mac-wakeup.h"
 
 namespace ns3 {
@@ -76,6 +77,8 @@ public:
    * \return Contention window size.
    */
   virtual uint32_t GetCw (void);
+  /** \return The backoff policy. */
+  Ptr<UanBackoff> GetBackoff (void) const;
   /**
    * Get the slot time duration.
    *
@@ -98,6 +101,7 @@ public:
 
   void AttachMacWakeup (Ptr<UanMacWakeup> mac);
     /** End TX state. */
+  /** End TX state and report the attempt to the backoff policy. */
   void EndTx (void);
   /**
    *  TracedCallback signature for enqueue/dequeue of a packet.
@@ -160,8 +164,8 @@ private:
   bool m_cleared;
   bool m_useWakeup;
 
-  /** Provides uniform random variable for contention window. */
-  Ptr<UniformRandomVariable> m_rv;
+  /** Backoff policy drawing the contention window. */
+  Ptr<UanBackoff> m_backoff;
 
   /**
    * Receive packet from lower layer (passed to PHY as callback).
@@ -30,6 +30,8 @@
 #include "ns3/attribute.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/nstime.h"
 
 #include <iostream>
@@ -51,12 +53,22 @@ UanMacFamaNW::UanMacFamaNW ()
     m_maxPropTime (0.47),
     m_maxPacketSize (26)
 {
-  m_timerCONTEND.SetFunction (&UanMacFamaNW::On_timerCONTEND, this);
-  m_timerWaitToBackoff.SetFunction (&UanMacFamaNW::On_timerWaitToBackoff, this);
-  m_timerWfCTS.SetFunction (&UanMacFamaNW::On_timerWfCTS, this);
-  m_timerWfDATA.SetFunction (&UanMacFamaNW::On_timerWfDATA, this);
-  m_timerBackoff.SetFunction (&UanMacFamaNW::On_timerBackoff, this);
-  m_timerWfACK.SetFunction (&UanMacFamaNW::On_timerWfACK, this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (WFCTS, "WFCTS");
+  m_fsm->AddState (SDATA, "SDATA");
+  m_fsm->AddState (WFDATA, "WFDATA");
+  m_fsm->AddState (WFACK, "WFACK");
+  m_fsm->AddState (BACKOFF, "BACKOFF");
+  m_fsm->AddState (RX, "RX");
+
+  m_timerCONTEND.Attach (m_fsm, "CONTEND", MakeCallback (&UanMacFamaNW::On_timerCONTEND, this));
+  m_timerWaitToBackoff.Attach (m_fsm, "WaitToBackoff", MakeCallback (&UanMacFamaNW::On_timerWaitToBackoff, this));
+  m_timerWfCTS.Attach (m_fsm, "WfCTS", MakeCallback (&UanMacFamaNW::On_timerWfCTS, this));
+  m_timerWfDATA.Attach (m_fsm, "WfDATA", MakeCallback (&UanMacFamaNW::On_timerWfDATA, this));
+  m_timerBackoff.Attach (m_fsm, "Backoff", MakeCallback (&UanMacFamaNW::On_timerBackoff, this));
+  m_timerWfACK.Attach (m_fsm, "WfACK", MakeCallback (&UanMacFamaNW::On_timerWfACK, this));
   
   m_rtsSize = 0;
   m_useAck = true;
@@ -66,9 +78,10 @@ UanMacFamaNW::UanMacFamaNW ()
   m_bulkSend = 0;
   m_state = UanMacWakeup::IDLE;
   m_rand= CreateObject<UniformRandomVariable>();
+  m_backoff = CreateObject<UanBackoffUniform> ();
   
   m_phy=0;
-  m_macState = IDLE;
+  SetMacState (IDLE);
 }
 
 UanMacFamaNW::~UanMacFamaNW ()
@@ -97,6 +110,7 @@ void
 UanMacFamaNW::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -107,6 +121,11 @@ UanMacFamaNW::GetTypeId (void)
     .SetParent<UanMac> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacFamaNW> ()
+    .AddAttribute ("Backoff",
+                   "Backoff policy used after a failed handshake and before each RTS.",
+                   StringValue ("ns3::UanBackoffUniform"),
+                   MakePointerAccessor (&UanMacFamaNW::m_backoff),
+                   MakePointerChecker<UanBackoff> ())
   ;
   return tid;
 }
@@ -134,6 +153,30 @@ UanMacFamaNW::GetBackoffTime ()
   return m_maxBackoff;
 }
 
+Ptr<UanBackoff>
+UanMacFamaNW::GetBackoff (void) const
+{
+  return m_backoff;
+}
+
+Ptr<UanMacFsm>
+UanMacFamaNW::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+void
+UanMacFamaNW::SetMacState (MACSTATE state)
+{
+  m_fsm->SetState (state);
+}
+
+UanMacFamaNW::MACSTATE
+UanMacFamaNW::GetMacState (void) const
+{
+  return static_cast<MACSTATE> (m_fsm->GetState ());
+}
+
 void
 UanMacFamaNW::SetRtsSize (uint32_t size)
 {
@@ -185,9 +228,9 @@ UanMacFamaNW::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protoco
       && !m_timerWaitToBackoff.IsRunning()
       && !m_timerCONTEND.IsRunning ()
       && m_state == UanMacWakeup::IDLE
-	  && m_macState == IDLE)
+	  && GetMacState () == IDLE)
     {
-      m_macState = CONTEND;
+      SetMacState (CONTEND);
 	  uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
       UanHeaderCommon header;
       header.SetSrc (src);
@@ -245,7 +288,7 @@ UanMacFamaNW::SendRTS ()
 
   bool success = Send(packet);
   if(success){
-    m_macState = WFCTS;
+    SetMacState (WFCTS);
 	/*uint32_t size = 10;// DynamicCast<UanMacWakeup> (m_mac)->GetHeadersSize ();
     if (m_rtsSize > size)
       size = m_rtsSize - size;
@@ -281,7 +324,7 @@ UanMacFamaNW::SendCTS (const Address &dest, const double duration)
 
   bool success = Send(packet);
   if(success) {
-  m_macState = WFDATA;
+  SetMacState (WFDATA);
   m_timerWfDATA.Schedule(Seconds(m_maxPropTime * 2 + (size + packet->GetSize ()) * 8 / dataRate));
   }
   return success;
@@ -324,7 +367,7 @@ UanMacFamaNW::PhyStateCb (UanMacWakeup::PhyState phyState)
   switch (phyState)
   {
   case UanMacWakeup::IDLE:
-    if (m_macState == IDLE)
+    if (GetMacState () == IDLE)
       {
         m_timerWaitToBackoff.Cancel ();
         m_timerCONTEND.Cancel ();
@@ -353,7 +396,7 @@ UanMacFamaNW::TxEnd ()
       if (!m_useAck)
         {
           m_sendingData = false;
-		  m_macState = IDLE;
+		  SetMacState (IDLE);
           m_sendQueue.pop ();
 
           if (m_sendQueue.size () >= 1 && m_bulkSend > 0)
@@ -364,7 +407,7 @@ UanMacFamaNW::TxEnd ()
               if (Send (sendPkt->Copy()))
                 {
                   m_sendingData = true;
-				  m_macState = SDATA;
+				  SetMacState (SDATA);
                   m_bulkSend--;
                   m_sendDataCallback (sendPkt);
                 }
@@ -380,7 +423,7 @@ UanMacFamaNW::TxEnd ()
 		else{
 		  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Sent DATA, WFACK");
 		  uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
-		  m_macState = WFACK;
+		  SetMacState (WFACK);
 		  m_timerWfACK.Schedule(Seconds(m_maxPropTime * 2 + (m_maxPacketSize+20 + 5) * 8 / dataRate));
 		}
     }
@@ -449,7 +492,7 @@ UanMacFamaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
 		
 		if (m_useAck) SendAck (m_rxSrc);
         NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX DATA from " << header.GetSrc ()<<"********************************");
-        m_macState = IDLE;
+        SetMacState (IDLE);
 		m_forUpCb (pkt, m_rxSrc);
       }
 	else{
@@ -461,22 +504,28 @@ UanMacFamaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
 		   m_timerBackoff.Schedule(Seconds(m_maxPropTime+0.1));
 		 }
 		 NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xDATA " );
-		 m_macState = BACKOFF;
+		 SetMacState (BACKOFF);
 	}
     break;
   case ACK:
     if (header.GetDest () == GetAddress () || header.GetDest () == UanAddress::GetBroadcast ())
       {
+        // After the WfACK timeout the packet is being retried, not delivered
+        if (GetMacState () != WFACK)
+          {
+            NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" stale ACK from " << header.GetSrc () << " dropped");
+            break;
+          }
         m_sendQueue.pop ();
         m_sendingData = false;
-        NS_ASSERT(m_macState = WFACK);
+        DynamicCast<UanMacWakeup> (m_mac)->NotifyDelivered (header.GetSrc (), Seconds (m_maxPropTime));
 		m_timerWfACK.Cancel();
 		StopTimer();
-		m_macState = IDLE;
+		SetMacState (IDLE);
         if (m_sendQueue.size () >= 1 && m_bulkSend > 0)
           {
             Ptr<Packet> sendPkt = m_sendQueue.front();
-            m_macState = SDATA;
+            SetMacState (SDATA);
             if (Send (sendPkt->Copy()))
               {
 				NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send Pkt Train after ACK. Queue size"<< m_sendQueue.size());
@@ -488,7 +537,7 @@ UanMacFamaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
 				//		else{
 		  
 				uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
-			    m_macState = WFACK;
+			    SetMacState (WFACK);
 		        m_timerWfACK.Schedule(Seconds(m_maxPropTime * 2 + (m_maxPacketSize+20 + 5) * 8 / dataRate));
 
               }
@@ -504,9 +553,9 @@ UanMacFamaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
         m_forUpCb (pkt, header.GetSrc ());
       }
 	  else{
-	    if(m_macState != WFDATA && m_macState != WFACK){
+	    if(GetMacState () != WFDATA && GetMacState () != WFACK){
 	      StopTimer();
-		  m_macState = BACKOFF;
+		  SetMacState (BACKOFF);
 		  m_timerBackoff.Schedule(Seconds(m_maxPropTime+0.08));
 		  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xACK " );
 		}
@@ -516,7 +565,7 @@ UanMacFamaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
 }
 void 
 UanMacFamaNW::StartContend(){
-    m_macState = CONTEND;
+    SetMacState (CONTEND);
 	NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds ()  <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Schedule Next packet. Queue size"<< m_sendQueue.size());
     // Size
     uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
@@ -545,7 +594,7 @@ UanMacFamaNW::RxRTS (Ptr<Packet> pkt)
 {
   if (m_rxDest == GetAddress())
     {
-	  if(m_macState != WFDATA){
+	  if(GetMacState () != WFDATA){
 	    NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX RTS from " << m_rxSrc);
 		StopTimer();
         SendCTS (m_rxSrc, 0);
@@ -553,11 +602,12 @@ UanMacFamaNW::RxRTS (Ptr<Packet> pkt)
     }
   else
   {
-    if(m_macState != WFDATA && m_macState != WFACK){
+    if(GetMacState () != WFDATA && GetMacState () != WFACK){
       StopTimer();
 	  m_timerBackoff.Schedule(Seconds(2*m_maxPropTime+0.1));
-	  m_macState = BACKOFF;
+	  SetMacState (BACKOFF);
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xRTS " );
+	  m_backoff->NotifyBusy ();
 	}
   }
 }
@@ -568,12 +618,13 @@ UanMacFamaNW::RxCTS (Ptr<Packet> pkt)
   if (m_rxDest == GetAddress() && m_sendQueue.size() > 0)
     {
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX CTS ");
+	  m_backoff->NotifySuccess ();
 	  //NS_ASSERT (m_sendQueue.size () > 0);
         Ptr<Packet> sendPkt = m_sendQueue.front();
 		Ptr<Packet> sendPktCb = sendPkt -> Copy();
 		Ptr<Packet> sendPktCb2 = sendPktCb -> Copy();
 		StopTimer();
-		m_macState = IDLE;
+		SetMacState (IDLE);
         if (Send (sendPkt->Copy()))
           {
 		    Ptr<Packet> sendPktCb = Create<Packet> (m_maxPacketSize);
@@ -582,11 +633,11 @@ UanMacFamaNW::RxCTS (Ptr<Packet> pkt)
 			NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Sent DATA");
 			//m_sendQueue.pop ();
             m_sendingData = true;
-			m_macState = SDATA;
+			SetMacState (SDATA);
 			if(m_useAck){
 		      NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Sent DATA, WFACK");
 		      uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
-		      m_macState = WFACK;
+		      SetMacState (WFACK);
 		      m_timerWfACK.Schedule(Seconds(m_maxPropTime * 2 + (m_maxPacketSize+20 + 5) * 8 / dataRate));
 			}
 			
@@ -598,14 +649,16 @@ UanMacFamaNW::RxCTS (Ptr<Packet> pkt)
     if(m_useAck){
 	  StopTimer();
 	  m_timerBackoff.Schedule(Seconds(4*m_maxPropTime+(m_maxPacketSize+10+8)*2*8/dataRate));
-	  m_macState = BACKOFF;
+	  SetMacState (BACKOFF);
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xCTS " );
+	  m_backoff->NotifyBusy ();
 	}
 	else{
 	  StopTimer();
 	  m_timerBackoff.Schedule(Seconds(2*m_maxPropTime+(m_maxPacketSize)*2*8/dataRate));
-	  m_macState = BACKOFF;
+	  SetMacState (BACKOFF);
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xCTS " );
+	  m_backoff->NotifyBusy ();
 	} 
 	
   }
@@ -620,15 +673,14 @@ UanMacFamaNW::RxPacketError (Ptr<Packet> pkt, double sinr)
 Address
 UanMacFamaNW::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 void
 UanMacFamaNW::On_timerWaitToBackoff (void)
 {
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Schedule RTS timer");
-  m_timerCONTEND.Schedule (Seconds (m_rand->GetValue(0.1, m_maxBackoff)));
+  m_timerCONTEND.Schedule (Seconds (m_backoff->GetBackoff (0.1, m_maxBackoff)));
 }
 
 void
@@ -639,19 +691,20 @@ UanMacFamaNW::On_timerCONTEND (void)
 
 void 
 UanMacFamaNW::On_timerWfCTS(void){
-  double bkoffNum=m_rand->GetValue(0.1,m_maxBackoff);
+  m_backoff->NotifyCollision ();
+  double bkoffNum=m_backoff->GetBackoff (0.1,m_maxBackoff);
   m_timerBackoff.Schedule(Seconds(10*bkoffNum*(2*m_maxPropTime+0.1)));
-  m_macState = BACKOFF;
+  SetMacState (BACKOFF);
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " not receive CTS");
 }
 void 
 UanMacFamaNW::On_timerWfDATA(void){
-  m_macState = IDLE;
+  SetMacState (IDLE);
 }
 void 
 UanMacFamaNW::On_timerBackoff(void){
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Exit Backoff");
-  m_macState = IDLE;
+  SetMacState (IDLE);
   if(m_sendQueue.size()){
     StopTimer();
 	StartContend();
@@ -660,9 +713,10 @@ UanMacFamaNW::On_timerBackoff(void){
 
 void
 UanMacFamaNW::On_timerWfACK(void){
-  double bkoffNum=m_rand->GetValue(0.1,m_maxBackoff);
+  m_backoff->NotifyCollision ();
+  double bkoffNum=m_backoff->GetBackoff (0.1,m_maxBackoff);
   m_timerBackoff.Schedule(Seconds(10*bkoffNum*(2*m_maxPropTime+0.1)));
-  m_macState = BACKOFF;
+  SetMacState (BACKOFF);
   m_sendingData = false;
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " not receive ACK");
 }
@@ -677,7 +731,8 @@ UanMacFamaNW::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_rand->SetStream (stream);
-  return 1;
+  m_backoff->AssignStreams (stream + 1);
+  return 2;
 }
 
 
@@ -28,6 +28,8 @@
 #include "ns3/timer.h"
 #include "ns3/uan-phy.h"
 #include "uan-mac-wakeup.h"
+#include "uan-backoff.h"
+#include "uan-mac-fsm.h"
 
 #include <queue>
 
@@ -74,6 +76,11 @@ public:
 
   void SetBackoffTime (double backoff);
   double GetBackoffTime ();
+  Ptr<UanBackoff> GetBackoff (void) const;
+  /** \return State machine engine holding the MAC state, timers and dwell counters. */
+  Ptr<UanMacFsm> GetFsm (void) const;
+  /** \return Current state, kept by the state machine engine. */
+  MACSTATE GetMacState (void) const;
   void SetRtsSize (uint32_t size);
   uint32_t GetRtsSize () const;
 
@@ -81,6 +88,7 @@ public:
   int64_t AssignStreams(int64_t stream);
 private:
   Ptr<UniformRandomVariable> m_rand;
+  Ptr<UanBackoff> m_backoff;
 
   std::queue<Ptr<Packet> > m_sendQueue;
 
@@ -96,15 +104,15 @@ private:
   Ptr<Packet> m_pkt;
   UanAddress m_dest;
 
-  Timer m_timerCONTEND;
-  Timer m_timerWaitToBackoff;
-  Timer m_timerWfCTS;
-  Timer m_timerWfDATA;
-  Timer m_timerBackoff;
-  Timer m_timerWfACK;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerCONTEND;
+  UanMacFsmTimer m_timerWaitToBackoff;
+  UanMacFsmTimer m_timerWfCTS;
+  UanMacFsmTimer m_timerWfDATA;
+  UanMacFsmTimer m_timerBackoff;
+  UanMacFsmTimer m_timerWfACK;
 
   UanMacWakeup::PhyState m_state;
-  MACSTATE m_macState;
 
   double m_maxBackoff;
   double m_maxPropTime;
@@ -122,6 +130,7 @@ private:
   uint8_t m_maxBulkSend;
   uint8_t m_bulkSend;
 
+  void SetMacState (MACSTATE state);
   void On_timerCONTEND (void);
   void On_timerWaitToBackoff (void);
   void On_timerWfCTS(void);
@@ -25,17 +25,22 @@
 #include "uan-phy.h"
 #include "uan-header-common.h"
 #include "uan-header-wakeup.h"
+#include "uan-phy-header.h"
 #include "ns3/uan-header-common.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/attribute.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/boolean.h"
 
 #include "ns3/nstime.h"
 #include "ns3/double.h"
 
 
 #include <iostream>
+#include <algorithm>
 NS_LOG_COMPONENT_DEFINE ("UanMacFama");
 
 
@@ -51,12 +56,46 @@ UanMacFama::UanMacFama ()
     m_maxPropTime (0.3),
     m_maxPacketSize (26)
 {
-  m_timerCONTEND.SetFunction (&UanMacFama::On_timerCONTEND, this);
-  m_timerWaitToBackoff.SetFunction (&UanMacFama::On_timerWaitToBackoff, this);
-  m_timerWfCTS.SetFunction (&UanMacFama::On_timerWfCTS, this);
-  m_timerWfDATA.SetFunction (&UanMacFama::On_timerWfDATA, this);
-  m_timerBackoff.SetFunction (&UanMacFama::On_timerBackoff, this);
-  m_timerWfACK.SetFunction (&UanMacFama::On_timerWfACK, this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (WFCTS, "WFCTS");
+  m_fsm->AddState (SDATA, "SDATA");
+  m_fsm->AddState (WFDATA, "WFDATA");
+  m_fsm->AddState (WFACK, "WFACK");
+  m_fsm->AddState (BACKOFF, "BACKOFF");
+  m_fsm->AddState (RX, "RX");
+
+  // Frames sent or received outside a handshake move the MAC from any state
+  for (uint32_t state = IDLE; state <= RX; state++)
+    {
+      m_fsm->AddTransition (state, TX_CTS, WFDATA);
+      m_fsm->AddTransition (state, TX_DATA, SDATA);
+      m_fsm->AddTransition (state, TX_DATA_END, WFACK);
+      m_fsm->AddTransition (state, TX_DONE, IDLE);
+      m_fsm->AddTransition (state, RX_DATA, IDLE);
+      m_fsm->AddTransition (state, OVERHEARD, BACKOFF);
+    }
+  m_fsm->AddTransition (IDLE, START_CONTEND, CONTEND);
+  m_fsm->AddTransition (CONTEND, START_CONTEND, CONTEND);
+  m_fsm->AddTransition (CONTEND, STOP_CONTEND, IDLE);
+  m_fsm->AddTransition (IDLE, TX_RTS, WFCTS);
+  m_fsm->AddTransition (CONTEND, TX_RTS, WFCTS);
+  // A CTS or ACK only counts while it is awaited
+  m_fsm->AddTransition (WFCTS, RX_CTS, IDLE);
+  m_fsm->AddTransition (WFACK, RX_ACK, IDLE);
+  // Each waiting state runs one timer
+  m_fsm->AddTransition (WFCTS, TIMEOUT, BACKOFF);
+  m_fsm->AddTransition (WFDATA, TIMEOUT, IDLE);
+  m_fsm->AddTransition (WFACK, TIMEOUT, BACKOFF);
+  m_fsm->AddTransition (BACKOFF, TIMEOUT, IDLE);
+
+  m_timerCONTEND.Attach (m_fsm, "CONTEND", MakeCallback (&UanMacFama::On_timerCONTEND, this));
+  m_timerWaitToBackoff.Attach (m_fsm, "WaitToBackoff", MakeCallback (&UanMacFama::On_timerWaitToBackoff, this));
+  m_timerWfCTS.Attach (m_fsm, "WfCTS", MakeCallback (&UanMacFama::On_timerWfCTS, this));
+  m_timerWfDATA.Attach (m_fsm, "WfDATA", MakeCallback (&UanMacFama::On_timerWfDATA, this));
+  m_timerBackoff.Attach (m_fsm, "Backoff", MakeCallback (&UanMacFama::On_timerBackoff, this));
+  m_timerWfACK.Attach (m_fsm, "WfACK", MakeCallback (&UanMacFama::On_timerWfACK, this));
 
   m_rtsSize = 0;
   m_useAck = true;
@@ -66,7 +105,12 @@ UanMacFama::UanMacFama ()
   m_bulkSend = 0;
   m_state = UanMacWakeup::IDLE;
 
+  m_learnPropDelay = true;
+  m_propDelayGuard = 0.01;
+  m_propDelayAlpha = 0.25;
+
   m_rand= CreateObject<UniformRandomVariable>();
+  m_backoff = CreateObject<UanBackoffUniform> ();
 }
 
 UanMacFama::~UanMacFama ()
@@ -95,6 +139,7 @@ void
 UanMacFama::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -105,6 +150,31 @@ UanMacFama::GetTypeId (void)
     .SetParent<UanMac> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacFama> ()
+    .AddAttribute ("Backoff",
+                   "Backoff policy used after a failed handshake and before each RTS.",
+                   StringValue ("ns3::UanBackoffUniform"),
+                   MakePointerAccessor (&UanMacFama::m_backoff),
+                   MakePointerChecker<UanBackoff> ())
+    .AddAttribute ("MaxPropDelay",
+                   "Maximum propagation delay in seconds, used towards unknown neighbors.",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&UanMacFama::m_maxPropTime),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LearnPropDelay",
+                   "Learn per-neighbor delays from RTS/CTS timestamps to size handshake timers.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&UanMacFama::m_learnPropDelay),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PropDelayGuard",
+                   "Margin in seconds added to a learned neighbor delay.",
+                   DoubleValue (0.01),
+                   MakeDoubleAccessor (&UanMacFama::m_propDelayGuard),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PropDelayAlpha",
+                   "Weight of a new sample in the smoothed neighbor delay.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&UanMacFama::m_propDelayAlpha),
+                   MakeDoubleChecker<double> (0, 1))
   ;
   return tid;
 }
@@ -133,6 +203,24 @@ UanMacFama::GetBackoffTime ()
   return m_maxBackoff;
 }
 
+Ptr<UanBackoff>
+UanMacFama::GetBackoff (void) const
+{
+  return m_backoff;
+}
+
+Ptr<UanMacFsm>
+UanMacFama::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+UanMacFama::MACSTATE
+UanMacFama::GetMacState (void) const
+{
+  return static_cast<MACSTATE> (m_fsm->GetState ());
+}
+
 void
 UanMacFama::SetRtsSize (uint32_t size)
 {
@@ -173,6 +261,7 @@ UanMacFama::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolN
   header.SetType (DATA);
 
   packet->AddHeader (header);
+  DynamicCast<UanMacWakeup> (m_mac)->SetSleepMode (false);
 
  if(m_sendQueue.size() < 10){
     m_sendQueue.push(packet);
@@ -182,9 +271,9 @@ UanMacFama::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolN
       && !m_timerWaitToBackoff.IsRunning()
       && !m_timerCONTEND.IsRunning ()
       && m_state == UanMacWakeup::IDLE
-	  && m_macState == IDLE)
+	  && GetMacState () == IDLE)
     {
-      m_macState = CONTEND;
+      m_fsm->Input (START_CONTEND);
       uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
       UanHeaderCommon header;
       header.SetSrc (src);
@@ -229,23 +318,22 @@ UanMacFama::SendRTS ()
   header.SetDest (udest);
   header.SetType (RTS);
 
-  // RTS size
-  uint32_t size = DynamicCast<UanMacWakeup> (m_mac)->GetHeadersSize ();
-  if (m_rtsSize > size)
-    size = m_rtsSize - size;
+  UanHeaderTimestamp timestamp (Simulator::Now ());
+  uint32_t size = GetRtsPayloadSize ();
 
   Ptr<Packet> packet = Create<Packet> (size);
+  packet->AddHeader (timestamp);
   packet->AddHeader (header);
 
 bool success = Send(packet);
   if(success){
-    m_macState = WFCTS;
+    m_fsm->Input (TX_RTS);
 	/*uint32_t size = 10;// DynamicCast<UanMacWakeup> (m_mac)->GetHeadersSize ();
     if (m_rtsSize > size)
       size = m_rtsSize - size;
     Ptr<Packet> packetRts = Create<Packet> (size);
     packetRts->AddHeader (header);*/
-	m_timerWfCTS.Schedule(Seconds(m_maxPropTime * 2 + (size + packet->GetSize ()) * 8 / dataRate)*2);
+	m_timerWfCTS.Schedule(Seconds(GetPropDelay (udest) * 2 + (size + packet->GetSize ()) * 8 / dataRate)*2);
   }
   return success;
 }
@@ -269,13 +357,14 @@ UanMacFama::SendCTS (const Address &dest, const double duration)
     size = m_rtsSize - size;
 
   Ptr<Packet> packet = Create<Packet> (m_maxPacketSize);
+  packet->AddHeader (UanHeaderTimestamp (Simulator::Now ()));
   packet->AddHeader (header);
 
   bool success = Send(packet);
   if(success) {
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send CTS");
-  m_macState = WFDATA;
-  m_timerWfDATA.Schedule(Seconds(m_maxPropTime * 2 + (size + packet->GetSize ()) * 8 / dataRate));
+  m_fsm->Input (TX_CTS);
+  m_timerWfDATA.Schedule(Seconds(GetPropDelay (udest) * 2 + (size + packet->GetSize ()) * 8 / dataRate));
   }
   return success;
 }
@@ -312,7 +401,7 @@ UanMacFama::PhyStateCb (UanMacWakeup::PhyState phyState)
   switch (phyState)
   {
   case UanMacWakeup::IDLE:
-    if (m_macState == IDLE)
+    if (GetMacState () == IDLE)
       {
         m_timerWaitToBackoff.Cancel ();
         m_timerCONTEND.Cancel ();
@@ -341,7 +430,7 @@ UanMacFama::TxEnd ()
       if (!m_useAck)
         {
           m_sendingData = false;
-          m_macState = IDLE;
+          m_fsm->Input (TX_DONE);
           m_sendQueue.pop ();
 
           if (m_sendQueue.size () >= 1 && m_bulkSend > 0)
@@ -364,13 +453,16 @@ UanMacFama::TxEnd ()
               NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds ()  <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Shedule Next packet in Queue (no ACK). Queue "<< m_sendQueue.size());
  			  StartContend();
             }
+          SleepWhenDone ();
         }
     else{
 		  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Sent DATA, WFACK");
 		  uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
-		  m_macState = WFACK;
+		  UanHeaderCommon dataHeader;
+		  m_sendQueue.front ()->PeekHeader (dataHeader);
+		  m_fsm->Input (TX_DATA_END);
 		  m_sendingData = false;
-		  m_timerWfACK.Schedule(Seconds(m_maxPropTime * 2 + (m_maxPacketSize+20 + 5) * 8 / dataRate));
+		  m_timerWfACK.Schedule(Seconds(GetPropDelay (dataHeader.GetDest ()) * 2 + (m_maxPacketSize+20 + 5) * 8 / dataRate));
 		}
     }
 }
@@ -386,6 +478,10 @@ UanMacFama::AttachMacWakeup (Ptr<UanMacWakeup> mac)
 {
   m_mac = mac;
   m_mac->SetForwardUpCb (MakeCallback (&UanMacFama::RxPacket, this));
+  mac->SetTxStampCallback (MakeCallback (&UanMacFama::StampTx, this));
+  mac->SetTxAlignCallback (MakeCallback (&UanMacFama::AlignTx, this));
+  // One timer event for the whole node
+  m_fsm->SetTimerQueue (mac->GetFsm ()->GetTimerQueue ());
 }
 
 bool
@@ -406,6 +502,7 @@ UanMacFama::SendAck (const UanAddress& dest)
 void
 UanMacFama::RxPacket (Ptr<Packet> pkt, const UanAddress& addr)
 {
+  uint32_t rxBytes = pkt->GetSize ();
   UanHeaderCommon header;
   pkt->RemoveHeader (header);
   //NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<"Receiving packet from " << header.GetSrc () << " For " << header.GetDest ());
@@ -418,6 +515,12 @@ UanMacFama::RxPacket (Ptr<Packet> pkt, const UanAddress& addr)
   if (m_rxSrc == GetAddress ())
     return;
 
+  if (m_rxType == RTS || m_rxType == CTS)
+    {
+      UanHeaderTimestamp timestamp;
+      pkt->RemoveHeader (timestamp);
+      LearnPropDelay (m_rxSrc, timestamp.GetTimeStamp (), rxBytes);
+    }
 
   uint8_t type = header.GetType();
 
@@ -436,38 +539,42 @@ UanMacFama::RxPacket (Ptr<Packet> pkt, const UanAddress& addr)
         if (m_useAck) SendAck (addr);
 		
         NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX DATA from " << header.GetSrc ()<<"********************************");
-        m_macState = IDLE;
+        m_fsm->Input (RX_DATA);
 		m_forUpCb (pkt, m_rxSrc);
-        m_forUpCb (pkt, header.GetSrc ());
+        SleepWhenDone ();
       }
    else{
 	     NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xDATA " );
 		 StopTimer();
 	     if(m_useAck){
-	       m_timerBackoff.Schedule(Seconds(2*m_maxPropTime+0.1));
+	       m_timerBackoff.Schedule(Seconds(2*GetPropDelay (m_rxSrc, m_rxDest)+0.1));
 		 }
 		 else{
-		   m_timerBackoff.Schedule(Seconds(m_maxPropTime+0.1));
+		   m_timerBackoff.Schedule(Seconds(GetPropDelay (m_rxSrc, m_rxDest)+0.1));
 		 }
 
-		 m_macState = BACKOFF;
+		 m_fsm->Input (OVERHEARD);
 	}
     break;
   case ACK:
     if (header.GetDest () == GetAddress () || header.GetDest () == UanAddress::GetBroadcast ())
       {
+        // After the WfACK timeout the packet is being retried, not delivered
+        if (!m_fsm->Input (RX_ACK))
+          {
+            NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" stale ACK from " << header.GetSrc () << " dropped");
+            break;
+          }
         m_sendQueue.pop ();
         m_sendingData = false;
-        
-		NS_ASSERT(m_macState = WFACK);
-		m_timerWfACK.Cancel();
+        DynamicCast<UanMacWakeup> (m_mac)->NotifyDelivered (header.GetSrc (), Seconds (GetPropDelay (header.GetSrc ())));
+
 		StopTimer();
-		m_macState = IDLE;
         if (m_sendQueue.size () >= 1 && m_bulkSend > 0)
           {
             Ptr<Packet> sendPkt = m_sendQueue.front();
 
-            m_macState = SDATA;
+            m_fsm->Input (TX_DATA);
             if (Send (sendPkt->Copy()))
               {
                 NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send Pkt Train after ACK. Queue size"<< m_sendQueue.size());
@@ -485,12 +592,13 @@ UanMacFama::RxPacket (Ptr<Packet> pkt, const UanAddress& addr)
          }
 
         m_forUpCb (pkt, header.GetSrc ());
+        SleepWhenDone ();
       }
        else{
-	    if(m_macState != WFDATA && m_macState != WFACK){
+	    if(GetMacState () != WFDATA && GetMacState () != WFACK){
 	      StopTimer();
-		  m_macState = BACKOFF;
-		  m_timerBackoff.Schedule(Seconds(m_maxPropTime+0.08));
+		  m_fsm->Input (OVERHEARD);
+		  m_timerBackoff.Schedule(Seconds(GetPropDelay (m_rxSrc, m_rxDest)+0.08));
 		  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xACK " );
 		}
 	  }
@@ -502,7 +610,7 @@ UanMacFama::StartContend(){
     NS_ASSERT(!m_timerCONTEND.IsRunning());
 	NS_ASSERT(!m_timerWaitToBackoff.IsRunning());
 	
-    m_macState = CONTEND;
+    m_fsm->Input (START_CONTEND);
 	NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds ()  <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Schedule Next packet. Queue size"<< m_sendQueue.size());
     // Size
     uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
@@ -520,6 +628,101 @@ UanMacFama::StopTimer(){
   m_timerWfDATA.Cancel();
 }
 
+double
+UanMacFama::GetPropDelay (UanAddress addr) const
+{
+  std::map<UanAddress, double>::const_iterator it = m_propDelay.find (addr);
+  if (!m_learnPropDelay || it == m_propDelay.end ())
+    {
+      return m_maxPropTime;
+    }
+  return std::min (it->second + m_propDelayGuard, m_maxPropTime);
+}
+
+double
+UanMacFama::GetPropDelay (UanAddress src, UanAddress dest) const
+{
+  // This node may lie between src and dest, so the larger of the two
+  // delays underestimates the exchange
+  return std::min (GetPropDelay (src) + GetPropDelay (dest), m_maxPropTime);
+}
+
+uint32_t
+UanMacFama::GetRtsPayloadSize (void) const
+{
+  UanHeaderTimestamp timestamp;
+  uint32_t size = DynamicCast<UanMacWakeup> (m_mac)->GetHeadersSize () + timestamp.GetSerializedSize ();
+  if (m_rtsSize > size)
+    size = m_rtsSize - size;
+  return size;
+}
+
+void
+UanMacFama::StampTx (Ptr<Packet> pkt, Time txStart)
+{
+  UanHeaderCommon header;
+  pkt->PeekHeader (header);
+  if (header.GetType () != RTS && header.GetType () != CTS)
+    {
+      return;
+    }
+
+  UanHeaderTimestamp timestamp;
+  pkt->RemoveHeader (header);
+  pkt->RemoveHeader (timestamp);
+  timestamp.SetTimeStamp (txStart);
+  pkt->AddHeader (timestamp);
+  pkt->AddHeader (header);
+}
+
+Time
+UanMacFama::AlignTx (Ptr<const Packet> pkt, Time txStart)
+{
+  return txStart;
+}
+
+void
+UanMacFama::LearnPropDelay (UanAddress src, Time timeStamp, uint32_t rxBytes)
+{
+  if (!m_learnPropDelay || m_phy == 0)
+    {
+      return;
+    }
+
+  // rxBytes excludes the PHY framing stripped by the wakeup MAC
+  UanPhyHeader phyHeader;
+  UanPhyTrailer phyTrailer;
+  rxBytes += phyHeader.GetSerializedSize () + phyTrailer.GetSerializedSize ();
+  double airTime = rxBytes * 8.0 / m_phy->GetMode (0).GetDataRateBps ();
+
+  double sample = (Simulator::Now () - timeStamp).GetSeconds () - airTime;
+  if (sample < 0)
+    {
+      return;
+    }
+
+  std::map<UanAddress, double>::iterator it = m_propDelay.find (src);
+  if (it == m_propDelay.end ())
+    {
+      m_propDelay.insert (std::make_pair (src, sample));
+    }
+  else
+    {
+      it->second = (1 - m_propDelayAlpha) * it->second + m_propDelayAlpha * sample;
+    }
+  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " delay to " << src << " " << m_propDelay[src]);
+}
+
+void
+UanMacFama::SleepWhenDone (void)
+{
+  if (GetMacState () == IDLE && m_sendQueue.empty ())
+    {
+      // Held for the wakeup MAC's SleepLinger
+      DynamicCast<UanMacWakeup> (m_mac)->SetSleepMode (true);
+    }
+}
+
 void
 UanMacFama::RxPacketGood (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
@@ -531,7 +734,7 @@ UanMacFama::RxRTS (Ptr<Packet> pkt)
 {
   if (m_rxDest == GetAddress())
     {
-      	if(m_macState != WFDATA){
+      	if(GetMacState () != WFDATA){
 	    NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX RTS from " << m_rxSrc);
 		StopTimer();
         SendCTS (m_rxSrc, 0);
@@ -540,11 +743,12 @@ UanMacFama::RxRTS (Ptr<Packet> pkt)
 
     else
   {
-    if(m_macState != WFDATA && m_macState != WFACK){
+    if(GetMacState () != WFDATA && GetMacState () != WFACK){
       StopTimer();
-	  m_timerBackoff.Schedule(Seconds(2*m_maxPropTime+0.1));
-	  m_macState = BACKOFF;
+	  m_timerBackoff.Schedule(Seconds(2*GetPropDelay (m_rxSrc, m_rxDest)+0.1));
+	  m_fsm->Input (OVERHEARD);
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xRTS " );
+	  m_backoff->NotifyBusy ();
 	}
   }
 }
@@ -554,21 +758,21 @@ UanMacFama::RxCTS (Ptr<Packet> pkt)
 {
   if (m_rxDest == GetAddress())
   {
-    if(m_macState == WFCTS && m_sendQueue.size() > 0){
+    if(m_sendQueue.size() > 0 && m_fsm->Input (RX_CTS)){
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " RX CTS");
+	  m_backoff->NotifySuccess ();
       //NS_ASSERT (m_sendQueue.size () > 0);
       Ptr<Packet> sendPkt = m_sendQueue.front();
 
       
       StopTimer();
-	  m_macState = IDLE;
       if (Send (sendPkt->Copy()))
         {
           NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Sent DATA");
           //m_sendQueue.pop ();
           m_sendingData = true;
           m_sendDataCallback (sendPkt);
-		  m_macState = SDATA;
+		  m_fsm->Input (TX_DATA);
         }
       }
     }
@@ -576,15 +780,17 @@ else{
     uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
     if(m_useAck){
 	  StopTimer();
-	  m_timerBackoff.Schedule(Seconds(4*m_maxPropTime+(m_maxPacketSize+10+8)*2*8/dataRate));
-	  m_macState = BACKOFF;
+	  m_timerBackoff.Schedule(Seconds(4*GetPropDelay (m_rxSrc, m_rxDest)+(m_maxPacketSize+10+8)*2*8/dataRate));
+	  m_fsm->Input (OVERHEARD);
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xCTS " );
+	  m_backoff->NotifyBusy ();
 	}
 	else{
 	  StopTimer();
-	  m_timerBackoff.Schedule(Seconds(2*m_maxPropTime+(m_maxPacketSize)*2*8/dataRate));
-	  m_macState = BACKOFF;
+	  m_timerBackoff.Schedule(Seconds(2*GetPropDelay (m_rxSrc, m_rxDest)+(m_maxPacketSize)*2*8/dataRate));
+	  m_fsm->Input (OVERHEARD);
 	  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" rx xCTS " );
+	  m_backoff->NotifyBusy ();
 	} 
 	
   }
@@ -599,8 +805,7 @@ UanMacFama::RxPacketError (Ptr<Packet> pkt, double sinr)
 Address
 UanMacFama::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 void
@@ -608,7 +813,7 @@ UanMacFama::On_timerWaitToBackoff (void)
 {
   NS_ASSERT(!m_timerCONTEND.IsRunning());
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Schedule RTS timer");
-  m_timerCONTEND.Schedule (Seconds (m_rand->GetValue(0.1, m_maxBackoff)));
+  m_timerCONTEND.Schedule (Seconds (m_backoff->GetBackoff (0.1, m_maxBackoff)));
 }
 
 void
@@ -618,34 +823,45 @@ UanMacFama::On_timerCONTEND (void)
 }
 void 
 UanMacFama::On_timerWfCTS(void){
+  if (!m_fsm->Input (TIMEOUT))
+    {
+      return;
+    }
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " not receive CTS");
-  double bkoffNum=m_rand->GetValue(0.1,m_maxBackoff);
+  m_backoff->NotifyCollision ();
+  double bkoffNum=m_backoff->GetBackoff (0.1,m_maxBackoff);
   m_timerBackoff.Schedule(Seconds(10*bkoffNum*(2*m_maxPropTime+0.1)));
-  m_macState = BACKOFF;
-
 }
 void 
 UanMacFama::On_timerWfDATA(void){
-  m_macState = IDLE;
+  m_fsm->Input (TIMEOUT);
+  SleepWhenDone ();
 }
 void 
 UanMacFama::On_timerBackoff(void){
+  if (!m_fsm->Input (TIMEOUT))
+    {
+      return;
+    }
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Exit Backoff");
-  m_macState = IDLE;
   if(m_sendQueue.size()){
     StopTimer();
 	//StartContend();
 	SendRTS();
   }
+  SleepWhenDone ();
 }
 
 void
 UanMacFama::On_timerWfACK(void){
+  if (!m_fsm->Input (TIMEOUT))
+    {
+      return;
+    }
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " not receive ACK");
-  double bkoffNum=m_rand->GetValue(0.1,m_maxBackoff);
+  m_backoff->NotifyCollision ();
+  double bkoffNum=m_backoff->GetBackoff (0.1,m_maxBackoff);
   m_timerBackoff.Schedule(Seconds(10*bkoffNum*(2*m_maxPropTime+0.1)));
-  m_macState = BACKOFF;
-  
 }
 
 void
@@ -659,7 +875,8 @@ UanMacFama::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_rand->SetStream (stream);
-  return 1;
+  m_backoff->AssignStreams (stream + 1);
+  return 2;
 }
 }
 
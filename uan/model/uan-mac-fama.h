@@ -28,8 +28,11 @@
 #include "ns3/timer.h"
 #include "ns3/uan-phy.h"
 #include "uan-mac-wakeup.h"
+#include "uan-backoff.h"
+#include "uan-mac-fsm.h"
 
 #include <queue>
+#include <map>
 
 namespace ns3
 {
@@ -43,6 +46,22 @@ class UanMacFama : public UanMac
 public:
   enum TYPE {RTS, CTS, DATA, ACK};
   enum MACSTATE {IDLE, CONTEND, WFCTS, SDATA, WFDATA, WFACK, BACKOFF, RX};
+  /** Inputs of the transition table built in the constructor. */
+  enum INPUT
+  {
+    START_CONTEND,  //!< Contend for the channel, or keep contending
+    STOP_CONTEND,   //!< Nothing left to send
+    TX_RTS,
+    TX_CTS,
+    TX_DATA,
+    TX_DATA_END,    //!< Data frame sent, ACK awaited
+    TX_DONE,        //!< Data frame sent, no ACK
+    RX_CTS,         //!< CTS for this node
+    RX_DATA,        //!< Data for this node
+    RX_ACK,         //!< ACK for this node
+    OVERHEARD,      //!< Exchange of other nodes, stay off the channel
+    TIMEOUT         //!< Timer of the current state expired
+  };
 
   UanMacFama ();
   virtual ~UanMacFama ();
@@ -63,7 +82,7 @@ public:
   void TxEnd ();
 
   void StartContend();
-  void StopTimer();
+  virtual void StopTimer();
   void SetUseAck (bool ack);
   bool GetUseAck () const;
 
@@ -76,13 +95,35 @@ public:
 
   void SetBackoffTime (double backoff);
   double GetBackoffTime ();
+  Ptr<UanBackoff> GetBackoff (void) const;
+  /** \return State machine engine holding the MAC state, timers and dwell counters. */
+  Ptr<UanMacFsm> GetFsm (void) const;
+  /** \return Current state, kept by the state machine engine. */
+  MACSTATE GetMacState (void) const;
   void SetRtsSize (uint32_t size);
   uint32_t GetRtsSize () const;
 
   void SetBulkSend (uint8_t bulkSend);
 
-private:
+  /**
+   * \param addr Neighbor address
+   * \return One-way delay used to size timers towards addr, in seconds.
+   * Learned from RTS/CTS timestamps, falls back to and is capped at the
+   * maximum propagation delay.
+   */
+  double GetPropDelay (UanAddress addr) const;
+  /**
+   * \param src Sender of an overheard frame
+   * \param dest Receiver of an overheard frame
+   * \return Delay from src to dest bounded from this node, in seconds.
+   * By the triangle inequality d(src,dest) <= d(me,src) + d(me,dest),
+   * capped at the maximum propagation delay.
+   */
+  double GetPropDelay (UanAddress src, UanAddress dest) const;
+
+protected:
   Ptr<UniformRandomVariable> m_rand;
+  Ptr<UanBackoff> m_backoff;
 
   std::queue<Ptr<Packet> > m_sendQueue;
 
@@ -98,15 +139,15 @@ private:
   Ptr<Packet> m_pkt;
   UanAddress m_dest;
 
-  Timer m_timerCONTEND;
-  Timer m_timerWaitToBackoff;
-  Timer m_timerWfCTS;
-  Timer m_timerWfDATA;
-  Timer m_timerBackoff;
-  Timer m_timerWfACK;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerCONTEND;
+  UanMacFsmTimer m_timerWaitToBackoff;
+  UanMacFsmTimer m_timerWfCTS;
+  UanMacFsmTimer m_timerWfDATA;
+  UanMacFsmTimer m_timerBackoff;
+  UanMacFsmTimer m_timerWfACK;
 
   UanMacWakeup::PhyState m_state;
-  MACSTATE m_macState;
 
   double m_maxBackoff;
   double m_maxPropTime;
@@ -124,19 +165,42 @@ private:
   uint8_t m_maxBulkSend;
   uint8_t m_bulkSend;
 
+  // Neighbor table: smoothed one-way delay (propagation plus wakeup latency)
+  std::map<UanAddress, double> m_propDelay;
+  bool m_learnPropDelay;
+  double m_propDelayGuard;
+  double m_propDelayAlpha;
+
   void On_timerCONTEND (void);
   void On_timerWaitToBackoff (void);
   void On_timerWfCTS(void);
   void On_timerWfDATA(void);
   void On_timerBackoff(void);
   void On_timerWfACK(void);
-  bool SendRTS ();
+  virtual bool SendRTS ();
   bool SendCTS (const Address &dest, const double duration);
   bool Send (Ptr<Packet> pkt);
   bool SendAck (const UanAddress& dest);
   void RxRTS (Ptr<Packet> pkt);
   void RxCTS (Ptr<Packet> pkt);
   bool SendWakeupBroadcast (Ptr<Packet> pkt);
+  void LearnPropDelay (UanAddress src, Time timeStamp, uint32_t rxBytes);
+  /**
+   * Rewrite the RTS/CTS timestamp with the PHY transmit start.
+   * \param pkt Frame about to be sent
+   * \param txStart Time the PHY starts sending it
+   */
+  void StampTx (Ptr<Packet> pkt, Time txStart);
+  /**
+   * \param pkt Frame about to be sent
+   * \param txStart Earliest time the PHY can start sending it
+   * \return Start to send at; txStart unless a subclass aligns frames.
+   */
+  virtual Time AlignTx (Ptr<const Packet> pkt, Time txStart);
+  /** \return Payload bytes padding an RTS up to RtsSize. */
+  uint32_t GetRtsPayloadSize (void) const;
+  /** Let the wakeup MAC put the data PHY to sleep once idle with nothing queued. */
+  void SleepWhenDone (void);
 
   /**
    * \brief Receive packet from lower layer (passed to PHY as callback)
@@ -152,7 +216,7 @@ private:
    * \param sinr SINR of received packet
    */
   void RxPacketError (Ptr<Packet> pkt, double sinr);
-protected:
+
   virtual void DoDispose ();
 };
 
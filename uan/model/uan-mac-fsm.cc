@@ -0,0 +1,298 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-mac-fsm.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanMacFsm");
+
+NS_OBJECT_ENSURE_REGISTERED (UanMacFsm);
+
+UanMacFsm::UanMacFsm ()
+  : m_state (0),
+    m_stateStart (Seconds (0))
+{
+  m_timerQueue = CreateObject<UanTimerQueue> ();
+}
+
+UanMacFsm::~UanMacFsm ()
+{
+}
+
+TypeId
+UanMacFsm::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanMacFsm")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanMacFsm> ()
+    .AddTraceSource ("Transition",
+                     "The MAC changed state.",
+                     MakeTraceSourceAccessor (&UanMacFsm::m_transitionTrace),
+                     "ns3::UanMacFsm::TransitionTracedCallback")
+  ;
+  return tid;
+}
+
+void
+UanMacFsm::DoDispose (void)
+{
+  CancelAll ();
+  m_transitions.clear ();
+  m_timerQueue = 0;
+  Object::DoDispose ();
+}
+
+void
+UanMacFsm::AddState (uint32_t state, std::string name)
+{
+  StateInfo info;
+  info.name = name;
+  info.dwell = Seconds (0);
+  info.entries = 0;
+  if (m_states.empty ())
+    {
+      m_state = state;
+      m_stateStart = Simulator::Now ();
+      info.entries = 1;
+    }
+  m_states[state] = info;
+}
+
+void
+UanMacFsm::SetState (uint32_t state)
+{
+  if (state == m_state)
+    {
+      return;
+    }
+  NS_ASSERT_MSG (m_states.find (state) != m_states.end (), "Unknown MAC state " << state);
+
+  Time now = Simulator::Now ();
+  StateInfo &from = m_states[m_state];
+  StateInfo &to = m_states[state];
+  from.dwell += now - m_stateStart;
+  to.entries++;
+
+  NS_LOG_DEBUG (now.GetSeconds () << " " << from.name << " -> " << to.name);
+  m_transitionTrace (from.name, to.name);
+
+  m_state = state;
+  m_stateStart = now;
+}
+
+uint32_t
+UanMacFsm::GetState (void) const
+{
+  return m_state;
+}
+
+std::string
+UanMacFsm::GetStateName (uint32_t state) const
+{
+  std::map<uint32_t, StateInfo>::const_iterator it = m_states.find (state);
+  return it == m_states.end () ? "" : it->second.name;
+}
+
+Time
+UanMacFsm::GetDwellTime (uint32_t state) const
+{
+  std::map<uint32_t, StateInfo>::const_iterator it = m_states.find (state);
+  if (it == m_states.end ())
+    {
+      return Seconds (0);
+    }
+  Time dwell = it->second.dwell;
+  if (state == m_state)
+    {
+      dwell += Simulator::Now () - m_stateStart;
+    }
+  return dwell;
+}
+
+uint32_t
+UanMacFsm::GetEntries (uint32_t state) const
+{
+  std::map<uint32_t, StateInfo>::const_iterator it = m_states.find (state);
+  return it == m_states.end () ? 0 : it->second.entries;
+}
+
+void
+UanMacFsm::AddTransition (uint32_t from, uint32_t input, uint32_t to, Action action)
+{
+  Transition t;
+  t.to = to;
+  t.action = action;
+  m_transitions[std::make_pair (from, input)] = t;
+}
+
+bool
+UanMacFsm::Input (uint32_t input)
+{
+  std::map<std::pair<uint32_t, uint32_t>, Transition>::const_iterator it =
+    m_transitions.find (std::make_pair (m_state, input));
+  if (it == m_transitions.end ())
+    {
+      NS_LOG_DEBUG ("No transition from " << GetStateName (m_state) << " on input " << input);
+      return false;
+    }
+  Action action = it->second.action;
+  SetState (it->second.to);
+  if (!action.IsNull ())
+    {
+      action ();
+    }
+  return true;
+}
+
+uint32_t
+UanMacFsm::AddTimer (std::string name, Callback<void> expire)
+{
+  NS_ASSERT_MSG (m_timerQueue, "Timer " << name << " added after dispose");
+  TimerInfo info;
+  info.name = name;
+  info.expire = expire;
+  info.id = m_timerQueue->Add (name, expire);
+  m_timers.push_back (info);
+  return m_timers.size () - 1;
+}
+
+void
+UanMacFsm::Schedule (uint32_t timer, Time delay)
+{
+  NS_ASSERT (timer < m_timers.size ());
+  NS_ASSERT_MSG (m_timerQueue, "Timer " << m_timers[timer].name << " scheduled after dispose");
+  m_timerQueue->Schedule (m_timers[timer].id, delay);
+}
+
+void
+UanMacFsm::Cancel (uint32_t timer)
+{
+  NS_ASSERT (timer < m_timers.size ());
+  if (m_timerQueue)
+    {
+      m_timerQueue->Cancel (m_timers[timer].id);
+    }
+}
+
+void
+UanMacFsm::CancelAll (void)
+{
+  // Only the timers of this MAC, the queue may be shared
+  for (uint32_t i = 0; i < m_timers.size (); i++)
+    {
+      Cancel (i);
+    }
+}
+
+bool
+UanMacFsm::IsRunning (uint32_t timer) const
+{
+  NS_ASSERT (timer < m_timers.size ());
+  return m_timerQueue && m_timerQueue->IsRunning (m_timers[timer].id);
+}
+
+Time
+UanMacFsm::GetDelayLeft (uint32_t timer) const
+{
+  NS_ASSERT (timer < m_timers.size ());
+  if (!m_timerQueue)
+    {
+      return Seconds (0);
+    }
+  return m_timerQueue->GetDelayLeft (m_timers[timer].id);
+}
+
+uint64_t
+UanMacFsm::GetScheduledEvents (void) const
+{
+  return m_timerQueue ? m_timerQueue->GetScheduledEvents () : 0;
+}
+
+void
+UanMacFsm::SetTimerQueue (Ptr<UanTimerQueue> queue)
+{
+  NS_ASSERT_MSG (m_timerQueue, "Timer queue set on a disposed state machine");
+  if (queue == m_timerQueue)
+    {
+      return;
+    }
+  for (uint32_t i = 0; i < m_timers.size (); i++)
+    {
+      // The old queue must not fire the timer once it has moved
+      bool running = m_timerQueue->IsRunning (m_timers[i].id);
+      Time left = m_timerQueue->GetDelayLeft (m_timers[i].id);
+      m_timerQueue->Cancel (m_timers[i].id);
+      m_timers[i].id = queue->Add (m_timers[i].name, m_timers[i].expire);
+      if (running)
+        {
+          queue->Schedule (m_timers[i].id, left);
+        }
+    }
+  m_timerQueue = queue;
+}
+
+Ptr<UanTimerQueue>
+UanMacFsm::GetTimerQueue (void) const
+{
+  return m_timerQueue;
+}
+
+/*************** UanMacFsmTimer definition *****************/
+UanMacFsmTimer::UanMacFsmTimer ()
+  : m_fsm (0),
+    m_id (0)
+{
+}
+
+void
+UanMacFsmTimer::Attach (Ptr<UanMacFsm> fsm, std::string name, Callback<void> expire)
+{
+  m_fsm = fsm;
+  m_id = fsm->AddTimer (name, expire);
+}
+
+void
+UanMacFsmTimer::Schedule (Time delay)
+{
+  m_fsm->Schedule (m_id, delay);
+}
+
+void
+UanMacFsmTimer::Cancel (void)
+{
+  m_fsm->Cancel (m_id);
+}
+
+bool
+UanMacFsmTimer::IsRunning (void) const
+{
+  return m_fsm->IsRunning (m_id);
+}
+
+Time
+UanMacFsmTimer::GetDelayLeft (void) const
+{
+  return m_fsm->GetDelayLeft (m_id);
+}
+
+} // namespace ns3
@@ -0,0 +1,187 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_MAC_FSM_H_
+#define UAN_MAC_FSM_H_
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/traced-callback.h"
+#include "uan-timer-queue.h"
+
+#include <map>
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * State machine engine shared by the UAN MACs.
+ *
+ * Holds the MAC state with per-state dwell time and entry counters, an
+ * optional transition table (state, input) -> (state, action), and the
+ * MAC timers.  Timers live in a UanTimerQueue, which the MACs stacked on
+ * a node can share so the whole node uses a single simulator event.
+ *
+ * The FAMA, MACA and T-Lohi MACs keep their state and timers here, the
+ * wakeup MACs their timers.  FAMA and slotted FAMA change state only
+ * through Input, so a frame or timeout the table has no entry for in the
+ * current state, such as a late ACK, is refused; the other MACs enter
+ * their states with SetState.
+ */
+class UanMacFsm : public Object
+{
+public:
+  /** Action run when a table transition is taken. */
+  typedef Callback<void> Action;
+
+  /**
+   * TracedCallback signature for state transitions.
+   *
+   * \param [in] from Name of the state left.
+   * \param [in] to Name of the state entered.
+   */
+  typedef void (* TransitionTracedCallback)(std::string from, std::string to);
+
+  UanMacFsm ();
+  virtual ~UanMacFsm ();
+  static TypeId GetTypeId (void);
+
+  /**
+   * \param state State id, usually the MAC enum value
+   * \param name Name used in traces and logs
+   */
+  void AddState (uint32_t state, std::string name);
+  /**
+   * Enter state.  Entering the current state again is not a transition.
+   * \param state State id
+   */
+  void SetState (uint32_t state);
+  uint32_t GetState (void) const;
+  std::string GetStateName (uint32_t state) const;
+  /**
+   * \param state State id
+   * \return Total time spent in state, including the current visit.
+   */
+  Time GetDwellTime (uint32_t state) const;
+  /**
+   * \param state State id
+   * \return Number of times state was entered.
+   */
+  uint32_t GetEntries (uint32_t state) const;
+
+  /**
+   * Declare that input in state from moves to state to and runs action.
+   */
+  void AddTransition (uint32_t from, uint32_t input, uint32_t to, Action action = Action ());
+  /**
+   * Apply input to the current state.
+   * \return False if the table has no entry for (state, input).
+   */
+  bool Input (uint32_t input);
+
+  /**
+   * \param name Name used in logs
+   * \param expire Called when the timer expires
+   * \return Timer id
+   */
+  uint32_t AddTimer (std::string name, Callback<void> expire);
+  void Schedule (uint32_t timer, Time delay);
+  void Cancel (uint32_t timer);
+  void CancelAll (void);
+  bool IsRunning (uint32_t timer) const;
+  /** \return Time until timer expires, zero if it is not running or the engine was disposed. */
+  Time GetDelayLeft (uint32_t timer) const;
+  /** \return Simulator events scheduled by the timer queue so far, zero once disposed. */
+  uint64_t GetScheduledEvents (void) const;
+
+  /**
+   * Move the timers of this MAC to queue, typically the one of the MAC
+   * below it on the same node.  Running timers are cancelled in the old
+   * queue and keep their deadline in the new one.
+   * \param queue Timer queue to use from now on
+   */
+  void SetTimerQueue (Ptr<UanTimerQueue> queue);
+  Ptr<UanTimerQueue> GetTimerQueue (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct StateInfo
+  {
+    std::string name;
+    Time dwell;
+    uint32_t entries;
+  };
+  struct TimerInfo
+  {
+    std::string name;
+    Callback<void> expire;
+    uint32_t id;           //!< Id in m_timerQueue
+  };
+  struct Transition
+  {
+    uint32_t to;
+    Action action;
+  };
+
+  std::map<uint32_t, StateInfo> m_states;
+  std::map<std::pair<uint32_t, uint32_t>, Transition> m_transitions;
+  uint32_t m_state;
+  Time m_stateStart;
+
+  std::vector<TimerInfo> m_timers;
+  Ptr<UanTimerQueue> m_timerQueue;
+
+  TracedCallback<std::string, std::string> m_transitionTrace;
+};
+
+/**
+ * \ingroup uan
+ *
+ * Handle to a UanMacFsm timer with the Timer interface the MACs use.
+ */
+class UanMacFsmTimer
+{
+public:
+  UanMacFsmTimer ();
+
+  /**
+   * \param fsm Engine owning the timer
+   * \param name Name used in logs
+   * \param expire Called when the timer expires
+   */
+  void Attach (Ptr<UanMacFsm> fsm, std::string name, Callback<void> expire);
+
+  void Schedule (Time delay);
+  void Cancel (void);
+  bool IsRunning (void) const;
+  Time GetDelayLeft (void) const;
+
+private:
+  Ptr<UanMacFsm> m_fsm;
+  uint32_t m_id;
+};
+
+} // namespace ns3
+
+#endif /* UAN_MAC_FSM_H_ */
@@ -30,6 +30,8 @@
 #include "ns3/attribute.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/nstime.h"
 
 #include <iostream>
@@ -49,25 +51,29 @@ UanMacMacaNW::UanMacMacaNW ()
   m_maxPropTime (0.3),
   m_maxPacketSize (64)
   {
-  m_timerSendBackoff.SetFunction (&UanMacMacaNW::OntimerSendBackoff,this);
-  m_timerQuiet.SetFunction (&UanMacMacaNW::OntimerQuiet,this);
-  m_timerWFCTS.SetFunction (&UanMacMacaNW::OntimerWFCTS,this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (WFCTS, "WFCTS");
+  m_fsm->AddState (WFDATA, "WFDATA");
+  m_fsm->AddState (QUIET, "QUIET");
+  m_timerSendBackoff.Attach (m_fsm, "SendBackoff", MakeCallback (&UanMacMacaNW::OntimerSendBackoff, this));
+  m_timerQuiet.Attach (m_fsm, "Quiet", MakeCallback (&UanMacMacaNW::OntimerQuiet, this));
+  m_timerWFCTS.Attach (m_fsm, "WFCTS", MakeCallback (&UanMacMacaNW::OntimerWFCTS, this));
   
   m_rtsSize = 0;
   
   m_maxBulkSend = 0;
   m_bulkSend = 0;
   m_state = UanMacWakeup::IDLE;
-  m_macaState = IDLE;
   m_rand= CreateObject<UniformRandomVariable>();
   
   m_phy = 0;
   m_tCTS = 0.05;
   m_tDATA = 0.22;
-    
-  m_minBEB=1;
-  m_maxBEB=10;
-  m_countBEB=1;
+
+  m_backoff = CreateObject<UanBackoffBeb> ();
+  m_queue = CreateObject<UanRelayQueue> ();
   }
   
 UanMacMacaNW::~UanMacMacaNW ()
@@ -98,6 +104,7 @@ void
 UanMacMacaNW::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -108,6 +115,16 @@ UanMacMacaNW::GetTypeId (void)
     .SetParent<Object> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacMacaNW> ()
+    .AddAttribute ("Backoff",
+                   "Backoff policy, in units of (max propagation delay + CTS time).",
+                   StringValue ("ns3::UanBackoffBeb"),
+                   MakePointerAccessor (&UanMacMacaNW::m_backoff),
+                   MakePointerChecker<UanBackoff> ())
+    .AddAttribute ("Queue",
+                   "Per next hop forwarding queue.",
+                   StringValue ("ns3::UanRelayQueue"),
+                   MakePointerAccessor (&UanMacMacaNW::m_queue),
+                   MakePointerChecker<UanRelayQueue> ())
   ;
   return tid;
 }
@@ -135,6 +152,18 @@ UanMacMacaNW::GetBackoffTime ()
   return m_maxBackoff;
 }
 
+Ptr<UanBackoff>
+UanMacMacaNW::GetBackoff (void) const
+{
+  return m_backoff;
+}
+
+Ptr<UanRelayQueue>
+UanMacMacaNW::GetQueue (void) const
+{
+  return m_queue;
+}
+
 void
 UanMacMacaNW::SetRtsSize (uint32_t size)
 {
@@ -156,6 +185,17 @@ UanMacMacaNW::SetForwardUpCb (Callback<void, Ptr<Packet>, const UanAddress& > cb
 
 bool
 UanMacMacaNW::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber){
+  return DoEnqueue (packet, dest, false);
+}
+
+bool
+UanMacMacaNW::Relay (Ptr<Packet> packet, const Address &nextHop)
+{
+  return DoEnqueue (packet, nextHop, true);
+}
+
+bool
+UanMacMacaNW::DoEnqueue (Ptr<Packet> packet, const Address &dest, bool relay){
    //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Queueing packet for " << UanAddress::ConvertFrom (dest));
 
   UanAddress src = UanAddress::ConvertFrom (GetAddress ());
@@ -168,17 +208,17 @@ UanMacMacaNW::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protoco
 
   packet->AddHeader (header);
 
-  if(m_sendQueue.size() < 10){
-    m_sendQueue.push(packet);
-    //NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" packet queueing increase to "<<m_sendQueue.size());
+  if (!m_queue->Enqueue (packet, udest, relay)){
+    NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" queue full, dropping packet for "<<udest);
+    return false;
   }
   
-  if (m_macaState == IDLE){
-    m_macaState = CONTEND;
+  if (GetMacState () == IDLE){
+    SetMacState (CONTEND);
 	
 	if (!m_timerSendBackoff.IsRunning())
 	  BackoffNextSend ();
-	else if (m_sendQueue.size() == 1){
+	else if (m_queue->GetSize() == 1){
 	  m_timerSendBackoff.Cancel();
 	  BackoffNextSend();
 	}
@@ -191,7 +231,7 @@ UanMacMacaNW::BackoffNextSend ()
 {
   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" sendBackoff ");
   NS_ASSERT(!m_timerSendBackoff.IsRunning());
-  double backoffTime = (double)(m_rand->GetValue(0,m_countBEB))*(m_maxPropTime+m_tCTS);
+  double backoffTime = m_backoff->GetBackoff (0, 1)*(m_maxPropTime+m_tCTS);
   m_timerSendBackoff.Schedule(Seconds(backoffTime));
 }
 
@@ -200,15 +240,15 @@ UanMacMacaNW::BackoffNextSend (bool b)
 {
   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" sendBackoff after Data");
   NS_ASSERT(!m_timerSendBackoff.IsRunning());
-  double backoffTime = (double)(m_rand->GetValue(0,m_countBEB))*(m_maxPropTime+m_tCTS);
+  double backoffTime = m_backoff->GetBackoff (0, 1)*(m_maxPropTime+m_tCTS);
   m_timerSendBackoff.Schedule(Seconds(backoffTime*1));
 }
 
 bool
 UanMacMacaNW::SendRTS ()
 {
-    NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send RTS. Queue "<<m_sendQueue.size ());
-  if((m_sendQueue.size() + m_relayQueue.size())< 1)
+    NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send RTS. Queue "<<m_queue->GetSize ());
+  if(m_queue->IsEmpty())
     return false;
   //NS_ASSERT(m_sendQueue.size () >= 1);
 
@@ -216,9 +256,7 @@ UanMacMacaNW::SendRTS ()
 
 //Get a RTS header
   UanHeaderCommon dataHeader;
-  Ptr<Packet> pkt=0;
-  if(!m_relayQueue.empty())  pkt=m_relayQueue.front();
-  else  pkt = m_sendQueue.front ();
+  Ptr<Packet> pkt = m_queue->Select ();
   pkt->PeekHeader (dataHeader);
 
   UanAddress udest = dataHeader.GetDest();
@@ -268,6 +306,8 @@ UanMacMacaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
   m_rxDest = header.GetDest();
   m_rxType = header.GetType();
   m_rxSize = header.GetSerializedSize();
+  // Whoever we hear is awake again
+  m_queue->Unblock (m_rxSrc);
   
   if (UanAddress::ConvertFrom (GetAddress ()) == m_rxDest){
     //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" Receiving "<< int(m_rxType) <<" packet from " << m_rxSrc);
@@ -292,21 +332,21 @@ UanMacMacaNW::RxPacket (Ptr<Packet> pkt,  double sinr, UanTxMode mode)
     RxCTS (pkt);
     break;
   case DATA:
-    if (m_macaState == WFDATA){
+    if (GetMacState () == WFDATA){
 	
 	  if (m_rxDest == GetAddress () || m_rxDest == UanAddress::GetBroadcast ())
         {
 		   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX DATA from "<<  m_rxSrc <<"***************");
-           m_macaState = IDLE;
+           SetMacState (IDLE);
 		   m_timerWFCTS.Cancel();
 		   m_forUpCb (pkt, m_rxSrc);
         }
     }
-	else if(m_macaState == QUIET && m_rxDest != GetAddress ())
+	else if(GetMacState () == QUIET && m_rxDest != GetAddress ())
 	{
 	   m_timerQuiet.Cancel();
 	   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << "end quiet");
-       m_macaState = IDLE;
+       SetMacState (IDLE);
        BackoffNextSend ();
 	}
     break;
@@ -317,18 +357,18 @@ void
 UanMacMacaNW::RxRTS (Ptr<Packet> pkt)
 {
 
-  if(m_macaState == QUIET && (m_rxDest != GetAddress())){
+  if(GetMacState () == QUIET && (m_rxDest != GetAddress())){
       NS_ASSERT(m_timerQuiet.IsRunning());
 	  double newtime = std::max(m_timerQuiet.GetDelayLeft().GetSeconds(),(2 * m_maxPropTime + m_tCTS));
 	  m_timerQuiet.Cancel();
 	  m_timerQuiet.Schedule(Seconds(newtime));
 	  //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<< " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" hear xRTS reset quiet "<<newtime);
 	}
-  else if (m_macaState == IDLE || m_macaState == CONTEND){
+  else if (GetMacState () == IDLE || GetMacState () == CONTEND){
     if (m_rxDest == GetAddress()){
       if (SendCTS (m_rxSrc, 0)){
 		m_timerSendBackoff.Cancel();
-		m_macaState=WFDATA;
+		SetMacState (WFDATA);
 		m_timerWFCTS.Schedule(Seconds(m_maxPropTime*2+m_tDATA));
 	  }
     }
@@ -336,8 +376,9 @@ UanMacMacaNW::RxRTS (Ptr<Packet> pkt)
 	  //uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
 	  //TO DO: Change timer period accroding to datarate and pktsize
 	  m_timerSendBackoff.Cancel();
-	  m_macaState = QUIET;
+	  SetMacState (QUIET);
 	  m_timerQuiet.Schedule(Seconds(2 * m_maxPropTime + m_tCTS));
+	  m_backoff->NotifyBusy ();
 	  //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " RX xRTS to QUIET");
 	}	
   }
@@ -347,40 +388,41 @@ void
 UanMacMacaNW::RxCTS (Ptr<Packet> pkt)
 {
   
-  if (m_macaState == WFCTS && m_rxDest == GetAddress()){
+  if (GetMacState () == WFCTS && m_rxDest == GetAddress()){
     m_timerWFCTS.Cancel();
 	
-	if ( m_sendQueue.size() > 0){
+	if (m_queue->Front ()){
 	    NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send DATA");
-        Ptr<Packet> sendPkt = m_sendQueue.front();
+        Ptr<Packet> sendPkt = m_queue->Front ();
         Ptr<Packet> sendPktCb = sendPkt -> Copy();
 	    Ptr<Packet> sendPktCb2 = sendPktCb -> Copy();
-        m_countBEB=m_minBEB;
+        m_backoff->NotifySuccess ();
 	    if (Send (sendPkt)){
 	        
               m_sendingData = true;
             //m_sendDataCallback (sendPktCb);
-			m_sendQueue.pop();
+			m_queue->Pop ();
            }
 
 	   }
- 	   m_macaState = IDLE;
+ 	   SetMacState (IDLE);
 	   BackoffNextSend(true);
  }
   else if (m_rxDest != GetAddress()){
-    if(m_macaState == QUIET){
+    if(GetMacState () == QUIET){
 	  NS_ASSERT(m_timerQuiet.IsRunning());
 	  double newtime = std::max(m_timerQuiet.GetDelayLeft().GetSeconds(),(2 * m_maxPropTime + m_tDATA));
 	  m_timerQuiet.Cancel();
 	  m_timerQuiet.Schedule(Seconds(newtime));
 	  	 //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<< " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" hear xCTS reset quiet "<<newtime);
 	}
-	else if (m_macaState == IDLE || m_macaState == CONTEND || m_macaState == WFCTS){
+	else if (GetMacState () == IDLE || GetMacState () == CONTEND || GetMacState () == WFCTS){
 	
 	  m_timerSendBackoff.Cancel();
 	  m_timerWFCTS.Cancel();
-	  m_macaState = QUIET;
+	  SetMacState (QUIET);
 	  m_timerQuiet.Schedule(Seconds(2 * m_maxPropTime + m_tDATA));
+	  m_backoff->NotifyBusy ();
 	  //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " RX xCTS to QUIET");
 	}
 	
@@ -455,7 +497,26 @@ UanMacMacaNW::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_rand->SetStream (stream);
-  return 1;
+  m_backoff->AssignStreams (stream + 1);
+  return 2;
+}
+
+Ptr<UanMacFsm>
+UanMacMacaNW::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+void
+UanMacMacaNW::SetMacState (MACASTATE state)
+{
+  m_fsm->SetState (state);
+}
+
+UanMacMacaNW::MACASTATE
+UanMacMacaNW::GetMacState (void) const
+{
+  return static_cast<MACASTATE> (m_fsm->GetState ());
 }
 
 void
@@ -474,17 +535,16 @@ UanMacMacaNW::RxPacketError (Ptr<Packet> pkt, double sinr)
 Address
 UanMacMacaNW::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 
 void
 UanMacMacaNW::OntimerSendBackoff(){
-  if (!m_sendQueue.empty()){
-    m_macaState = CONTEND;
+  if (!m_queue->IsEmpty()){
+    SetMacState (CONTEND);
     if (SendRTS()){
-	  m_macaState = WFCTS;
+	  SetMacState (WFCTS);
 	  m_timerWFCTS.Schedule(Seconds(2 * m_maxPropTime + m_tCTS));
     }
 	else{
@@ -496,15 +556,21 @@ UanMacMacaNW::OntimerSendBackoff(){
 
 void
 UanMacMacaNW::OntimerWFCTS(){
-  m_countBEB = std::min(uint8_t(2*m_countBEB),m_maxBEB);
-  m_macaState = IDLE;
+  if (GetMacState () == WFCTS && m_queue->Front ()){
+    // No CTS: serve the other next hops while this one is quiet
+    UanHeaderCommon header;
+    m_queue->Front ()->PeekHeader (header);
+    m_queue->Block (header.GetDest ());
+  }
+  m_backoff->NotifyCollision ();
+  SetMacState (IDLE);
   BackoffNextSend ();
 }
 
 void
 UanMacMacaNW::OntimerQuiet(){
   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << "end quiet");
-  m_macaState = IDLE;
+  SetMacState (IDLE);
   BackoffNextSend ();
 }
 
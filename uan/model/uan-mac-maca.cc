@@ -30,6 +30,8 @@
 #include "ns3/attribute.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
 #include "ns3/nstime.h"
 
 #include <iostream>
@@ -49,25 +51,29 @@ UanMacMaca::UanMacMaca ()
   m_maxPropTime (0.3),
   m_maxPacketSize (64)
   {
-  m_timerSendBackoff.SetFunction (&UanMacMaca::OntimerSendBackoff,this);
-  m_timerQuiet.SetFunction (&UanMacMaca::OntimerQuiet,this);
-  m_timerWFCTS.SetFunction (&UanMacMaca::OntimerWFCTS,this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (WFCTS, "WFCTS");
+  m_fsm->AddState (WFDATA, "WFDATA");
+  m_fsm->AddState (QUIET, "QUIET");
+  m_timerSendBackoff.Attach (m_fsm, "SendBackoff", MakeCallback (&UanMacMaca::OntimerSendBackoff, this));
+  m_timerQuiet.Attach (m_fsm, "Quiet", MakeCallback (&UanMacMaca::OntimerQuiet, this));
+  m_timerWFCTS.Attach (m_fsm, "WFCTS", MakeCallback (&UanMacMaca::OntimerWFCTS, this));
   
   m_rtsSize = 0;
   
   m_maxBulkSend = 0;
   m_bulkSend = 0;
   m_state = UanMacWakeup::IDLE;
-  m_macaState = IDLE;
   m_rand= CreateObject<UniformRandomVariable>();
   
   m_phy = 0;
   m_tCTS = 0.05;
   m_tDATA = 0.22;
-    
-  m_minBEB=1;
-  m_maxBEB=10;
-  m_countBEB=1;
+
+  m_backoff = CreateObject<UanBackoffBeb> ();
+  m_queue = CreateObject<UanRelayQueue> ();
   }
   
 UanMacMaca::~UanMacMaca ()
@@ -98,6 +104,7 @@ void
 UanMacMaca::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -108,6 +115,16 @@ UanMacMaca::GetTypeId (void)
     .SetParent<Object> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacMaca> ()
+    .AddAttribute ("Backoff",
+                   "Backoff policy, in units of (max propagation delay + CTS time).",
+                   StringValue ("ns3::UanBackoffBeb"),
+                   MakePointerAccessor (&UanMacMaca::m_backoff),
+                   MakePointerChecker<UanBackoff> ())
+    .AddAttribute ("Queue",
+                   "Per next hop forwarding queue.",
+                   StringValue ("ns3::UanRelayQueue"),
+                   MakePointerAccessor (&UanMacMaca::m_queue),
+                   MakePointerChecker<UanRelayQueue> ())
   ;
   return tid;
 }
@@ -135,6 +152,18 @@ UanMacMaca::GetBackoffTime ()
   return m_maxBackoff;
 }
 
+Ptr<UanBackoff>
+UanMacMaca::GetBackoff (void) const
+{
+  return m_backoff;
+}
+
+Ptr<UanRelayQueue>
+UanMacMaca::GetQueue (void) const
+{
+  return m_queue;
+}
+
 void
 UanMacMaca::SetRtsSize (uint32_t size)
 {
@@ -156,6 +185,17 @@ UanMacMaca::SetForwardUpCb (Callback<void, Ptr<Packet>, const UanAddress& > cb)
 
 bool
 UanMacMaca::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber){
+  return DoEnqueue (packet, dest, false);
+}
+
+bool
+UanMacMaca::Relay (Ptr<Packet> packet, const Address &nextHop)
+{
+  return DoEnqueue (packet, nextHop, true);
+}
+
+bool
+UanMacMaca::DoEnqueue (Ptr<Packet> packet, const Address &dest, bool relay){
    //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Queueing packet for " << UanAddress::ConvertFrom (dest));
 
   UanAddress src = UanAddress::ConvertFrom (GetAddress ());
@@ -167,18 +207,18 @@ UanMacMaca::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protocolN
   header.SetType (DATA);
 
   packet->AddHeader (header);
-   DynamicCast<UanMacWakeupMaca> (m_mac) -> SetSleepMode(false);
-  if(m_sendQueue.size() < 10){
-    m_sendQueue.push(packet);
-    //NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" packet queueing increase to "<<m_sendQueue.size());
+  if (!m_queue->Enqueue (packet, udest, relay)){
+    NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" queue full, dropping packet for "<<udest);
+    return false;
   }
+   DynamicCast<UanMacWakeupMaca> (m_mac) -> SetSleepMode(false);
   
-  if (m_macaState == IDLE){
-    m_macaState = CONTEND;
+  if (GetMacState () == IDLE){
+    SetMacState (CONTEND);
 	
 	if (!m_timerSendBackoff.IsRunning())
 	  BackoffNextSend ();
-	else if (m_sendQueue.size() == 1){
+	else if (m_queue->GetSize() == 1){
 	  m_timerSendBackoff.Cancel();
 	  BackoffNextSend();
 	}
@@ -191,7 +231,7 @@ UanMacMaca::BackoffNextSend ()
 {
   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" sendBackoff ");
   NS_ASSERT(!m_timerSendBackoff.IsRunning());
-  double backoffTime = (double)(m_rand->GetValue(0,m_countBEB))*(m_maxPropTime+m_tCTS);
+  double backoffTime = m_backoff->GetBackoff (0, 1)*(m_maxPropTime+m_tCTS);
   m_timerSendBackoff.Schedule(Seconds(backoffTime));
 }
 
@@ -200,15 +240,15 @@ UanMacMaca::BackoffNextSend (bool b)
 {
   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" sendBackoff after Data");
   NS_ASSERT(!m_timerSendBackoff.IsRunning());
-  double backoffTime = (double)(m_rand->GetValue(0,m_countBEB))*(m_maxPropTime+m_tCTS);
+  double backoffTime = m_backoff->GetBackoff (0, 1)*(m_maxPropTime+m_tCTS);
   m_timerSendBackoff.Schedule(Seconds(backoffTime*1));
 }
 
 bool
 UanMacMaca::SendRTS ()
 {
-    NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send RTS. Queue "<<m_sendQueue.size ());
-  if((m_sendQueue.size() + m_relayQueue.size())< 1)
+    NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send RTS. Queue "<<m_queue->GetSize ());
+  if(m_queue->IsEmpty())
     return false;
   //NS_ASSERT(m_sendQueue.size () >= 1);
 
@@ -216,9 +256,7 @@ UanMacMaca::SendRTS ()
 
 //Get a RTS header
   UanHeaderCommon dataHeader;
-  Ptr<Packet> pkt=0;
-  if(!m_relayQueue.empty())  pkt=m_relayQueue.front();
-  else  pkt = m_sendQueue.front ();
+  Ptr<Packet> pkt = m_queue->Select ();
   pkt->PeekHeader (dataHeader);
 
   UanAddress udest = dataHeader.GetDest();
@@ -266,7 +304,7 @@ UanMacMaca::Send (Ptr<Packet> pkt)
     DynamicCast<UanMacWakeupMaca> (m_mac) -> Enqueue (pkt, dest, 0);
     //m_phy->SendPacket (pkt, 0);
 	
-	if(!m_sendQueue.size()){
+	if(m_queue->IsEmpty()){
 	  DynamicCast<UanMacWakeupMaca> (m_mac) -> SetSleepMode(true);
 	}
     return true;
@@ -287,6 +325,8 @@ UanMacMaca::RxPacket (Ptr<Packet> pkt,const UanAddress& dst)
   m_rxDest = header.GetDest();
   m_rxType = header.GetType();
   m_rxSize = header.GetSerializedSize();
+  // Whoever we hear is awake again
+  m_queue->Unblock (m_rxSrc);
   
   if (UanAddress::ConvertFrom (GetAddress ()) == m_rxDest){
     //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" Receiving "<< int(m_rxType) <<" packet from " << m_rxSrc);
@@ -311,21 +351,21 @@ UanMacMaca::RxPacket (Ptr<Packet> pkt,const UanAddress& dst)
     RxCTS (pkt,m_rxDest);
     break;
   case DATA:
-    if (m_macaState == WFDATA){
+    if (GetMacState () == WFDATA){
 	
 	  if (m_rxDest == GetAddress () || m_rxDest == UanAddress::GetBroadcast ())
         {
 		   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () <<" MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" RX DATA from "<<  m_rxSrc <<"***************");
-           m_macaState = IDLE;
+           SetMacState (IDLE);
 		   m_timerWFCTS.Cancel();
 		   m_forUpCb (pkt, m_rxSrc);
         }
     }
-	else if(m_macaState == QUIET && m_rxDest != GetAddress ())
+	else if(GetMacState () == QUIET && m_rxDest != GetAddress ())
 	{
 	   m_timerQuiet.Cancel();
 	   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << "end quiet");
-       m_macaState = IDLE;
+       SetMacState (IDLE);
        BackoffNextSend ();
 	}
     break;
@@ -339,18 +379,18 @@ UanMacMaca::RxRTS (Ptr<Packet> pkt,const UanAddress& dst)
     DynamicCast<UanMacWakeupMaca> (m_mac) -> SetSleepMode(false);
   }
   
-  if(m_macaState == QUIET && (dst != GetAddress())){
+  if(GetMacState () == QUIET && (dst != GetAddress())){
       NS_ASSERT(m_timerQuiet.IsRunning());
 	  double newtime = std::max(m_timerQuiet.GetDelayLeft().GetSeconds(),(2 * m_maxPropTime + m_tCTS));
 	  m_timerQuiet.Cancel();
 	  m_timerQuiet.Schedule(Seconds(newtime));
 	  //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<< " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" hear xRTS reset quiet "<<newtime);
 	}
-  else if (m_macaState == IDLE || m_macaState == CONTEND){
+  else if (GetMacState () == IDLE || GetMacState () == CONTEND){
     if (dst == GetAddress()){
       if (SendCTS (m_rxSrc, 0)){
 		m_timerSendBackoff.Cancel();
-		m_macaState=WFDATA;
+		SetMacState (WFDATA);
 		m_timerWFCTS.Schedule(Seconds(m_maxPropTime*2+m_tDATA));
 	  }
     }
@@ -358,8 +398,9 @@ UanMacMaca::RxRTS (Ptr<Packet> pkt,const UanAddress& dst)
 	  //uint32_t dataRate = m_phy->GetMode(0).GetDataRateBps();
 	  //TO DO: Change timer period accroding to datarate and pktsize
 	  m_timerSendBackoff.Cancel();
-	  m_macaState = QUIET;
+	  SetMacState (QUIET);
 	  m_timerQuiet.Schedule(Seconds(2 * m_maxPropTime + m_tCTS));
+	  m_backoff->NotifyBusy ();
 	  //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " RX xRTS to QUIET");
 	}	
   }
@@ -368,40 +409,41 @@ UanMacMaca::RxRTS (Ptr<Packet> pkt,const UanAddress& dst)
 void
 UanMacMaca::RxCTS (Ptr<Packet> pkt ,const UanAddress& dst)
 {
-  if (m_macaState == WFCTS && dst == GetAddress()){
+  if (GetMacState () == WFCTS && dst == GetAddress()){
     m_timerWFCTS.Cancel();
 	
-	if ( m_sendQueue.size() > 0){
+	if (m_queue->Front ()){
 	    NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " Send DATA");
-        Ptr<Packet> sendPkt = m_sendQueue.front();
+        Ptr<Packet> sendPkt = m_queue->Front ();
         Ptr<Packet> sendPktCb = sendPkt -> Copy();
 	    Ptr<Packet> sendPktCb2 = sendPktCb -> Copy();
-        m_countBEB=m_minBEB;
+        m_backoff->NotifySuccess ();
 	    if (Send (sendPkt)){
 	        
               m_sendingData = true;
             //m_sendDataCallback (sendPktCb);
-			m_sendQueue.pop();
+			m_queue->Pop ();
            }
 
 	   }
- 	   m_macaState = IDLE;
+ 	   SetMacState (IDLE);
 	   BackoffNextSend(true);
  }
   else if (dst != GetAddress()){
-    if(m_macaState == QUIET){
+    if(GetMacState () == QUIET){
 	  NS_ASSERT(m_timerQuiet.IsRunning());
 	  double newtime = std::max(m_timerQuiet.GetDelayLeft().GetSeconds(),(2 * m_maxPropTime + m_tDATA));
 	  m_timerQuiet.Cancel();
 	  m_timerQuiet.Schedule(Seconds(newtime));
 	  	 //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<< " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" hear xCTS reset quiet "<<newtime);
 	}
-	else if (m_macaState == IDLE || m_macaState == CONTEND || m_macaState == WFCTS){
+	else if (GetMacState () == IDLE || GetMacState () == CONTEND || GetMacState () == WFCTS){
 	
 	  m_timerSendBackoff.Cancel();
 	  m_timerWFCTS.Cancel();
-	  m_macaState = QUIET;
+	  SetMacState (QUIET);
 	  m_timerQuiet.Schedule(Seconds(2 * m_maxPropTime + m_tDATA));
+	  m_backoff->NotifyBusy ();
 	  //NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " RX xCTS to QUIET");
 	}
 	
@@ -469,6 +511,7 @@ UanMacMaca::AttachPhy (Ptr<UanPhy> phy)
 void
 UanMacMaca::AttachMacWakeup(Ptr<UanMacWakeupMaca> mac){
   m_mac = mac;
+  m_fsm->SetTimerQueue (mac->GetFsm ()->GetTimerQueue ());
   DynamicCast<UanMacWakeupMaca> (m_mac) ->SetForwardUpCb(MakeCallback (&UanMacMaca::RxPacket, this));
   //DynamicCast<UanMacWakeupMaca> (m_mac) ->SetRxRTSCb(MakeCallback (&UanMacMaca:: RxRTS, this));
   //DynamicCast<UanMacWakeupMaca> (m_mac) ->SetRxCTSCb(MakeCallback (&UanMacMaca:: RxCTS, this));
@@ -485,7 +528,26 @@ UanMacMaca::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
   m_rand->SetStream (stream);
-  return 1;
+  m_backoff->AssignStreams (stream + 1);
+  return 2;
+}
+
+Ptr<UanMacFsm>
+UanMacMaca::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+void
+UanMacMaca::SetMacState (MACASTATE state)
+{
+  m_fsm->SetState (state);
+}
+
+UanMacMaca::MACASTATE
+UanMacMaca::GetMacState (void) const
+{
+  return static_cast<MACASTATE> (m_fsm->GetState ());
 }
 
 void
@@ -504,17 +566,16 @@ UanMacMaca::RxPacketError (Ptr<Packet> pkt, double sinr)
 Address
 UanMacMaca::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 
 void
 UanMacMaca::OntimerSendBackoff(){
-  if (!m_sendQueue.empty()){
-    m_macaState = CONTEND;
+  if (!m_queue->IsEmpty()){
+    SetMacState (CONTEND);
     if (SendRTS()){
-	  m_macaState = WFCTS;
+	  SetMacState (WFCTS);
 	  m_timerWFCTS.Schedule(Seconds(2 * m_maxPropTime + m_tCTS));
     }
 	else{
@@ -526,15 +587,21 @@ UanMacMaca::OntimerSendBackoff(){
 
 void
 UanMacMaca::OntimerWFCTS(){
-  m_countBEB = std::min(uint8_t(2*m_countBEB),m_maxBEB);
-  m_macaState = IDLE;
+  if (GetMacState () == WFCTS && m_queue->Front ()){
+    // No CTS: serve the other next hops while this one is quiet
+    UanHeaderCommon header;
+    m_queue->Front ()->PeekHeader (header);
+    m_queue->Block (header.GetDest ());
+  }
+  m_backoff->NotifyCollision ();
+  SetMacState (IDLE);
   BackoffNextSend ();
 }
 
 void
 UanMacMaca::OntimerQuiet(){
   NS_LOG_DEBUG (" " << Simulator::Now ().GetSeconds ()<<" MAC " << UanAddress::ConvertFrom (GetAddress ()) << "end quiet");
-  m_macaState = IDLE;
+  SetMacState (IDLE);
   BackoffNextSend ();
 }
 
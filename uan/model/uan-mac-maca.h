@@ -26,8 +26,11 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/event-id.h"
 #include "ns3/timer.h"
+#include "uan-mac-fsm.h"
 #include "ns3/uan-phy.h"
 #include "uan-mac-wakeup.h"
+#include "uan-backoff.h"
+#include "uan-relay-queue.h"
 #include "ns3/uan-module.h"
 #include <queue>
 
@@ -53,6 +56,13 @@ public:
   Address GetAddress (void);
   virtual void SetAddress (UanAddress addr);
   virtual bool Enqueue (Ptr<Packet> pkt, const Address &dest, uint16_t protocolNumber);
+  /**
+   * Queue a packet being forwarded for another node.
+   * \param pkt Packet to forward
+   * \param nextHop Neighbor to hand it to
+   * \return False if the relay queue is full.
+   */
+  virtual bool Relay (Ptr<Packet> pkt, const Address &nextHop);
   virtual void SetForwardUpCb (Callback<void, Ptr<Packet>, const UanAddress& > cb);
   virtual void AttachPhy (Ptr<UanPhy> phy);
   void AttachMacWakeup (Ptr<UanMacWakeupMaca> mac);
@@ -70,15 +80,19 @@ public:
 
   void SetBackoffTime (double backoff);
   double GetBackoffTime ();
+  Ptr<UanBackoff> GetBackoff (void) const;
+  Ptr<UanRelayQueue> GetQueue (void) const;
   void SetRtsSize (uint32_t size);
   uint32_t GetRtsSize () const;
 
   int64_t AssignStreams(int64_t stream);
+  /** \return State machine engine holding the MAC state and timers. */
+  Ptr<UanMacFsm> GetFsm (void) const;
 private:
   Ptr<UniformRandomVariable> m_rand;
+  Ptr<UanBackoff> m_backoff;
 
-  std::queue<Ptr<Packet> > m_relayQueue;
-  std::queue<Ptr<Packet> > m_sendQueue;
+  Ptr<UanRelayQueue> m_queue;
   
 
   Callback<void, Ptr<Packet> > m_sendDataCallback;
@@ -93,12 +107,12 @@ private:
   Ptr<Packet> m_pkt;
   UanAddress m_dest;
 
-  Timer m_timerSendBackoff;
-  Timer m_timerQuiet;
-  Timer m_timerWFCTS;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerSendBackoff;
+  UanMacFsmTimer m_timerQuiet;
+  UanMacFsmTimer m_timerWFCTS;
   
   UanMacWakeup::PhyState m_state;
-  MACASTATE m_macaState;
   MACASTATE m_lastState;
 
   double m_maxBackoff;
@@ -119,15 +133,16 @@ private:
   uint8_t m_bulkSend;
 
   
-  uint8_t m_countBEB;
-  uint8_t m_minBEB;
-  uint8_t m_maxBEB;
   
+  void SetMacState (MACASTATE state);
+  /** \return Current state, kept by the state machine engine. */
+  MACASTATE GetMacState (void) const;
   void OntimerSendBackoff (void);
   void OntimerQuiet (void);
   void OntimerWFCTS (void);
   
 
+  bool DoEnqueue (Ptr<Packet> pkt, const Address &dest, bool relay);
   bool SendRTS ();
   bool SendCTS (const Address &dest, const double duration);
   bool Send (Ptr<Packet> pkt);
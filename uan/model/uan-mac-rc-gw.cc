@@ -427,6 +427,7 @@ UanMacRcGw::StartCycle (void)
       nextEarliest = arrivalTime + Seconds (req.length * 8.0 / dataRate) + Seconds (m_sifs.GetSeconds () * req.numFrames);
 
       UanHeaderRcCts ctsh;
+      ctsh.SetTimeStampReference (Simulator::Now ());
       ctsh.SetAddress (dest);
       ctsh.SetRtsTimeStamp (req.rxTime);
       ctsh.SetFrameNo (req.frameNo);
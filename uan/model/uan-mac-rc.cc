@@ -394,6 +394,7 @@ UanMacRc::ReceiveOkFromPhy (Ptr<Packet> pkt, double sinr, UanTxMode mode)
 
         UanHeaderRcCts ctsh;
         ctsh.SetAddress (UanAddress::GetBroadcast ());
+        ctsh.SetTimeStampReference (ctsg.GetTxTimeStamp ());
         while (pkt->GetSize () > 0)
           {
             pkt->RemoveHeader (ctsh);
@@ -0,0 +1,140 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-mac-slotted-fama.h"
+#include "uan-header-common.h"
+#include "uan-header-wakeup.h"
+#include "uan-phy-header.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("UanMacSlottedFama");
+
+namespace ns3
+{
+
+NS_OBJECT_ENSURE_REGISTERED (UanMacSlottedFama);
+
+UanMacSlottedFama::UanMacSlottedFama ()
+  : UanMacFama ()
+{
+  m_timerSlot.Attach (m_fsm, "Slot", MakeCallback (&UanMacSlottedFama::On_timerSlot, this));
+}
+
+UanMacSlottedFama::~UanMacSlottedFama ()
+{
+  m_timerSlot.Cancel ();
+}
+
+TypeId
+UanMacSlottedFama::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanMacSlottedFama")
+    .SetParent<UanMacFama> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanMacSlottedFama> ()
+  ;
+  return tid;
+}
+
+Time
+UanMacSlottedFama::GetSlotTime (void) const
+{
+  // The RTS built by UanMacFama::SendRTS, plus the PHY framing the
+  // wakeup MAC adds to it
+  UanHeaderCommon header;
+  UanHeaderTimestamp timestamp;
+  UanPhyHeader phyHeader;
+  UanPhyTrailer phyTrailer;
+  uint32_t rtsBytes = GetRtsPayloadSize () + timestamp.GetSerializedSize () + header.GetSerializedSize ()
+    + phyHeader.GetSerializedSize () + phyTrailer.GetSerializedSize ();
+
+  return Seconds (m_maxPropTime + rtsBytes * 8.0 / m_phy->GetMode (0).GetDataRateBps ());
+}
+
+Time
+UanMacSlottedFama::GetNextSlot (void) const
+{
+  return GetNextSlot (Simulator::Now ());
+}
+
+Time
+UanMacSlottedFama::GetNextSlot (Time t) const
+{
+  int64_t slot = GetSlotTime ().GetTimeStep ();
+  int64_t step = t.GetTimeStep ();
+  return TimeStep (((step + slot - 1) / slot) * slot);
+}
+
+void
+UanMacSlottedFama::StopTimer (void)
+{
+  m_timerSlot.Cancel ();
+  UanMacFama::StopTimer ();
+}
+
+bool
+UanMacSlottedFama::SendRTS (void)
+{
+  Time delay = GetNextSlot () - Simulator::Now ();
+  if (delay.IsStrictlyPositive ())
+    {
+      NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " RTS held until slot at " << (Simulator::Now () + delay).GetSeconds ());
+      m_fsm->Input (START_CONTEND);
+      m_timerSlot.Cancel ();
+      m_timerSlot.Schedule (delay);
+      return false;
+    }
+
+  // Carrier sensed at the slot boundary: the RTS would collide, try the next slot
+  if (m_state == UanMacWakeup::BUSY)
+    {
+      NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) << " channel busy at slot start");
+      m_backoff->NotifyBusy ();
+      m_fsm->Input (START_CONTEND);
+      m_timerSlot.Cancel ();
+      m_timerSlot.Schedule (GetSlotTime ());
+      return false;
+    }
+
+  return UanMacFama::SendRTS ();
+}
+
+Time
+UanMacSlottedFama::AlignTx (Ptr<const Packet> pkt, Time txStart)
+{
+  UanHeaderCommon header;
+  pkt->PeekHeader (header);
+  if (header.GetType () != RTS)
+    {
+      return txStart;
+    }
+  return GetNextSlot (txStart);
+}
+
+void
+UanMacSlottedFama::On_timerSlot (void)
+{
+  if (!SendRTS () && !m_timerSlot.IsRunning ())
+    {
+      // Nothing to send, or the wakeup MAC refused it
+      m_fsm->Input (STOP_CONTEND);
+    }
+}
+
+}
@@ -0,0 +1,83 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_MAC_SLOTTED_FAMA_H_
+#define UAN_MAC_SLOTTED_FAMA_H_
+
+#include "uan-mac-fama.h"
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup uan
+ *
+ * Slotted FAMA.
+ *
+ * Same handshake, headers and wakeup hooks as UanMacFama, but RTS
+ * transmissions start only at slot boundaries.  A slot lasts the maximum
+ * propagation delay plus the RTS air time, so an RTS is heard by every
+ * neighbor before the next slot starts and the vulnerability window is
+ * bounded to one slot.  Nodes are assumed to share a time reference.
+ * The RTS is aligned where the PHY starts sending it, after any wakeup
+ * tone and warm-up, not where it is handed to the wakeup MAC.
+ */
+class UanMacSlottedFama : public UanMacFama
+{
+public:
+  UanMacSlottedFama ();
+  virtual ~UanMacSlottedFama ();
+  static TypeId GetTypeId (void);
+
+  /** \return Slot duration. */
+  Time GetSlotTime (void) const;
+  /** \return Start of the current slot if now is on a boundary, else of the next one. */
+  Time GetNextSlot (void) const;
+  /**
+   * \param t Time to align
+   * \return t if it is on a boundary, else the start of the next slot.
+   */
+  Time GetNextSlot (Time t) const;
+
+  // Inherited methods
+  virtual void StopTimer (void);
+
+protected:
+  /**
+   * Send the RTS if now is a slot boundary with the channel idle.
+   * Otherwise hold it in CONTEND until the next boundary.
+   * \return True only if an RTS went out.
+   */
+  virtual bool SendRTS (void);
+  /**
+   * Hold an RTS at the wakeup MAC until the slot boundary following
+   * its PHY start, which a wakeup tone or warm-up may push past the
+   * boundary it was handed over at.
+   */
+  virtual Time AlignTx (Ptr<const Packet> pkt, Time txStart);
+
+private:
+  void On_timerSlot (void);
+
+  UanMacFsmTimer m_timerSlot;  //!< Holds a pending RTS until the next slot boundary.
+};
+
+}
+
+#endif /* UAN_MAC_SLOTTED_FAMA_H_ */
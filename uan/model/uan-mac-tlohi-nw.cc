@@ -3,6 +3,7 @@
 #include "uan-header-wakeup.h"
 
 #include "uan-mac-tlohi-nw.h"
+#include "uan-mac-tlohi.h"
 #include "uan-tx-mode.h"
 #include "uan-address.h"
 #include "ns3/log.h"
@@ -17,6 +18,7 @@
 #include "ns3/nstime.h"
 
 #include <iostream>
+#include <algorithm>
 
 namespace ns3
 {
@@ -27,16 +29,23 @@ NS_OBJECT_ENSURE_REGISTERED (UanMacTlohiNW);
 UanMacTlohiNW::UanMacTlohiNW()
   :m_Ttlohi(0.024),
   m_Tmax(0.47),
-  m_state(IDLE),
   m_blocking(false),
   m_CTC(1),
   m_sizeCTD(3)
 {
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (BKOFF, "BKOFF");
+  m_fsm->AddState (ENDFRAME, "ENDFRAME");
+  m_timerCR.Attach (m_fsm, "CR", MakeCallback (&UanMacTlohiNW::on_timerCR, this));
+  m_timerBkoffCR.Attach (m_fsm, "BkoffCR", MakeCallback (&UanMacTlohiNW::on_timerBkoffCR, this));
+  m_timerMaxFrame.Attach (m_fsm, "MaxFrame", MakeCallback (&UanMacTlohiNW::on_timerMaxFrame, this));
   Clear();
   m_CRWindow = (m_Tmax + m_Ttlohi)* 1.0 ;
-  m_timerCR.SetFunction (&UanMacTlohiNW::on_timerCR,this);
-  m_timerBkoffCR.SetFunction (&UanMacTlohiNW::on_timerBkoffCR,this);
-  m_timerMaxFrame.SetFunction (&UanMacTlohiNW::on_timerMaxFrame,this);
+  m_ctcEstimate = 1;
+  m_ctcAlpha = 0.25;
+  m_rand = CreateObject<UniformRandomVariable> ();
 
 }
 
@@ -74,6 +83,7 @@ void
 UanMacTlohiNW::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -84,6 +94,12 @@ UanMacTlohiNW::GetTypeId (void)
     .SetParent<Object> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacTlohiNW> ()
+    .AddAttribute ("CtcAlpha",
+                   "Weight of the last contention round in the smoothed contender count. "
+                   "0 backs off over the count of the last round only.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&UanMacTlohiNW::m_ctcAlpha),
+                   MakeDoubleChecker<double> (0, 1))
   ;
   return tid;
 }
@@ -101,15 +117,15 @@ UanMacTlohiNW::Enqueue(Ptr<Packet> packet, const Address &dest, uint16_t protoco
     if (!m_timerMaxFrame.IsRunning()){
 	
       m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-      m_state = ENDFRAME;//Wait for frame end
+      SetMacState (ENDFRAME);//Wait for frame end
 	  NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from idle(enqueue) This should not happen too !!!!!!");
   }}
-  if(m_state == IDLE && (!m_blocking)){
+  if(GetMacState () == IDLE && (!m_blocking)){
     NS_ASSERT(!(m_timerCR.IsRunning() || m_timerBkoffCR.IsRunning() || m_timerMaxFrame.IsRunning()) );
 	TxCTD();
   }
   else if(!(m_timerCR.IsRunning() || m_timerBkoffCR.IsRunning()|| m_timerMaxFrame.IsRunning())){
-    NS_ASSERT(m_state != BKOFF);
+    NS_ASSERT(GetMacState () != BKOFF);
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" This should logically not appear!!!!!!!!!!!!!!!");
     TxCTD();
   }
@@ -132,11 +148,11 @@ UanMacTlohiNW::RxPacket(Ptr<Packet> pkt,  double sinr, UanTxMode mode){
 void
 UanMacTlohiNW::RxCTD(){
   if(!m_blocking){
-    switch(m_state){
+    switch(GetMacState ()){
       case IDLE:
 	    m_blocking = true;
 		m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-		m_state = ENDFRAME;//Wait for frame end
+		SetMacState (ENDFRAME);//Wait for frame end
 		NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from idle");
 	    break;
       case CONTEND:
@@ -150,7 +166,7 @@ UanMacTlohiNW::RxCTD(){
 		
         m_blocking = true;//Wait for frame end
 		m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-	    m_state = ENDFRAME;
+	    SetMacState (ENDFRAME);
 		NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from bkoff");
 	    break;
 	  case ENDFRAME:
@@ -169,7 +185,7 @@ UanMacTlohiNW::RxData(UanAddress dest){
     return;
   }
   if(m_blocking){
-    NS_ASSERT(m_state = ENDFRAME);
+    NS_ASSERT (GetMacState () == ENDFRAME);
     m_blocking = false;
     m_timerMaxFrame.Cancel();	
 	}
@@ -180,7 +196,7 @@ UanMacTlohiNW::RxData(UanAddress dest){
 	  NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" restart contend after data");
 	}
   else{
-	m_state = IDLE;
+	SetMacState (IDLE);
   }
 
 }
@@ -198,7 +214,7 @@ UanMacTlohiNW::TxCTD(){
     NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" CONTENDING");
     m_phy->SendPacket (packetCTD, 0);
     m_timerCR.Schedule(Seconds(m_CRWindow));
-    m_state = CONTEND;
+    SetMacState (CONTEND);
     m_CTC = 1;
   //}
 }
@@ -212,7 +228,7 @@ UanMacTlohiNW::TxData(){
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" SentData");
 	 //m_sendDataCallback(packetData);
     m_sendQueue.pop();
-	m_state = IDLE;
+	SetMacState (IDLE);
 	return true;
   }
   return false;
@@ -220,11 +236,10 @@ UanMacTlohiNW::TxData(){
 
 void
 UanMacTlohiNW::on_timerCR(){
+  uint32_t backoffCR = UanMacTlohi::DrawBackoffRounds (m_rand, m_CTC, m_ctcAlpha, m_ctcEstimate);
   if(m_CTC > 1){
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>() ;
-    uint32_t backoffCR = (uint32_t)rand-> GetValue(0,double(m_CTC));
     m_timerBkoffCR.Schedule (Seconds((double)backoffCR*(m_CRWindow)));
-    m_state = BKOFF ;
+    SetMacState (BKOFF);
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" Backoff for "<< backoffCR <<"  CRs ");
   }
   else if(m_CTC == 1){
@@ -245,7 +260,7 @@ UanMacTlohiNW::on_timerMaxFrame(){
 	TxCTD();
   }
   else
-	m_state = IDLE;
+	SetMacState (IDLE);
 }
 void
 UanMacTlohiNW::AttachPhy (Ptr<UanPhy> phy)
@@ -280,16 +295,33 @@ UanMacTlohiNW::SetSendDatacb (Callback<void, Ptr<Packet> > cb){
 Address
 UanMacTlohiNW::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 int64_t
 UanMacTlohiNW::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
-  //m_rand->SetStream (stream);
+  m_rand->SetStream (stream);
   return 1;
 }
 
+Ptr<UanMacFsm>
+UanMacTlohiNW::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+void
+UanMacTlohiNW::SetMacState (State state)
+{
+  m_fsm->SetState (state);
+}
+
+UanMacTlohiNW::State
+UanMacTlohiNW::GetMacState (void) const
+{
+  return static_cast<State> (m_fsm->GetState ());
+}
+
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "ns3/nstime.h"
 #include "ns3/uan-module.h"
 #include <iostream>
+#include <algorithm>
 
 namespace ns3
 {
@@ -27,17 +28,24 @@ NS_OBJECT_ENSURE_REGISTERED (UanMacTlohiU);
 UanMacTlohiU::UanMacTlohiU()
   :m_Ttlohi(0.024),
   m_Tmax(0.47),
-  m_state(IDLE),
   m_blocking(false),
   m_CTC(1),
   m_sizeCTD(3)
 {
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (BKOFF, "BKOFF");
+  m_fsm->AddState (ENDFRAME, "ENDFRAME");
+  m_timerCR.Attach (m_fsm, "CR", MakeCallback (&UanMacTlohiU::on_timerCR, this));
+  m_timerBkoffCR.Attach (m_fsm, "BkoffCR", MakeCallback (&UanMacTlohiU::on_timerBkoffCR, this));
+  m_timerMaxFrame.Attach (m_fsm, "MaxFrame", MakeCallback (&UanMacTlohiU::on_timerMaxFrame, this));
   m_cleared = false;
   Clear();
   m_CRWindow = (m_Tmax + m_Ttlohi)* 1.0 ;
-  m_timerCR.SetFunction (&UanMacTlohiU::on_timerCR,this);
-  m_timerBkoffCR.SetFunction (&UanMacTlohiU::on_timerBkoffCR,this);
-  m_timerMaxFrame.SetFunction (&UanMacTlohiU::on_timerMaxFrame,this);
+  m_ctcEstimate = 1;
+  m_ctcAlpha = 0.25;
+  m_rand = CreateObject<UniformRandomVariable> ();
 
 }
 
@@ -75,6 +83,7 @@ void
 UanMacTlohiU::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -85,6 +94,12 @@ UanMacTlohiU::GetTypeId (void)
     .SetParent<Object> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacTlohiU> ()
+    .AddAttribute ("CtcAlpha",
+                   "Weight of the last contention round in the smoothed contender count. "
+                   "0 backs off over the count of the last round only.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&UanMacTlohiU::m_ctcAlpha),
+                   MakeDoubleChecker<double> (0, 1))
   ;
   return tid;
 }
@@ -103,16 +118,16 @@ UanMacTlohiU::Enqueue(Ptr<Packet> packet, const Address &dest, uint16_t protocol
     if (!m_timerMaxFrame.IsRunning()){
 	
       m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-      m_state = ENDFRAME;//Wait for frame end
+      SetMacState (ENDFRAME);//Wait for frame end
 	  NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from idle(enqueue) This should not happen too !!!!!!");
 	  DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
   }}
-  if(m_state == IDLE && (!m_blocking)){
+  if(GetMacState () == IDLE && (!m_blocking)){
     NS_ASSERT(!(m_timerCR.IsRunning() || m_timerBkoffCR.IsRunning() || m_timerMaxFrame.IsRunning()) );
 	TxCTD();
   }
   else if(!(m_timerCR.IsRunning() || m_timerBkoffCR.IsRunning()|| m_timerMaxFrame.IsRunning())&& (!m_blocking)){
-    NS_ASSERT(m_state != BKOFF);
+    NS_ASSERT(GetMacState () != BKOFF);
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" This should logically not appear!!!!!!!!!!!!!!!");
     TxCTD();
   }
@@ -134,11 +149,11 @@ UanMacTlohiU::RxPacket(Ptr<Packet> pkt, const UanAddress& add){
 void
 UanMacTlohiU::RxCTD(){
   if(!m_blocking){
-    switch(m_state){
+    switch(GetMacState ()){
       case IDLE:
 	    m_blocking = true;
 		m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-		m_state = ENDFRAME;//Wait for frame end
+		SetMacState (ENDFRAME);//Wait for frame end
 		NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from idle");
 	    break;
       case CONTEND:
@@ -152,7 +167,7 @@ UanMacTlohiU::RxCTD(){
 		
         m_blocking = true;//Wait for frame end
 		m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-	    m_state = ENDFRAME;
+	    SetMacState (ENDFRAME);
 		NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from bkoff");
 	    break;
 	  case ENDFRAME:
@@ -176,7 +191,7 @@ UanMacTlohiU::RxData(Ptr<Packet> pkt, const UanAddress& add){
     return;
   }
   if(m_blocking){
-    NS_ASSERT(m_state = ENDFRAME);
+    NS_ASSERT (GetMacState () == ENDFRAME);
     m_blocking = false;
     m_timerMaxFrame.Cancel();	
 	}
@@ -187,7 +202,7 @@ UanMacTlohiU::RxData(Ptr<Packet> pkt, const UanAddress& add){
 	  NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" restart contend after data");
 	}
   else{
-	m_state = IDLE;
+	SetMacState (IDLE);
 	DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
   }
 
@@ -208,7 +223,7 @@ UanMacTlohiU::TxCTD(){
     DynamicCast<UanMacWakeupTlohi> (m_mac) -> SendCTDTone();
 	//m_phy->SendPacket (packetCTD, 0);
     m_timerCR.Schedule(Seconds(m_CRWindow));
-    m_state = CONTEND;
+    SetMacState (CONTEND);
     m_CTC = 1;
   //}
 }
@@ -227,7 +242,7 @@ UanMacTlohiU::TxData(){
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" SentData");
 	 //m_sendDataCallback(packetData);
     m_sendQueue.pop();
-	m_state = IDLE;
+	SetMacState (IDLE);
 	DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
 	return true;
   }
@@ -236,18 +251,17 @@ UanMacTlohiU::TxData(){
 
 void
 UanMacTlohiU::TxEnd(){
-  if(!(m_sendQueue.size()) && m_state == IDLE){
+  if(!(m_sendQueue.size()) && GetMacState () == IDLE){
 	DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
   }
 }
 
 void
 UanMacTlohiU::on_timerCR(){
+  uint32_t backoffCR = UanMacTlohi::DrawBackoffRounds (m_rand, m_CTC, m_ctcAlpha, m_ctcEstimate);
   if(m_CTC > 1){
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>() ;
-    uint32_t backoffCR = (uint32_t)rand-> GetValue(0,double(m_CTC));
     m_timerBkoffCR.Schedule (Seconds((double)backoffCR*(m_CRWindow)));
-    m_state = BKOFF ;
+    SetMacState (BKOFF);
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" Backoff for "<< backoffCR <<"  CRs ");
   }
   else if(m_CTC == 1){
@@ -269,7 +283,7 @@ UanMacTlohiU::on_timerMaxFrame(){
 	TxCTD();
   }
   else{
-	m_state = IDLE;
+	SetMacState (IDLE);
 	DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
   }
 }
@@ -284,6 +298,7 @@ void
 UanMacTlohiU::AttachMacWakeup (Ptr<UanMac> mac)
 {
   m_mac = mac;
+  m_fsm->SetTimerQueue (DynamicCast<UanMacWakeupTlohi> (m_mac)->GetFsm ()->GetTimerQueue ());
   DynamicCast<UanMacWakeupTlohi> (m_mac) -> SetForwardUpCb (MakeCallback(&UanMacTlohiU::RxData,this));
   
   DynamicCast<UanMacWakeupTlohi> (m_mac) -> SetToneMode();
@@ -316,16 +331,33 @@ UanMacTlohiU::SetSendDatacb (Callback<void, Ptr<Packet> > cb){
 Address
 UanMacTlohiU::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 int64_t
 UanMacTlohiU::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
-  //m_rand->SetStream (stream);
+  m_rand->SetStream (stream);
   return 1;
 }
 
+Ptr<UanMacFsm>
+UanMacTlohiU::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+void
+UanMacTlohiU::SetMacState (State state)
+{
+  m_fsm->SetState (state);
+}
+
+UanMacTlohiU::State
+UanMacTlohiU::GetMacState (void) const
+{
+  return static_cast<State> (m_fsm->GetState ());
+}
+
 }
\ No newline at end of file
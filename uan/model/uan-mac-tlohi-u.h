@@ -9,6 +9,7 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/event-id.h"
 #include "ns3/timer.h"
+#include "uan-mac-fsm.h"
 #include "ns3/uan-phy.h"
 #include "uan-mac-wakeup.h"
 
@@ -25,12 +26,14 @@ public:
   enum State{IDLE, CONTEND, BKOFF, ENDFRAME};
   double m_Ttlohi;
   double m_Tmax;
-  State m_state;
   bool m_blocking;
   uint32_t m_CTC;
   uint32_t m_sizeCTD;
   
   double m_CRWindow;
+  double m_ctcEstimate;   //Contender count smoothed across rounds
+  double m_ctcAlpha;      //Weight of the last round in m_ctcEstimate
+  Ptr<UniformRandomVariable> m_rand;
   Ptr<Packet> m_pkt;
   std::queue<Ptr<Packet> > m_sendQueue;
   Callback<void, Ptr<Packet>, const UanAddress& > m_forUpCb;
@@ -40,9 +43,10 @@ public:
   Ptr<UanMac> m_mac;
   bool m_cleared;
   
-  Timer m_timerBkoffCR;
-  Timer m_timerCR;
-  Timer m_timerMaxFrame;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerBkoffCR;
+  UanMacFsmTimer m_timerCR;
+  UanMacFsmTimer m_timerMaxFrame;
   
   UanMacTlohiU ();
   virtual ~UanMacTlohiU ();
@@ -58,6 +62,8 @@ public:
   virtual Address GetBroadcast (void) const;
   virtual void Clear (void);
   int64_t AssignStreams(int64_t stream);
+  /** \return State machine engine holding the MAC state and timers. */
+  Ptr<UanMacFsm> GetFsm (void) const;
   
   //void RxPacket (Ptr<Packet> pkt, double sinr, UanTxMode mode);
   void SetSendDatacb (Callback<void, Ptr<Packet> > cb);
@@ -71,6 +77,10 @@ private:
   void TxCTD();
   bool TxData();
   
+  void SetMacState (State state);
+  /** \return Current state, kept by the state machine engine. */
+  State GetMacState (void) const;
+  
   void on_timerCR();
   void on_timerBkoffCR();
   void on_timerMaxFrame();
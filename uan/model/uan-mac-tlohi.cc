@@ -18,6 +18,7 @@
 #include "ns3/uan-mac-wakeup-tlohi.h"
 #include "ns3/uan-module.h"
 #include <iostream>
+#include <algorithm>
 
 namespace ns3
 {
@@ -28,17 +29,24 @@ NS_OBJECT_ENSURE_REGISTERED (UanMacTlohi);
 UanMacTlohi::UanMacTlohi()
   :m_Ttlohi(0.024),
   m_Tmax(0.47),
-  m_state(IDLE),
   m_blocking(false),
   m_CTC(1),
   m_sizeCTD(3)
 {
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_fsm->AddState (IDLE, "IDLE");
+  m_fsm->AddState (CONTEND, "CONTEND");
+  m_fsm->AddState (BKOFF, "BKOFF");
+  m_fsm->AddState (ENDFRAME, "ENDFRAME");
+  m_timerCR.Attach (m_fsm, "CR", MakeCallback (&UanMacTlohi::on_timerCR, this));
+  m_timerBkoffCR.Attach (m_fsm, "BkoffCR", MakeCallback (&UanMacTlohi::on_timerBkoffCR, this));
+  m_timerMaxFrame.Attach (m_fsm, "MaxFrame", MakeCallback (&UanMacTlohi::on_timerMaxFrame, this));
   m_cleared = false;
   Clear();
   m_CRWindow = (m_Tmax + m_Ttlohi)* 1.0 ;
-  m_timerCR.SetFunction (&UanMacTlohi::on_timerCR,this);
-  m_timerBkoffCR.SetFunction (&UanMacTlohi::on_timerBkoffCR,this);
-  m_timerMaxFrame.SetFunction (&UanMacTlohi::on_timerMaxFrame,this);
+  m_ctcEstimate = 1;
+  m_ctcAlpha = 0.25;
+  m_rand = CreateObject<UniformRandomVariable> ();
   
   m_ultra = true;
 }
@@ -77,6 +85,7 @@ void
 UanMacTlohi::DoDispose ()
 {
   Clear ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -87,6 +96,12 @@ UanMacTlohi::GetTypeId (void)
     .SetParent<Object> ()
 	.SetGroupName ("Uan")
     .AddConstructor<UanMacTlohi> ()
+    .AddAttribute ("CtcAlpha",
+                   "Weight of the last contention round in the smoothed contender count. "
+                   "0 backs off over the count of the last round only.",
+                   DoubleValue (0.25),
+                   MakeDoubleAccessor (&UanMacTlohi::m_ctcAlpha),
+                   MakeDoubleChecker<double> (0, 1))
   ;
   return tid;
 }
@@ -105,18 +120,18 @@ UanMacTlohi::Enqueue(Ptr<Packet> packet, const Address &dest, uint16_t protocolN
     if (!m_timerMaxFrame.IsRunning()){
 	
       m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-      m_state = ENDFRAME;//Wait for frame end
+      SetMacState (ENDFRAME);//Wait for frame end
 	  NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from idle(enqueue) This should not happen too !!!!!!");
       if (m_ultra){
 	    DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
 	  }
   }}
-  if(m_state == IDLE && (!m_blocking)){
+  if(GetMacState () == IDLE && (!m_blocking)){
     NS_ASSERT(!(m_timerCR.IsRunning() || m_timerBkoffCR.IsRunning() || m_timerMaxFrame.IsRunning()) );
 	TxCTD();
   }
   else if(!(m_timerCR.IsRunning() || m_timerBkoffCR.IsRunning()|| m_timerMaxFrame.IsRunning())&& (!m_blocking)){
-    NS_ASSERT(m_state != BKOFF);
+    NS_ASSERT(GetMacState () != BKOFF);
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" This should logically not appear!!!!!!!!!!!!!!!");
     TxCTD();
   }
@@ -138,11 +153,11 @@ UanMacTlohi::RxPacket(Ptr<Packet> pkt, const UanAddress& add){
 void
 UanMacTlohi::RxCTD(){
   if(!m_blocking){
-    switch(m_state){
+    switch(GetMacState ()){
       case IDLE:
 	    m_blocking = true;
 		m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-		m_state = ENDFRAME;//Wait for frame end
+		SetMacState (ENDFRAME);//Wait for frame end
 		if (m_ultra){
 	      DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
 	    }
@@ -161,7 +176,7 @@ UanMacTlohi::RxCTD(){
 	    }
         m_blocking = true;//Wait for frame end
 		m_timerMaxFrame.Schedule(Seconds(m_CRWindow*30));
-	    m_state = ENDFRAME;
+	    SetMacState (ENDFRAME);
 		NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" quit frame from bkoff");
 	    break;
 	  case ENDFRAME:
@@ -185,7 +200,7 @@ UanMacTlohi::RxData(Ptr<Packet> pkt, const UanAddress& add){
     return;
   }
   if(m_blocking){
-    NS_ASSERT(m_state = ENDFRAME);
+    NS_ASSERT (GetMacState () == ENDFRAME);
     m_blocking = false;
     m_timerMaxFrame.Cancel();	
 	}
@@ -196,7 +211,7 @@ UanMacTlohi::RxData(Ptr<Packet> pkt, const UanAddress& add){
 	  NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" restart contend after data");
 	}
   else{
-	m_state = IDLE;
+	SetMacState (IDLE);
 	DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
   }
 
@@ -217,7 +232,7 @@ UanMacTlohi::TxCTD(){
     DynamicCast<UanMacWakeupTlohi> (m_mac) -> SendCTDTone();
 	//m_phy->SendPacket (packetCTD, 0);
     m_timerCR.Schedule(Seconds(m_CRWindow));
-    m_state = CONTEND;
+    SetMacState (CONTEND);
     m_CTC = 1;
   //}
 }
@@ -236,7 +251,7 @@ UanMacTlohi::TxData(){
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" SentData");
 	 //m_sendDataCallback(packetData);
     m_sendQueue.pop();
-	m_state = IDLE;
+	SetMacState (IDLE);
 	if(!m_sendQueue.size()){
 	  DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
 	}
@@ -247,20 +262,43 @@ UanMacTlohi::TxData(){
 
 void
 UanMacTlohi::TxEnd(){
-  if(!(m_sendQueue.size()) && m_state == IDLE){
+  if(!(m_sendQueue.size()) && GetMacState () == IDLE){
 	if (m_ultra){
 	    DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
 	  }
   }
 }
 
+// A round only counts the tones that did not overlap, so it undercounts
+// the contenders at high load.  Spreading the retries over the larger of
+// this round's count and its running average keeps them from colliding
+// again in the next round.
+uint32_t
+UanMacTlohi::DrawBackoffRounds (void)
+{
+  return DrawBackoffRounds (m_rand, m_CTC, m_ctcAlpha, m_ctcEstimate);
+}
+
+uint32_t
+UanMacTlohi::DrawBackoffRounds (Ptr<UniformRandomVariable> rand, uint32_t ctc,
+                                double alpha, double &estimate)
+{
+  estimate = (1 - alpha) * estimate + alpha * ctc;
+  // A lone contender sends without backing off
+  if (ctc <= 1)
+    {
+      return 0;
+    }
+  double contenders = std::max (double(ctc), estimate);
+  return (uint32_t)rand->GetValue (0, contenders);
+}
+
 void
 UanMacTlohi::on_timerCR(){
+  uint32_t backoffCR = DrawBackoffRounds ();
   if(m_CTC > 1){
-    Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>() ;
-    uint32_t backoffCR = (uint32_t)rand-> GetValue(0,double(m_CTC));
     m_timerBkoffCR.Schedule (Seconds((double)backoffCR*(m_CRWindow)));
-    m_state = BKOFF ;
+    SetMacState (BKOFF);
 	NS_LOG_DEBUG(" " << Simulator::Now ().GetSeconds () << " MAC " << UanAddress::ConvertFrom (GetAddress ()) <<" Backoff for "<< backoffCR <<"  CRs ");
   }
   else if(m_CTC == 1){
@@ -284,7 +322,7 @@ UanMacTlohi::on_timerMaxFrame(){
 	TxCTD();
   }
   else
-	m_state = IDLE;
+	SetMacState (IDLE);
 	DynamicCast<UanMacWakeupTlohi> (m_mac)->SetSleepMode (true);
 }
 void
@@ -298,6 +336,7 @@ void
 UanMacTlohi::AttachMacWakeup (Ptr<UanMac> mac)
 {
   m_mac = mac;
+  m_fsm->SetTimerQueue (DynamicCast<UanMacWakeupTlohi> (m_mac)->GetFsm ()->GetTimerQueue ());
   DynamicCast<UanMacWakeupTlohi> (m_mac) -> SetForwardUpCb (MakeCallback(&UanMacTlohi::RxData,this));
   
   DynamicCast<UanMacWakeupTlohi> (m_mac) -> SetToneMode();
@@ -335,16 +374,33 @@ UanMacTlohi::SetSendDatacb (Callback<void, Ptr<Packet> > cb){
 Address
 UanMacTlohi::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 int64_t
 UanMacTlohi::AssignStreams (int64_t stream)
 {
   NS_LOG_FUNCTION (this << stream);
-  //m_rand->SetStream (stream);
+  m_rand->SetStream (stream);
   return 1;
 }
 
+Ptr<UanMacFsm>
+UanMacTlohi::GetFsm (void) const
+{
+  return m_fsm;
+}
+
+void
+UanMacTlohi::SetMacState (State state)
+{
+  m_fsm->SetState (state);
+}
+
+UanMacTlohi::State
+UanMacTlohi::GetMacState (void) const
+{
+  return static_cast<State> (m_fsm->GetState ());
+}
+
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/event-id.h"
 #include "ns3/timer.h"
+#include "uan-mac-fsm.h"
 #include "ns3/uan-phy.h"
 #include "uan-mac-wakeup.h"
 
@@ -25,12 +26,14 @@ public:
   enum State{IDLE, CONTEND, BKOFF, ENDFRAME};
   double m_Ttlohi;
   double m_Tmax;
-  State m_state;
   bool m_blocking;
   uint32_t m_CTC;
   uint32_t m_sizeCTD;
   
   double m_CRWindow;
+  double m_ctcEstimate;   //Contender count smoothed across rounds
+  double m_ctcAlpha;      //Weight of the last round in m_ctcEstimate
+  Ptr<UniformRandomVariable> m_rand;
   Ptr<Packet> m_pkt;
   std::queue<Ptr<Packet> > m_sendQueue;
   Callback<void, Ptr<Packet>, const UanAddress& > m_forUpCb;
@@ -41,9 +44,10 @@ public:
   bool m_cleared;
   bool m_ultra;
   
-  Timer m_timerBkoffCR;
-  Timer m_timerCR;
-  Timer m_timerMaxFrame;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerBkoffCR;
+  UanMacFsmTimer m_timerCR;
+  UanMacFsmTimer m_timerMaxFrame;
   
   UanMacTlohi ();
   virtual ~UanMacTlohi ();
@@ -59,6 +63,8 @@ public:
   virtual Address GetBroadcast (void) const;
   virtual void Clear (void);
   int64_t AssignStreams(int64_t stream);
+  /** \return State machine engine holding the MAC state and timers. */
+  Ptr<UanMacFsm> GetFsm (void) const;
   void SetUltra(bool isUltra);
   //void RxPacket (Ptr<Packet> pkt, double sinr, UanTxMode mode);
   void SetSendDatacb (Callback<void, Ptr<Packet> > cb);
@@ -66,12 +72,35 @@ public:
   void TxEnd();
   void RxData(Ptr<Packet> pkt, const UanAddress& add);
   void RxCTD();
+  /**
+   * Fold the contender count of the round just ended into the running
+   * estimate and draw how many rounds to back off.
+   *
+   * \return Backoff in rounds, uniform in [0, max (m_CTC, m_ctcEstimate)),
+   *   or 0 without a draw when this node was the only contender.
+   */
+  uint32_t DrawBackoffRounds (void);
+  /**
+   * DrawBackoffRounds on the state of any T-Lohi variant.
+   *
+   * \param rand Backoff random variable.
+   * \param ctc Contenders counted in the round just ended.
+   * \param alpha Weight of that round in the estimate.
+   * \param estimate Smoothed contender count, updated.
+   * \return Backoff in rounds.
+   */
+  static uint32_t DrawBackoffRounds (Ptr<UniformRandomVariable> rand, uint32_t ctc,
+                                     double alpha, double &estimate);
 private:
 
 
   void TxCTD();
   bool TxData();
   
+  void SetMacState (State state);
+  /** \return Current state, kept by the state machine engine. */
+  State GetMacState (void) const;
+  
   void on_timerCR();
   void on_timerBkoffCR();
   void on_timerMaxFrame();
@@ -27,6 +27,7 @@
 #include "uan-header-wakeup.h"
 //#include "uan-mac-rts.h"
 #include "uan-phy-header.h"
+#include "uan-phy-wakeup-dual.h"
 #include "ns3/uan-module.h"
 
 #include <iostream>
@@ -41,14 +42,16 @@ NS_OBJECT_ENSURE_REGISTERED (UanMacWakeupMaca);
 
 UanMacWakeupMaca::UanMacWakeupMaca ()
   : UanMac (),
+    m_dataMode (0),
     m_cleared (false),
     m_timeDelayTx (1),
     m_dataSent (false)
 {
-  m_timerEndTx.SetFunction (&UanMacWakeupMaca::On_timerEndTx, this);
-  m_timerDelayTx.SetFunction (&UanMacWakeupMaca::On_timerDelayTx, this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_timerEndTx.Attach (m_fsm, "EndTx", MakeCallback (&UanMacWakeupMaca::On_timerEndTx, this));
+  m_timerDelayTx.Attach (m_fsm, "DelayTx", MakeCallback (&UanMacWakeupMaca::On_timerDelayTx, this));
+  m_timerTxFail.Attach (m_fsm, "TxFail", MakeCallback (&UanMacWakeupMaca::On_timerTxFail, this));
   //m_timerDelayTxWUHE.SetFunction (&UanMacWakeupMaca::On_timerDelayTxWUHE, this);
-  m_timerTxFail.SetFunction (&UanMacWakeupMaca::On_timerTxFail, this);
 
   m_pkt = 0;
   //m_highEnergyMode = false;
@@ -97,6 +100,7 @@ UanMacWakeupMaca::DoDispose ()
   m_timerDelayTx.Cancel ();
   //m_timerDelayTxWUHE.Cancel ();
   m_timerTxFail.Cancel ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -141,16 +145,6 @@ UanMacWakeupMaca::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t pro
 
   m_dest = UanAddress::ConvertFrom (dest);
   m_pkt = packet;
-  UanWakeupTag uwt;
-  if (!m_pkt->PeekPacketTag(uwt))
-    {
-      uwt.m_type = UanWakeupTag::DATA;
-      m_pkt->AddPacketTag (uwt);
-    }
-  else
-    {
-      NS_ASSERT (uwt.m_type == UanWakeupTag::DATA);
-    }
 
   UanPhyHeader phyHeader;
   m_pkt->AddHeader (phyHeader);
@@ -209,7 +203,7 @@ UanMacWakeupMaca::Send ()
       << " sending packet to " << (uint32_t) m_dest.GetAsInt ());
 
   m_state = DATA;
-  m_wakeupPhy->SendPacket (m_pkt, 0);
+  m_wakeupPhy->SendPacket (m_pkt, m_dataMode);
   //m_phy->SendPacket (m_pkt, 0);
 
   return true;
@@ -226,10 +220,6 @@ UanMacWakeupMaca::SendWU (UanAddress dst)
   UanPhyWUHeader phyHeader;
   pkt->AddHeader (phyHeader);
 
-  UanWakeupTag uwt;
-  uwt.m_type = UanWakeupTag::WU;
-  pkt->AddPacketTag (uwt);
-
   m_state = WU;
   m_wakeupPhy->SendPacket (pkt, 0);
   //m_phy->SendPacket (pkt, 0);
@@ -259,12 +249,9 @@ UanMacWakeupMaca::SendBroadcastCTD(UanAddress dest){
   wakeup.SetDest (dest);
   pkt->AddHeader (wakeup);
   UanPhyWUHeader phyHeader;
+  phyHeader.SetFrameType (UanPhyHeader::CTD);
   pkt->AddHeader (phyHeader);
 
-  UanWakeupTag uwt;
-  uwt.m_type = UanWakeupTag::CTD;
-  pkt->AddPacketTag (uwt);
-
   m_state = WU;
   m_wakeupPhy->SendPacket (pkt, 0);
 
@@ -293,12 +280,9 @@ UanMacWakeupMaca::SendBroadcastCTS(UanAddress dest)
   wakeup.SetDest (dest);
   pkt->AddHeader (wakeup);
   UanPhyWUHeader phyHeader;
+  phyHeader.SetFrameType (UanPhyHeader::CTS);
   pkt->AddHeader (phyHeader);
 
-  UanWakeupTag uwt;
-  uwt.m_type = UanWakeupTag::CTS;
-  pkt->AddPacketTag (uwt);
-
   m_state = WU;
   m_wakeupPhy->SendPacket (pkt, 0);
 
@@ -346,6 +330,16 @@ void UanMacWakeupMaca::SetSendPhyStateChangeCb (Callback<void, PhyState> cb)
 void
 UanMacWakeupMaca::AttachPhy (Ptr<UanPhy> phy)
 {
+  Ptr<UanPhyWakeupDual> dual = DynamicCast<UanPhyWakeupDual> (phy);
+  if (dual != 0)
+    {
+      // Both receivers share the device, data frames go out in the data band
+      AttachPhy (dual->GetDataPhy ());
+      AttachWakeupPhy (dual->GetWakeupPhy ());
+      dual->RegisterListener (this);
+      m_dataMode = dual->GetWakeupPhyDataMode ();
+      return;
+    }
   m_phy = DynamicCast<UanPhyGen> (phy);
   m_phy->SetReceiveOkCallback (MakeCallback (&UanMacWakeupMaca::RxPacketGood, this));
   m_phy->SetReceiveErrorCallback (MakeCallback (&UanMacWakeupMaca::RxPacketError, this));
@@ -367,19 +361,16 @@ UanMacWakeupMaca::AttachWakeupHEPhy (Ptr<UanPhy> phy)
 void
 UanMacWakeupMaca::RxPacketGood (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
-  UanWakeupTag uwt;
-  NS_ASSERT (pkt->RemovePacketTag(uwt));
-  
-  if(uwt.m_type != UanWakeupTag::DATA)
+  if (UanPhyHeader::PeekFrameType (pkt) != UanPhyHeader::DATA)
     return;
 
   UanPhyHeader phyHeader;
-  NS_ASSERT (pkt->RemoveHeader (phyHeader));
+  pkt->RemoveHeader (phyHeader);
   UanPhyTrailer phyTrailer;
-  NS_ASSERT (pkt->RemoveTrailer (phyTrailer));
+  pkt->RemoveTrailer (phyTrailer);
 
   UanHeaderCommon header;
-  NS_ASSERT (pkt->PeekHeader (header));
+  pkt->PeekHeader (header);
 
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " <<  (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt () << " receiving packet from " << header.GetSrc () << " For " << header.GetDest ());
 
@@ -412,10 +403,9 @@ UanMacWakeupMaca::RxPacketGoodData (Ptr<Packet> pkt, double sinr, UanTxMode txMo
 void
 UanMacWakeupMaca::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
-  UanWakeupTag uwt;
-  NS_ASSERT (pkt->RemovePacketTag(uwt));
+  UanPhyHeader::FrameType type = UanPhyHeader::PeekFrameType (pkt);
 
-  if(uwt.m_type == UanWakeupTag::CTD){
+  if(type == UanPhyHeader::CTD){
 
   UanPhyWUHeader phyWUHeader;
   pkt->RemoveHeader (phyWUHeader);
@@ -424,10 +414,12 @@ UanMacWakeupMaca::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
   pkt->RemoveHeader (header);
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " << (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt ()
       << " receiving wakeup packet for " << header.GetDest ());
+  if (!header.IsValid ())
+    return;
 
   UanAddress dest = header.GetDest();
 
-  if (dest == GetAddress () || dest == UanAddress::GetBroadcast())
+  if (IsWakeupFor (header))
        m_phy->SetSleepMode(false);
   
   m_rxRTSCb(pkt,dest);
@@ -436,7 +428,7 @@ UanMacWakeupMaca::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
   m_timerTxFail.Schedule (MilliSeconds (2));
 
   }
-  else if(uwt.m_type == UanWakeupTag::CTS){
+  else if(type == UanPhyHeader::CTS){
   
     UanPhyWUHeader phyWUHeader;
     pkt->RemoveHeader (phyWUHeader);
@@ -445,11 +437,12 @@ UanMacWakeupMaca::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
     pkt->RemoveHeader (header);
     NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " << (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt ()
       << " receiving wakeup packet for " << header.GetDest ());
+    if (!header.IsValid ())
+      return;
 
     UanAddress dest = header.GetDest();
-    m_phy->SetSleepMode(false);
-    //if (dest == GetAddress () || dest == UanAddress::GetBroadcast())
-      // m_phy->SetSleepMode(false);
+    if (IsWakeupFor (header))
+       m_phy->SetSleepMode(false);
 	m_rxCTSCb(pkt,dest);
 	}
   /*if (m_highEnergyMode)
@@ -535,6 +528,25 @@ void
 UanMacWakeupMaca::SetUseWakeup(bool useWakeup){
   m_useWakeup = useWakeup;
 }
+
+void
+UanMacWakeupMaca::JoinWakeupGroup (uint8_t group)
+{
+  m_groups.insert (group);
+}
+
+void
+UanMacWakeupMaca::LeaveWakeupGroup (uint8_t group)
+{
+  m_groups.erase (group);
+}
+
+bool
+UanMacWakeupMaca::IsWakeupFor (const UanHeaderWakeup &header) const
+{
+  bool inGroup = header.GetMode () == UanHeaderWakeup::GROUP && m_groups.count (header.GetGroup ());
+  return inGroup || header.IsDestination (m_address);
+}
 void 
 UanMacWakeupMaca::SetRxRTSCb(Callback<void,Ptr<Packet>,const UanAddress& > cb ){
   m_rxRTSCb = cb;
@@ -549,8 +561,7 @@ UanMacWakeupMaca::SetRxCTSCb(Callback<void,Ptr<Packet>,const UanAddress& > cb ){
 Address
 UanMacWakeupMaca::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 void
@@ -678,6 +689,12 @@ UanMacWakeupMaca::AssignStreams (int64_t stream)
   m_rand->SetStream (stream);
   return 1;
 }
+
+Ptr<UanMacFsm>
+UanMacWakeupMaca::GetFsm (void) const
+{
+  return m_fsm;
+}
 }
 
 
@@ -26,10 +26,13 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/event-id.h"
 #include "ns3/timer.h"
+#include "uan-header-wakeup.h"
+#include "uan-mac-fsm.h"
 #include "ns3/uan-phy-gen.h"
 #include "ns3/simulator.h"
 
 #include <queue>
+#include <set>
 
 namespace ns3
 {
@@ -83,6 +86,11 @@ public:
   void SetSleepMode(bool isSleep);
   void SetUseWakeup(bool useWakeup);
 
+  /** \param group Wakeup group this node answers to */
+  void JoinWakeupGroup (uint8_t group);
+  /** \param group Wakeup group this node no longer answers to */
+  void LeaveWakeupGroup (uint8_t group);
+
   uint32_t GetHeadersSize () const;
 
   //PhyListener
@@ -113,9 +121,17 @@ public:
   virtual void NotifyTxStart (Time duration);
 
   int64_t AssignStreams (int64_t stream);
+  /** \return State machine engine holding the timers; MACs stacked on top share its timer queue. */
+  Ptr<UanMacFsm> GetFsm (void) const;
 private:
   enum State { WU, DATA };
 
+  /**
+   * \param header Wakeup header of a received CTD or CTS
+   * \return True if the frame is addressed to this node or to a group it joined
+   */
+  bool IsWakeupFor (const UanHeaderWakeup &header) const;
+
   Ptr<UniformRandomVariable> m_rand;
 
   Callback<void> m_sendDataCallback;
@@ -123,20 +139,23 @@ private:
   UanAddress m_address;
   Ptr<UanPhyGen> m_phy;
   Ptr<UanPhy> m_wakeupPhy;
+  uint32_t m_dataMode;  //!< Mode number of m_wakeupPhy used for data frames.
   //Ptr<UanPhy> m_wakeupPhyHE;
   Callback<void, Ptr<Packet>, const UanAddress& > m_forUpCb;
   Callback<void, PhyState> m_stateChangeCb;
   bool m_cleared;
   bool m_wuAlone;
   bool m_useWakeup;
+  std::set<uint8_t> m_groups;
 
   Ptr<Packet> m_pkt;
   UanAddress m_dest;
 
-  Timer m_timerEndTx;
-  Timer m_timerDelayTx;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerEndTx;
+  UanMacFsmTimer m_timerDelayTx;
   //Timer m_timerDelayTxWUHE;
-  Timer m_timerTxFail;
+  UanMacFsmTimer m_timerTxFail;
 
 
   uint64_t m_timeDelayTx; //Miliseconds
@@ -27,6 +27,7 @@
 #include "uan-header-wakeup.h"
 //#include "uan-mac-rts.h"
 #include "uan-phy-header.h"
+#include "uan-phy-wakeup-dual.h"
 
 
 #include <iostream>
@@ -41,14 +42,16 @@ NS_OBJECT_ENSURE_REGISTERED (UanMacWakeupTlohi);
 
 UanMacWakeupTlohi::UanMacWakeupTlohi ()
   : UanMac (),
+    m_dataMode (0),
     m_cleared (false),
     m_timeDelayTx (1),
     m_dataSent (false)
 {
-  m_timerEndTx.SetFunction (&UanMacWakeupTlohi::On_timerEndTx, this);
-  m_timerDelayTx.SetFunction (&UanMacWakeupTlohi::On_timerDelayTx, this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_timerEndTx.Attach (m_fsm, "EndTx", MakeCallback (&UanMacWakeupTlohi::On_timerEndTx, this));
+  m_timerDelayTx.Attach (m_fsm, "DelayTx", MakeCallback (&UanMacWakeupTlohi::On_timerDelayTx, this));
+  m_timerTxFail.Attach (m_fsm, "TxFail", MakeCallback (&UanMacWakeupTlohi::On_timerTxFail, this));
   //m_timerDelayTxWUHE.SetFunction (&UanMacWakeupTlohi::On_timerDelayTxWUHE, this);
-  m_timerTxFail.SetFunction (&UanMacWakeupTlohi::On_timerTxFail, this);
 
   m_pkt = 0;
   //m_highEnergyMode = false;
@@ -97,6 +100,7 @@ UanMacWakeupTlohi::DoDispose ()
   m_timerDelayTx.Cancel ();
   //m_timerDelayTxWUHE.Cancel ();
   m_timerTxFail.Cancel ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -141,16 +145,6 @@ UanMacWakeupTlohi::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t pr
 
   m_dest = UanAddress::ConvertFrom (dest);
   m_pkt = packet;
-  UanWakeupTag uwt;
-  if (!m_pkt->PeekPacketTag(uwt))
-    {
-      uwt.m_type = UanWakeupTag::DATA;
-      m_pkt->AddPacketTag (uwt);
-    }
-  else
-    {
-      NS_ASSERT (uwt.m_type == UanWakeupTag::DATA);
-    }
 
   UanPhyHeader phyHeader;
   m_pkt->AddHeader (phyHeader);
@@ -197,7 +191,7 @@ UanMacWakeupTlohi::Send ()
       << " sending packet to " << (uint32_t) m_dest.GetAsInt ());
 
   m_state = DATA;
-  m_wakeupPhy->SendPacket (m_pkt, 0);
+  m_wakeupPhy->SendPacket (m_pkt, m_dataMode);
   //m_phy->SendPacket (m_pkt, 0);
 
   return true;
@@ -214,10 +208,6 @@ UanMacWakeupTlohi::SendWU (UanAddress dst)
   UanPhyWUHeader phyHeader;
   pkt->AddHeader (phyHeader);
 
-  UanWakeupTag uwt;
-  uwt.m_type = UanWakeupTag::WU;
-  pkt->AddPacketTag (uwt);
-
   m_state = WU;
   m_wakeupPhy->SendPacket (pkt, 0);
   //m_phy->SendPacket (pkt, 0);
@@ -245,12 +235,9 @@ UanMacWakeupTlohi::SendCTDTone ()
   wakeup.SetDest (UanAddress::ConvertFrom (GetBroadcast()).GetAsInt());
   pkt->AddHeader (wakeup);
   UanPhyWUHeader phyHeader;
+  phyHeader.SetFrameType (UanPhyHeader::CTD);
   pkt->AddHeader (phyHeader);
 
-  UanWakeupTag uwt;
-  uwt.m_type = UanWakeupTag::CTD;
-  pkt->AddPacketTag (uwt);
-
   m_state = WU;
   m_wakeupPhy->SendPacket (pkt, 0);
 
@@ -304,6 +291,16 @@ void UanMacWakeupTlohi::SetSendPhyStateChangeCb (Callback<void, PhyState> cb)
 void
 UanMacWakeupTlohi::AttachPhy (Ptr<UanPhy> phy)
 {
+  Ptr<UanPhyWakeupDual> dual = DynamicCast<UanPhyWakeupDual> (phy);
+  if (dual != 0)
+    {
+      // Both receivers share the device, data frames go out in the data band
+      AttachPhy (dual->GetDataPhy ());
+      AttachWakeupPhy (dual->GetWakeupPhy ());
+      dual->RegisterListener (this);
+      m_dataMode = dual->GetWakeupPhyDataMode ();
+      return;
+    }
   m_phy = DynamicCast<UanPhyGen> (phy);
   m_phy->SetReceiveOkCallback (MakeCallback (&UanMacWakeupTlohi::RxPacketGood, this));
   m_phy->SetReceiveErrorCallback (MakeCallback (&UanMacWakeupTlohi::RxPacketError, this));
@@ -325,19 +322,16 @@ UanMacWakeupTlohi::AttachWakeupHEPhy (Ptr<UanPhy> phy)
 void
 UanMacWakeupTlohi::RxPacketGood (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
-  UanWakeupTag uwt;
-  NS_ASSERT (pkt->RemovePacketTag(uwt));
-  
-  if(uwt.m_type != UanWakeupTag::DATA)
+  if (UanPhyHeader::PeekFrameType (pkt) != UanPhyHeader::DATA)
     return;
 
   UanPhyHeader phyHeader;
-  NS_ASSERT (pkt->RemoveHeader (phyHeader));
+  pkt->RemoveHeader (phyHeader);
   UanPhyTrailer phyTrailer;
-  NS_ASSERT (pkt->RemoveTrailer (phyTrailer));
+  pkt->RemoveTrailer (phyTrailer);
 
   UanHeaderCommon header;
-  NS_ASSERT (pkt->PeekHeader (header));
+  pkt->PeekHeader (header);
 
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " <<  (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt () << " receiving packet from " << header.GetSrc () << " For " << header.GetDest ());
 
@@ -370,10 +364,9 @@ UanMacWakeupTlohi::RxPacketGoodData (Ptr<Packet> pkt, double sinr, UanTxMode txM
 void
 UanMacWakeupTlohi::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
-  UanWakeupTag uwt;
-  NS_ASSERT (pkt->RemovePacketTag(uwt));
+  UanPhyHeader::FrameType type = UanPhyHeader::PeekFrameType (pkt);
 
-  if(uwt.m_type == UanWakeupTag::WU){
+  if(type == UanPhyHeader::WU){
 
   UanPhyWUHeader phyWUHeader;
   pkt->RemoveHeader (phyWUHeader);
@@ -383,16 +376,18 @@ UanMacWakeupTlohi::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " << (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt ()
       << " receiving wakeup packet for " << header.GetDest ());
 
-  UanAddress dest = header.GetDest();
+  if (!header.IsValid ())
+      return;
 
-  if (dest != GetAddress () && dest != UanAddress::GetBroadcast())
+  bool inGroup = header.GetMode () == UanHeaderWakeup::GROUP && m_groups.count (header.GetGroup ());
+  if (!inGroup && !header.IsDestination (m_address))
       return;
 	  
   m_phy->SetSleepMode(false);
   m_timerTxFail.Schedule (MilliSeconds (2));
 
   }
-  else if(uwt.m_type == UanWakeupTag::CTD){
+  else if(type == UanPhyHeader::CTD){
    if (!m_toneRxCallback.IsNull())
       m_toneRxCallback ();
 	  
@@ -480,11 +475,22 @@ void UanMacWakeupTlohi::SetUseWakeup(bool useWakeup){
   m_useWakeup = useWakeup;
 }
 
+void
+UanMacWakeupTlohi::JoinWakeupGroup (uint8_t group)
+{
+  m_groups.insert (group);
+}
+
+void
+UanMacWakeupTlohi::LeaveWakeupGroup (uint8_t group)
+{
+  m_groups.erase (group);
+}
+
 Address
 UanMacWakeupTlohi::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 void
@@ -611,6 +617,12 @@ UanMacWakeupTlohi::AssignStreams (int64_t stream)
   m_rand->SetStream (stream);
   return 1;
 }
+
+Ptr<UanMacFsm>
+UanMacWakeupTlohi::GetFsm (void) const
+{
+  return m_fsm;
+}
 }
 
 
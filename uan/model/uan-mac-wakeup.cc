@@ -27,6 +27,9 @@
 #include "uan-header-wakeup.h"
 //#include "uan-mac-rts.h"
 #include "uan-phy-header.h"
+#include "uan-phy-wakeup-dual.h"
+#include "uan-duty-cycle-controller.h"
+#include "ns3/nstime.h"
 
 
 #include <iostream>
@@ -41,14 +44,24 @@ NS_OBJECT_ENSURE_REGISTERED (UanMacWakeup);
 
 UanMacWakeup::UanMacWakeup ()
   : UanMac (),
+    m_dataMode (0),
     m_cleared (false),
+    m_sleepLinger (Seconds (0)),
+    m_peerSleepLinger (Seconds (0)),
+    m_skippedWakeups (0),
+    m_warmupMode (0),
+    m_wakeupsReceived (0),
     m_timeDelayTx (1),
     m_dataSent (false)
 {
-  m_timerEndTx.SetFunction (&UanMacWakeup::On_timerEndTx, this);
-  m_timerDelayTx.SetFunction (&UanMacWakeup::On_timerDelayTx, this);
+  m_fsm = CreateObject<UanMacFsm> ();
+  m_timerEndTx.Attach (m_fsm, "EndTx", MakeCallback (&UanMacWakeup::On_timerEndTx, this));
+  m_timerDelayTx.Attach (m_fsm, "DelayTx", MakeCallback (&UanMacWakeup::On_timerDelayTx, this));
   //m_timerDelayTxWUHE.SetFunction (&UanMacWakeup::On_timerDelayTxWUHE, this);
-  m_timerTxFail.SetFunction (&UanMacWakeup::On_timerTxFail, this);
+  m_timerTxFail.Attach (m_fsm, "TxFail", MakeCallback (&UanMacWakeup::On_timerTxFail, this));
+  m_timerSleep.Attach (m_fsm, "Sleep", MakeCallback (&UanMacWakeup::On_timerSleep, this));
+  m_timerWindow.Attach (m_fsm, "Window", MakeCallback (&UanMacWakeup::On_timerWindow, this));
+  m_timerWarmup.Attach (m_fsm, "Warmup", MakeCallback (&UanMacWakeup::On_timerWarmup, this));
 
   m_pkt = 0;
   //m_highEnergyMode = false;
@@ -97,6 +110,15 @@ UanMacWakeup::DoDispose ()
   m_timerDelayTx.Cancel ();
   //m_timerDelayTxWUHE.Cancel ();
   m_timerTxFail.Cancel ();
+  m_timerSleep.Cancel ();
+  m_timerWindow.Cancel ();
+  m_timerWarmup.Cancel ();
+  m_pendingTone = 0;
+  m_warmupPkt = 0;
+  m_dutyCycle = 0;
+  m_txStamp.Nullify ();
+  m_txAlign.Nullify ();
+  m_fsm->Dispose ();
   UanMac::DoDispose ();
 }
 
@@ -107,6 +129,18 @@ UanMacWakeup::GetTypeId (void)
     .SetParent<UanMac> ()
     .SetGroupName ("Uan")
     .AddConstructor<UanMacWakeup> ()
+    .AddAttribute ("SleepLinger",
+                   "Time the data PHY stays awake after a sleep request or the last received frame.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UanMacWakeup::m_sleepLinger),
+                   MakeTimeChecker ())
+    .AddAttribute ("PeerSleepLinger",
+                   "Linger assumed for a neighbor after it acknowledged a frame; a frame sent to it "
+                   "within this time needs no wakeup tone.  Keep it at or below the smallest SleepLinger "
+                   "of the neighbors; zero always sends the tone.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UanMacWakeup::m_peerSleepLinger),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -133,34 +167,29 @@ UanMacWakeup::Enqueue (Ptr<Packet> packet, const Address &dest, uint16_t protoco
     }
 
 //  std::cerr << m_phy->IsStateIdle () << " " << m_wakeupPhy->IsStateIdle () << std::endl;
-  if (!m_phy->IsStateIdle () && !m_wakeupPhy->IsStateIdle ())
+  if (!IsPhyReady ())
     {
       NS_LOG_DEBUG ("Phy not IDLE, discarding");
       return false;
     }
 
   m_dest = UanAddress::ConvertFrom (dest);
+  // Framed in FrameData, once the transmit time is known
   m_pkt = packet;
-  UanWakeupTag uwt;
-  if (!m_pkt->PeekPacketTag(uwt))
-    {
-      uwt.m_type = UanWakeupTag::DATA;
-      m_pkt->AddPacketTag (uwt);
-    }
-  else
-    {
-      NS_ASSERT (uwt.m_type == UanWakeupTag::DATA);
-    }
-
-  UanPhyHeader phyHeader;
-  m_pkt->AddHeader (phyHeader);
-  UanPhyTrailer phyTrailer;
-  m_pkt->AddTrailer (phyTrailer);
 
 
   NS_LOG_DEBUG ((uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt ()
       << " sending wakeup signal to " << (uint32_t) m_dest.GetAsInt ());
 
+  //Receiver still lingering from the last exchange, no need to wake it
+  if (!m_toneMode && IsAwake (m_dest))
+    {
+      NS_LOG_DEBUG ((uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt ()
+          << " skipping wakeup signal, " << (uint32_t) m_dest.GetAsInt () << " is awake");
+      m_skippedWakeups++;
+      return Send ();
+    }
+
   //Send wakeup signal
   //if (m_highEnergyMode) SendBroadcastWU ();
   if (m_toneMode) SendBroadcastWU();
@@ -199,7 +228,7 @@ UanMacWakeup::Send ()
       << " sending packet to " << (uint32_t) m_dest.GetAsInt ());
 
   m_state = DATA;
-  m_wakeupPhy->SendPacket (m_pkt, 0);
+  SendOnWakeupPhy (m_pkt, m_dataMode);
   //m_phy->SendPacket (m_pkt, 0);
 
   return true;
@@ -208,25 +237,62 @@ UanMacWakeup::Send ()
 void
 UanMacWakeup::SendWU (UanAddress dst)
 {
-  Ptr<Packet> pkt = Create<Packet> ();
-
   UanHeaderWakeup wakeup;
   wakeup.SetDest (dst);
+  SendWU (wakeup);
+}
+
+void
+UanMacWakeup::SendWU (const UanHeaderWakeup &wakeup)
+{
+  Ptr<Packet> pkt = Create<Packet> ();
+
   pkt->AddHeader (wakeup);
   UanPhyWUHeader phyHeader;
   pkt->AddHeader (phyHeader);
 
-  UanWakeupTag uwt;
-  uwt.m_type = UanWakeupTag::WU;
-  pkt->AddPacketTag (uwt);
-
   m_state = WU;
-  m_wakeupPhy->SendPacket (pkt, 0);
+  if (m_dutyCycle)
+    {
+      // Neighbors only listen in the windows
+      Time delay = m_dutyCycle->GetNextWindow () - Simulator::Now ();
+      if (delay.IsStrictlyPositive ())
+        {
+          m_pendingTone = pkt;
+          m_timerWindow.Schedule (delay);
+          return;
+        }
+    }
+  SendOnWakeupPhy (pkt, 0);
   //m_phy->SendPacket (pkt, 0);
 }
 
 bool
 UanMacWakeup::SendWUAlone (UanAddress dst)
+{
+  UanHeaderWakeup wakeup;
+  wakeup.SetDest (dst);
+  return SendWUAlone (wakeup);
+}
+
+bool
+UanMacWakeup::SendWUGroup (uint8_t group)
+{
+  UanHeaderWakeup wakeup;
+  wakeup.SetGroup (group);
+  return SendWUAlone (wakeup);
+}
+
+bool
+UanMacWakeup::SendWUMembers (const std::vector<UanAddress> &dsts)
+{
+  UanHeaderWakeup wakeup;
+  wakeup.SetMembers (dsts);
+  return SendWUAlone (wakeup);
+}
+
+bool
+UanMacWakeup::SendWUAlone (const UanHeaderWakeup &wakeup)
 {
   if (m_pkt != 0)
     {
@@ -234,14 +300,14 @@ UanMacWakeup::SendWUAlone (UanAddress dst)
       return false;
     }
 
-  if (!m_phy->IsStateIdle () && !m_wakeupPhy->IsStateIdle ())
+  if (!IsPhyReady ())
     {
       NS_LOG_DEBUG ("Phy not IDLE, discarding");
       return false;
     }
 
   m_wuAlone = true;
-  SendWU(dst);
+  SendWU (wakeup);
 
   return true;
 }
@@ -285,6 +351,16 @@ UanMacWakeup::SetToneRxCallback (ToneRxCallback cb)
 {
   m_toneRxCallback = cb;
 }
+void
+UanMacWakeup::SetTxStampCallback (TxStampCallback cb)
+{
+  m_txStamp = cb;
+}
+void
+UanMacWakeup::SetTxAlignCallback (TxAlignCallback cb)
+{
+  m_txAlign = cb;
+}
 void UanMacWakeup::SetSendPhyStateChangeCb (Callback<void, PhyState> cb)
 {
   m_stateChangeCb = cb;
@@ -293,6 +369,16 @@ void UanMacWakeup::SetSendPhyStateChangeCb (Callback<void, PhyState> cb)
 void
 UanMacWakeup::AttachPhy (Ptr<UanPhy> phy)
 {
+  Ptr<UanPhyWakeupDual> dual = DynamicCast<UanPhyWakeupDual> (phy);
+  if (dual != 0)
+    {
+      // Both receivers share the device, data frames go out in the data band
+      AttachPhy (dual->GetDataPhy ());
+      AttachWakeupPhy (dual->GetWakeupPhy ());
+      dual->RegisterListener (this);
+      m_dataMode = dual->GetWakeupPhyDataMode ();
+      return;
+    }
   m_phy = DynamicCast<UanPhyGen> (phy);
   m_phy->SetReceiveOkCallback (MakeCallback (&UanMacWakeup::RxPacketGood, this));
   m_phy->SetReceiveErrorCallback (MakeCallback (&UanMacWakeup::RxPacketError, this));
@@ -314,23 +400,27 @@ UanMacWakeup::AttachWakeupHEPhy (Ptr<UanPhy> phy)
 void
 UanMacWakeup::RxPacketGood (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
-  UanWakeupTag uwt;
-  NS_ASSERT (pkt->RemovePacketTag(uwt));
-  
-  if(uwt.m_type != UanWakeupTag::DATA)
+  if (UanPhyHeader::PeekFrameType (pkt) != UanPhyHeader::DATA)
     return;
 
   UanPhyHeader phyHeader;
-  NS_ASSERT (pkt->RemoveHeader (phyHeader));
+  pkt->RemoveHeader (phyHeader);
   UanPhyTrailer phyTrailer;
-  NS_ASSERT (pkt->RemoveTrailer (phyTrailer));
+  pkt->RemoveTrailer (phyTrailer);
 
   UanHeaderCommon header;
-  NS_ASSERT (pkt->PeekHeader (header));
+  pkt->PeekHeader (header);
 
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " <<  (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt () << " receiving packet from " << header.GetSrc () << " For " << header.GetDest ());
 
 
+  //Traffic keeps a lingering receiver awake
+  if (m_timerSleep.IsRunning ())
+    {
+      m_timerSleep.Cancel ();
+      m_timerSleep.Schedule (m_sleepLinger);
+    }
+
   m_forUpCb (pkt, header.GetSrc ());
 
   //if(m_useWakeup) m_phy->SetSleepMode(true);
@@ -359,10 +449,7 @@ UanMacWakeup::RxPacketGoodData (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 void
 UanMacWakeup::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
 {
-  UanWakeupTag uwt;
-  NS_ASSERT (pkt->RemovePacketTag(uwt));
-
-  if(uwt.m_type != UanWakeupTag::WU)
+  if (UanPhyHeader::PeekFrameType (pkt) != UanPhyHeader::WU)
     return;
 
   UanPhyWUHeader phyWUHeader;
@@ -371,12 +458,17 @@ UanMacWakeup::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
   UanHeaderWakeup header;
   pkt->RemoveHeader (header);
   NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " << (uint32_t) UanAddress::ConvertFrom (GetAddress ()).GetAsInt ()
-      << " receiving wakeup packet for " << header.GetDest ());
+      << " receiving wakeup packet: " << header);
 
-  UanAddress dest = header.GetDest();
-
-  if (dest != GetAddress () && dest != UanAddress::GetBroadcast())
+  if (!header.IsValid ())
+    {
+      NS_LOG_DEBUG ("Dropping wakeup packet with a corrupted mode");
       return;
+    }
+  bool inGroup = header.GetMode () == UanHeaderWakeup::GROUP && m_groups.count (header.GetGroup ());
+  if (!inGroup && !header.IsDestination (m_address))
+      return;
+  m_wakeupsReceived++;
 
   m_timerTxFail.Schedule (MilliSeconds (2));
   if (!m_toneRxCallback.IsNull())
@@ -392,7 +484,11 @@ UanMacWakeup::RxPacketGoodW (Ptr<Packet> pkt, double sinr, UanTxMode txMode)
       if(m_useWakeup) m_phy->SetSleepMode (false);
       //std::cerr << Simulator::Now().GetSeconds() << " Phy Data wakeup" << (uint32_t) m_address.GetAsInt() << std::endl;
     }*/
-	if(m_useWakeup) m_phy->SetSleepMode (false);
+	if(m_useWakeup)
+	  {
+	    m_timerSleep.Cancel ();
+	    m_phy->SetSleepMode (false);
+	  }
 }
 
 /*void
@@ -456,6 +552,12 @@ UanMacWakeup::RxPacketErrorWHE (Ptr<Packet> pkt, double sinr)
 void 
 UanMacWakeup::SetSleepMode(bool isSleep)
 {
+  m_timerSleep.Cancel ();
+  if (isSleep && m_sleepLinger.IsStrictlyPositive ())
+    {
+      m_timerSleep.Schedule (m_sleepLinger);
+      return;
+    }
   m_phy->SetSleepMode (isSleep);
   
   //m_wakeupPhyHE->SetSleepMode (isSleep);
@@ -464,11 +566,95 @@ void UanMacWakeup::SetUseWakeup(bool useWakeup){
   m_useWakeup = useWakeup;
 }
 
+void
+UanMacWakeup::JoinWakeupGroup (uint8_t group)
+{
+  m_groups.insert (group);
+}
+
+void
+UanMacWakeup::LeaveWakeupGroup (uint8_t group)
+{
+  m_groups.erase (group);
+}
+
+bool
+UanMacWakeup::IsAwake (UanAddress dst) const
+{
+  if (dst == UanAddress::GetBroadcast ())
+    {
+      return false;
+    }
+  std::map<UanAddress, Time>::const_iterator it = m_awakeUntil.find (dst);
+  return it != m_awakeUntil.end () && Simulator::Now () < it->second;
+}
+
+void
+UanMacWakeup::NotifyDelivered (UanAddress dst, Time age)
+{
+  if (!m_peerSleepLinger.IsStrictlyPositive () || dst == UanAddress::GetBroadcast ())
+    {
+      return;
+    }
+  // The peer lingers from its ACK, not from when we heard it
+  m_awakeUntil[dst] = Simulator::Now () - age + m_peerSleepLinger;
+}
+
+uint32_t
+UanMacWakeup::GetSkippedWakeups () const
+{
+  return m_skippedWakeups;
+}
+
+uint32_t
+UanMacWakeup::GetWakeupsReceived () const
+{
+  return m_wakeupsReceived;
+}
+
+bool
+UanMacWakeup::IsBusy () const
+{
+  return m_pkt != 0 || m_wuAlone || m_timerEndTx.IsRunning () || m_timerWindow.IsRunning ()
+         || m_timerWarmup.IsRunning ();
+}
+
+Ptr<UanPhy>
+UanMacWakeup::GetWakeupPhy () const
+{
+  return m_wakeupPhy;
+}
+
+void
+UanMacWakeup::SetDutyCycleController (Ptr<UanDutyCycleController> controller)
+{
+  m_dutyCycle = controller;
+}
+
+Ptr<UanDutyCycleController>
+UanMacWakeup::GetDutyCycleController () const
+{
+  return m_dutyCycle;
+}
+
+bool
+UanMacWakeup::IsPhyReady (void)
+{
+  // A duty-cycled wakeup receiver is woken up to transmit
+  return m_phy->IsStateIdle () || m_wakeupPhy->IsStateIdle ()
+         || (m_dutyCycle && m_wakeupPhy->IsStateSleep ());
+}
+
+Ptr<UanMacFsm>
+UanMacWakeup::GetFsm () const
+{
+  return m_fsm;
+}
+
 Address
 UanMacWakeup::GetBroadcast (void) const
 {
-  UanAddress broadcast (255);
-  return broadcast;
+  return UanAddress::GetBroadcast ();
 }
 
 void
@@ -477,6 +663,10 @@ UanMacWakeup::On_timerEndTx (void)
   if (m_wuAlone)
     {
       m_wuAlone = false;
+      if (m_dutyCycle)
+        {
+          m_dutyCycle->Release ();
+        }
       return;
     }
 
@@ -496,6 +686,10 @@ UanMacWakeup::On_timerEndTx (void)
   case DATA:
     m_pkt = 0;
     m_state = WU;
+    if (m_dutyCycle)
+      {
+        m_dutyCycle->Release ();
+      }
     if (!m_txEnd.IsNull())
       m_txEnd ();
     break;
@@ -531,6 +725,81 @@ UanMacWakeup::On_timerTxFail ()
     }*/
 }
 
+void
+UanMacWakeup::On_timerWindow (void)
+{
+  Ptr<Packet> pkt = m_pendingTone;
+  m_pendingTone = 0;
+  SendOnWakeupPhy (pkt, 0);
+}
+
+void
+UanMacWakeup::On_timerWarmup (void)
+{
+  Ptr<Packet> pkt = m_warmupPkt;
+  m_warmupPkt = 0;
+  SendOnWakeupPhy (pkt, m_warmupMode);
+}
+
+void
+UanMacWakeup::SendOnWakeupPhy (Ptr<Packet> pkt, uint32_t mode)
+{
+  if (m_dutyCycle)
+    {
+      // Keep the MAC busy until the duty-cycled PHY has warmed up
+      Time delay = m_dutyCycle->Hold ();
+      if (delay.IsStrictlyPositive ())
+        {
+          m_warmupPkt = pkt;
+          m_warmupMode = mode;
+          m_timerWarmup.Schedule (delay);
+          return;
+        }
+    }
+  if (pkt == m_pkt)
+    {
+      // A warming up PHY holds the frame until it is ready
+      Ptr<UanPhyGen> phy = DynamicCast<UanPhyGen> (m_wakeupPhy);
+      Time txStart = Simulator::Now () + (phy ? phy->GetWakeupDelayLeft () : Seconds (0));
+      if (!m_txAlign.IsNull ())
+        {
+          Time aligned = m_txAlign (m_pkt, txStart);
+          if (aligned > txStart)
+            {
+              m_warmupPkt = pkt;
+              m_warmupMode = mode;
+              m_timerWarmup.Schedule (aligned - Simulator::Now ());
+              return;
+            }
+        }
+      pkt = FrameData (txStart);
+    }
+  m_wakeupPhy->SendPacket (pkt, mode);
+}
+
+Ptr<Packet>
+UanMacWakeup::FrameData (Time txStart)
+{
+  Ptr<Packet> frame = m_pkt->Copy ();
+  if (!m_txStamp.IsNull ())
+    {
+      m_txStamp (frame, txStart);
+    }
+
+  UanPhyHeader phyHeader;
+  frame->AddHeader (phyHeader);
+  UanPhyTrailer phyTrailer;
+  frame->AddTrailer (phyTrailer);
+  return frame;
+}
+
+void
+UanMacWakeup::On_timerSleep (void)
+{
+  NS_LOG_DEBUG ("" << Simulator::Now ().GetSeconds () << " Wakeup " << (uint32_t) m_address.GetAsInt () << " linger expired, data PHY sleeps");
+  m_phy->SetSleepMode (true);
+}
+
 /*
  * PhyListener
  */
@@ -586,6 +855,13 @@ UanMacWakeup::NotifyTxStart (Time duration)
 
   m_stateChangeCb(BUSY);
   m_timerEndTx.Schedule (duration);
+
+  //An ACK starts the window its sender assumes in NotifyDelivered
+  if (m_state == DATA && m_timerSleep.IsRunning ())
+    {
+      m_timerSleep.Cancel ();
+      m_timerSleep.Schedule (duration + m_sleepLinger);
+    }
 }
 
 int64_t
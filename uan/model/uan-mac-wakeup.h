@@ -28,8 +28,13 @@
 #include "ns3/timer.h"
 #include "ns3/uan-phy-gen.h"
 #include "ns3/simulator.h"
+#include "uan-header-wakeup.h"
+#include "uan-mac-fsm.h"
 
 #include <queue>
+#include <map>
+#include <set>
+#include <vector>
 
 namespace ns3
 {
@@ -37,6 +42,7 @@ namespace ns3
 
 class UanPhy;
 class UanTxMode;
+class UanDutyCycleController;
 
 class UanMacWakeup : public UanMac, public UanPhyListener
 {
@@ -45,6 +51,16 @@ public:
 
   typedef Callback<void> TxEndCallback;
   typedef Callback<void> ToneRxCallback;
+  /**
+   * Called with the upper MAC frame, before the PHY framing is added,
+   * and the time the PHY will start sending it.
+   */
+  typedef Callback<void, Ptr<Packet>, Time> TxStampCallback;
+  /**
+   * Called with the upper MAC frame and the earliest time the PHY could
+   * start sending it; returns the start to use, not earlier.
+   */
+  typedef Callback<Time, Ptr<const Packet>, Time> TxAlignCallback;
 
   UanMacWakeup ();
   virtual ~UanMacWakeup ();
@@ -58,6 +74,18 @@ public:
   virtual void SetForwardUpCb (Callback<void, Ptr<Packet>, const UanAddress& > cb);
   void SetTxEndCallback (TxEndCallback cb);
   void SetToneRxCallback (ToneRxCallback cb);
+  /**
+   * Let the upper MAC stamp its frame when it reaches the PHY, after
+   * any wakeup tone, duty cycle hold and warm-up.
+   * \param cb Stamping callback
+   */
+  void SetTxStampCallback (TxStampCallback cb);
+  /**
+   * Let the upper MAC delay its frame at the PHY, e.g. to a slot
+   * boundary.  The frame is held until the returned start.
+   * \param cb Alignment callback
+   */
+  void SetTxAlignCallback (TxAlignCallback cb);
   virtual void AttachPhy (Ptr<UanPhy> phy);
   void AttachWakeupPhy (Ptr<UanPhy> phy);
   //void AttachWakeupHEPhy (Ptr<UanPhy> phy);
@@ -67,6 +95,18 @@ public:
   bool Send ();
   void SendWU (UanAddress dst);
   bool SendWUAlone (UanAddress dst);
+  /**
+   * Wake every node that joined group in a single tone.
+   * \param group Wakeup group id
+   * \return False if the MAC or PHY is busy
+   */
+  bool SendWUGroup (uint8_t group);
+  /**
+   * Wake exactly the listed nodes in a single tone.
+   * \param dsts Nodes to wake
+   * \return False if the MAC or PHY is busy
+   */
+  bool SendWUMembers (const std::vector<UanAddress> &dsts);
   //void SendWUHE ();
   void SendBroadcastWU ();
 
@@ -75,9 +115,48 @@ public:
 
   void SetSendPhyStateChangeCb (Callback<void, PhyState> cb);
   
+  /**
+   * Put the data PHY to sleep or wake it up.  A sleep request is held
+   * for the SleepLinger time and restarted by every frame received
+   * meanwhile, or by the end of every frame sent, so close traffic can
+   * skip its wakeup tone.
+   */
   void SetSleepMode(bool isSleep);
   void SetUseWakeup(bool useWakeup);
 
+  /** \param group Wakeup group this node answers to */
+  void JoinWakeupGroup (uint8_t group);
+  /** \param group Wakeup group this node no longer answers to */
+  void LeaveWakeupGroup (uint8_t group);
+
+  /**
+   * \param dst Neighbor address
+   * \return True if dst is believed to have its data PHY awake, so no tone is needed.
+   */
+  bool IsAwake (UanAddress dst) const;
+  /**
+   * Called by the upper MAC when dst acknowledged a frame.  dst is then
+   * taken to be awake for PeerSleepLinger from when it sent the ACK.
+   * \param dst Neighbor that acknowledged
+   * \param age Time since dst sent the ACK, at least the propagation delay
+   */
+  void NotifyDelivered (UanAddress dst, Time age);
+  /** \return Number of data frames sent without a wakeup tone. */
+  uint32_t GetSkippedWakeups () const;
+  /** \return Number of wakeup tones received for this node. */
+  uint32_t GetWakeupsReceived () const;
+  /** \return True while a tone or frame is pending or being sent. */
+  bool IsBusy () const;
+  Ptr<UanPhy> GetWakeupPhy () const;
+  /**
+   * Hold tones until the listen windows of controller, which
+   * duty-cycles the wakeup receiver.  Set by UanDutyCycleController::Install.
+   */
+  void SetDutyCycleController (Ptr<UanDutyCycleController> controller);
+  Ptr<UanDutyCycleController> GetDutyCycleController () const;
+  /** \return State machine engine holding the timers; MACs stacked on top share its timer queue. */
+  Ptr<UanMacFsm> GetFsm () const;
+
   uint32_t GetHeadersSize () const;
 
   //PhyListener
@@ -118,6 +197,7 @@ private:
   UanAddress m_address;
   Ptr<UanPhyGen> m_phy;
   Ptr<UanPhy> m_wakeupPhy;
+  uint32_t m_dataMode;  //!< Mode number of m_wakeupPhy used for data frames.
   //Ptr<UanPhy> m_wakeupPhyHE;
   Callback<void, Ptr<Packet>, const UanAddress& > m_forUpCb;
   Callback<void, PhyState> m_stateChangeCb;
@@ -128,11 +208,26 @@ private:
   Ptr<Packet> m_pkt;
   UanAddress m_dest;
 
-  Timer m_timerEndTx;
-  Timer m_timerDelayTx;
+  Ptr<UanMacFsm> m_fsm;
+  UanMacFsmTimer m_timerEndTx;
+  UanMacFsmTimer m_timerDelayTx;
   //Timer m_timerDelayTxWUHE;
-  Timer m_timerTxFail;
-
+  UanMacFsmTimer m_timerTxFail;
+  UanMacFsmTimer m_timerSleep;
+  UanMacFsmTimer m_timerWindow;
+  UanMacFsmTimer m_timerWarmup;
+
+  Ptr<UanDutyCycleController> m_dutyCycle;
+  Ptr<Packet> m_pendingTone;   //!< Tone held for the next listen window
+  Ptr<Packet> m_warmupPkt;     //!< Frame held while the wakeup PHY warms up, or until its aligned start
+  uint32_t m_warmupMode;       //!< Mode number of m_warmupPkt
+  uint32_t m_wakeupsReceived;
+
+  Time m_sleepLinger;
+  Time m_peerSleepLinger;  //!< Linger assumed for neighbors when skipping tones
+  std::map<UanAddress, Time> m_awakeUntil; //End of the awake window of each neighbor
+  uint32_t m_skippedWakeups;
+  std::set<uint8_t> m_groups;
 
   uint64_t m_timeDelayTx; //Miliseconds
 
@@ -144,11 +239,32 @@ private:
 
   TxEndCallback m_txEnd;
   ToneRxCallback m_toneRxCallback;
+  TxStampCallback m_txStamp;
+  TxAlignCallback m_txAlign;
 
   void On_timerEndTx (void);
   void On_timerDelayTx (void);
   //void On_timerDelayTxWUHE (void);
   void On_timerTxFail (void);
+  void On_timerSleep (void);
+  void On_timerWindow (void);
+  void On_timerWarmup (void);
+  /**
+   * Send on the wakeup PHY, once it is awake when duty-cycled.
+   *
+   * \param pkt Frame to send.
+   * \param mode Mode number of the wakeup PHY.
+   */
+  void SendOnWakeupPhy (Ptr<Packet> pkt, uint32_t mode);
+  /**
+   * \param txStart Time the PHY starts sending the data frame
+   * \return Copy of the data frame, stamped and with the PHY framing.
+   */
+  Ptr<Packet> FrameData (Time txStart);
+  /** \return True if the PHYs can take a transmission. */
+  bool IsPhyReady (void);
+  void SendWU (const UanHeaderWakeup &wakeup);
+  bool SendWUAlone (const UanHeaderWakeup &wakeup);
 
 
 
@@ -33,4 +33,10 @@ TypeId UanMac::GetTypeId (void)
   return tid;
 }
 
+bool
+UanMac::Relay (Ptr<Packet> pkt, const Address &nextHop)
+{
+  return Enqueue (pkt, nextHop, 0);
+}
+
 } // namespace ns3
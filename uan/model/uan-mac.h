@@ -77,6 +77,17 @@ public:
    * \return True if packet was successfully enqueued.
    */
   virtual bool Enqueue (Ptr<Packet> pkt, const Address &dest, uint16_t protocolNumber) = 0;
+  /**
+   * Enqueue a packet forwarded on behalf of another node.
+   *
+   * MACs that schedule relayed traffic apart from local traffic
+   * override this; the default is Enqueue.
+   *
+   * \param pkt Packet to be forwarded.
+   * \param nextHop Neighbor the packet is handed to.
+   * \return True if packet was successfully enqueued.
+   */
+  virtual bool Relay (Ptr<Packet> pkt, const Address &nextHop);
   /**
    * Set the callback to forward packets up to higher layers.
    * 
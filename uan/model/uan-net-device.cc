@@ -28,6 +28,8 @@
 #include "uan-mac.h"
 #include "uan-channel.h"
 #include "uan-transducer.h"
+#include "uan-routing-table.h"
+#include "uan-header-common.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -56,6 +58,7 @@ UanNetDevice::Clear ()
     }
   m_cleared = true;
   m_node = 0;
+  m_routing = 0;
   if (m_channel)
     {
       m_channel->Clear ();
@@ -108,12 +111,20 @@ UanNetDevice::GetTypeId ()
                    MakePointerAccessor (&UanNetDevice::GetTransducer,
                                         &UanNetDevice::SetTransducer),
                    MakePointerChecker<UanTransducer> ())
+    .AddAttribute ("RoutingTable", "Next hop table for multi-hop operation.",
+                   PointerValue (),
+                   MakePointerAccessor (&UanNetDevice::GetRoutingTable,
+                                        &UanNetDevice::SetRoutingTable),
+                   MakePointerChecker<UanRoutingTable> ())
     .AddTraceSource ("Rx", "Received payload from the MAC layer.",
                      MakeTraceSourceAccessor (&UanNetDevice::m_rxLogger),
                      "ns3::UanNetDevice::RxTxTracedCallback")
     .AddTraceSource ("Tx", "Send payload to the MAC layer.",
                      MakeTraceSourceAccessor (&UanNetDevice::m_txLogger),
                      "ns3::UanNetDevice::RxTxTracedCallback")
+    .AddTraceSource ("Relay", "Relay payload for another node.",
+                     MakeTraceSourceAccessor (&UanNetDevice::m_relayLogger),
+                     "ns3::UanNetDevice::RxTxTracedCallback")
   ;
   return tid;
 }
@@ -291,7 +302,15 @@ UanNetDevice::IsPointToPoint () const
 bool
 UanNetDevice::Send (Ptr<Packet> packet, const Address &dest, uint16_t protocolNumber)
 {
-  return m_mac->Enqueue (packet, dest, protocolNumber);
+  if (m_routing == 0)
+    {
+      return m_mac->Enqueue (packet, dest, protocolNumber);
+    }
+
+  UanAddress udest = UanAddress::ConvertFrom (dest);
+  UanHeaderRoute route (UanAddress::ConvertFrom (GetAddress ()), udest);
+  packet->AddHeader (route);
+  return m_mac->Enqueue (packet, m_routing->GetNextHop (udest), protocolNumber);
 }
 
 bool
@@ -328,9 +347,32 @@ UanNetDevice::SetReceiveCallback (NetDevice::ReceiveCallback cb)
 void
 UanNetDevice::ForwardUp (Ptr<Packet> pkt, const UanAddress &src)
 {
-  NS_LOG_DEBUG ("Forwarding packet up to application");
-  m_rxLogger (pkt, src);
-  m_forwardUp (this, pkt, 0, src);
+  if (m_routing == 0)
+    {
+      NS_LOG_DEBUG ("Forwarding packet up to application");
+      m_rxLogger (pkt, src);
+      m_forwardUp (this, pkt, 0, src);
+      return;
+    }
+
+  // Strip the route header from a copy, the MAC may still hold the packet
+  pkt = pkt->Copy ();
+  UanHeaderRoute route;
+  pkt->RemoveHeader (route);
+  UanAddress target = route.GetFinal ();
+  if (target == UanAddress::ConvertFrom (GetAddress ()) || target == UanAddress::GetBroadcast ())
+    {
+      NS_LOG_DEBUG ("Forwarding packet from " << route.GetOrigin () << " up to application");
+      m_rxLogger (pkt, route.GetOrigin ());
+      m_forwardUp (this, pkt, 0, route.GetOrigin ());
+      return;
+    }
+
+  UanAddress next = m_routing->GetNextHop (target);
+  NS_LOG_DEBUG ("Relaying packet from " << route.GetOrigin () << " to " << target << " via " << next);
+  pkt->AddHeader (route);
+  m_relayLogger (pkt, next);
+  m_mac->Relay (pkt, next);
 
 }
 
@@ -390,6 +432,18 @@ UanNetDevice::SetAddress (Address address)
   m_mac->SetAddress (UanAddress::ConvertFrom (address));
 }
 
+void
+UanNetDevice::SetRoutingTable (Ptr<UanRoutingTable> routing)
+{
+  m_routing = routing;
+}
+
+Ptr<UanRoutingTable>
+UanNetDevice::GetRoutingTable (void) const
+{
+  return m_routing;
+}
+
 void
 UanNetDevice::SetSleepMode (bool sleep)
 {
@@ -33,6 +33,7 @@ class UanChannel;
 class UanPhy;
 class UanMac;
 class UanTransducer;
+class UanRoutingTable;
 
 /**
  * \defgroup uan UAN Models
@@ -121,6 +122,23 @@ public:
    */
   void SetSleepMode (bool sleep);
 
+  /**
+   * Route packets over several hops.
+   *
+   * With a table attached, outgoing packets carry a UanHeaderRoute and
+   * go to the table's next hop; received packets for other nodes are
+   * handed back to the MAC as relayed traffic.
+   *
+   * \param routing The routing table, or 0 for single hop.
+   */
+  void SetRoutingTable (Ptr<UanRoutingTable> routing);
+  /**
+   * Get the routing table used by this device.
+   *
+   * \return The routing table, or 0.
+   */
+  Ptr<UanRoutingTable> GetRoutingTable (void) const;
+
   // Inherited methods
   virtual void SetIfIndex (const uint32_t index);
   virtual uint32_t GetIfIndex (void) const;
@@ -173,6 +191,7 @@ private:
   Ptr<UanChannel> m_channel;       //!< The channel attached to this device.
   Ptr<UanMac> m_mac;               //!< The MAC layer attached to this device.
   Ptr<UanPhy> m_phy;               //!< The PHY layer attached to this device.
+  Ptr<UanRoutingTable> m_routing;  //!< Next hop table, 0 for single hop.
 
   //unused: std::string m_name;
   uint32_t m_ifIndex;              //!< The interface index of this device.
@@ -185,6 +204,8 @@ private:
   TracedCallback<Ptr<const Packet>, UanAddress> m_rxLogger;
   /** Trace source triggered when sending to the MAC layer */
   TracedCallback<Ptr<const Packet>, UanAddress> m_txLogger;
+  /** Trace source triggered when relaying a packet for another node, with its next hop. */
+  TracedCallback<Ptr<const Packet>, UanAddress> m_relayLogger;
 
   /** Flag when we've been cleared. */
   bool m_cleared;
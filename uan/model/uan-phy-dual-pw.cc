@@ -249,7 +249,15 @@ UanPhyDualPw::SetEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback cal
 void
 UanPhyDualPw::EnergyDepletionHandler ()
 {
-  NS_LOG_DEBUG ("Not Implemented");
+  m_phy1->EnergyDepletionHandler ();
+  m_phy2->EnergyDepletionHandler ();
+}
+
+void
+UanPhyDualPw::EnergyRechargeHandler ()
+{
+  m_phy1->EnergyRechargeHandler ();
+  m_phy2->EnergyRechargeHandler ();
 }
 
 void
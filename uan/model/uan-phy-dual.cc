@@ -265,7 +265,15 @@ UanPhyDual::UpdatePowerConsumption (const State state)
 void
 UanPhyDual::EnergyDepletionHandler ()
 {
-  NS_LOG_DEBUG ("Not Implemented");
+  m_phy1->EnergyDepletionHandler ();
+  m_phy2->EnergyDepletionHandler ();
+}
+
+void
+UanPhyDual::EnergyRechargeHandler ()
+{
+  m_phy1->EnergyRechargeHandler ();
+  m_phy2->EnergyRechargeHandler ();
 }
 
 void
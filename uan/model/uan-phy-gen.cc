@@ -36,6 +36,9 @@
 #include "ns3/energy-source-container.h"
 #include "ns3/acoustic-modem-energy-model.h"
 
+#include <algorithm>
+#include <limits>
+
 
 namespace ns3 {
 
@@ -358,8 +361,12 @@ UanPhyGen::UanPhyGen ()
     m_rxThreshDb (0),
     m_ccaThreshDb (0),
     m_pktRx (0),
+    m_rxRecvPwrDb (0),
     m_cleared (false),
-    m_disabled (false)
+    m_disabled (false),
+    m_rxModeCount (std::numeric_limits<uint32_t>::max ()),
+    m_pendingTx (0),
+    m_pendingTxMode (0)
 {
   m_pg = CreateObject<UniformRandomVariable> ();
 
@@ -411,11 +418,13 @@ UanPhyGen::Clear ()
       m_sinr = 0;
     }
   m_pktRx = 0;
+  m_pendingTx = 0;
 }
 
 void
 UanPhyGen::DoDispose ()
 {
+  m_wakeupEvent.Cancel ();
   Clear ();
   m_energyCallback.Nullify ();
   UanPhy::DoDispose ();
@@ -472,6 +481,12 @@ UanPhyGen::GetTypeId (void)
                    StringValue ("ns3::UanPhyCalcSinrDefault"),
                    MakePointerAccessor (&UanPhyGen::m_sinr),
                    MakePointerChecker<UanPhyCalcSinr> ())
+    .AddAttribute ("WakeupLatency",
+                   "Time after leaving sleep before the modem can receive or transmit.  "
+                   "A frame sent meanwhile is held until the end of it.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UanPhyGen::m_wakeupLatency),
+                   MakeTimeChecker ())
     .AddTraceSource ("RxOk",
                      "A packet was received successfully.",
                      MakeTraceSourceAccessor (&UanPhyGen::m_rxOkLogger),
@@ -517,6 +532,16 @@ UanPhyGen::EnergyDepletionHandler ()
   m_disabled = true;
 }
 
+void
+UanPhyGen::EnergyRechargeHandler ()
+{
+  NS_LOG_FUNCTION (this);
+  NS_LOG_DEBUG ("Energy recharged at node " << m_device->GetNode ()->GetId () <<
+                ", resuming rx/tx activities");
+
+  m_disabled = false;
+}
+
 void
 UanPhyGen::SendPacket (Ptr<Packet> pkt, uint32_t modeNum)
 {
@@ -534,6 +559,13 @@ UanPhyGen::SendPacket (Ptr<Packet> pkt, uint32_t modeNum)
     }
   else if (m_state == SLEEP)
     {
+      if (m_wakeupEvent.IsRunning () && m_pendingTx == 0)
+        {
+          NS_LOG_DEBUG ("PHY requested to TX while warming up.  Holding packet.");
+          m_pendingTx = pkt;
+          m_pendingTxMode = modeNum;
+          return;
+        }
       NS_LOG_DEBUG ("PHY requested to TX while sleeping.  Dropping packet.");
       return;
     }
@@ -616,7 +648,8 @@ UanPhyGen::StartRxPacket (Ptr<Packet> pkt, double rxPowerDb, UanTxMode txMode, U
       {
         NS_ASSERT (!m_pktRx);
         bool hasmode = false;
-        for (uint32_t i = 0; i < GetNModes (); i++)
+        uint32_t nRxModes = std::min (GetNModes (), m_rxModeCount);
+        for (uint32_t i = 0; i < nRxModes; i++)
           {
             if (txMode.GetUid () == GetMode (i).GetUid ())
               {
@@ -802,6 +835,12 @@ UanPhyGen::GetCcaThresholdDb (void)
   return m_ccaThreshDb;
 }
 
+double
+UanPhyGen::GetRxPowerDb (void) const
+{
+  return m_rxRecvPwrDb;
+}
+
 Ptr<UanChannel>
 UanPhyGen::GetChannel (void) const
 {
@@ -849,31 +888,79 @@ UanPhyGen::SetSleepMode (bool sleep)
 {
   if (sleep)
     {
+      m_wakeupEvent.Cancel ();
+      m_pendingTx = 0;
       m_state = SLEEP;
       if (!m_energyCallback.IsNull ())
         {
           m_energyCallback (SLEEP);
         }
     }
-  else if (m_state == SLEEP)
+  else if (m_state == SLEEP && !m_wakeupEvent.IsRunning ())
     {
-      if (GetInterferenceDb ((Ptr<Packet>) 0) > m_ccaThreshDb)
+      // The modem draws power while it warms up
+      if (!m_energyCallback.IsNull ())
         {
-          m_state = CCABUSY;
-          NotifyListenersCcaStart ();
+          m_energyCallback (IDLE);
         }
-      else
+
+      if (m_wakeupLatency.IsZero ())
         {
-          m_state = IDLE;
+          EndWakeup ();
         }
-
-      if (!m_energyCallback.IsNull ())
+      else
         {
-          m_energyCallback (IDLE);
+          m_wakeupEvent = Simulator::Schedule (m_wakeupLatency, &UanPhyGen::EndWakeup, this);
         }
     }
 }
 
+void
+UanPhyGen::EndWakeup (void)
+{
+  if (GetInterferenceDb ((Ptr<Packet>) 0) > m_ccaThreshDb)
+    {
+      m_state = CCABUSY;
+      NotifyListenersCcaStart ();
+    }
+  else
+    {
+      m_state = IDLE;
+    }
+
+  if (m_pendingTx)
+    {
+      Ptr<Packet> pkt = m_pendingTx;
+      m_pendingTx = 0;
+      SendPacket (pkt, m_pendingTxMode);
+    }
+}
+
+bool
+UanPhyGen::IsWakingUp (void) const
+{
+  return m_wakeupEvent.IsRunning ();
+}
+
+Time
+UanPhyGen::GetWakeupDelayLeft (void) const
+{
+  return m_wakeupEvent.IsRunning () ? Simulator::GetDelayLeft (m_wakeupEvent) : Seconds (0);
+}
+
+Time
+UanPhyGen::GetWakeupLatency (void) const
+{
+  return m_wakeupLatency;
+}
+
+void
+UanPhyGen::SetRxModeCount (uint32_t n)
+{
+  NS_LOG_FUNCTION (this << n);
+  m_rxModeCount = n;
+}
+
 int64_t
 UanPhyGen::AssignStreams (int64_t stream)
 {
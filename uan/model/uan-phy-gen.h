@@ -28,6 +28,7 @@
 #include "ns3/nstime.h"
 #include "ns3/device-energy-model.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/event-id.h"
 #include <list>
 
 namespace ns3 {
@@ -240,6 +241,7 @@ public:
   // Inherited methods
   virtual void SetEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback cb);
   virtual void EnergyDepletionHandler (void);
+  virtual void EnergyRechargeHandler (void);
   virtual void SendPacket (Ptr<Packet> pkt, uint32_t modeNum);
   virtual void RegisterListener (UanPhyListener *listener);
   virtual void StartRxPacket (Ptr<Packet> pkt, double rxPowerDb, UanTxMode txMode, UanPdp pdp);
@@ -275,6 +277,34 @@ public:
   virtual void SetSleepMode (bool sleep);
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * Received power of the last packet the receiver locked onto.  Valid
+   * in the RxOk and RxError trace sinks.
+   *
+   * \return Power in dB re 1 uPa.
+   */
+  double GetRxPowerDb (void) const;
+
+  /**
+   * \return True between SetSleepMode (false) and the end of the
+   *   WakeupLatency warm-up.  The PHY still reports sleep and drops
+   *   rx meanwhile; the first frame handed to SendPacket is held and
+   *   sent when the warm-up ends.
+   */
+  bool IsWakingUp (void) const;
+  /** \return Time left of the warm-up, zero when not waking up. */
+  Time GetWakeupDelayLeft (void) const;
+  /** \return Warm-up time after leaving sleep. */
+  Time GetWakeupLatency (void) const;
+
+  /**
+   * Only lock onto the first n supported modes; the rest are kept for
+   * transmission and only count as interference on reception.
+   *
+   * \param n Number of receive modes, all modes by default.
+   */
+  void SetRxModeCount (uint32_t n);
+
 private:
   /** List of Phy Listeners. */
   typedef std::list<UanPhyListener *> ListenerList;
@@ -307,6 +337,12 @@ private:
   bool m_cleared;                   //!< Flag when we've been cleared.
   bool m_disabled;                  //!< Energy depleted. 
 
+  Time m_wakeupLatency;             //!< Warm-up time after leaving sleep.
+  uint32_t m_rxModeCount;           //!< Leading modes the receiver locks onto.
+  EventId m_wakeupEvent;            //!< End of the warm-up.
+  Ptr<Packet> m_pendingTx;          //!< Frame held until the end of the warm-up.
+  uint32_t m_pendingTxMode;         //!< Mode number of m_pendingTx.
+
   /** Provides uniform random variables. */
   Ptr<UniformRandomVariable> m_pg;
 
@@ -371,6 +407,8 @@ private:
   void RxEndEvent (Ptr<Packet> pkt, double rxPowerDb, UanTxMode txMode);
   /** Event to process end of packet transmission. */
   void TxEndEvent ();
+  /** End of the warm-up after sleep: the receiver is ready. */
+  void EndWakeup (void);
   /**
    * Update energy source with new state.
    *
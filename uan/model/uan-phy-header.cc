@@ -20,12 +20,14 @@
 
 #include "uan-phy-header.h"
 #include "uan-address.h"
+#include "uan-header-packing.h"
 
 namespace ns3 {
 
   NS_OBJECT_ENSURE_REGISTERED (UanPhyHeader);
 
   UanPhyHeader::UanPhyHeader ()
+  : m_type (DATA)
 {
 }
 
@@ -50,13 +52,38 @@ UanPhyHeader::~UanPhyHeader ()
 {
 }
 
+void
+UanPhyHeader::SetFrameType (FrameType type)
+{
+  m_type = type;
+}
+
+UanPhyHeader::FrameType
+UanPhyHeader::GetFrameType (void) const
+{
+  return m_type;
+}
+
+UanPhyHeader::FrameType
+UanPhyHeader::PeekFrameType (Ptr<const Packet> pkt)
+{
+  uint8_t type = 0;
+  pkt->CopyData (&type, 1);
+  return (FrameType) type;
+}
+
 // Inherrited methods
 
 uint32_t
 UanPhyHeader::GetSerializedSize (void) const
 {
   //
-  uint32_t size = 4 //sync bytes
+  if (UanHeaderPacking::IsEnabled ())
+    {
+      // The sync word already marks the start
+      return 4 + 1;
+    }
+  uint32_t size = 4 //frame type + sync bytes
       + 1 // start byte
       + 1 // payload long
       ;
@@ -66,28 +93,34 @@ UanPhyHeader::GetSerializedSize (void) const
 void
 UanPhyHeader::Serialize (Buffer::Iterator start) const
 {
-  start.WriteU32(0);
+  start.WriteU8(m_type);
   start.WriteU8(0);
+  start.WriteU16(0);
+  if (!UanHeaderPacking::IsEnabled ())
+    {
+      start.WriteU8(0);
+    }
   start.WriteU8(0);
 }
 
 uint32_t
 UanPhyHeader::Deserialize (Buffer::Iterator start)
 {
-
+  m_type = (FrameType) start.ReadU8 ();
   return GetSerializedSize ();
 }
 
 void
 UanPhyHeader::Print (std::ostream &os) const
 {
-  os << "UAN Phy Header";
+  os << "UAN Phy Header type=" << (uint32_t) m_type;
 }
 
 
 NS_OBJECT_ENSURE_REGISTERED (UanPhyWUHeader);
 
 UanPhyWUHeader::UanPhyWUHeader ()
+  : m_type (UanPhyHeader::WU)
 {
 }
 
@@ -111,13 +144,25 @@ UanPhyWUHeader::~UanPhyWUHeader ()
 {
 }
 
+void
+UanPhyWUHeader::SetFrameType (UanPhyHeader::FrameType type)
+{
+  m_type = type;
+}
+
+UanPhyHeader::FrameType
+UanPhyWUHeader::GetFrameType (void) const
+{
+  return m_type;
+}
+
 // Inherrited methods
 
 uint32_t
 UanPhyWUHeader::GetSerializedSize (void) const
 {
 //
-uint32_t size = 1 //carrier byte
+uint32_t size = 1 //carrier byte, coding the frame type
     + 1 // preamble byte
     ;
 return size;
@@ -126,22 +171,21 @@ return size;
 void
 UanPhyWUHeader::Serialize (Buffer::Iterator start) const
 {
-  start.WriteU8(0);
+  start.WriteU8(m_type);
   start.WriteU8(0);
 }
 
 uint32_t
 UanPhyWUHeader::Deserialize (Buffer::Iterator start)
 {
-
-
+m_type = (UanPhyHeader::FrameType) start.ReadU8 ();
 return GetSerializedSize ();
 }
 
 void
 UanPhyWUHeader::Print (std::ostream &os) const
 {
-os << "UAN Phy WU Header";
+os << "UAN Phy WU Header type=" << (uint32_t) m_type;
 }
 
 
@@ -178,6 +222,11 @@ uint32_t
 UanPhyTrailer::GetSerializedSize (void) const
 {
 //
+if (UanHeaderPacking::IsEnabled ())
+  {
+    // The length in the header delimits the frame, no stop byte
+    return 1 + 2;
+  }
 uint32_t size = 1 //crc
     + 1 // stop
     + 2 // sync
@@ -190,7 +239,10 @@ UanPhyTrailer::Serialize (Buffer::Iterator start) const
 {
   start.Prev (GetSerializedSize ());
   start.WriteU8(0);
-  start.WriteU8(0);
+  if (!UanHeaderPacking::IsEnabled ())
+    {
+      start.WriteU8(0);
+    }
   start.WriteU16(0);
 }
 
@@ -25,26 +25,53 @@
 #include "ns3/trailer.h"
 #include "ns3/nstime.h"
 #include "ns3/simulator.h"
-#include "ns3/tag.h"
+#include "ns3/packet.h"
 
 namespace ns3 {
 
+/**
+ * \ingroup uan
+ *
+ * Data frame PHY header.  Its first byte, like the first byte of
+ * UanPhyWUHeader, carries the frame type, so the wakeup MACs tell frames
+ * apart with PeekFrameType before removing any header.
+ */
 class UanPhyHeader : public Header
 {
 public:
+  /** Frame types sent by the wakeup MACs. */
+  enum FrameType {WU, WUHE, DATA, CTD, CTS};
+
   UanPhyHeader ();
   virtual ~UanPhyHeader ();
 
   static TypeId GetTypeId (void);
 
+  void SetFrameType (FrameType type);
+  FrameType GetFrameType (void) const;
+
+  /**
+   * \param pkt Packet starting with a UanPhyHeader or a UanPhyWUHeader
+   * \return Frame type in its first byte
+   */
+  static FrameType PeekFrameType (Ptr<const Packet> pkt);
+
   // Inherrited methods
   virtual uint32_t GetSerializedSize (void) const;
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual void Print (std::ostream &os) const;
   virtual TypeId GetInstanceTypeId (void) const;
+
+private:
+  FrameType m_type;
 };
 
+/**
+ * \ingroup uan
+ *
+ * Wakeup tone PHY header, frame type WU by default.
+ */
 class UanPhyWUHeader : public Header
 {
 public:
@@ -53,12 +80,18 @@ public:
 
   static TypeId GetTypeId (void);
 
+  void SetFrameType (UanPhyHeader::FrameType type);
+  UanPhyHeader::FrameType GetFrameType (void) const;
+
   // Inherrited methods
   virtual uint32_t GetSerializedSize (void) const;
   virtual void Serialize (Buffer::Iterator start) const;
   virtual uint32_t Deserialize (Buffer::Iterator start);
   virtual void Print (std::ostream &os) const;
   virtual TypeId GetInstanceTypeId (void) const;
+
+private:
+  UanPhyHeader::FrameType m_type;
 };
 
 class UanPhyTrailer : public Trailer
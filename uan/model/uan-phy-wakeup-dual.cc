@@ -0,0 +1,515 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-phy-wakeup-dual.h"
+#include "uan-tx-mode.h"
+#include "ns3/pointer.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/string.h"
+#include "ns3/log.h"
+#include "ns3/fatal-error.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanPhyWakeupDual");
+
+NS_OBJECT_ENSURE_REGISTERED (UanPhyWakeupDual);
+
+UanPhyWakeupDual::UanPhyWakeupDual ()
+  : UanPhy ()
+{
+  m_dataPhy = CreateObject<UanPhyGen> ();
+  m_wakeupPhy = CreateObject<UanPhyGen> ();
+  m_dataModes = UanPhyGen::GetDefaultModes ();
+  m_wakeupModes = GetDefaultWakeupModes ();
+  m_dataPhy->SetAttribute ("SupportedModes", UanModesListValue (m_dataModes));
+  UpdateWakeupPhyModes ();
+
+  m_dataPhy->TraceConnectWithoutContext ("Tx", MakeCallback (&UanPhyWakeupDual::TxFromSubPhy, this));
+  m_wakeupPhy->TraceConnectWithoutContext ("Tx", MakeCallback (&UanPhyWakeupDual::TxFromSubPhy, this));
+  m_dataPhy->TraceConnectWithoutContext ("RxOk", MakeCallback (&UanPhyWakeupDual::RxOkFromSubPhy, this));
+  m_wakeupPhy->TraceConnectWithoutContext ("RxOk", MakeCallback (&UanPhyWakeupDual::RxOkFromSubPhy, this));
+  m_dataPhy->TraceConnectWithoutContext ("RxError", MakeCallback (&UanPhyWakeupDual::RxErrFromSubPhy, this));
+  m_wakeupPhy->TraceConnectWithoutContext ("RxError", MakeCallback (&UanPhyWakeupDual::RxErrFromSubPhy, this));
+}
+
+UanPhyWakeupDual::~UanPhyWakeupDual ()
+{
+}
+
+TypeId
+UanPhyWakeupDual::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanPhyWakeupDual")
+    .SetParent<UanPhy> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanPhyWakeupDual> ()
+    .AddAttribute ("DataModes",
+                   "List of modes supported by the data PHY.",
+                   UanModesListValue (UanPhyGen::GetDefaultModes ()),
+                   MakeUanModesListAccessor (&UanPhyWakeupDual::GetDataModes, &UanPhyWakeupDual::SetDataModes),
+                   MakeUanModesListChecker ())
+    .AddAttribute ("WakeupModes",
+                   "List of wakeup tone modes, in a band apart from the data modes.",
+                   UanModesListValue (GetDefaultWakeupModes ()),
+                   MakeUanModesListAccessor (&UanPhyWakeupDual::GetWakeupModes, &UanPhyWakeupDual::SetWakeupModes),
+                   MakeUanModesListChecker ())
+    .AddAttribute ("PerModel",
+                   "Functor to calculate PER based on SINR and TxMode, for both PHYs.",
+                   StringValue ("ns3::UanPhyPerGenDefault"),
+                   MakePointerAccessor (&UanPhyWakeupDual::GetPerModel, &UanPhyWakeupDual::SetPerModel),
+                   MakePointerChecker<UanPhyPer> ())
+    .AddAttribute ("SinrModel",
+                   "Functor to calculate SINR, for both PHYs.  The default only counts interferers in an overlapping band.",
+                   StringValue ("ns3::UanPhyCalcSinrDual"),
+                   MakePointerAccessor (&UanPhyWakeupDual::GetSinrModel, &UanPhyWakeupDual::SetSinrModel),
+                   MakePointerChecker<UanPhyCalcSinr> ())
+    .AddAttribute ("DataWakeupLatency",
+                   "Warm-up time of the data PHY after sleep; the wakeup receiver never sleeps.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&UanPhyWakeupDual::GetDataWakeupLatency, &UanPhyWakeupDual::SetDataWakeupLatency),
+                   MakeTimeChecker ())
+    .AddTraceSource ("RxOk",
+                     "A packet was received successfully by either PHY.",
+                     MakeTraceSourceAccessor (&UanPhyWakeupDual::m_rxOkLogger),
+                     "ns3::UanPhy::TracedCallback")
+    .AddTraceSource ("RxError",
+                     "A packet was received unsuccessfully by either PHY.",
+                     MakeTraceSourceAccessor (&UanPhyWakeupDual::m_rxErrLogger),
+                     "ns3::UanPhy::TracedCallback")
+    .AddTraceSource ("Tx",
+                     "Packet transmission beginning on either PHY.",
+                     MakeTraceSourceAccessor (&UanPhyWakeupDual::m_txLogger),
+                     "ns3::UanPhy::TracedCallback")
+  ;
+  return tid;
+}
+
+UanModesList
+UanPhyWakeupDual::GetDefaultWakeupModes (void)
+{
+  UanModesList l;
+  l.AppendMode (UanTxModeFactory::CreateMode (UanTxMode::FSK, 80, 80, 26000, 1000, 2, "WakeupFSK"));
+  return l;
+}
+
+void
+UanPhyWakeupDual::DoDispose (void)
+{
+  Clear ();
+  UanPhy::DoDispose ();
+}
+
+Ptr<UanPhyGen>
+UanPhyWakeupDual::GetDataPhy (void) const
+{
+  return m_dataPhy;
+}
+
+Ptr<UanPhyGen>
+UanPhyWakeupDual::GetWakeupPhy (void) const
+{
+  return m_wakeupPhy;
+}
+
+uint32_t
+UanPhyWakeupDual::GetWakeupPhyDataMode (void) const
+{
+  return m_wakeupModes.GetNModes ();
+}
+
+UanModesList
+UanPhyWakeupDual::GetDataModes (void) const
+{
+  return m_dataModes;
+}
+
+void
+UanPhyWakeupDual::SetDataModes (UanModesList modes)
+{
+  m_dataModes = modes;
+  m_dataPhy->SetAttribute ("SupportedModes", UanModesListValue (modes));
+  UpdateWakeupPhyModes ();
+}
+
+UanModesList
+UanPhyWakeupDual::GetWakeupModes (void) const
+{
+  return m_wakeupModes;
+}
+
+void
+UanPhyWakeupDual::SetWakeupModes (UanModesList modes)
+{
+  m_wakeupModes = modes;
+  UpdateWakeupPhyModes ();
+}
+
+void
+UanPhyWakeupDual::UpdateWakeupPhyModes (void)
+{
+  UanModesList modes = m_wakeupModes;
+  for (uint32_t i = 0; i < m_dataModes.GetNModes (); i++)
+    {
+      modes.AppendMode (m_dataModes[i]);
+    }
+  m_wakeupPhy->SetAttribute ("SupportedModes", UanModesListValue (modes));
+  // Data modes are there to transmit on
+  m_wakeupPhy->SetRxModeCount (m_wakeupModes.GetNModes ());
+}
+
+void
+UanPhyWakeupDual::TxFromSubPhy (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode)
+{
+  m_txLogger (pkt, txPowerDb, mode);
+}
+
+void
+UanPhyWakeupDual::RxOkFromSubPhy (Ptr<const Packet> pkt, double sinr, UanTxMode mode)
+{
+  m_rxOkLogger (pkt, sinr, mode);
+}
+
+void
+UanPhyWakeupDual::RxErrFromSubPhy (Ptr<const Packet> pkt, double sinr, UanTxMode mode)
+{
+  m_rxErrLogger (pkt, sinr, mode);
+}
+
+Ptr<UanPhyPer>
+UanPhyWakeupDual::GetPerModel (void) const
+{
+  PointerValue perValue;
+  m_dataPhy->GetAttribute ("PerModel", perValue);
+  return perValue;
+}
+
+void
+UanPhyWakeupDual::SetPerModel (Ptr<UanPhyPer> per)
+{
+  m_dataPhy->SetAttribute ("PerModel", PointerValue (per));
+  m_wakeupPhy->SetAttribute ("PerModel", PointerValue (per));
+}
+
+Ptr<UanPhyCalcSinr>
+UanPhyWakeupDual::GetSinrModel (void) const
+{
+  PointerValue sinrValue;
+  m_dataPhy->GetAttribute ("SinrModel", sinrValue);
+  return sinrValue;
+}
+
+void
+UanPhyWakeupDual::SetSinrModel (Ptr<UanPhyCalcSinr> sinr)
+{
+  m_dataPhy->SetAttribute ("SinrModel", PointerValue (sinr));
+  m_wakeupPhy->SetAttribute ("SinrModel", PointerValue (sinr));
+}
+
+Time
+UanPhyWakeupDual::GetDataWakeupLatency (void) const
+{
+  TimeValue latency;
+  m_dataPhy->GetAttribute ("WakeupLatency", latency);
+  return latency.Get ();
+}
+
+void
+UanPhyWakeupDual::SetDataWakeupLatency (Time latency)
+{
+  m_dataPhy->SetAttribute ("WakeupLatency", TimeValue (latency));
+}
+
+void
+UanPhyWakeupDual::SetDataEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback callback)
+{
+  NS_LOG_FUNCTION (this);
+  m_dataPhy->SetEnergyModelCallback (callback);
+}
+
+void
+UanPhyWakeupDual::SetWakeupEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback callback)
+{
+  NS_LOG_FUNCTION (this);
+  m_wakeupPhy->SetEnergyModelCallback (callback);
+}
+
+void
+UanPhyWakeupDual::SetEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback callback)
+{
+  NS_FATAL_ERROR ("UanPhyWakeupDual needs one energy model per receiver, "
+                  "see SetDataEnergyModelCallback and SetWakeupEnergyModelCallback");
+}
+
+void
+UanPhyWakeupDual::EnergyDepletionHandler (void)
+{
+  m_dataPhy->EnergyDepletionHandler ();
+  m_wakeupPhy->EnergyDepletionHandler ();
+}
+
+void
+UanPhyWakeupDual::EnergyRechargeHandler (void)
+{
+  m_dataPhy->EnergyRechargeHandler ();
+  m_wakeupPhy->EnergyRechargeHandler ();
+}
+
+void
+UanPhyWakeupDual::SendPacket (Ptr<Packet> pkt, uint32_t modeNum)
+{
+  uint32_t nData = m_dataPhy->GetNModes ();
+  if (modeNum < nData)
+    {
+      m_dataPhy->SendPacket (pkt, modeNum);
+    }
+  else
+    {
+      m_wakeupPhy->SendPacket (pkt, modeNum - nData);
+    }
+}
+
+void
+UanPhyWakeupDual::RegisterListener (UanPhyListener *listener)
+{
+  m_dataPhy->RegisterListener (listener);
+  m_wakeupPhy->RegisterListener (listener);
+}
+
+void
+UanPhyWakeupDual::StartRxPacket (Ptr<Packet> pkt, double rxPowerDb, UanTxMode txMode, UanPdp pdp)
+{
+  // Not called, the transducer delivers to both PHYs directly.
+}
+
+void
+UanPhyWakeupDual::SetReceiveOkCallback (RxOkCallback cb)
+{
+  m_dataPhy->SetReceiveOkCallback (cb);
+  m_wakeupPhy->SetReceiveOkCallback (cb);
+}
+
+void
+UanPhyWakeupDual::SetReceiveErrorCallback (RxErrCallback cb)
+{
+  m_dataPhy->SetReceiveErrorCallback (cb);
+  m_wakeupPhy->SetReceiveErrorCallback (cb);
+}
+
+void
+UanPhyWakeupDual::SetRxGainDb (double gain)
+{
+  m_dataPhy->SetRxGainDb (gain);
+  m_wakeupPhy->SetRxGainDb (gain);
+}
+
+void
+UanPhyWakeupDual::SetTxPowerDb (double txpwr)
+{
+  m_dataPhy->SetTxPowerDb (txpwr);
+  m_wakeupPhy->SetTxPowerDb (txpwr);
+}
+
+void
+UanPhyWakeupDual::SetRxThresholdDb (double thresh)
+{
+  m_dataPhy->SetRxThresholdDb (thresh);
+  m_wakeupPhy->SetRxThresholdDb (thresh);
+}
+
+void
+UanPhyWakeupDual::SetCcaThresholdDb (double thresh)
+{
+  m_dataPhy->SetCcaThresholdDb (thresh);
+  m_wakeupPhy->SetCcaThresholdDb (thresh);
+}
+
+double
+UanPhyWakeupDual::GetRxGainDb (void)
+{
+  return m_dataPhy->GetRxGainDb ();
+}
+
+double
+UanPhyWakeupDual::GetTxPowerDb (void)
+{
+  return m_dataPhy->GetTxPowerDb ();
+}
+
+double
+UanPhyWakeupDual::GetRxThresholdDb (void)
+{
+  return m_dataPhy->GetRxThresholdDb ();
+}
+
+double
+UanPhyWakeupDual::GetCcaThresholdDb (void)
+{
+  return m_dataPhy->GetCcaThresholdDb ();
+}
+
+bool
+UanPhyWakeupDual::IsStateSleep (void)
+{
+  return m_dataPhy->IsStateSleep () && m_wakeupPhy->IsStateSleep ();
+}
+
+bool
+UanPhyWakeupDual::IsStateIdle (void)
+{
+  return m_dataPhy->IsStateIdle () && m_wakeupPhy->IsStateIdle ();
+}
+
+bool
+UanPhyWakeupDual::IsStateBusy (void)
+{
+  return IsStateRx () || IsStateTx () || IsStateCcaBusy ();
+}
+
+bool
+UanPhyWakeupDual::IsStateRx (void)
+{
+  return m_dataPhy->IsStateRx () || m_wakeupPhy->IsStateRx ();
+}
+
+bool
+UanPhyWakeupDual::IsStateTx (void)
+{
+  return m_dataPhy->IsStateTx () || m_wakeupPhy->IsStateTx ();
+}
+
+bool
+UanPhyWakeupDual::IsStateCcaBusy (void)
+{
+  return m_dataPhy->IsStateCcaBusy () || m_wakeupPhy->IsStateCcaBusy ();
+}
+
+Ptr<UanChannel>
+UanPhyWakeupDual::GetChannel (void) const
+{
+  return m_dataPhy->GetChannel ();
+}
+
+Ptr<UanNetDevice>
+UanPhyWakeupDual::GetDevice (void) const
+{
+  return m_dataPhy->GetDevice ();
+}
+
+void
+UanPhyWakeupDual::SetChannel (Ptr<UanChannel> channel)
+{
+  m_dataPhy->SetChannel (channel);
+  m_wakeupPhy->SetChannel (channel);
+}
+
+void
+UanPhyWakeupDual::SetDevice (Ptr<UanNetDevice> device)
+{
+  m_dataPhy->SetDevice (device);
+  m_wakeupPhy->SetDevice (device);
+}
+
+void
+UanPhyWakeupDual::SetMac (Ptr<UanMac> mac)
+{
+  m_dataPhy->SetMac (mac);
+  m_wakeupPhy->SetMac (mac);
+}
+
+void
+UanPhyWakeupDual::NotifyTransStartTx (Ptr<Packet> packet, double txPowerDb, UanTxMode txMode)
+{
+  // Not called, the transducer notifies both PHYs directly.
+}
+
+void
+UanPhyWakeupDual::NotifyIntChange (void)
+{
+  m_dataPhy->NotifyIntChange ();
+  m_wakeupPhy->NotifyIntChange ();
+}
+
+void
+UanPhyWakeupDual::SetTransducer (Ptr<UanTransducer> trans)
+{
+  m_dataPhy->SetTransducer (trans);
+  m_wakeupPhy->SetTransducer (trans);
+}
+
+Ptr<UanTransducer>
+UanPhyWakeupDual::GetTransducer (void)
+{
+  return m_dataPhy->GetTransducer ();
+}
+
+uint32_t
+UanPhyWakeupDual::GetNModes (void)
+{
+  return m_dataModes.GetNModes () + m_wakeupModes.GetNModes ();
+}
+
+UanTxMode
+UanPhyWakeupDual::GetMode (uint32_t n)
+{
+  if (n < m_dataModes.GetNModes ())
+    {
+      return m_dataModes[n];
+    }
+  return m_wakeupModes[n - m_dataModes.GetNModes ()];
+}
+
+Ptr<Packet>
+UanPhyWakeupDual::GetPacketRx (void) const
+{
+  return m_dataPhy->GetPacketRx ();
+}
+
+void
+UanPhyWakeupDual::Clear (void)
+{
+  if (m_dataPhy)
+    {
+      m_dataPhy->Clear ();
+      m_dataPhy = 0;
+    }
+  if (m_wakeupPhy)
+    {
+      m_wakeupPhy->Clear ();
+      m_wakeupPhy = 0;
+    }
+}
+
+void
+UanPhyWakeupDual::SetSleepMode (bool sleep)
+{
+  // The wakeup receiver stays on
+  m_dataPhy->SetSleepMode (sleep);
+}
+
+int64_t
+UanPhyWakeupDual::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  int64_t currentStream = stream;
+  currentStream += m_dataPhy->AssignStreams (currentStream);
+  currentStream += m_wakeupPhy->AssignStreams (currentStream);
+  return (currentStream - stream);
+}
+
+} // namespace ns3
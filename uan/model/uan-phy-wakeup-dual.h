@@ -0,0 +1,176 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_PHY_WAKEUP_DUAL_H_
+#define UAN_PHY_WAKEUP_DUAL_H_
+
+#include "uan-phy.h"
+#include "uan-phy-gen.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Data modem plus wakeup receiver on one transducer.
+ *
+ * Along the lines of UanPhyDual: two UanPhyGen share the transducer of a
+ * single net device, so a transmission reaches each node once and the
+ * transducer hands it to both receivers.  The receivers are told apart
+ * by frequency: the data PHY supports DataModes, the wakeup PHY supports
+ * WakeupModes followed by DataModes, since the wakeup MACs send data
+ * frames through the wakeup front end, which never sleeps.  The wakeup
+ * PHY only receives WakeupModes, so a data frame in the air does not
+ * keep it from hearing a tone.
+ *
+ * The wakeup MACs recognise this PHY in AttachPhy and wire both
+ * receivers themselves.  Seen as a plain UanPhy, modes are DataModes
+ * followed by WakeupModes and sleep mode only affects the data PHY.
+ */
+class UanPhyWakeupDual : public UanPhy
+{
+public:
+  UanPhyWakeupDual ();
+  virtual ~UanPhyWakeupDual ();
+  static TypeId GetTypeId (void);
+
+  /** \return Default wakeup mode list, a narrow FSK tone band above the default data modes. */
+  static UanModesList GetDefaultWakeupModes (void);
+
+  /** \return Main modem receiver. */
+  Ptr<UanPhyGen> GetDataPhy (void) const;
+  /** \return Wakeup receiver. */
+  Ptr<UanPhyGen> GetWakeupPhy (void) const;
+  /** \return Mode number of the first data mode on the wakeup PHY. */
+  uint32_t GetWakeupPhyDataMode (void) const;
+
+  UanModesList GetDataModes (void) const;
+  void SetDataModes (UanModesList modes);
+  UanModesList GetWakeupModes (void) const;
+  void SetWakeupModes (UanModesList modes);
+  Ptr<UanPhyPer> GetPerModel (void) const;
+  void SetPerModel (Ptr<UanPhyPer> per);
+  Ptr<UanPhyCalcSinr> GetSinrModel (void) const;
+  void SetSinrModel (Ptr<UanPhyCalcSinr> sinr);
+  Time GetDataWakeupLatency (void) const;
+  void SetDataWakeupLatency (Time latency);
+
+  /**
+   * \param callback State change callback of the data modem's energy model.
+   */
+  void SetDataEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback callback);
+  /**
+   * \param callback State change callback of the wakeup receiver's energy model.
+   */
+  void SetWakeupEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback callback);
+
+  // Inherited methods
+  /**
+   * Fatal: one energy model cannot follow two receivers that change
+   * state independently.  Use SetDataEnergyModelCallback and
+   * SetWakeupEnergyModelCallback, as UanWakeupHelper does.
+   *
+   * \param callback Ignored.
+   */
+  virtual void SetEnergyModelCallback (DeviceEnergyModel::ChangeStateCallback callback);
+  virtual void EnergyDepletionHandler (void);
+  virtual void EnergyRechargeHandler (void);
+  virtual void SendPacket (Ptr<Packet> pkt, uint32_t modeNum);
+  virtual void RegisterListener (UanPhyListener *listener);
+  virtual void StartRxPacket (Ptr<Packet> pkt, double rxPowerDb, UanTxMode txMode, UanPdp pdp);
+  virtual void SetReceiveOkCallback (RxOkCallback cb);
+  virtual void SetReceiveErrorCallback (RxErrCallback cb);
+  virtual void SetRxGainDb (double gain);
+  virtual void SetTxPowerDb (double txpwr);
+  virtual void SetRxThresholdDb (double thresh);
+  virtual void SetCcaThresholdDb (double thresh);
+  virtual double GetRxGainDb (void);
+  virtual double GetTxPowerDb (void);
+  virtual double GetRxThresholdDb (void);
+  virtual double GetCcaThresholdDb (void);
+  virtual bool IsStateSleep (void);
+  virtual bool IsStateIdle (void);
+  virtual bool IsStateBusy (void);
+  virtual bool IsStateRx (void);
+  virtual bool IsStateTx (void);
+  virtual bool IsStateCcaBusy (void);
+  virtual Ptr<UanChannel> GetChannel (void) const;
+  virtual Ptr<UanNetDevice> GetDevice (void) const;
+  virtual void SetChannel (Ptr<UanChannel> channel);
+  virtual void SetDevice (Ptr<UanNetDevice> device);
+  virtual void SetMac (Ptr<UanMac> mac);
+  virtual void NotifyTransStartTx (Ptr<Packet> packet, double txPowerDb, UanTxMode txMode);
+  virtual void NotifyIntChange (void);
+  virtual void SetTransducer (Ptr<UanTransducer> trans);
+  virtual Ptr<UanTransducer> GetTransducer (void);
+  virtual uint32_t GetNModes (void);
+  virtual UanTxMode GetMode (uint32_t n);
+  virtual Ptr<Packet> GetPacketRx (void) const;
+  virtual void Clear (void);
+  virtual void SetSleepMode (bool sleep);
+  virtual int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /** Push WakeupModes + DataModes to the wakeup PHY. */
+  void UpdateWakeupPhyModes (void);
+
+  /**
+   * Forward a sub-PHY Tx trace.
+   *
+   * \param pkt The packet.
+   * \param txPowerDb Transmit power.
+   * \param mode Transmit mode.
+   */
+  void TxFromSubPhy (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode);
+  /**
+   * Forward a sub-PHY RxOk trace.
+   *
+   * \param pkt The packet.
+   * \param sinr The SINR.
+   * \param mode Receive mode.
+   */
+  void RxOkFromSubPhy (Ptr<const Packet> pkt, double sinr, UanTxMode mode);
+  /**
+   * Forward a sub-PHY RxError trace.
+   *
+   * \param pkt The packet.
+   * \param sinr The SINR.
+   * \param mode Receive mode.
+   */
+  void RxErrFromSubPhy (Ptr<const Packet> pkt, double sinr, UanTxMode mode);
+
+  Ptr<UanPhyGen> m_dataPhy;
+  Ptr<UanPhyGen> m_wakeupPhy;
+  UanModesList m_dataModes;
+  UanModesList m_wakeupModes;
+
+  /** A packet was received successfully by either PHY. */
+  ns3::TracedCallback<Ptr<const Packet>, double, UanTxMode > m_rxOkLogger;
+  /** A packet was received with errors by either PHY. */
+  ns3::TracedCallback<Ptr<const Packet>, double, UanTxMode > m_rxErrLogger;
+  /** A packet was sent from either PHY. */
+  ns3::TracedCallback<Ptr<const Packet>, double, UanTxMode > m_txLogger;
+};
+
+} // namespace ns3
+
+#endif /* UAN_PHY_WAKEUP_DUAL_H_ */
@@ -223,6 +223,10 @@ public:
    * Handle the energy depletion event.
    */
   virtual void EnergyDepletionHandler (void) = 0;
+  /**
+   * Handle the energy recharged event.
+   */
+  virtual void EnergyRechargeHandler (void) = 0;
   /**
    * Send a packet using a specific transmission mode.
    *
@@ -0,0 +1,311 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-relay-queue.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanRelayQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (UanRelayQueue);
+
+UanRelayQueue::UanRelayQueue ()
+  : m_last (UanAddress::GetBroadcast ()),
+    m_currentRelay (false),
+    m_selected (false),
+    m_relayWeight (2),
+    m_localWeight (1),
+    m_relayCredit (0),
+    m_localCredit (0),
+    m_maxRelay (10),
+    m_maxLocal (10),
+    m_blockTime (Seconds (2)),
+    m_relayLength (0),
+    m_localLength (0)
+{
+  m_current = m_hops.end ();
+}
+
+UanRelayQueue::~UanRelayQueue ()
+{
+}
+
+TypeId
+UanRelayQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanRelayQueue")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanRelayQueue> ()
+    .AddAttribute ("RelayWeight",
+                   "Relayed packets served per round.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&UanRelayQueue::m_relayWeight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("LocalWeight",
+                   "Locally generated packets served per round.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&UanRelayQueue::m_localWeight),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxRelayPackets",
+                   "Maximum relayed packets queued over all next hops.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&UanRelayQueue::m_maxRelay),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MaxLocalPackets",
+                   "Maximum local packets queued over all next hops.",
+                   UintegerValue (10),
+                   MakeUintegerAccessor (&UanRelayQueue::m_maxLocal),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("BlockTime",
+                   "How long a next hop that did not answer is skipped.",
+                   TimeValue (Seconds (2)),
+                   MakeTimeAccessor (&UanRelayQueue::m_blockTime),
+                   MakeTimeChecker ())
+    .AddTraceSource ("RelayQueueLength",
+                     "Number of relayed packets queued.",
+                     MakeTraceSourceAccessor (&UanRelayQueue::m_relayLength),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("LocalQueueLength",
+                     "Number of local packets queued.",
+                     MakeTraceSourceAccessor (&UanRelayQueue::m_localLength),
+                     "ns3::TracedValueCallback::Uint32")
+  ;
+  return tid;
+}
+
+void
+UanRelayQueue::DoDispose (void)
+{
+  m_hops.clear ();
+  m_current = m_hops.end ();
+  m_selected = false;
+  Object::DoDispose ();
+}
+
+bool
+UanRelayQueue::Enqueue (Ptr<Packet> pkt, UanAddress nextHop, bool relay)
+{
+  if (relay ? m_relayLength >= m_maxRelay : m_localLength >= m_maxLocal)
+    {
+      NS_LOG_DEBUG ("Dropping " << (relay ? "relay" : "local") << " packet for " << nextHop << ", queue full");
+      return false;
+    }
+
+  HopQueue &hop = m_hops[nextHop];
+  if (relay)
+    {
+      hop.relay.push_back (pkt);
+      m_relayLength++;
+    }
+  else
+    {
+      hop.local.push_back (pkt);
+      m_localLength++;
+    }
+  return true;
+}
+
+UanRelayQueue::HopMap::iterator
+UanRelayQueue::FindHop (bool relay, bool blocked)
+{
+  if (m_hops.empty ())
+    {
+      return m_hops.end ();
+    }
+
+  // Start right after the last hop served
+  HopMap::iterator start = m_hops.upper_bound (m_last);
+  if (start == m_hops.end ())
+    {
+      start = m_hops.begin ();
+    }
+
+  Time now = Simulator::Now ();
+  HopMap::iterator it = start;
+  do
+    {
+      const HopQueue &hop = it->second;
+      bool pending = relay ? !hop.relay.empty () : !hop.local.empty ();
+      if (pending && (blocked || hop.blockedUntil <= now))
+        {
+          return it;
+        }
+      if (++it == m_hops.end ())
+        {
+          it = m_hops.begin ();
+        }
+    }
+  while (it != start);
+
+  return m_hops.end ();
+}
+
+Ptr<Packet>
+UanRelayQueue::Select (void)
+{
+  m_selected = false;
+  if (IsEmpty ())
+    {
+      return 0;
+    }
+
+  if (m_relayCredit == 0 && m_localCredit == 0)
+    {
+      m_relayCredit = m_relayWeight;
+      m_localCredit = m_localWeight;
+    }
+
+  // Class order: the one with credit left first, relay on ties
+  bool order[2];
+  order[0] = m_relayCredit > 0 || m_localCredit == 0;
+  order[1] = !order[0];
+
+  // Unblocked hops first; blocked ones only if nothing else can go
+  for (uint32_t pass = 0; pass < 2 && !m_selected; pass++)
+    {
+      for (uint32_t c = 0; c < 2 && !m_selected; c++)
+        {
+          HopMap::iterator it = FindHop (order[c], pass == 1);
+          if (it != m_hops.end ())
+            {
+              m_current = it;
+              m_currentRelay = order[c];
+              m_selected = true;
+            }
+        }
+    }
+
+  return Front ();
+}
+
+Ptr<Packet>
+UanRelayQueue::Front (void) const
+{
+  if (!m_selected)
+    {
+      return 0;
+    }
+  return m_currentRelay ? m_current->second.relay.front () : m_current->second.local.front ();
+}
+
+void
+UanRelayQueue::Pop (void)
+{
+  if (!m_selected)
+    {
+      return;
+    }
+  m_selected = false;
+
+  HopQueue &hop = m_current->second;
+  if (m_currentRelay)
+    {
+      hop.relay.pop_front ();
+      m_relayLength--;
+      if (m_relayCredit > 0)
+        {
+          m_relayCredit--;
+        }
+    }
+  else
+    {
+      hop.local.pop_front ();
+      m_localLength--;
+      if (m_localCredit > 0)
+        {
+          m_localCredit--;
+        }
+    }
+  m_last = m_current->first;
+  if (hop.relay.empty () && hop.local.empty ())
+    {
+      m_hops.erase (m_current);
+    }
+  m_current = m_hops.end ();
+}
+
+void
+UanRelayQueue::Block (UanAddress nextHop)
+{
+  HopMap::iterator it = m_hops.find (nextHop);
+  if (it == m_hops.end ())
+    {
+      return;
+    }
+  NS_LOG_DEBUG ("Blocking next hop " << nextHop << " for " << m_blockTime.GetSeconds () << " s");
+  it->second.blockedUntil = Simulator::Now () + m_blockTime;
+}
+
+void
+UanRelayQueue::Unblock (UanAddress nextHop)
+{
+  HopMap::iterator it = m_hops.find (nextHop);
+  if (it != m_hops.end ())
+    {
+      it->second.blockedUntil = Seconds (0);
+    }
+}
+
+bool
+UanRelayQueue::IsBlocked (UanAddress nextHop) const
+{
+  HopMap::const_iterator it = m_hops.find (nextHop);
+  return it != m_hops.end () && it->second.blockedUntil > Simulator::Now ();
+}
+
+uint32_t
+UanRelayQueue::GetSize (void) const
+{
+  return m_relayLength + m_localLength;
+}
+
+uint32_t
+UanRelayQueue::GetRelaySize (void) const
+{
+  return m_relayLength;
+}
+
+uint32_t
+UanRelayQueue::GetLocalSize (void) const
+{
+  return m_localLength;
+}
+
+uint32_t
+UanRelayQueue::GetSize (UanAddress nextHop) const
+{
+  HopMap::const_iterator it = m_hops.find (nextHop);
+  if (it == m_hops.end ())
+    {
+      return 0;
+    }
+  return it->second.relay.size () + it->second.local.size ();
+}
+
+bool
+UanRelayQueue::IsEmpty (void) const
+{
+  return GetSize () == 0;
+}
+
+} // namespace ns3
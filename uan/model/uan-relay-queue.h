@@ -0,0 +1,127 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_RELAY_QUEUE_H_
+#define UAN_RELAY_QUEUE_H_
+
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-value.h"
+#include "uan-address.h"
+
+#include <deque>
+#include <map>
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Forwarding scheduler for the MACA MACs.
+ *
+ * Packets are kept in one virtual queue per next hop, split into relayed
+ * and locally generated traffic.  The two classes are served in weighted
+ * round robin (RelayWeight:LocalWeight) and next hops round robin within
+ * a class.  A next hop that did not answer can be blocked for a while so
+ * its packets do not hold back traffic for the other neighbors; blocked
+ * hops are only served when nothing else is eligible.
+ *
+ * Select () fixes the packet the handshake is about; Front () returns it
+ * and Pop () removes it once sent.
+ */
+class UanRelayQueue : public Object
+{
+public:
+  UanRelayQueue ();
+  virtual ~UanRelayQueue ();
+  static TypeId GetTypeId (void);
+
+  /**
+   * \param pkt Packet, MAC header included
+   * \param nextHop Destination of the MAC handshake
+   * \param relay True for forwarded traffic, false for local
+   * \return False if the class is full and the packet was dropped.
+   */
+  bool Enqueue (Ptr<Packet> pkt, UanAddress nextHop, bool relay);
+  /**
+   * Pick the next packet to serve.
+   * \return The packet, or 0 if the queue is empty.
+   */
+  Ptr<Packet> Select (void);
+  /** \return The packet picked by the last Select, or 0. */
+  Ptr<Packet> Front (void) const;
+  /** Remove the packet picked by the last Select and charge its class. */
+  void Pop (void);
+
+  /**
+   * Skip nextHop until delay has elapsed or it is heard again.
+   * \param nextHop Neighbor that did not answer
+   */
+  void Block (UanAddress nextHop);
+  void Unblock (UanAddress nextHop);
+  bool IsBlocked (UanAddress nextHop) const;
+
+  uint32_t GetSize (void) const;
+  uint32_t GetRelaySize (void) const;
+  uint32_t GetLocalSize (void) const;
+  /** \return Packets waiting for nextHop. */
+  uint32_t GetSize (UanAddress nextHop) const;
+  bool IsEmpty (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  struct HopQueue
+  {
+    std::deque<Ptr<Packet> > relay;
+    std::deque<Ptr<Packet> > local;
+    Time blockedUntil;
+  };
+  typedef std::map<UanAddress, HopQueue> HopMap;
+
+  /**
+   * Next hop after m_last with packets of the class.
+   * \param relay Class
+   * \param blocked Whether blocked hops are eligible
+   * \return m_hops.end () if none.
+   */
+  HopMap::iterator FindHop (bool relay, bool blocked);
+
+  HopMap m_hops;
+  UanAddress m_last;          //!< Last next hop served, for round robin
+  HopMap::iterator m_current; //!< Hop of the selected packet
+  bool m_currentRelay;        //!< Class of the selected packet
+  bool m_selected;
+
+  uint32_t m_relayWeight;
+  uint32_t m_localWeight;
+  uint32_t m_relayCredit;     //!< Relay packets left this round, refilled from m_relayWeight
+  uint32_t m_localCredit;     //!< Local packets left this round, refilled from m_localWeight
+  uint32_t m_maxRelay;
+  uint32_t m_maxLocal;
+  Time m_blockTime;
+
+  TracedValue<uint32_t> m_relayLength;
+  TracedValue<uint32_t> m_localLength;
+};
+
+} // namespace ns3
+
+#endif /* UAN_RELAY_QUEUE_H_ */
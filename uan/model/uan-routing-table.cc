@@ -0,0 +1,193 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-routing-table.h"
+#include "uan-net-device.h"
+#include "uan-channel.h"
+#include "uan-prop-model.h"
+#include "uan-phy.h"
+#include "ns3/node.h"
+#include "ns3/mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanRoutingTable");
+
+NS_OBJECT_ENSURE_REGISTERED (UanRoutingTable);
+
+UanRoutingTable::UanRoutingTable ()
+  : m_maxPathLossDb (60)
+{
+}
+
+UanRoutingTable::~UanRoutingTable ()
+{
+}
+
+TypeId
+UanRoutingTable::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanRoutingTable")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanRoutingTable> ()
+    .AddAttribute ("MaxPathLossDb",
+                   "Highest path loss of a link ComputeRoutes may use.",
+                   DoubleValue (60),
+                   MakeDoubleAccessor (&UanRoutingTable::m_maxPathLossDb),
+                   MakeDoubleChecker<double> ())
+  ;
+  return tid;
+}
+
+void
+UanRoutingTable::SetRoute (UanAddress dest, UanAddress nextHop)
+{
+  uint32_t index = dest.GetAsInt ();
+  if (index >= m_nextHop.size ())
+    {
+      m_nextHop.resize (index + 1, UanAddress::GetBroadcast ());
+    }
+  m_nextHop[index] = nextHop;
+}
+
+void
+UanRoutingTable::RemoveRoute (UanAddress dest)
+{
+  uint32_t index = dest.GetAsInt ();
+  if (index < m_nextHop.size ())
+    {
+      m_nextHop[index] = UanAddress::GetBroadcast ();
+    }
+}
+
+void
+UanRoutingTable::Clear (void)
+{
+  m_nextHop.clear ();
+}
+
+bool
+UanRoutingTable::HasRoute (UanAddress dest) const
+{
+  uint32_t index = dest.GetAsInt ();
+  return index < m_nextHop.size () && m_nextHop[index] != UanAddress::GetBroadcast ();
+}
+
+UanAddress
+UanRoutingTable::GetNextHop (UanAddress dest) const
+{
+  return HasRoute (dest) ? m_nextHop[dest.GetAsInt ()] : dest;
+}
+
+uint32_t
+UanRoutingTable::ComputeRoutes (Ptr<UanNetDevice> device)
+{
+  Ptr<UanChannel> channel = DynamicCast<UanChannel> (device->GetChannel ());
+  NS_ASSERT_MSG (channel, "Device is not attached to a channel");
+  Ptr<UanPropModel> prop = channel->GetPropagationModel ();
+
+  uint32_t n = channel->GetNDevices ();
+  std::vector<Ptr<UanNetDevice> > devs (n);
+  std::vector<Ptr<MobilityModel> > pos (n);
+  uint32_t self = n;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      devs[i] = DynamicCast<UanNetDevice> (channel->GetDevice (i));
+      pos[i] = devs[i]->GetNode ()->GetObject<MobilityModel> ();
+      NS_ASSERT_MSG (pos[i], "Node " << devs[i]->GetNode ()->GetId () << " has no mobility model");
+      if (devs[i] == device)
+        {
+          self = i;
+        }
+    }
+  NS_ASSERT (self < n);
+
+  // Dijkstra on (hops, path loss), dense since n is small and this runs once
+  double inf = std::numeric_limits<double>::infinity ();
+  std::vector<uint32_t> hops (n, std::numeric_limits<uint32_t>::max ());
+  std::vector<double> loss (n, inf);
+  std::vector<uint32_t> first (n, n);  // First hop on the path from self
+  std::vector<bool> done (n, false);
+  hops[self] = 0;
+  loss[self] = 0;
+
+  for (uint32_t k = 0; k < n; k++)
+    {
+      uint32_t u = n;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          if (!done[i] && loss[i] < inf
+              && (u == n || hops[i] < hops[u] || (hops[i] == hops[u] && loss[i] < loss[u])))
+            {
+              u = i;
+            }
+        }
+      if (u == n)
+        {
+          break;
+        }
+      done[u] = true;
+
+      UanTxMode mode = devs[u]->GetPhy ()->GetMode (0);
+      for (uint32_t v = 0; v < n; v++)
+        {
+          if (done[v])
+            {
+              continue;
+            }
+          double l = prop->GetPathLossDb (pos[u], pos[v], mode);
+          if (l > m_maxPathLossDb)
+            {
+              continue;
+            }
+          if (hops[u] + 1 < hops[v] || (hops[u] + 1 == hops[v] && loss[u] + l < loss[v]))
+            {
+              hops[v] = hops[u] + 1;
+              loss[v] = loss[u] + l;
+              first[v] = (u == self) ? v : first[u];
+            }
+        }
+    }
+
+  Clear ();
+  uint32_t reachable = 0;
+  UanAddress selfAddr = UanAddress::ConvertFrom (device->GetAddress ());
+  for (uint32_t v = 0; v < n; v++)
+    {
+      if (v == self || first[v] == n)
+        {
+          continue;
+        }
+      reachable++;
+      UanAddress dest = UanAddress::ConvertFrom (devs[v]->GetAddress ());
+      UanAddress next = UanAddress::ConvertFrom (devs[first[v]]->GetAddress ());
+      if (dest != next)
+        {
+          SetRoute (dest, next);
+          NS_LOG_DEBUG ("Node " << selfAddr << " route to " << dest << " via " << next << ", " << hops[v] << " hops");
+        }
+    }
+  return reachable;
+}
+
+} // namespace ns3
@@ -0,0 +1,84 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_ROUTING_TABLE_H_
+#define UAN_ROUTING_TABLE_H_
+
+#include "ns3/object.h"
+#include "uan-address.h"
+
+#include <vector>
+
+namespace ns3 {
+
+class UanNetDevice;
+
+/**
+ * \ingroup uan
+ *
+ * Static next hop table for multi-hop UAN fields.
+ *
+ * A flat array indexed by destination address, so the lookup done for
+ * every packet is O(1).  Destinations without an entry are assumed to
+ * be neighbors.  Routes are set by hand or computed once at setup time
+ * by ComputeRoutes, a shortest path (fewest hops, then least total path
+ * loss) over the links the channel's propagation model rates usable.
+ *
+ * Attached to a UanNetDevice, which then adds a UanHeaderRoute to each
+ * packet and relays packets not addressed to it.
+ */
+class UanRoutingTable : public Object
+{
+public:
+  UanRoutingTable ();
+  virtual ~UanRoutingTable ();
+  static TypeId GetTypeId (void);
+
+  /**
+   * \param dest Final destination
+   * \param nextHop Neighbor to send packets for dest to
+   */
+  void SetRoute (UanAddress dest, UanAddress nextHop);
+  void RemoveRoute (UanAddress dest);
+  void Clear (void);
+  bool HasRoute (UanAddress dest) const;
+  /**
+   * \param dest Final destination
+   * \return Next hop to dest, dest itself if there is no route.
+   */
+  UanAddress GetNextHop (UanAddress dest) const;
+
+  /**
+   * Fill the table for device from the devices on its channel.
+   *
+   * A link is usable if its path loss, at the first mode of the sender's
+   * PHY, is at most MaxPathLossDb.  Nodes need a MobilityModel.
+   *
+   * \param device Device the table is for
+   * \return Number of destinations reachable.
+   */
+  uint32_t ComputeRoutes (Ptr<UanNetDevice> device);
+
+private:
+  std::vector<UanAddress> m_nextHop;  //!< Indexed by destination, broadcast if none
+  double m_maxPathLossDb;
+};
+
+} // namespace ns3
+
+#endif /* UAN_ROUTING_TABLE_H_ */
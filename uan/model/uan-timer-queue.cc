@@ -0,0 +1,179 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "uan-timer-queue.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("UanTimerQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (UanTimerQueue);
+
+UanTimerQueue::UanTimerQueue ()
+  : m_eventTime (Seconds (0)),
+    m_expiring (false),
+    m_scheduledEvents (0)
+{
+}
+
+UanTimerQueue::~UanTimerQueue ()
+{
+  // The queue is not aggregated, so it may never see DoDispose
+  m_event.Cancel ();
+}
+
+TypeId
+UanTimerQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::UanTimerQueue")
+    .SetParent<Object> ()
+    .SetGroupName ("Uan")
+    .AddConstructor<UanTimerQueue> ()
+  ;
+  return tid;
+}
+
+void
+UanTimerQueue::DoDispose (void)
+{
+  CancelAll ();
+  Object::DoDispose ();
+}
+
+uint32_t
+UanTimerQueue::Add (std::string name, Callback<void> expire)
+{
+  Entry entry;
+  entry.name = name;
+  entry.expire = expire;
+  entry.running = false;
+  entry.pos = m_deadlines.end ();
+  m_timers.push_back (entry);
+  return m_timers.size () - 1;
+}
+
+void
+UanTimerQueue::Schedule (uint32_t timer, Time delay)
+{
+  NS_ASSERT (timer < m_timers.size ());
+  Entry &entry = m_timers[timer];
+  NS_ASSERT_MSG (!entry.running, "Timer " << entry.name << " is still running while re-scheduling.");
+  entry.running = true;
+  // Equal deadlines expire in scheduling order, as simulator events do
+  entry.pos = m_deadlines.insert (m_deadlines.upper_bound (Simulator::Now () + delay),
+                                  std::make_pair (Simulator::Now () + delay, timer));
+  Arm ();
+}
+
+void
+UanTimerQueue::Cancel (uint32_t timer)
+{
+  NS_ASSERT (timer < m_timers.size ());
+  Entry &entry = m_timers[timer];
+  if (!entry.running)
+    {
+      return;
+    }
+  entry.running = false;
+  m_deadlines.erase (entry.pos);
+  entry.pos = m_deadlines.end ();
+}
+
+void
+UanTimerQueue::CancelAll (void)
+{
+  for (uint32_t i = 0; i < m_timers.size (); i++)
+    {
+      m_timers[i].running = false;
+      m_timers[i].pos = m_deadlines.end ();
+    }
+  m_deadlines.clear ();
+  m_event.Cancel ();
+}
+
+bool
+UanTimerQueue::IsRunning (uint32_t timer) const
+{
+  NS_ASSERT (timer < m_timers.size ());
+  return m_timers[timer].running;
+}
+
+Time
+UanTimerQueue::GetDelayLeft (uint32_t timer) const
+{
+  NS_ASSERT (timer < m_timers.size ());
+  if (!m_timers[timer].running)
+    {
+      return Seconds (0);
+    }
+  return m_timers[timer].pos->first - Simulator::Now ();
+}
+
+uint32_t
+UanTimerQueue::GetN (void) const
+{
+  return m_timers.size ();
+}
+
+uint64_t
+UanTimerQueue::GetScheduledEvents (void) const
+{
+  return m_scheduledEvents;
+}
+
+void
+UanTimerQueue::Arm (void)
+{
+  if (m_expiring || m_deadlines.empty ())
+    {
+      return;
+    }
+
+  Time next = m_deadlines.begin ()->first;
+  if (m_event.IsRunning () && m_eventTime <= next)
+    {
+      return;
+    }
+
+  m_event.Cancel ();
+  m_eventTime = next;
+  m_event = Simulator::Schedule (next - Simulator::Now (), &UanTimerQueue::Expire, this);
+  m_scheduledEvents++;
+}
+
+void
+UanTimerQueue::Expire (void)
+{
+  m_expiring = true;
+  Time now = Simulator::Now ();
+  while (!m_deadlines.empty () && m_deadlines.begin ()->first <= now)
+    {
+      uint32_t timer = m_deadlines.begin ()->second;
+      m_deadlines.erase (m_deadlines.begin ());
+      m_timers[timer].running = false;
+      m_timers[timer].pos = m_deadlines.end ();
+      NS_LOG_LOGIC (now.GetSeconds () << " timer " << m_timers[timer].name << " expired");
+      m_timers[timer].expire ();
+    }
+  m_expiring = false;
+  Arm ();
+}
+
+} // namespace ns3
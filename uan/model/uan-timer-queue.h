@@ -0,0 +1,99 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef UAN_TIMER_QUEUE_H_
+#define UAN_TIMER_QUEUE_H_
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/callback.h"
+
+#include <map>
+#include <vector>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup uan
+ *
+ * Node-local protocol timers behind a single simulator event.
+ *
+ * The MACs of a node (wakeup MAC plus upper MAC) register their timers
+ * here.  Deadlines are kept in an ordered index and one simulator event
+ * is armed for the earliest.  It is moved only when a new deadline comes
+ * before it; a cancelled timeout just leaves the index, and the event,
+ * if it fires with nothing due, re-arms for the next deadline.  Since
+ * most contention timeouts (WfCTS, WfACK, TxFail) are cancelled before
+ * they expire, this keeps them out of the global scheduler.
+ */
+class UanTimerQueue : public Object
+{
+public:
+  UanTimerQueue ();
+  virtual ~UanTimerQueue ();
+  static TypeId GetTypeId (void);
+
+  /**
+   * \param name Name used in logs
+   * \param expire Called when the timer expires
+   * \return Timer id
+   */
+  uint32_t Add (std::string name, Callback<void> expire);
+  void Schedule (uint32_t timer, Time delay);
+  void Cancel (uint32_t timer);
+  void CancelAll (void);
+  bool IsRunning (uint32_t timer) const;
+  Time GetDelayLeft (uint32_t timer) const;
+
+  /** \return Number of timers registered. */
+  uint32_t GetN (void) const;
+  /** \return Simulator events scheduled on behalf of the timers so far. */
+  uint64_t GetScheduledEvents (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  typedef std::multimap<Time, uint32_t> Deadlines;
+
+  struct Entry
+  {
+    std::string name;
+    Callback<void> expire;
+    bool running;
+    Deadlines::iterator pos;
+  };
+
+  /** Arm the shared event for the earliest deadline, if needed. */
+  void Arm (void);
+  /** Shared event handler: expire every due timer. */
+  void Expire (void);
+
+  std::vector<Entry> m_timers;
+  Deadlines m_deadlines;     //!< Running timers ordered by deadline
+  EventId m_event;           //!< The single pending simulator event
+  Time m_eventTime;          //!< When m_event fires
+  bool m_expiring;           //!< Inside Expire, defer arming
+  uint64_t m_scheduledEvents;
+};
+
+} // namespace ns3
+
+#endif /* UAN_TIMER_QUEUE_H_ */
@@ -10,6 +10,8 @@
 cpp_examples = [
     ("uan-rc-example", "True", "True"),
     ("uan-cw-example", "True", "True"),
+    ("uan-micro-benchmark --MinTime=1", "True", "False"),
+    ("uan-macro-benchmark --Nodes=5 --SimTime=60s", "True", "False"),
 ]
 
 # A list of Python examples to run in order to ensure that they remain
@@ -35,6 +35,7 @@
 #include "ns3/uan-prop-model-ideal.h"
 #include "ns3/uan-header-common.h"
 #include "ns3/uan-phy.h"
+#include "ns3/uan-battery-energy-source.h"
 
 using namespace ns3;
 
@@ -186,6 +187,20 @@ AcousticModemEnergyTestCase::DoRun ()
   NS_TEST_ASSERT_MSG_EQ_TOL (consumed2, computed2, 1.0e-5,
                              "Incorrect node consumed energy!");
 
+  // per-state counters of the node modem
+  std::vector<AcousticModemEnergyModel::Snapshot> snapshots = AcousticModemEnergyModelHelper::GetSnapshots (cont);
+  NS_TEST_ASSERT_MSG_EQ (snapshots.size (), 1, "Missing snapshot");
+  NS_TEST_ASSERT_MSG_EQ_TOL (snapshots[0].time[UanPhy::TX].GetSeconds (), packetDuration * m_sentPackets, 1.0e-6,
+                             "Incorrect node tx time!");
+  NS_TEST_ASSERT_MSG_EQ (snapshots[0].entries[UanPhy::TX], m_sentPackets, "Incorrect node tx count!");
+  double stateSum = 0;
+  for (uint32_t i = 0; i < AcousticModemEnergyModel::STATES; i++)
+    {
+      stateSum += snapshots[0].energy[i];
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (stateSum + snapshots[0].transition, snapshots[0].total, 1.0e-9,
+                             "Per-state energy does not add up to the total!");
+
   Simulator::Destroy ();
 }
 
@@ -288,6 +303,209 @@ AcousticModemEnergyDepletionTestCase::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (m_callbackCount, 1, "Callback not invoked");
 }
 
+class UanBatteryEnergySourceTestCase : public TestCase
+{
+public:
+  UanBatteryEnergySourceTestCase ();
+
+  void CheckRemaining (Ptr<UanBatteryEnergySource> source, double expected);
+  void CheckDepleted (Ptr<UanBatteryEnergySource> source, bool expected);
+
+  void DoRun (void);
+};
+
+UanBatteryEnergySourceTestCase::UanBatteryEnergySourceTestCase ()
+  : TestCase ("UAN battery drain, harvesting and depletion")
+{
+}
+
+void
+UanBatteryEnergySourceTestCase::CheckRemaining (Ptr<UanBatteryEnergySource> source, double expected)
+{
+  NS_TEST_ASSERT_MSG_EQ_TOL (source->GetRemainingEnergy (), expected, 1.0e-6,
+                             "Wrong remaining energy at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+UanBatteryEnergySourceTestCase::CheckDepleted (Ptr<UanBatteryEnergySource> source, bool expected)
+{
+  NS_TEST_ASSERT_MSG_EQ (source->IsDepleted (), expected,
+                         "Wrong depletion state at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+UanBatteryEnergySourceTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+
+  // 100 J at 10 V, harvesting 5 W
+  Ptr<UanBatteryEnergySource> source = CreateObject<UanBatteryEnergySource> ();
+  source->SetInitialEnergy (100.0);
+  source->SetSupplyVoltage (10.0);
+  source->AddHarvestingStep (Seconds (0), 5.0);
+  source->SetNode (node);
+
+  // 1 A draws 10 W, so the battery loses 5 W net and is empty at 20 s
+  Ptr<SimpleDeviceEnergyModel> model = CreateObject<SimpleDeviceEnergyModel> ();
+  model->SetNode (node);
+  model->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (model);
+  model->SetCurrentA (1.0);
+
+  Simulator::Schedule (Seconds (10), &UanBatteryEnergySourceTestCase::CheckRemaining, this, source, 50.0);
+  Simulator::Schedule (Seconds (19.9), &UanBatteryEnergySourceTestCase::CheckDepleted, this, source, false);
+  Simulator::Schedule (Seconds (20.1), &UanBatteryEnergySourceTestCase::CheckDepleted, this, source, true);
+  Simulator::Stop (Seconds (25));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (source->GetHarvestedEnergy (), 125.0, 1.0e-6, "Wrong harvested energy");
+  Simulator::Destroy ();
+}
+
+class AcousticModemEnergyTotalsTestCase : public TestCase
+{
+public:
+  AcousticModemEnergyTotalsTestCase ();
+
+  /** Integrate the reference up to now, then change the model state. */
+  void Step (Ptr<AcousticModemEnergyModel> model, int state);
+  /** \return Energy the reference integrated, plus the current state up to now. */
+  double GetReferenceTotal (void) const;
+
+  void DoRun (void);
+
+  double m_power[UanPhy::SLEEP + 1];  //!< Reference power per state, W.
+  int m_state;                        //!< Reference state.
+  Time m_lastUpdate;                  //!< Reference integration time.
+  double m_total;                     //!< Reference energy, J.
+};
+
+AcousticModemEnergyTotalsTestCase::AcousticModemEnergyTotalsTestCase ()
+  : TestCase ("Acoustic modem energy totals match eager accounting"),
+    m_state (UanPhy::IDLE),
+    m_lastUpdate (Seconds (0)),
+    m_total (0)
+{
+  m_power[UanPhy::IDLE] = 0.2;
+  m_power[UanPhy::CCABUSY] = 0.2;
+  m_power[UanPhy::RX] = 0.2;
+  m_power[UanPhy::TX] = 50;
+  m_power[UanPhy::SLEEP] = 0.01;
+}
+
+double
+AcousticModemEnergyTotalsTestCase::GetReferenceTotal (void) const
+{
+  return m_total + (Simulator::Now () - m_lastUpdate).GetSeconds () * m_power[m_state];
+}
+
+void
+AcousticModemEnergyTotalsTestCase::Step (Ptr<AcousticModemEnergyModel> model, int state)
+{
+  // What the model reported when it integrated on every call
+  m_total = GetReferenceTotal ();
+  m_lastUpdate = Simulator::Now ();
+  m_state = state;
+
+  model->ChangeState (state);
+  NS_TEST_ASSERT_MSG_EQ_TOL (model->GetTotalEnergyConsumption (), m_total, 1.0e-9,
+                             "Total differs at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+AcousticModemEnergyTotalsTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<UanBatteryEnergySource> source = CreateObject<UanBatteryEnergySource> ();
+  source->SetInitialEnergy (10000.0);
+  source->SetSupplyVoltage (10.0);
+  source->SetNode (node);
+
+  Ptr<AcousticModemEnergyModel> model = CreateObject<AcousticModemEnergyModel> ();
+  model->SetTxPowerW (m_power[UanPhy::TX]);
+  model->SetRxPowerW (m_power[UanPhy::RX]);
+  model->SetIdlePowerW (m_power[UanPhy::IDLE]);
+  model->SetSleepPowerW (m_power[UanPhy::SLEEP]);
+  model->SetNode (node);
+  model->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (model);
+
+  // Repeated states and rx/idle flips are the updates that are skipped
+  double times[] = { 1, 2, 3, 3.5, 4, 6, 7, 9, 9.5, 12 };
+  int states[] = { UanPhy::RX, UanPhy::RX, UanPhy::IDLE, UanPhy::CCABUSY, UanPhy::TX,
+                   UanPhy::TX, UanPhy::IDLE, UanPhy::SLEEP, UanPhy::SLEEP, UanPhy::IDLE };
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Simulator::Schedule (Seconds (times[i]), &AcousticModemEnergyTotalsTestCase::Step, this, model, states[i]);
+    }
+  Simulator::Stop (Seconds (15));
+  Simulator::Run ();
+
+  // Between state changes the total also covers the current state
+  double total = GetReferenceTotal ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (model->GetTotalEnergyConsumption (), total, 1.0e-9, "Total differs at the end");
+  NS_TEST_ASSERT_MSG_EQ_TOL (source->GetRemainingEnergy (), 10000.0 - total, 1.0e-6,
+                             "Source drained a different energy");
+  Simulator::Destroy ();
+}
+
+class AcousticModemEnergyOffTestCase : public TestCase
+{
+public:
+  AcousticModemEnergyOffTestCase ();
+
+  void Check (Ptr<AcousticModemEnergyModel> model, Ptr<UanBatteryEnergySource> source,
+              double currentA, double total, double remaining);
+
+  void DoRun (void);
+};
+
+AcousticModemEnergyOffTestCase::AcousticModemEnergyOffTestCase ()
+  : TestCase ("Acoustic modem draws nothing while the battery is depleted")
+{
+}
+
+void
+AcousticModemEnergyOffTestCase::Check (Ptr<AcousticModemEnergyModel> model, Ptr<UanBatteryEnergySource> source,
+                                       double currentA, double total, double remaining)
+{
+  double now = Simulator::Now ().GetSeconds ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (model->GetCurrentA (), currentA, 1.0e-9, "Wrong draw at " << now);
+  NS_TEST_ASSERT_MSG_EQ_TOL (model->GetTotalEnergyConsumption (), total, 1.0e-6, "Wrong total at " << now);
+  NS_TEST_ASSERT_MSG_EQ_TOL (source->GetRemainingEnergy (), remaining, 1.0e-6, "Wrong remaining energy at " << now);
+  // What the battery supplied is what the modem consumed
+  double supplied = source->GetInitialEnergy () - source->GetRemainingEnergy () + source->GetHarvestedEnergy ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (supplied, model->GetTotalEnergyConsumption (), 1.0e-6, "Totals drift at " << now);
+}
+
+void
+AcousticModemEnergyOffTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<UanBatteryEnergySource> source = CreateObject<UanBatteryEnergySource> ();
+  source->SetInitialEnergy (100.0);
+  source->SetSupplyVoltage (10.0);
+  source->SetNode (node);
+
+  // Idle at 10 W empties the battery at 10 s
+  Ptr<AcousticModemEnergyModel> model = CreateObject<AcousticModemEnergyModel> ();
+  model->SetIdlePowerW (10.0);
+  model->SetNode (node);
+  model->SetEnergySource (source);
+  source->AppendDeviceEnergyModel (model);
+
+  // 20 W harvested from 15 s refill the 5 J recharge threshold at 15.25 s
+  source->AddHarvestingStep (Seconds (15), 20.0);
+
+  Simulator::Schedule (Seconds (5), &AcousticModemEnergyOffTestCase::Check, this, model, source, 1.0, 50.0, 50.0);
+  Simulator::Schedule (Seconds (12), &AcousticModemEnergyOffTestCase::Check, this, model, source, 0.0, 100.0, 0.0);
+  Simulator::Schedule (Seconds (15.2), &AcousticModemEnergyOffTestCase::Check, this, model, source, 0.0, 100.0, 4.0);
+  Simulator::Schedule (Seconds (16), &AcousticModemEnergyOffTestCase::Check, this, model, source, 1.0, 107.5, 12.5);
+  Simulator::Stop (Seconds (17));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
 // -------------------------------------------------------------------------- //
 
 /**
@@ -305,6 +523,9 @@ UanEnergyModelTestSuite::UanEnergyModelTestSuite ()
 {
   AddTestCase (new AcousticModemEnergyTestCase, TestCase::QUICK);
   AddTestCase (new AcousticModemEnergyDepletionTestCase, TestCase::QUICK);
+  AddTestCase (new UanBatteryEnergySourceTestCase, TestCase::QUICK);
+  AddTestCase (new AcousticModemEnergyTotalsTestCase, TestCase::QUICK);
+  AddTestCase (new AcousticModemEnergyOffTestCase, TestCase::QUICK);
 }
 
 // create an instance of the test suite
@@ -0,0 +1,885 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Universitat Politècnica de València
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/uan-mac-fama.h"
+#include "ns3/uan-mac-slotted-fama.h"
+#include "ns3/uan-mac-wakeup.h"
+#include "ns3/uan-mac-aloha-cs.h"
+#include "ns3/uan-mac-tlohi.h"
+#include "ns3/uan-mac-wakeup-tlohi.h"
+#include "ns3/uan-mac-maca.h"
+#include "ns3/uan-mac-wakeup-maca.h"
+#include "ns3/uan-duty-cycle-controller.h"
+#include "ns3/uan-header-common.h"
+#include "ns3/uan-header-wakeup.h"
+#include "ns3/uan-phy-header.h"
+#include "ns3/uan-backoff.h"
+#include "ns3/uan-net-device.h"
+#include "ns3/uan-channel.h"
+#include "ns3/uan-phy-gen.h"
+#include "ns3/uan-phy-wakeup-dual.h"
+#include "ns3/uan-transducer-hd.h"
+#include "ns3/uan-prop-model-ideal.h"
+#include "ns3/uan-wakeup-helper.h"
+#include "ns3/basic-energy-source-helper.h"
+#include "ns3/energy-source-container.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/double.h"
+#include "ns3/pointer.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Device with a UanPhyWakeupDual and mac as its only MAC.
+ */
+static Ptr<UanNetDevice>
+CreateWakeupNode (UanAddress addr, Vector pos, Ptr<UanChannel> chan, Ptr<UanMac> mac)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (pos);
+  node->AggregateObject (mobility);
+  dev->SetPhy (CreateObject<UanPhyWakeupDual> ());
+  dev->SetMac (mac);
+  dev->SetChannel (chan);
+  dev->SetTransducer (CreateObject<UanTransducerHd> ());
+  mac->SetAddress (addr);
+  node->AddDevice (dev);
+  return dev;
+}
+
+/**
+ * FAMA with the neighbor delay table exposed.
+ */
+class UanMacFamaProbe : public UanMacFama
+{
+public:
+  void SetNeighborDelay (UanAddress addr, double delay)
+  {
+    m_propDelay[addr] = delay;
+  }
+  uint32_t GetQueueSize (void) const
+  {
+    return m_sendQueue.size ();
+  }
+  void SetState (MACSTATE state)
+  {
+    m_fsm->SetState (state);
+  }
+};
+
+class UanMacFamaPropDelayTest : public TestCase
+{
+public:
+  UanMacFamaPropDelayTest ();
+
+  virtual void DoRun (void);
+};
+
+UanMacFamaPropDelayTest::UanMacFamaPropDelayTest () : TestCase ("UAN FAMA overheard exchange delay")
+{
+
+}
+
+void
+UanMacFamaPropDelayTest::DoRun (void)
+{
+  Ptr<UanMacFamaProbe> mac = CreateObject<UanMacFamaProbe> ();
+  mac->SetAttribute ("MaxPropDelay", DoubleValue (0.3));
+  mac->SetAttribute ("PropDelayGuard", DoubleValue (0.01));
+
+  // This node halfway between 1 and 2, which are 0.2 s apart
+  mac->SetNeighborDelay (UanAddress (1), 0.1);
+  mac->SetNeighborDelay (UanAddress (2), 0.1);
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->GetPropDelay (UanAddress (1)), 0.11, 1e-9, "Wrong neighbor delay");
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->GetPropDelay (UanAddress (1), UanAddress (2)), 0.22, 1e-9,
+                             "Overheard exchange shorter than the delay between its ends");
+
+  // Bounded by the maximum propagation delay
+  mac->SetNeighborDelay (UanAddress (3), 0.25);
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->GetPropDelay (UanAddress (1), UanAddress (3)), 0.3, 1e-9, "Delay not capped");
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->GetPropDelay (UanAddress (1), UanAddress (4)), 0.3, 1e-9, "Unknown neighbor not at the maximum");
+  mac->SetNeighborDelay (UanAddress (5), 0.295);
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->GetPropDelay (UanAddress (5)), 0.3, 1e-9, "Neighbor delay not capped");
+
+  mac->Dispose ();
+  Simulator::Destroy ();
+}
+
+class UanMacFamaLateAckTest : public TestCase
+{
+public:
+  UanMacFamaLateAckTest ();
+
+  virtual void DoRun (void);
+private:
+  static Ptr<Packet> CreateAck (void);
+  void ForwardUp (Ptr<Packet> pkt, const UanAddress &src);
+  uint32_t m_forwarded;
+};
+
+UanMacFamaLateAckTest::UanMacFamaLateAckTest () : TestCase ("UAN FAMA ACK after the WfACK timeout")
+{
+
+}
+
+Ptr<Packet>
+UanMacFamaLateAckTest::CreateAck (void)
+{
+  UanHeaderCommon header;
+  header.SetSrc (UanAddress (2));
+  header.SetDest (UanAddress (1));
+  header.SetType (UanMacFama::ACK);
+  Ptr<Packet> pkt = Create<Packet> ();
+  pkt->AddHeader (header);
+  return pkt;
+}
+
+void
+UanMacFamaLateAckTest::ForwardUp (Ptr<Packet> pkt, const UanAddress &src)
+{
+  m_forwarded++;
+}
+
+void
+UanMacFamaLateAckTest::DoRun (void)
+{
+  m_forwarded = 0;
+  Ptr<UanMacFamaProbe> mac = CreateObject<UanMacFamaProbe> ();
+  Ptr<UanMacWakeup> wakeup = CreateObject<UanMacWakeup> ();
+  wakeup->AttachPhy (CreateObject<UanPhyGen> ());
+  mac->AttachPhy (CreateObject<UanPhyGen> ());
+  mac->AttachMacWakeup (wakeup);
+  mac->SetAddress (UanAddress (1));
+  mac->SetForwardUpCb (MakeCallback (&UanMacFamaLateAckTest::ForwardUp, this));
+
+  mac->Enqueue (Create<Packet> (10), UanAddress (2), 0);
+  NS_TEST_ASSERT_MSG_EQ (mac->GetMacState (), UanMacFama::CONTEND, "Queued packet not contending");
+
+  // The WfACK timeout already gave up on the packet: the ACK is stale
+  mac->RxPacket (CreateAck (), UanAddress (2));
+  NS_TEST_ASSERT_MSG_EQ (mac->GetQueueSize (), 1, "Stale ACK removed the retried packet");
+  NS_TEST_ASSERT_MSG_EQ (mac->GetMacState (), UanMacFama::CONTEND, "Stale ACK changed the state");
+  NS_TEST_ASSERT_MSG_EQ (m_forwarded, 0, "Stale ACK passed up");
+
+  // While it is awaited the ACK delivers the packet
+  mac->SetState (UanMacFama::WFACK);
+  mac->RxPacket (CreateAck (), UanAddress (2));
+  NS_TEST_ASSERT_MSG_EQ (mac->GetQueueSize (), 0, "Awaited ACK did not deliver the packet");
+  NS_TEST_ASSERT_MSG_EQ (mac->GetMacState (), UanMacFama::IDLE, "Awaited ACK did not end the exchange");
+
+  mac->Dispose ();
+  wakeup->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Slotted FAMA with SendRTS exposed.
+ */
+class UanMacSlottedFamaProbe : public UanMacSlottedFama
+{
+public:
+  using UanMacSlottedFama::SendRTS;
+  using UanMacSlottedFama::AlignTx;
+};
+
+class UanMacSlottedFamaTest : public TestCase
+{
+public:
+  UanMacSlottedFamaTest ();
+
+  virtual void DoRun (void);
+private:
+  void Probe (Ptr<UanMacSlottedFamaProbe> mac);
+  Time m_next;
+  bool m_sent;
+  uint32_t m_state;
+};
+
+UanMacSlottedFamaTest::UanMacSlottedFamaTest () : TestCase ("UAN slotted FAMA slot alignment")
+{
+
+}
+
+void
+UanMacSlottedFamaTest::Probe (Ptr<UanMacSlottedFamaProbe> mac)
+{
+  m_next = mac->GetNextSlot ();
+  m_sent = mac->SendRTS ();
+  m_state = mac->GetFsm ()->GetState ();
+}
+
+void
+UanMacSlottedFamaTest::DoRun (void)
+{
+  Ptr<UanMacSlottedFamaProbe> mac = CreateObject<UanMacSlottedFamaProbe> ();
+  Ptr<UanMacWakeup> wakeup = CreateObject<UanMacWakeup> ();
+  mac->AttachPhy (CreateObject<UanPhyGen> ());
+  mac->AttachMacWakeup (wakeup);
+  mac->SetAttribute ("MaxPropDelay", DoubleValue (0.3));
+  mac->SetRtsSize (40);
+
+  // RtsSize counts the wakeup MAC overhead once; the RTS carries the
+  // common header on top and gets the PHY framing below
+  UanHeaderCommon header;
+  UanPhyHeader phyHeader;
+  UanPhyTrailer phyTrailer;
+  uint32_t rtsBytes = 40 - wakeup->GetHeadersSize () + header.GetSerializedSize ()
+    + phyHeader.GetSerializedSize () + phyTrailer.GetSerializedSize ();
+  Time slot = mac->GetSlotTime ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (slot.GetSeconds (), 0.3 + rtsBytes * 8.0 / 80, 1e-9, "Slot does not fit one RTS");
+
+  // Between boundaries the RTS is held, not reported as sent
+  Simulator::Schedule (TimeStep (slot.GetTimeStep () * 5 / 2), &UanMacSlottedFamaTest::Probe, this, mac);
+  Simulator::Stop (TimeStep (slot.GetTimeStep () * 11 / 4));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_next, TimeStep (slot.GetTimeStep () * 3), "Next slot not aligned");
+  NS_TEST_ASSERT_MSG_EQ (m_sent, false, "Held RTS reported as sent");
+  NS_TEST_ASSERT_MSG_EQ (m_state, (uint32_t) UanMacFama::CONTEND, "Held RTS left CONTEND");
+
+  // On a boundary the current slot is used; the held RTS found nothing to send
+  Simulator::Schedule (TimeStep (slot.GetTimeStep () * 4) - Simulator::Now (), &UanMacSlottedFamaTest::Probe, this, mac);
+  Simulator::Stop (TimeStep (slot.GetTimeStep () * 2));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_next, TimeStep (slot.GetTimeStep () * 4), "Boundary not its own slot");
+  NS_TEST_ASSERT_MSG_EQ (m_state, (uint32_t) UanMacFama::IDLE, "Empty queue left the MAC contending");
+
+  // An RTS pushed off its boundary by a tone or warm-up waits for the
+  // next one at the PHY; other frames go out at once
+  Time late = TimeStep (slot.GetTimeStep () * 9 / 2);
+  header.SetType (UanMacFama::RTS);
+  Ptr<Packet> rts = Create<Packet> (10);
+  rts->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (mac->AlignTx (rts, late), TimeStep (slot.GetTimeStep () * 5), "RTS not aligned at the PHY");
+  header.SetType (UanMacFama::CTS);
+  Ptr<Packet> cts = Create<Packet> (10);
+  cts->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (mac->AlignTx (cts, late), late, "CTS held for a slot");
+
+  mac->Dispose ();
+  wakeup->Dispose ();
+  Simulator::Destroy ();
+}
+
+class UanMacWakeupLingerTest : public TestCase
+{
+public:
+  UanMacWakeupLingerTest ();
+
+  virtual void DoRun (void);
+private:
+  static void Send (Ptr<UanNetDevice> dev);
+};
+
+UanMacWakeupLingerTest::UanMacWakeupLingerTest () : TestCase ("UAN wakeup tone skipped only for awake peers")
+{
+
+}
+
+void
+UanMacWakeupLingerTest::Send (Ptr<UanNetDevice> dev)
+{
+  dev->Send (Create<Packet> (10), UanAddress (2), 0);
+}
+
+void
+UanMacWakeupLingerTest::DoRun (void)
+{
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  Ptr<UanMacWakeup> mac = CreateObject<UanMacWakeup> ();
+  mac->SetAttribute ("SleepLinger", TimeValue (Seconds (5)));
+  mac->SetAttribute ("PeerSleepLinger", TimeValue (Seconds (5)));
+  Ptr<UanNetDevice> dev = CreateWakeupNode (UanAddress (1), Vector (0, 0, 0), channel, mac);
+
+  // Nobody answers: a sent frame says nothing about the peer
+  Simulator::Schedule (Seconds (1), &UanMacWakeupLingerTest::Send, dev);
+  Simulator::Schedule (Seconds (5), &UanMacWakeupLingerTest::Send, dev);
+  Simulator::Stop (Seconds (9));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (mac->IsAwake (UanAddress (2)), false, "Unacknowledged peer taken as awake");
+  NS_TEST_ASSERT_MSG_EQ (mac->GetSkippedWakeups (), 0, "Tone skipped without a delivery");
+
+  // An ACK sent 0.5 s ago keeps the peer awake until 13.5 s
+  mac->NotifyDelivered (UanAddress (2), Seconds (0.5));
+  NS_TEST_ASSERT_MSG_EQ (mac->IsAwake (UanAddress (2)), true, "Acknowledging peer not awake");
+  Simulator::Schedule (Seconds (1), &UanMacWakeupLingerTest::Send, dev);
+  Simulator::Schedule (Seconds (5), &UanMacWakeupLingerTest::Send, dev);
+  Simulator::Stop (Seconds (9));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (mac->GetSkippedWakeups (), 1, "Tone skipped after the peer linger");
+  NS_TEST_ASSERT_MSG_EQ (mac->IsAwake (UanAddress (2)), false, "Peer still awake after its linger");
+
+  Simulator::Destroy ();
+}
+
+class UanMacFamaLingerTest : public TestCase
+{
+public:
+  UanMacFamaLingerTest ();
+
+  virtual void DoRun (void);
+private:
+  Ptr<UanNetDevice> CreateFamaNode (UanAddress addr, Vector pos, Ptr<UanChannel> chan, Ptr<UanMacWakeup> wakeup);
+  static void Send (Ptr<UanNetDevice> dev);
+  void DataSent (Ptr<Packet> pkt);
+  void ForwardUp (Ptr<Packet> pkt, const UanAddress &src);
+
+  Ptr<UanMacWakeup> m_rxWakeup;
+  std::vector<uint32_t> m_tones;  //!< Tones the receiver had heard at each delivery
+};
+
+UanMacFamaLingerTest::UanMacFamaLingerTest () : TestCase ("UAN FAMA frame to a lingering receiver")
+{
+
+}
+
+Ptr<UanNetDevice>
+UanMacFamaLingerTest::CreateFamaNode (UanAddress addr, Vector pos, Ptr<UanChannel> chan, Ptr<UanMacWakeup> wakeup)
+{
+  wakeup->SetAttribute ("SleepLinger", TimeValue (Seconds (150)));
+  wakeup->SetAttribute ("PeerSleepLinger", TimeValue (Seconds (150)));
+  Ptr<UanNetDevice> dev = CreateWakeupNode (addr, pos, chan, wakeup);
+
+  // Wired as UanWakeupHelper does
+  Ptr<UanMacFama> fama = CreateObject<UanMacFama> ();
+  fama->AttachMacWakeup (wakeup);
+  wakeup->SetSendPhyStateChangeCb (MakeCallback (&UanMacFama::PhyStateCb, fama));
+  wakeup->SetTxEndCallback (MakeCallback (&UanMacFama::TxEnd, fama));
+  fama->SetSendDataCallback (MakeCallback (&UanMacFamaLingerTest::DataSent, this));
+  dev->SetMac (fama);
+  fama->SetAddress (addr);
+  DynamicCast<UanPhyWakeupDual> (dev->GetPhy ())->GetDataPhy ()->SetSleepMode (true);
+  return dev;
+}
+
+void
+UanMacFamaLingerTest::Send (Ptr<UanNetDevice> dev)
+{
+  dev->Send (Create<Packet> (10), UanAddress (2), 0);
+}
+
+void
+UanMacFamaLingerTest::DataSent (Ptr<Packet> pkt)
+{
+
+}
+
+void
+UanMacFamaLingerTest::ForwardUp (Ptr<Packet> pkt, const UanAddress &src)
+{
+  m_tones.push_back (m_rxWakeup->GetWakeupsReceived ());
+}
+
+void
+UanMacFamaLingerTest::DoRun (void)
+{
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  Ptr<UanMacWakeup> txWakeup = CreateObject<UanMacWakeup> ();
+  m_rxWakeup = CreateObject<UanMacWakeup> ();
+  Ptr<UanNetDevice> tx = CreateFamaNode (UanAddress (1), Vector (0, 0, 0), channel, txWakeup);
+  Ptr<UanNetDevice> rx = CreateFamaNode (UanAddress (2), Vector (100, 0, 0), channel, m_rxWakeup);
+  rx->GetMac ()->SetForwardUpCb (MakeCallback (&UanMacFamaLingerTest::ForwardUp, this));
+
+  // The receiver still lingers from the first ACK when the second frame comes
+  Simulator::Schedule (Seconds (1), &UanMacFamaLingerTest::Send, tx);
+  Simulator::Schedule (Seconds (100), &UanMacFamaLingerTest::Send, tx);
+  Simulator::Stop (Seconds (400));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_tones.size (), 2, "Frames not delivered");
+  NS_TEST_ASSERT_MSG_GT (m_tones[0], 0, "First frame delivered without waking the receiver");
+  NS_TEST_ASSERT_MSG_EQ (m_tones[1], m_tones[0], "Second frame needed a wakeup tone");
+  NS_TEST_ASSERT_MSG_GT (txWakeup->GetSkippedWakeups (), 0, "Sender did not skip the tone");
+  NS_TEST_ASSERT_MSG_EQ (DynamicCast<UanPhyWakeupDual> (rx->GetPhy ())->GetDataPhy ()->IsStateSleep (), true,
+                         "Receiver data PHY awake after its linger");
+
+  m_rxWakeup = 0;
+  Simulator::Destroy ();
+}
+
+class UanDutyCycleTest : public TestCase
+{
+public:
+  UanDutyCycleTest ();
+
+  virtual void DoRun (void);
+private:
+  void CheckState (bool listening, bool asleep, bool wakingUp);
+  void Hold (double wait);
+  void Release (bool asleep);
+  void Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode);
+  static void SendTone (Ptr<UanMacWakeup> mac);
+
+  Ptr<UanDutyCycleController> m_controller;
+  Ptr<UanPhyGen> m_phy;
+  uint32_t m_tx;
+  Time m_txTime;
+};
+
+UanDutyCycleTest::UanDutyCycleTest () : TestCase ("UAN duty cycle schedule and send during warm-up")
+{
+
+}
+
+void
+UanDutyCycleTest::CheckState (bool listening, bool asleep, bool wakingUp)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_controller->IsListening (), listening, "Wrong listen window at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_phy->IsStateSleep (), asleep, "Wrong sleep state at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_phy->IsWakingUp (), wakingUp, "Wrong warm-up at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+UanDutyCycleTest::Hold (double wait)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_controller->Hold (), Seconds (wait), "Wrong warm-up left on hold");
+}
+
+void
+UanDutyCycleTest::Release (bool asleep)
+{
+  m_controller->Release ();
+  NS_TEST_EXPECT_MSG_EQ (m_phy->IsStateSleep (), asleep, "Wrong sleep state on release");
+}
+
+void
+UanDutyCycleTest::Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode)
+{
+  m_tx++;
+  m_txTime = Simulator::Now ();
+}
+
+void
+UanDutyCycleTest::SendTone (Ptr<UanMacWakeup> mac)
+{
+  mac->SendWUAlone (UanAddress (2));
+}
+
+void
+UanDutyCycleTest::DoRun (void)
+{
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  Ptr<UanMacWakeup> mac = CreateObject<UanMacWakeup> ();
+  Ptr<UanNetDevice> dev = CreateWakeupNode (UanAddress (1), Vector (0, 0, 0), channel, mac);
+  m_phy = DynamicCast<UanPhyGen> (mac->GetWakeupPhy ());
+  m_phy->SetAttribute ("WakeupLatency", TimeValue (Seconds (0.5)));
+  m_phy->TraceConnectWithoutContext ("Tx", MakeCallback (&UanDutyCycleTest::Tx, this));
+  m_tx = 0;
+
+  m_controller = CreateObject<UanDutyCycleController> ();
+  m_controller->SetAttribute ("BasePeriod", TimeValue (Seconds (10)));
+  m_controller->SetAttribute ("ListenWindow", TimeValue (Seconds (2)));
+  m_controller->SetAttribute ("ControlInterval", TimeValue (Seconds (1000)));
+  m_controller->Install (mac, 0);
+
+  // Listen from 0 s and 10 s for 2 s, after a 0.5 s warm-up
+  Simulator::Schedule (Seconds (0.2), &UanDutyCycleTest::CheckState, this, true, true, true);
+  Simulator::Schedule (Seconds (1), &UanDutyCycleTest::CheckState, this, true, false, false);
+  Simulator::Schedule (Seconds (3), &UanDutyCycleTest::CheckState, this, false, true, false);
+  Simulator::Schedule (Seconds (10.2), &UanDutyCycleTest::CheckState, this, true, true, true);
+  Simulator::Schedule (Seconds (11), &UanDutyCycleTest::CheckState, this, true, false, false);
+
+  // Held outside a window the receiver warms up, and sleeps on release
+  Simulator::Schedule (Seconds (4), &UanDutyCycleTest::Hold, this, 0.5);
+  Simulator::Schedule (Seconds (4.2), &UanDutyCycleTest::CheckState, this, false, true, true);
+  Simulator::Schedule (Seconds (5), &UanDutyCycleTest::CheckState, this, false, false, false);
+  Simulator::Schedule (Seconds (5), &UanDutyCycleTest::Release, this, true);
+  // Inside a window it is already awake and keeps listening
+  Simulator::Schedule (Seconds (11), &UanDutyCycleTest::Hold, this, 0);
+  Simulator::Schedule (Seconds (11.5), &UanDutyCycleTest::Release, this, false);
+
+  // A tone sent at 13 s waits for the 20 s window, then for the warm-up
+  Simulator::Schedule (Seconds (13), &UanDutyCycleTest::SendTone, mac);
+  Simulator::Stop (Seconds (25));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_tx, 1, "Tone dropped by the warming up receiver");
+  NS_TEST_ASSERT_MSG_EQ (m_txTime, Seconds (20.5), "Tone not sent at the end of the warm-up");
+  NS_TEST_ASSERT_MSG_EQ (mac->IsBusy (), false, "MAC stuck after the tone");
+  NS_TEST_ASSERT_MSG_EQ (m_controller->IsListening (), false, "Receiver still listening after the window");
+  NS_TEST_ASSERT_MSG_EQ (m_phy->IsStateSleep (), true, "Receiver not released after the tone");
+
+  m_controller->Dispose ();
+  m_controller = 0;
+  m_phy = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * Backoff policy returning the lower edge of the window it is given
+ * plus a fixed fraction of the upper edge, as a widened window would.
+ */
+class UanBackoffFixed : public UanBackoff
+{
+public:
+  UanBackoffFixed (double fraction)
+    : m_fraction (fraction),
+      m_min (-1),
+      m_max (-1)
+  {
+  }
+  virtual double GetBackoff (double min, double max)
+  {
+    m_min = min;
+    m_max = max;
+    return min + m_fraction * max;
+  }
+  double m_fraction;
+  double m_min;
+  double m_max;
+};
+
+class UanMacAlohaCsBackoffTest : public TestCase
+{
+public:
+  UanMacAlohaCsBackoffTest ();
+
+  virtual void DoRun (void);
+private:
+  Ptr<UanNetDevice> CreateNode (UanAddress addr, Vector pos, Ptr<UanChannel> chan, Ptr<UanBackoff> backoff);
+  void Send (Ptr<UanNetDevice> dev);
+  void PhyTx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode);
+  /**
+   * Node 0 sends at t0, node 1 at t1, 100 m apart.
+   * \return Time node 1 started its transmission.
+   */
+  Time Run (Ptr<UanBackoff> b0, Ptr<UanBackoff> b1, Time t0, Time t1);
+  Time m_txTime;
+};
+
+UanMacAlohaCsBackoffTest::UanMacAlohaCsBackoffTest () : TestCase ("UAN Aloha-CS backoff policy feedback")
+{
+
+}
+
+Ptr<UanNetDevice>
+UanMacAlohaCsBackoffTest::CreateNode (UanAddress addr, Vector pos, Ptr<UanChannel> chan, Ptr<UanBackoff> backoff)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+  Ptr<UanMacAlohaCs> mac = CreateObject<UanMacAlohaCs> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (pos);
+  node->AggregateObject (mobility);
+  mac->SetAttribute ("Backoff", PointerValue (backoff));
+  mac->SetCw (10);
+  mac->SetSlotTime (MilliSeconds (50));
+  mac->SetAddress (addr);
+  dev->SetPhy (CreateObject<UanPhyGen> ());
+  dev->SetMac (mac);
+  dev->SetChannel (chan);
+  dev->SetTransducer (CreateObject<UanTransducerHd> ());
+  node->AddDevice (dev);
+  return dev;
+}
+
+void
+UanMacAlohaCsBackoffTest::Send (Ptr<UanNetDevice> dev)
+{
+  dev->Send (Create<Packet> (17), dev->GetBroadcast (), 0);
+}
+
+void
+UanMacAlohaCsBackoffTest::PhyTx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode)
+{
+  m_txTime = Simulator::Now ();
+}
+
+Time
+UanMacAlohaCsBackoffTest::Run (Ptr<UanBackoff> b0, Ptr<UanBackoff> b1, Time t0, Time t1)
+{
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  channel->SetPropagationModel (CreateObject<UanPropModelIdeal> ());
+  Ptr<UanNetDevice> dev0 = CreateNode (UanAddress (1), Vector (0, 50, 50), channel, b0);
+  Ptr<UanNetDevice> dev1 = CreateNode (UanAddress (2), Vector (100, 50, 50), channel, b1);
+  dev1->GetPhy ()->TraceConnectWithoutContext ("Tx", MakeCallback (&UanMacAlohaCsBackoffTest::PhyTx, this));
+
+  m_txTime = Seconds (0);
+  Simulator::Schedule (t0, &UanMacAlohaCsBackoffTest::Send, this, dev0);
+  Simulator::Schedule (t1, &UanMacAlohaCsBackoffTest::Send, this, dev1);
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  return m_txTime;
+}
+
+void
+UanMacAlohaCsBackoffTest::DoRun (void)
+{
+  // 20 bytes at 80 bps reach node 1 from 1.0667 s to 3.0667 s; node 1
+  // defers and draws from the policy when the channel clears
+  Ptr<UanBackoffFixed> early = CreateObject<UanBackoffFixed> (0.0);
+  Time txEarly = Run (CreateObject<UanBackoffFixed> (0.0), early, Seconds (1), Seconds (1.5));
+  Ptr<UanBackoffFixed> late = CreateObject<UanBackoffFixed> (1.0);
+  Time txLate = Run (CreateObject<UanBackoffFixed> (0.0), late, Seconds (1), Seconds (1.5));
+
+  // Constant CW slots unless the policy widens the window
+  NS_TEST_ASSERT_MSG_EQ (early->m_min, 10, "Window does not start at CW");
+  NS_TEST_ASSERT_MSG_EQ (early->m_max, 10, "Window does not end at CW");
+  NS_TEST_ASSERT_MSG_EQ (early->GetDeferrals (), 1, "Deferral not reported");
+  NS_TEST_ASSERT_MSG_EQ (early->GetSuccesses (), 1, "Clean transmission not reported");
+  NS_TEST_ASSERT_MSG_EQ_TOL ((txLate - txEarly).GetSeconds (), 0.5, 1e-6, "Policy did not move the transmission");
+
+  // Overlapping transmissions are reported to both policies
+  Ptr<UanBackoffFixed> b0 = CreateObject<UanBackoffFixed> (0.0);
+  Ptr<UanBackoffFixed> b1 = CreateObject<UanBackoffFixed> (0.0);
+  Run (b0, b1, Seconds (1), Seconds (1));
+  NS_TEST_ASSERT_MSG_EQ (b0->GetCollisions (), 1, "Collision not reported");
+  NS_TEST_ASSERT_MSG_EQ (b1->GetCollisions (), 1, "Collision not reported");
+  NS_TEST_ASSERT_MSG_EQ (b1->GetSuccesses (), 0, "Collision reported as success");
+}
+
+class UanMacTlohiBackoffTest : public TestCase
+{
+public:
+  UanMacTlohiBackoffTest ();
+
+  virtual void DoRun (void);
+private:
+  /**
+   * Draw n backoffs for a round of ctc contenders, starting each draw
+   * from the same estimate.
+   * \return Largest backoff drawn, in rounds.
+   */
+  uint32_t MaxBackoff (Ptr<UanMacTlohi> mac, double estimate, uint32_t ctc, uint32_t n);
+};
+
+UanMacTlohiBackoffTest::UanMacTlohiBackoffTest () : TestCase ("UAN T-Lohi contender count smoothing")
+{
+
+}
+
+uint32_t
+UanMacTlohiBackoffTest::MaxBackoff (Ptr<UanMacTlohi> mac, double estimate, uint32_t ctc, uint32_t n)
+{
+  uint32_t max = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      mac->m_ctcEstimate = estimate;
+      mac->m_CTC = ctc;
+      max = std::max (max, mac->DrawBackoffRounds ());
+    }
+  return max;
+}
+
+void
+UanMacTlohiBackoffTest::DoRun (void)
+{
+  Ptr<UanMacTlohi> mac = CreateObject<UanMacTlohi> ();
+  mac->AssignStreams (1);
+
+  // Without smoothing a round of two backs off over two rounds, whatever
+  // the load before it
+  mac->SetAttribute ("CtcAlpha", DoubleValue (0));
+  NS_TEST_ASSERT_MSG_EQ (MaxBackoff (mac, 8, 2, 1000), 1, "Backoff exceeds the last round's count");
+
+  // After a run of busy rounds the same round of two is spread wider
+  mac->SetAttribute ("CtcAlpha", DoubleValue (0.25));
+  mac->m_ctcEstimate = 1;
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      mac->m_CTC = 8;
+      mac->DrawBackoffRounds ();
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->m_ctcEstimate, 8, 1e-3, "Estimate did not converge");
+  mac->m_CTC = 2;
+  mac->DrawBackoffRounds ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->m_ctcEstimate, 6.5, 1e-3, "Estimate not weighted by CtcAlpha");
+  NS_TEST_ASSERT_MSG_EQ (MaxBackoff (mac, 8, 2, 1000), 6, "Backoff not spread over the estimate");
+
+  // A quiet round pulls the estimate back down
+  mac->m_ctcEstimate = 2;
+  mac->m_CTC = 1;
+  mac->DrawBackoffRounds ();
+  NS_TEST_ASSERT_MSG_EQ_TOL (mac->m_ctcEstimate, 1.75, 1e-3, "Estimate did not decay");
+
+  // A lone contender never backs off, however busy the past rounds
+  NS_TEST_ASSERT_MSG_EQ (MaxBackoff (mac, 8, 1, 100), 0, "Lone contender backed off");
+}
+
+class UanMacFsmStackTest : public TestCase
+{
+public:
+  UanMacFsmStackTest ();
+
+  virtual void DoRun (void);
+};
+
+UanMacFsmStackTest::UanMacFsmStackTest () : TestCase ("UAN MACA and T-Lohi share the wakeup MAC timer queue")
+{
+
+}
+
+void
+UanMacFsmStackTest::DoRun (void)
+{
+  Ptr<UanMacMaca> maca = CreateObject<UanMacMaca> ();
+  Ptr<UanMacWakeupMaca> wakeupMaca = CreateObject<UanMacWakeupMaca> ();
+  maca->AttachMacWakeup (wakeupMaca);
+  NS_TEST_ASSERT_MSG_EQ (maca->GetFsm ()->GetTimerQueue (), wakeupMaca->GetFsm ()->GetTimerQueue (), "MACA timers not moved to the wakeup MAC queue");
+
+  Ptr<UanMacTlohi> tlohi = CreateObject<UanMacTlohi> ();
+  Ptr<UanMacWakeupTlohi> wakeupTlohi = CreateObject<UanMacWakeupTlohi> ();
+  tlohi->AttachMacWakeup (wakeupTlohi);
+  Ptr<UanTimerQueue> queue = wakeupTlohi->GetFsm ()->GetTimerQueue ();
+  NS_TEST_ASSERT_MSG_EQ (tlohi->GetFsm ()->GetTimerQueue (), queue, "T-Lohi timers not moved to the wakeup MAC queue");
+
+  // Timers expiring after the earliest one cost no simulator event
+  tlohi->m_timerCR.Schedule (Seconds (1));
+  tlohi->m_timerMaxFrame.Schedule (Seconds (2));
+  NS_TEST_ASSERT_MSG_EQ (queue->GetScheduledEvents (), 1, "Each timer scheduled its own event");
+  NS_TEST_ASSERT_MSG_EQ (tlohi->m_timerMaxFrame.GetDelayLeft (), Seconds (2), "Timer lost its deadline");
+  NS_TEST_ASSERT_MSG_EQ (tlohi->GetFsm ()->GetStateName (tlohi->GetFsm ()->GetState ()), "IDLE", "T-Lohi state not tracked");
+
+  tlohi->Dispose ();
+  wakeupTlohi->Dispose ();
+  maca->Dispose ();
+  wakeupMaca->Dispose ();
+  Simulator::Destroy ();
+}
+
+class UanWakeupHelperTest : public TestCase
+{
+public:
+  UanWakeupHelperTest ();
+
+  virtual void DoRun (void);
+private:
+  static NodeContainer CreateNodes (uint32_t n);
+  static void Send (Ptr<NetDevice> src, Ptr<NetDevice> dst);
+  void Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode);
+  void WakeupRxOk (Ptr<const Packet> pkt, double sinr, UanTxMode mode);
+
+  uint32_t m_tx;
+  uint32_t m_wakeupRxOk;
+};
+
+UanWakeupHelperTest::UanWakeupHelperTest () : TestCase ("UAN wakeup helper wiring")
+{
+
+}
+
+NodeContainer
+UanWakeupHelperTest::CreateNodes (uint32_t n)
+{
+  NodeContainer c;
+  c.Create (n);
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (100 * i, 0, 0));
+      c.Get (i)->AggregateObject (mobility);
+    }
+  BasicEnergySourceHelper energy;
+  energy.Install (c);
+  return c;
+}
+
+void
+UanWakeupHelperTest::Send (Ptr<NetDevice> src, Ptr<NetDevice> dst)
+{
+  src->Send (Create<Packet> (10), dst->GetAddress (), 0);
+}
+
+void
+UanWakeupHelperTest::Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode)
+{
+  m_tx++;
+}
+
+void
+UanWakeupHelperTest::WakeupRxOk (Ptr<const Packet> pkt, double sinr, UanTxMode mode)
+{
+  m_wakeupRxOk++;
+}
+
+void
+UanWakeupHelperTest::DoRun (void)
+{
+  const char *macs[] = { "ns3::UanMacFama", "ns3::UanMacSlottedFama", "ns3::UanMacMaca",
+                         "ns3::UanMacTlohi", "ns3::UanMacCwW" };
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      NodeContainer c = CreateNodes (3);
+      UanWakeupHelper helper;
+      helper.SetMac (macs[i]);
+      NetDeviceContainer devices = helper.Install (c, CreateObject<UanChannel> ());
+      NS_TEST_ASSERT_MSG_EQ (devices.GetN (), 3, "One device per node");
+      for (uint32_t j = 0; j < devices.GetN (); j++)
+        {
+          Ptr<UanNetDevice> dev = DynamicCast<UanNetDevice> (devices.Get (j));
+          NS_TEST_ASSERT_MSG_EQ (dev->GetMac ()->GetInstanceTypeId ().GetName (), macs[i], "Device does not send through the upper MAC");
+          NS_TEST_ASSERT_MSG_EQ (UanAddress::ConvertFrom (dev->GetMac ()->GetAddress ()), UanAddress (j), "Addresses not allocated in node order");
+          Ptr<UanPhyWakeupDual> phy = DynamicCast<UanPhyWakeupDual> (dev->GetPhy ());
+          NS_TEST_ASSERT_MSG_EQ ((phy != 0), true, "No wakeup dual PHY");
+          NS_TEST_ASSERT_MSG_EQ (phy->GetDataPhy ()->IsStateSleep (), true, "Data modem left awake");
+          NS_TEST_ASSERT_MSG_EQ (phy->GetWakeupPhy ()->IsStateIdle (), true, "Wakeup receiver not listening");
+          Ptr<EnergySource> source = c.Get (j)->GetObject<EnergySourceContainer> ()->Get (0);
+          NS_TEST_ASSERT_MSG_EQ (source->FindDeviceEnergyModels ("ns3::AcousticModemEnergyModel").GetN (), 2,
+                                 "No energy model per receiver");
+        }
+      Simulator::Destroy ();
+    }
+
+  // A FAMA send goes out through the wakeup MAC and the peer hears the tone
+  NodeContainer c = CreateNodes (2);
+  UanWakeupHelper helper;
+  NetDeviceContainer devices = helper.Install (c, CreateObject<UanChannel> ());
+  m_tx = 0;
+  m_wakeupRxOk = 0;
+  Ptr<UanPhyWakeupDual> src = DynamicCast<UanPhyWakeupDual> (DynamicCast<UanNetDevice> (devices.Get (0))->GetPhy ());
+  Ptr<UanPhyWakeupDual> dst = DynamicCast<UanPhyWakeupDual> (DynamicCast<UanNetDevice> (devices.Get (1))->GetPhy ());
+  src->TraceConnectWithoutContext ("Tx", MakeCallback (&UanWakeupHelperTest::Tx, this));
+  dst->GetWakeupPhy ()->TraceConnectWithoutContext ("RxOk", MakeCallback (&UanWakeupHelperTest::WakeupRxOk, this));
+  Simulator::Schedule (Seconds (1), &UanWakeupHelperTest::Send, devices.Get (0), devices.Get (1));
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_GT (m_tx, 0, "Upper MAC not wired to the wakeup MAC");
+  NS_TEST_ASSERT_MSG_GT (m_wakeupRxOk, 0, "Wakeup receiver not wired to the channel");
+
+  Simulator::Destroy ();
+}
+
+class UanMacTestSuite : public TestSuite
+{
+public:
+  UanMacTestSuite ();
+};
+
+UanMacTestSuite::UanMacTestSuite ()
+  :  TestSuite ("devices-uan-mac", UNIT)
+{
+  AddTestCase (new UanMacFamaPropDelayTest, TestCase::QUICK);
+  AddTestCase (new UanMacFamaLateAckTest, TestCase::QUICK);
+  AddTestCase (new UanMacSlottedFamaTest, TestCase::QUICK);
+  AddTestCase (new UanMacWakeupLingerTest, TestCase::QUICK);
+  AddTestCase (new UanMacFamaLingerTest, TestCase::QUICK);
+  AddTestCase (new UanDutyCycleTest, TestCase::QUICK);
+  AddTestCase (new UanMacAlohaCsBackoffTest, TestCase::QUICK);
+  AddTestCase (new UanMacTlohiBackoffTest, TestCase::QUICK);
+  AddTestCase (new UanMacFsmStackTest, TestCase::QUICK);
+  AddTestCase (new UanWakeupHelperTest, TestCase::QUICK);
+}
+
+static UanMacTestSuite g_uanMacTestSuite;
@@ -21,15 +21,31 @@
 #include "ns3/uan-net-device.h"
 #include "ns3/uan-channel.h"
 #include "ns3/uan-mac-aloha.h"
+#include "ns3/uan-backoff.h"
+#include "ns3/uan-mac-fsm.h"
+#include "ns3/uan-relay-queue.h"
+#include "ns3/uan-routing-table.h"
+#include "ns3/uan-header-common.h"
+#include "ns3/uan-header-rc.h"
+#include "ns3/uan-header-wakeup.h"
+#include "ns3/uan-header-packing.h"
+#include "ns3/uan-phy-header.h"
+#include "ns3/uan-binary-trace.h"
+#include "ns3/uan-helper.h"
+#include "ns3/uan-header-pcap.h"
 #include "ns3/uan-phy-gen.h"
+#include "ns3/uan-phy-wakeup-dual.h"
 #include "ns3/uan-transducer-hd.h"
 #include "ns3/uan-prop-model-ideal.h"
+#include "ns3/uan-prop-model-thorp.h"
 #include "ns3/constant-position-mobility-model.h"
 #include "ns3/simulator.h"
 #include "ns3/test.h"
 #include "ns3/node.h"
 #include "ns3/object-factory.h"
 #include "ns3/pointer.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
 #include "ns3/callback.h"
 
 using namespace ns3;
@@ -240,6 +256,1029 @@ UanTest::DoRun (void)
   DoPhyTests ();
 }
 
+class UanBackoffTest : public TestCase
+{
+public:
+  UanBackoffTest ();
+
+  virtual void DoRun (void);
+};
+
+UanBackoffTest::UanBackoffTest () : TestCase ("UAN backoff policies")
+{
+
+}
+
+void
+UanBackoffTest::DoRun (void)
+{
+  Ptr<UanBackoffBeb> beb = CreateObject<UanBackoffBeb> ();
+  NS_TEST_ASSERT_MSG_EQ (beb->GetMultiplier (), 1, "Fresh BEB window should not be widened");
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      beb->NotifyCollision ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (beb->GetMultiplier (), 10, "BEB multiplier should saturate at MaxMultiplier");
+  NS_TEST_ASSERT_MSG_EQ (beb->GetCollisions (), 6, "Wrong collision count");
+  beb->NotifySuccess ();
+  NS_TEST_ASSERT_MSG_EQ (beb->GetRetries (), 0, "Success should clear the retry count");
+  NS_TEST_ASSERT_MSG_EQ (beb->GetCollisions (), 6, "Success should not clear the collision count");
+  NS_TEST_ASSERT_MSG_EQ (beb->GetMultiplier (), 1, "Success should restore the BEB window");
+
+  Ptr<UanBackoffBayesian> bayes = CreateObject<UanBackoffBayesian> ();
+  bayes->NotifyBusy ();
+  NS_TEST_ASSERT_MSG_EQ (bayes->GetContenders (), 2, "Overheard traffic implies two contenders");
+  bayes->NotifyCollision ();
+  NS_TEST_ASSERT_MSG_GT (bayes->GetContenders (), 2, "Collision should raise the estimate");
+  bayes->NotifySuccess ();
+  bayes->NotifySuccess ();
+  NS_TEST_ASSERT_MSG_EQ (bayes->GetContenders (), 1, "Estimate should not drop below one");
+
+  Ptr<UanBackoffUniform> uniform = CreateObject<UanBackoffUniform> ();
+  uniform->NotifyCollision ();
+  double b = uniform->GetBackoff (0.1, 0.2);
+  NS_TEST_ASSERT_MSG_EQ ((b >= 0.1 && b <= 0.2), true, "Uniform backoff outside of the base window");
+}
+
+class UanMacFsmTest : public TestCase
+{
+public:
+  UanMacFsmTest ();
+
+  virtual void DoRun (void);
+private:
+  static void Expire (UanMacFsmTest *test, uint32_t timer);
+  std::vector<uint32_t> m_expired;
+  std::vector<Time> m_expireTimes;
+};
+
+UanMacFsmTest::UanMacFsmTest () : TestCase ("UAN MAC state machine")
+{
+
+}
+
+void
+UanMacFsmTest::Expire (UanMacFsmTest *test, uint32_t timer)
+{
+  test->m_expired.push_back (timer);
+  test->m_expireTimes.push_back (Simulator::Now ());
+}
+
+void
+UanMacFsmTest::DoRun (void)
+{
+  Ptr<UanMacFsm> fsm = CreateObject<UanMacFsm> ();
+  fsm->AddState (0, "IDLE");
+  fsm->AddState (1, "BUSY");
+
+  uint32_t t0 = fsm->AddTimer ("t0", MakeBoundCallback (&UanMacFsmTest::Expire, this, 0));
+  uint32_t t1 = fsm->AddTimer ("t1", MakeBoundCallback (&UanMacFsmTest::Expire, this, 1));
+  uint32_t t2 = fsm->AddTimer ("t2", MakeBoundCallback (&UanMacFsmTest::Expire, this, 2));
+
+  fsm->Schedule (t0, Seconds (1));
+  fsm->Schedule (t1, Seconds (3));
+  fsm->Schedule (t2, Seconds (2));
+  fsm->Cancel (t2);
+  Simulator::Schedule (Seconds (0.5), &UanMacFsm::SetState, fsm, 1);
+  Simulator::Schedule (Seconds (2.5), &UanMacFsm::SetState, fsm, 0);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), 2, "Cancelled timer expired");
+  NS_TEST_ASSERT_MSG_EQ (m_expired[0], 0, "Timers expired out of order");
+  NS_TEST_ASSERT_MSG_EQ (m_expireTimes[0], Seconds (1), "Timer expired at the wrong time");
+  NS_TEST_ASSERT_MSG_EQ (m_expired[1], 1, "Timers expired out of order");
+  NS_TEST_ASSERT_MSG_EQ (m_expireTimes[1], Seconds (3), "Timer expired at the wrong time");
+  NS_TEST_ASSERT_MSG_EQ (fsm->GetScheduledEvents (), 2, "Later timers should share the pending event");
+  NS_TEST_ASSERT_MSG_EQ (fsm->GetDwellTime (1), Seconds (2), "Wrong dwell time");
+  NS_TEST_ASSERT_MSG_EQ (fsm->GetEntries (0), 2, "Wrong entry count");
+
+  Simulator::Destroy ();
+}
+
+class UanTimerQueueTest : public TestCase
+{
+public:
+  UanTimerQueueTest ();
+
+  virtual void DoRun (void);
+private:
+  static void Expire (UanTimerQueueTest *test, uint32_t timer);
+  std::vector<uint32_t> m_expired;
+  std::vector<Time> m_expireTimes;
+};
+
+UanTimerQueueTest::UanTimerQueueTest () : TestCase ("UAN shared timer queue")
+{
+
+}
+
+void
+UanTimerQueueTest::Expire (UanTimerQueueTest *test, uint32_t timer)
+{
+  test->m_expired.push_back (timer);
+  test->m_expireTimes.push_back (Simulator::Now ());
+}
+
+void
+UanTimerQueueTest::DoRun (void)
+{
+  // Two MACs of one node, the upper one moves onto the lower one's queue
+  // with a timer already running
+  Ptr<UanMacFsm> lower = CreateObject<UanMacFsm> ();
+  Ptr<UanMacFsm> upper = CreateObject<UanMacFsm> ();
+  uint32_t tl = lower->AddTimer ("lower", MakeBoundCallback (&UanTimerQueueTest::Expire, this, 0));
+  uint32_t tu = upper->AddTimer ("upper", MakeBoundCallback (&UanTimerQueueTest::Expire, this, 1));
+  Ptr<UanTimerQueue> old = upper->GetTimerQueue ();
+
+  upper->Schedule (tu, Seconds (2));
+  lower->Schedule (tl, Seconds (1));
+  upper->SetTimerQueue (lower->GetTimerQueue ());
+  NS_TEST_ASSERT_MSG_EQ (old->IsRunning (0), false, "Timer left running in the old queue");
+  NS_TEST_ASSERT_MSG_EQ (upper->IsRunning (tu), true, "Running timer not moved");
+  NS_TEST_ASSERT_MSG_EQ (upper->GetDelayLeft (tu), Seconds (2), "Moved timer lost its deadline");
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_expired.size (), 2, "Moved timer expired twice or not at all");
+  NS_TEST_ASSERT_MSG_EQ (m_expired[0], 0, "Timers expired out of order");
+  NS_TEST_ASSERT_MSG_EQ (m_expired[1], 1, "Timers expired out of order");
+  NS_TEST_ASSERT_MSG_EQ (m_expireTimes[1], Seconds (2), "Moved timer expired at the wrong time");
+  NS_TEST_ASSERT_MSG_EQ (lower->GetScheduledEvents (), 2, "Shared queue should arm one event per expiry");
+
+  // Cancelling one MAC's timers leaves the other's running
+  upper->Schedule (tu, Seconds (1));
+  lower->Schedule (tl, Seconds (1));
+  upper->CancelAll ();
+  NS_TEST_ASSERT_MSG_EQ (lower->IsRunning (tl), true, "CancelAll reached into the other MAC");
+
+  // A disposed engine reports no timers instead of dereferencing the queue
+  upper->Dispose ();
+  NS_TEST_ASSERT_MSG_EQ (upper->IsRunning (tu), false, "Disposed timer still running");
+  NS_TEST_ASSERT_MSG_EQ (upper->GetDelayLeft (tu), Seconds (0), "Disposed timer has a delay left");
+  NS_TEST_ASSERT_MSG_EQ (upper->GetScheduledEvents (), 0, "Disposed engine reports events");
+
+  lower->Dispose ();
+  Simulator::Destroy ();
+}
+
+class UanRelayQueueTest : public TestCase
+{
+public:
+  UanRelayQueueTest ();
+
+  virtual void DoRun (void);
+};
+
+UanRelayQueueTest::UanRelayQueueTest () : TestCase ("UAN relay queue scheduling")
+{
+
+}
+
+void
+UanRelayQueueTest::DoRun (void)
+{
+  // Relay packets are 100 bytes, local ones 10; weights 2:1
+  Ptr<UanRelayQueue> queue = CreateObject<UanRelayQueue> ();
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      queue->Enqueue (Create<Packet> (100), UanAddress (1), true);
+      queue->Enqueue (Create<Packet> (10), UanAddress (1), false);
+    }
+  NS_TEST_ASSERT_MSG_EQ (queue->GetRelaySize (), 3, "Wrong relay queue length");
+
+  uint32_t expected[] = { 100, 100, 10, 100, 10, 10 };
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (queue->Select ()->GetSize (), expected[i], "Classes not served by weight");
+      queue->Pop ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (queue->IsEmpty (), true, "Queue not drained");
+
+  // A blocked next hop does not hold back the others
+  queue->Enqueue (Create<Packet> (10), UanAddress (1), false);
+  queue->Enqueue (Create<Packet> (20), UanAddress (2), false);
+  queue->Block (UanAddress (1));
+  NS_TEST_ASSERT_MSG_EQ (queue->Select ()->GetSize (), 20, "Blocked next hop served first");
+  queue->Pop ();
+  NS_TEST_ASSERT_MSG_EQ (queue->Select ()->GetSize (), 10, "Blocked next hop starved");
+
+  // The first round already follows the configured weights
+  queue = CreateObject<UanRelayQueue> ();
+  queue->SetAttribute ("RelayWeight", UintegerValue (1));
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      queue->Enqueue (Create<Packet> (100), UanAddress (1), true);
+      queue->Enqueue (Create<Packet> (10), UanAddress (1), false);
+    }
+  uint32_t alternate[] = { 100, 10, 100, 10 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (queue->Select ()->GetSize (), alternate[i], "First round ignores RelayWeight");
+      queue->Pop ();
+    }
+
+  Simulator::Destroy ();
+}
+
+class UanRoutingTableTest : public TestCase
+{
+public:
+  UanRoutingTableTest ();
+
+  virtual void DoRun (void);
+};
+
+UanRoutingTableTest::UanRoutingTableTest () : TestCase ("UAN static routing table")
+{
+
+}
+
+void
+UanRoutingTableTest::DoRun (void)
+{
+  Ptr<UanRoutingTable> table = CreateObject<UanRoutingTable> ();
+  table->SetRoute (UanAddress (7), UanAddress (3));
+  NS_TEST_ASSERT_MSG_EQ (table->GetNextHop (UanAddress (7)), UanAddress (3), "Wrong next hop");
+  NS_TEST_ASSERT_MSG_EQ (table->GetNextHop (UanAddress (5)), UanAddress (5), "Unknown destinations are neighbors");
+  table->RemoveRoute (UanAddress (7));
+  NS_TEST_ASSERT_MSG_EQ (table->HasRoute (UanAddress (7)), false, "Route not removed");
+
+  // Line of three nodes 500 m apart; only adjacent nodes hear each other
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  channel->SetPropagationModel (CreateObject<UanPropModelThorp> ());
+  std::vector<Ptr<UanNetDevice> > devs;
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      Ptr<UanMacAloha> mac = CreateObject<UanMacAloha> ();
+      mobility->SetPosition (Vector (500.0 * i, 0, 0));
+      node->AggregateObject (mobility);
+      mac->SetAddress (UanAddress (i + 1));
+      dev->SetPhy (CreateObject<UanPhyGen> ());
+      dev->SetMac (mac);
+      dev->SetChannel (channel);
+      dev->SetTransducer (CreateObject<UanTransducerHd> ());
+      node->AddDevice (dev);
+      devs.push_back (dev);
+    }
+
+  table->SetAttribute ("MaxPathLossDb", DoubleValue (46));
+  NS_TEST_ASSERT_MSG_EQ (table->ComputeRoutes (devs[0]), 2, "Both nodes should be reachable");
+  NS_TEST_ASSERT_MSG_EQ (table->GetNextHop (UanAddress (3)), UanAddress (2), "Far node not routed through the middle one");
+  NS_TEST_ASSERT_MSG_EQ (table->GetNextHop (UanAddress (2)), UanAddress (2), "Neighbor not reached directly");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * MAC that records what the device relays and lets the test deliver
+ * packets up to the device.
+ */
+class UanMacRelayProbe : public UanMac
+{
+public:
+  UanMacRelayProbe (UanAddress addr) : m_address (addr) {}
+  virtual Address GetAddress (void) { return m_address; }
+  virtual void SetAddress (UanAddress addr) { m_address = addr; }
+  virtual bool Enqueue (Ptr<Packet> pkt, const Address &dest, uint16_t protocolNumber) { return true; }
+  virtual bool Relay (Ptr<Packet> pkt, const Address &nextHop)
+  {
+    m_relayed.push_back (pkt);
+    m_nextHops.push_back (UanAddress::ConvertFrom (nextHop));
+    return true;
+  }
+  virtual void SetForwardUpCb (Callback<void, Ptr<Packet>, const UanAddress&> cb) { m_forUp = cb; }
+  virtual void AttachPhy (Ptr<UanPhy> phy) {}
+  virtual Address GetBroadcast (void) const { return UanAddress::GetBroadcast (); }
+  virtual void Clear (void) {}
+  virtual int64_t AssignStreams (int64_t stream) { return 0; }
+
+  UanAddress m_address;
+  Callback<void, Ptr<Packet>, const UanAddress&> m_forUp;
+  std::vector<Ptr<Packet> > m_relayed;
+  std::vector<UanAddress> m_nextHops;
+};
+
+class UanNetDeviceRelayTest : public TestCase
+{
+public:
+  UanNetDeviceRelayTest ();
+
+  virtual void DoRun (void);
+private:
+  bool Receive (Ptr<NetDevice> dev, Ptr<const Packet> pkt, uint16_t mode, const Address &sender);
+  std::vector<uint32_t> m_rxSizes;
+  std::vector<UanAddress> m_rxOrigins;
+};
+
+UanNetDeviceRelayTest::UanNetDeviceRelayTest () : TestCase ("UAN multi-hop packet relayed once per delivery")
+{
+
+}
+
+bool
+UanNetDeviceRelayTest::Receive (Ptr<NetDevice> dev, Ptr<const Packet> pkt, uint16_t mode, const Address &sender)
+{
+  m_rxSizes.push_back (pkt->GetSize ());
+  m_rxOrigins.push_back (UanAddress::ConvertFrom (sender));
+  return true;
+}
+
+void
+UanNetDeviceRelayTest::DoRun (void)
+{
+  // Node 2 relays from 1 to 3
+  Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+  Ptr<UanMacRelayProbe> mac = CreateObject<UanMacRelayProbe> (UanAddress (2));
+  Ptr<UanRoutingTable> table = CreateObject<UanRoutingTable> ();
+  table->SetRoute (UanAddress (3), UanAddress (3));
+  dev->SetMac (mac);
+  dev->SetRoutingTable (table);
+  dev->SetReceiveCallback (MakeCallback (&UanNetDeviceRelayTest::Receive, this));
+
+  UanHeaderRoute route (UanAddress (1), UanAddress (3));
+  Ptr<Packet> pkt = Create<Packet> (10);
+  pkt->AddHeader (route);
+  uint32_t size = pkt->GetSize ();
+
+  mac->m_forUp (pkt, UanAddress (1));
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), size, "Delivered packet was modified");
+  NS_TEST_ASSERT_MSG_EQ (mac->m_relayed.size (), 1, "Packet should be relayed exactly once");
+  UanHeaderRoute relayed;
+  NS_TEST_ASSERT_MSG_EQ (mac->m_relayed[0]->GetSize (), size, "Relayed packet lost or gained a route header");
+  mac->m_relayed[0]->PeekHeader (relayed);
+  NS_TEST_ASSERT_MSG_EQ (relayed.GetOrigin (), UanAddress (1), "Wrong origin after relay");
+  NS_TEST_ASSERT_MSG_EQ (relayed.GetFinal (), UanAddress (3), "Wrong target after relay");
+  NS_TEST_ASSERT_MSG_EQ (mac->m_nextHops[0], UanAddress (3), "Wrong next hop");
+  NS_TEST_ASSERT_MSG_EQ (m_rxSizes.size (), 0, "Relayed packet passed up");
+
+  // At the final hop the packet reaches the application once, intact
+  mac->m_address = UanAddress (3);
+  mac->m_forUp (mac->m_relayed[0], UanAddress (2));
+  NS_TEST_ASSERT_MSG_EQ (m_rxSizes.size (), 1, "Packet should reach the application exactly once");
+  NS_TEST_ASSERT_MSG_EQ (m_rxSizes[0], 10, "Route header not stripped");
+  NS_TEST_ASSERT_MSG_EQ (m_rxOrigins[0], UanAddress (1), "Origin lost at the final hop");
+  NS_TEST_ASSERT_MSG_EQ (mac->m_relayed.size (), 1, "Delivered packet relayed again");
+
+  dev->Dispose ();
+  Simulator::Destroy ();
+}
+
+class UanAddressWidthTest : public TestCase
+{
+public:
+  UanAddressWidthTest ();
+
+  virtual void DoRun (void);
+};
+
+UanAddressWidthTest::UanAddressWidthTest () : TestCase ("UAN 16 bit addresses")
+{
+
+}
+
+void
+UanAddressWidthTest::DoRun (void)
+{
+  // Start a fresh run, earlier tests used 1 byte addresses
+  Simulator::Destroy ();
+  UanHeaderCommon header (UanAddress (300), UanAddress (1000), 2);
+  NS_TEST_ASSERT_MSG_EQ (header.GetSerializedSize (), 3, "Legacy header size changed");
+  UanAddress any;
+
+  UanAddress::SetWidth (2);
+  NS_TEST_ASSERT_MSG_EQ (UanAddress::GetBroadcast ().GetAsInt (), 65535, "Wrong 16 bit broadcast");
+  NS_TEST_ASSERT_MSG_EQ (any, UanAddress::GetBroadcast (), "Default address no longer broadcast after SetWidth");
+  Ptr<Packet> pkt = Create<Packet> ();
+  pkt->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 5, "16 bit header has the wrong size");
+
+  UanHeaderCommon rx;
+  pkt->RemoveHeader (rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.GetSrc (), UanAddress (300), "Source lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.GetDest (), UanAddress (1000), "Destination lost");
+  NS_TEST_ASSERT_MSG_EQ (UanAddress::ConvertFrom (Address (UanAddress (1000))), UanAddress (1000), "Address conversion lost the high byte");
+
+  // 16 bit allocation runs past the 8 bit broadcast
+  UanAddress last;
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      last = UanAddress::Allocate ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (last, UanAddress (299), "16 bit allocation wrapped");
+
+  // The width and the allocator only last for the run
+  Simulator::Destroy ();
+  NS_TEST_ASSERT_MSG_EQ ((int) UanAddress::GetWidth (), 1, "Width not reset at the end of the run");
+  NS_TEST_ASSERT_MSG_EQ (UanAddress::Allocate (), UanAddress (0), "Allocation not restarted for the new run");
+
+  // 8 bit allocation hands out every address below broadcast; one more
+  // would be a fatal error instead of wrapping onto node 0
+  for (uint32_t i = 1; i < 255; i++)
+    {
+      last = UanAddress::Allocate ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (last, UanAddress (254), "8 bit allocation stopped early");
+  NS_TEST_ASSERT_MSG_EQ ((last == UanAddress::GetBroadcast ()), false, "Broadcast address allocated");
+
+  // 8 bit broadcast goes on the air as 255 and comes back as broadcast
+  UanHeaderCommon bcast (UanAddress (1), UanAddress::GetBroadcast (), 2);
+  pkt = Create<Packet> ();
+  pkt->AddHeader (bcast);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 3, "8 bit broadcast header has the wrong size");
+  pkt->RemoveHeader (rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.GetDest (), UanAddress::GetBroadcast (), "8 bit broadcast lost");
+  Simulator::Destroy ();
+}
+
+class UanHeaderWakeupTest : public TestCase
+{
+public:
+  UanHeaderWakeupTest ();
+
+  virtual void DoRun (void);
+private:
+  /** Serialize and deserialize header, plain and bit-packed. */
+  bool RoundTrip (const UanHeaderWakeup &header, UanHeaderWakeup &rx);
+};
+
+UanHeaderWakeupTest::UanHeaderWakeupTest () : TestCase ("UAN wakeup header")
+{
+
+}
+
+bool
+UanHeaderWakeupTest::RoundTrip (const UanHeaderWakeup &header, UanHeaderWakeup &rx)
+{
+  for (uint32_t packed = 0; packed < 2; packed++)
+    {
+      if (packed)
+        {
+          UanHeaderPacking::Enable (8);
+        }
+      uint32_t expected = header.GetSerializedSize ();
+      Ptr<Packet> pkt = Create<Packet> ();
+      pkt->AddHeader (header);
+      uint32_t size = pkt->GetSize ();
+      rx = UanHeaderWakeup ();
+      pkt->RemoveHeader (rx);
+      UanHeaderPacking::Disable ();
+      NS_TEST_ASSERT_MSG_EQ_RETURNS_BOOL (size, expected, "Serialized size mismatch");
+      NS_TEST_ASSERT_MSG_EQ_RETURNS_BOOL (pkt->GetSize (), 0, "Header not fully consumed");
+      NS_TEST_ASSERT_MSG_EQ_RETURNS_BOOL (rx.GetMode (), header.GetMode (), "Mode lost");
+      NS_TEST_ASSERT_MSG_EQ_RETURNS_BOOL (rx.GetDest (), header.GetDest (), "Address lost");
+      NS_TEST_ASSERT_MSG_EQ_RETURNS_BOOL (rx.GetMembers ().size (), header.GetMembers ().size (), "Bitmap lost");
+    }
+  return false;
+}
+
+void
+UanHeaderWakeupTest::DoRun (void)
+{
+  UanHeaderWakeup rx;
+
+  UanHeaderWakeup unicast;
+  unicast.SetDest (UanAddress (9));
+  RoundTrip (unicast, rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.IsDestination (UanAddress (9)), true, "Unicast destination lost");
+
+  UanHeaderWakeup group;
+  group.SetGroup (4);
+  RoundTrip (group, rx);
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) rx.GetGroup (), 4, "Group lost");
+
+  std::vector<UanAddress> members;
+  members.push_back (UanAddress (3));
+  members.push_back (UanAddress (12));
+  members.push_back (UanAddress (20));
+  UanHeaderWakeup bitmap;
+  bitmap.SetMembers (members);
+  RoundTrip (bitmap, rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.IsDestination (UanAddress (12)), true, "Member lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.IsDestination (UanAddress (13)), false, "Non-member woken");
+
+  // Address 9, corrupted mode byte
+  uint8_t corrupt[] = { 9, 7 };
+  Ptr<Packet> pkt = Create<Packet> (corrupt, sizeof (corrupt));
+  pkt->RemoveHeader (rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.IsValid (), false, "Corrupted mode accepted");
+  NS_TEST_ASSERT_MSG_EQ (rx.GetMode (), UanHeaderWakeup::INVALID, "Corrupted mode not flagged");
+  NS_TEST_ASSERT_MSG_EQ (rx.IsDestination (UanAddress (9)), false, "Corrupted header addresses a node");
+}
+
+class UanPhyHeaderTest : public TestCase
+{
+public:
+  UanPhyHeaderTest ();
+
+  virtual void DoRun (void);
+};
+
+UanPhyHeaderTest::UanPhyHeaderTest () : TestCase ("UAN PHY headers and frame type")
+{
+
+}
+
+void
+UanPhyHeaderTest::DoRun (void)
+{
+  UanPhyHeader::FrameType types[] = {UanPhyHeader::WU, UanPhyHeader::WUHE, UanPhyHeader::DATA,
+                                     UanPhyHeader::CTD, UanPhyHeader::CTS};
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      // Data frame: PHY header, MAC header, payload, PHY trailer
+      UanPhyHeader header;
+      header.SetFrameType (types[i]);
+      Ptr<Packet> pkt = Create<Packet> (10);
+      pkt->AddHeader (UanHeaderCommon (UanAddress (1), UanAddress (2), 0));
+      pkt->AddHeader (header);
+      pkt->AddTrailer (UanPhyTrailer ());
+      NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 10 + 3 + 6 + 4, "PHY framing has the wrong size");
+      NS_TEST_ASSERT_MSG_EQ (UanPhyHeader::PeekFrameType (pkt), types[i], "Wrong frame type peeked from PHY header");
+
+      UanPhyHeader rx;
+      UanPhyTrailer rxTrailer;
+      pkt->RemoveHeader (rx);
+      pkt->RemoveTrailer (rxTrailer);
+      NS_TEST_ASSERT_MSG_EQ (rx.GetFrameType (), types[i], "Frame type lost");
+      UanHeaderCommon common;
+      pkt->RemoveHeader (common);
+      NS_TEST_ASSERT_MSG_EQ (common.GetDest (), UanAddress (2), "MAC header damaged by PHY framing");
+      NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 10, "Payload damaged by PHY framing");
+
+      // Tone: the frame type sits in the same first byte
+      UanPhyWUHeader wu;
+      wu.SetFrameType (types[i]);
+      pkt = Create<Packet> ();
+      pkt->AddHeader (wu);
+      NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 2, "Tone header has the wrong size");
+      NS_TEST_ASSERT_MSG_EQ (UanPhyHeader::PeekFrameType (pkt), types[i], "Wrong frame type peeked from tone header");
+      UanPhyWUHeader rxWu;
+      pkt->RemoveHeader (rxWu);
+      NS_TEST_ASSERT_MSG_EQ (rxWu.GetFrameType (), types[i], "Tone frame type lost");
+      NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 0, "Tone header not fully removed");
+    }
+
+  UanPhyWUHeader tone;
+  NS_TEST_ASSERT_MSG_EQ (tone.GetFrameType (), UanPhyHeader::WU, "Tone header does not default to WU");
+  UanPhyHeader data;
+  NS_TEST_ASSERT_MSG_EQ (data.GetFrameType (), UanPhyHeader::DATA, "PHY header does not default to DATA");
+}
+
+class UanHeaderPackingTest : public TestCase
+{
+public:
+  UanHeaderPackingTest ();
+
+  virtual void DoRun (void);
+private:
+  /** Read back a timestamp written at 69.5 s, after the 16 bit wrap. */
+  void ReadTimestamp (Ptr<Packet> pkt);
+  Time m_timestamp;
+};
+
+UanHeaderPackingTest::UanHeaderPackingTest () : TestCase ("UAN bit-packed headers")
+{
+
+}
+
+void
+UanHeaderPackingTest::DoRun (void)
+{
+  UanHeaderPacking::Enable (5);
+
+  // 5 + 5 + 3 bits
+  UanHeaderCommon header (UanAddress (3), UanAddress::GetBroadcast (), 2);
+  Ptr<Packet> pkt = Create<Packet> ();
+  pkt->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 2, "Packed common header has the wrong size");
+
+  UanHeaderCommon rx;
+  pkt->RemoveHeader (rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.GetSrc (), UanAddress (3), "Source lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.GetDest (), UanAddress::GetBroadcast (), "Broadcast lost");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) rx.GetType (), 2, "Type lost");
+
+  // RTS timestamp is coded against the CTS global timestamp
+  UanHeaderRcCts cts (7, 1, Seconds (10.5), Seconds (0.25), UanAddress (4));
+  cts.SetTimeStampReference (Seconds (12));
+  pkt = Create<Packet> ();
+  pkt->AddHeader (cts);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 7, "Packed CTS has the wrong size");
+
+  UanHeaderRcCts rxCts;
+  rxCts.SetTimeStampReference (Seconds (12));
+  pkt->RemoveHeader (rxCts);
+  NS_TEST_ASSERT_MSG_EQ (rxCts.GetAddress (), UanAddress (4), "CTS address lost");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) rxCts.GetFrameNo (), 7, "Frame number lost");
+  NS_TEST_ASSERT_MSG_EQ (rxCts.GetRtsTimeStamp (), Seconds (10.5), "RTS timestamp lost");
+  NS_TEST_ASSERT_MSG_EQ (rxCts.GetDelayToTx (), Seconds (0.25), "Delay lost");
+
+  // 5 address bits + 2 mode bits
+  UanHeaderWakeup wakeup (9);
+  pkt = Create<Packet> ();
+  pkt->AddHeader (wakeup);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 1, "Packed wakeup header has the wrong size");
+  UanHeaderWakeup rxWakeup;
+  pkt->RemoveHeader (rxWakeup);
+  NS_TEST_ASSERT_MSG_EQ (rxWakeup.GetDest (), UanAddress (9), "Wakeup destination lost");
+
+  // Durations are quantized to milliseconds
+  UanHeaderDuration duration (1.2344);
+  pkt = Create<Packet> ();
+  pkt->AddHeader (duration);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 2, "Packed duration has the wrong size");
+  UanHeaderDuration rxDuration;
+  pkt->RemoveHeader (rxDuration);
+  NS_TEST_ASSERT_MSG_EQ_TOL (rxDuration.GetTxDuration (), 1.234, 1e-6, "Duration lost");
+
+  // PHY framing drops the start and stop bytes, the tone header is
+  // already two bytes
+  UanPhyHeader phyHeader;
+  UanPhyTrailer phyTrailer;
+  UanPhyWUHeader wuHeader;
+  pkt = Create<Packet> (10);
+  pkt->AddHeader (phyHeader);
+  pkt->AddTrailer (phyTrailer);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 10 + 5 + 3, "Packed PHY framing has the wrong size");
+  NS_TEST_ASSERT_MSG_EQ (UanPhyHeader::PeekFrameType (pkt), UanPhyHeader::DATA, "Packed PHY header lost the frame type");
+  pkt->RemoveHeader (phyHeader);
+  pkt->RemoveTrailer (phyTrailer);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 10, "Packed PHY framing not removed");
+  NS_TEST_ASSERT_MSG_EQ (wuHeader.GetSerializedSize (), 2, "Tone header size changed");
+
+  // Timestamps keep 16 bits of milliseconds and are read back against
+  // the receiver's clock
+  pkt = Create<Packet> ();
+  pkt->AddHeader (UanHeaderTimestamp (Seconds (69.5)));
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 2, "Packed timestamp has the wrong size");
+  Simulator::Schedule (Seconds (70.2), &UanHeaderPackingTest::ReadTimestamp, this, pkt);
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_timestamp, Seconds (69.5), "Timestamp not unwrapped");
+  Simulator::Destroy ();
+
+  // Like the address width, packing only lasts for the run
+  NS_TEST_ASSERT_MSG_EQ (UanHeaderPacking::IsEnabled (), false, "Packing outlived the run");
+}
+
+void
+UanHeaderPackingTest::ReadTimestamp (Ptr<Packet> pkt)
+{
+  UanHeaderTimestamp timestamp;
+  pkt->RemoveHeader (timestamp);
+  m_timestamp = timestamp.GetTimeStamp ();
+}
+
+class UanBinaryTraceTest : public TestCase
+{
+public:
+  UanBinaryTraceTest ();
+
+  virtual void DoRun (void);
+private:
+  /** Trace a tone and a data frame between two wakeup dual PHY devices. */
+  void DoWakeupRun (void);
+};
+
+UanBinaryTraceTest::UanBinaryTraceTest () : TestCase ("UAN binary PHY trace")
+{
+
+}
+
+void
+UanBinaryTraceTest::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("uan-trace.bin");
+
+  Ptr<UanBinaryTraceWriter> writer = CreateObject<UanBinaryTraceWriter> ();
+  writer->SetAttribute ("BufferSize", UintegerValue (UanBinaryTraceWriter::RECORD_SIZE));
+  NS_TEST_ASSERT_MSG_EQ (writer->Open (filename), true, "Cannot create trace file");
+
+  UanTraceRecord record;
+  record.time = 1500000000;
+  record.node = 3;
+  record.device = 1;
+  record.event = UanTraceRecord::RX_OK;
+  record.size = 42;
+  record.sinr = 12.5;
+  record.mode = 7;
+  writer->Write (record);
+  record.event = UanTraceRecord::TX;
+  record.sinr = -3.25;
+  writer->Write (record);
+  writer->Close ();
+  NS_TEST_ASSERT_MSG_EQ (writer->GetRecords (), 2, "Wrong record count");
+
+  UanBinaryTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Cannot open trace file");
+  UanTraceRecord rx;
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (rx), true, "First record missing");
+  NS_TEST_ASSERT_MSG_EQ (rx.time, 1500000000, "Time lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.node, 3, "Node lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.device, 1, "Device lost");
+  NS_TEST_ASSERT_MSG_EQ ((uint32_t) rx.event, UanTraceRecord::RX_OK, "Event lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.size, 42, "Size lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.sinr, 12.5, "SINR lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.mode, 7, "Mode lost");
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (rx), true, "Second record missing");
+  NS_TEST_ASSERT_MSG_EQ (rx.sinr, -3.25, "Tx power lost");
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (rx), false, "Trailing record");
+
+  DoWakeupRun ();
+}
+
+void
+UanBinaryTraceTest::DoWakeupRun (void)
+{
+  std::string filename = CreateTempDirFilename ("uan-wakeup-trace.bin");
+
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  channel->SetAttribute ("PropagationModel", PointerValue (CreateObject<UanPropModelIdeal> ()));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<Node> node = CreateObject<Node> ();
+      Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (100 * i, 0, 50));
+      node->AggregateObject (mobility);
+      dev->SetPhy (CreateObject<UanPhyWakeupDual> ());
+      dev->SetMac (CreateObject<UanMacAloha> ());
+      dev->SetChannel (channel);
+      dev->SetTransducer (CreateObject<UanTransducerHd> ());
+      node->AddDevice (dev);
+      devices.Add (dev);
+    }
+  Ptr<UanNetDevice> src = DynamicCast<UanNetDevice> (devices.Get (0));
+  Ptr<UanNetDevice> dst = DynamicCast<UanNetDevice> (devices.Get (1));
+  Ptr<UanPhyWakeupDual> phy = DynamicCast<UanPhyWakeupDual> (src->GetPhy ());
+
+  Ptr<UanBinaryTraceWriter> writer = CreateObject<UanBinaryTraceWriter> ();
+  NS_TEST_ASSERT_MSG_EQ (writer->Open (filename), true, "Cannot create trace file");
+  UanHelper::EnableBinary (writer, devices);
+
+  // A tone, then a data frame, addressed to nobody
+  UanHeaderCommon ch (UanAddress (0), UanAddress (200), 0);
+  Ptr<Packet> tone = Create<Packet> ();
+  tone->AddHeader (ch);
+  Ptr<Packet> data = Create<Packet> (17);
+  data->AddHeader (ch);
+  uint32_t toneSize = tone->GetSize ();
+  uint32_t dataSize = data->GetSize ();
+  uint32_t toneMode = phy->GetDataModes ().GetNModes ();
+  Simulator::Schedule (Seconds (1), &UanPhyWakeupDual::SendPacket, phy, tone, toneMode);
+  Simulator::Schedule (Seconds (3), &UanPhyWakeupDual::SendPacket, phy, data, 0);
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+  writer->Close ();
+  NS_TEST_ASSERT_MSG_EQ (writer->GetRecords (), 4, "Each PHY event traced once");
+
+  // Both receivers feed the same device records
+  uint32_t toneUid = phy->GetMode (toneMode).GetUid ();
+  uint32_t dataUid = phy->GetMode (0).GetUid ();
+  uint8_t events[] = { UanTraceRecord::TX, UanTraceRecord::RX_OK, UanTraceRecord::TX, UanTraceRecord::RX_OK };
+  uint32_t nodes[] = { src->GetNode ()->GetId (), dst->GetNode ()->GetId (),
+                       src->GetNode ()->GetId (), dst->GetNode ()->GetId () };
+  uint32_t modes[] = { toneUid, toneUid, dataUid, dataUid };
+  uint32_t sizes[] = { toneSize, toneSize, dataSize, dataSize };
+  UanBinaryTraceReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (filename), true, "Cannot open trace file");
+  UanTraceRecord rx;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.Read (rx), true, "Record missing");
+      NS_TEST_ASSERT_MSG_EQ ((uint32_t) rx.event, (uint32_t) events[i], "Wrong event");
+      NS_TEST_ASSERT_MSG_EQ (rx.node, nodes[i], "Wrong node");
+      NS_TEST_ASSERT_MSG_EQ (rx.device, 0, "Wrong device");
+      NS_TEST_ASSERT_MSG_EQ (rx.mode, modes[i], "Wrong mode");
+      NS_TEST_ASSERT_MSG_EQ (rx.size, sizes[i], "Wrong size");
+    }
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (rx), false, "Trailing record");
+
+  Simulator::Destroy ();
+}
+
+class UanHeaderPcapTest : public TestCase
+{
+public:
+  UanHeaderPcapTest ();
+
+  virtual void DoRun (void);
+};
+
+UanHeaderPcapTest::UanHeaderPcapTest () : TestCase ("UAN pcap pseudo-header")
+{
+
+}
+
+void
+UanHeaderPcapTest::DoRun (void)
+{
+  UanHeaderPcap header;
+  header.SetEvent (UanHeaderPcap::RX_ERROR);
+  header.SetChannel (UanHeaderPcap::WAKEUP);
+  header.SetMode (UanPhyGen::GetDefaultModes ()[0]);
+  header.SetSinrDb (-4.56);
+  header.SetPowerDb (101.25);
+
+  Ptr<Packet> pkt = Create<Packet> (10);
+  pkt->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (pkt->GetSize (), 34, "Pseudo-header has the wrong size");
+
+  UanHeaderPcap rx;
+  pkt->RemoveHeader (rx);
+  NS_TEST_ASSERT_MSG_EQ (rx.GetEvent (), UanHeaderPcap::RX_ERROR, "Event lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.GetChannel (), UanHeaderPcap::WAKEUP, "Channel lost");
+  NS_TEST_ASSERT_MSG_EQ (rx.GetDataRateBps (), UanPhyGen::GetDefaultModes ()[0].GetDataRateBps (), "Data rate lost");
+  NS_TEST_ASSERT_MSG_EQ_TOL (rx.GetSinrDb (), -4.56, 0.001, "SINR lost");
+  NS_TEST_ASSERT_MSG_EQ_TOL (rx.GetPowerDb (), 101.25, 0.001, "Power lost");
+}
+
+
+class UanPhyWakeupLatencyTest : public TestCase
+{
+public:
+  UanPhyWakeupLatencyTest ();
+
+  virtual void DoRun (void);
+private:
+  /**
+   * Tx trace sink.
+   * \param pkt Transmitted packet.
+   * \param txPowerDb Transmit power.
+   * \param txMode Transmit mode.
+   */
+  void Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode txMode);
+
+  uint32_t m_tx;  //!< Frames transmitted.
+  Time m_txTime;  //!< Time of the last transmission.
+};
+
+UanPhyWakeupLatencyTest::UanPhyWakeupLatencyTest () : TestCase ("UAN PHY wake-up latency")
+{
+
+}
+
+void
+UanPhyWakeupLatencyTest::Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode txMode)
+{
+  m_tx++;
+  m_txTime = Simulator::Now ();
+}
+
+void
+UanPhyWakeupLatencyTest::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+  Ptr<UanPhyGen> phy = CreateObject<UanPhyGen> ();
+  Ptr<UanMacAloha> mac = CreateObject<UanMacAloha> ();
+  node->AggregateObject (CreateObject<ConstantPositionMobilityModel> ());
+  phy->SetAttribute ("WakeupLatency", TimeValue (Seconds (0.5)));
+  dev->SetPhy (phy);
+  dev->SetMac (mac);
+  dev->SetChannel (CreateObject<UanChannel> ());
+  dev->SetTransducer (CreateObject<UanTransducerHd> ());
+  node->AddDevice (dev);
+  phy->TraceConnectWithoutContext ("Tx", MakeCallback (&UanPhyWakeupLatencyTest::Tx, this));
+  m_tx = 0;
+
+  phy->SetSleepMode (true);
+  Simulator::Schedule (Seconds (1), &UanPhyGen::SetSleepMode, phy, false);
+  Simulator::Stop (Seconds (1.25));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (phy->IsWakingUp (), true, "PHY not warming up");
+  NS_TEST_ASSERT_MSG_EQ (phy->IsStateSleep (), true, "PHY usable before warm-up");
+
+  // A frame sent while warming up goes out at the end of the warm-up
+  phy->SendPacket (Create<Packet> (10), 0);
+  Simulator::Stop (Seconds (0.5));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (phy->IsWakingUp (), false, "Warm-up did not end");
+  NS_TEST_ASSERT_MSG_EQ (m_tx, 1, "Frame dropped during the warm-up");
+  NS_TEST_ASSERT_MSG_EQ (m_txTime, Seconds (1.5), "Frame not sent at the end of the warm-up");
+
+  // Going back to sleep discards a held frame
+  phy->SetSleepMode (true);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  phy->SetSleepMode (false);
+  phy->SendPacket (Create<Packet> (10), 0);
+  phy->SetSleepMode (true);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_tx, 1, "Held frame sent after going back to sleep");
+
+  phy->SetSleepMode (false);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (phy->IsStateIdle (), true, "PHY not idle after warm-up");
+
+  Simulator::Destroy ();
+}
+
+class UanPhyWakeupDualTest : public TestCase
+{
+public:
+  UanPhyWakeupDualTest ();
+
+  virtual void DoRun (void);
+private:
+  Ptr<UanPhyWakeupDual> CreateNode (Vector pos, Ptr<UanChannel> chan);
+  void Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode);
+  void RxOk (Ptr<const Packet> pkt, double sinr, UanTxMode mode);
+  void WakeupRxOk (Ptr<const Packet> pkt, double sinr, UanTxMode mode);
+
+  uint32_t m_tx;
+  uint32_t m_rxOk;
+  uint32_t m_wakeupRxOk;
+};
+
+UanPhyWakeupDualTest::UanPhyWakeupDualTest () : TestCase ("UAN wakeup dual PHY")
+{
+
+}
+
+void
+UanPhyWakeupDualTest::Tx (Ptr<const Packet> pkt, double txPowerDb, UanTxMode mode)
+{
+  m_tx++;
+}
+
+void
+UanPhyWakeupDualTest::RxOk (Ptr<const Packet> pkt, double sinr, UanTxMode mode)
+{
+  m_rxOk++;
+}
+
+void
+UanPhyWakeupDualTest::WakeupRxOk (Ptr<const Packet> pkt, double sinr, UanTxMode mode)
+{
+  m_wakeupRxOk++;
+}
+
+Ptr<UanPhyWakeupDual>
+UanPhyWakeupDualTest::CreateNode (Vector pos, Ptr<UanChannel> chan)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<UanNetDevice> dev = CreateObject<UanNetDevice> ();
+  Ptr<UanPhyWakeupDual> phy = CreateObject<UanPhyWakeupDual> ();
+  Ptr<UanMacAloha> mac = CreateObject<UanMacAloha> ();
+  Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (pos);
+  node->AggregateObject (mobility);
+  mac->SetAddress (UanAddress::Allocate ());
+  dev->SetPhy (phy);
+  dev->SetMac (mac);
+  dev->SetChannel (chan);
+  dev->SetTransducer (CreateObject<UanTransducerHd> ());
+  node->AddDevice (dev);
+  return phy;
+}
+
+void
+UanPhyWakeupDualTest::DoRun (void)
+{
+  Ptr<UanChannel> channel = CreateObject<UanChannel> ();
+  channel->SetAttribute ("PropagationModel", PointerValue (CreateObject<UanPropModelIdeal> ()));
+
+  Ptr<UanPhyWakeupDual> data = CreateNode (Vector (0, 50, 50), channel);
+  Ptr<UanPhyWakeupDual> rx = CreateNode (Vector (50, 50, 50), channel);
+  Ptr<UanPhyWakeupDual> tone = CreateNode (Vector (100, 50, 50), channel);
+
+  m_tx = 0;
+  m_rxOk = 0;
+  m_wakeupRxOk = 0;
+  data->TraceConnectWithoutContext ("Tx", MakeCallback (&UanPhyWakeupDualTest::Tx, this));
+  tone->TraceConnectWithoutContext ("Tx", MakeCallback (&UanPhyWakeupDualTest::Tx, this));
+  rx->TraceConnectWithoutContext ("RxOk", MakeCallback (&UanPhyWakeupDualTest::RxOk, this));
+  rx->GetWakeupPhy ()->TraceConnectWithoutContext ("RxOk", MakeCallback (&UanPhyWakeupDualTest::WakeupRxOk, this));
+
+  // A 2 s data frame sent the way the wakeup MACs do, through the wakeup
+  // PHY in a data mode, with a tone from the other side arriving half
+  // way through it.  Nobody is addressed, so the MACs drop both.
+  UanHeaderCommon ch (UanAddress (0), UanAddress (200), 0);
+  Ptr<Packet> dataPkt = Create<Packet> (17);
+  dataPkt->AddHeader (ch);
+  Ptr<Packet> tonePkt = Create<Packet> ();
+  tonePkt->AddHeader (ch);
+  uint32_t toneMode = rx->GetDataModes ().GetNModes ();
+  Simulator::Schedule (Seconds (1), &UanPhyGen::SendPacket, data->GetWakeupPhy (),
+                       dataPkt, data->GetWakeupPhyDataMode ());
+  Simulator::Schedule (Seconds (2), &UanPhyWakeupDual::SendPacket, tone,
+                       tonePkt, toneMode);
+  Simulator::Stop (Seconds (5));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_tx, 2, "Tx not forwarded from both PHYs");
+  NS_TEST_ASSERT_MSG_EQ (m_wakeupRxOk, 1, "Wakeup PHY missed the tone during a data frame");
+  NS_TEST_ASSERT_MSG_EQ (m_rxOk, 2, "RxOk not forwarded from both PHYs");
+
+  NS_TEST_ASSERT_MSG_EQ (rx->AssignStreams (10), 2, "Streams not assigned to both PHYs");
+
+  Simulator::Destroy ();
+}
 
 class UanTestSuite : public TestSuite
 {
@@ -251,6 +1290,20 @@ UanTestSuite::UanTestSuite ()
   :  TestSuite ("devices-uan", UNIT)
 {
   AddTestCase (new UanTest, TestCase::QUICK);
+  AddTestCase (new UanBackoffTest, TestCase::QUICK);
+  AddTestCase (new UanMacFsmTest, TestCase::QUICK);
+  AddTestCase (new UanTimerQueueTest, TestCase::QUICK);
+  AddTestCase (new UanRelayQueueTest, TestCase::QUICK);
+  AddTestCase (new UanRoutingTableTest, TestCase::QUICK);
+  AddTestCase (new UanNetDeviceRelayTest, TestCase::QUICK);
+  AddTestCase (new UanAddressWidthTest, TestCase::QUICK);
+  AddTestCase (new UanHeaderWakeupTest, TestCase::QUICK);
+  AddTestCase (new UanPhyHeaderTest, TestCase::QUICK);
+  AddTestCase (new UanHeaderPackingTest, TestCase::QUICK);
+  AddTestCase (new UanBinaryTraceTest, TestCase::QUICK);
+  AddTestCase (new UanHeaderPcapTest, TestCase::QUICK);
+  AddTestCase (new UanPhyWakeupLatencyTest, TestCase::QUICK);
+  AddTestCase (new UanPhyWakeupDualTest, TestCase::QUICK);
 }
 
 static UanTestSuite g_uanTestSuite;